@@ -2,14 +2,35 @@
 #define INV_GAMMA   2.2
 #define GAMMA       1.0 / INV_GAMMA
 
+#ifdef PACKED_VERTICES
+struct VSInput
+{
+    float4 position : POSITION0; // unorm16 relative to mesh bounds, tangent handedness in w
+    float4 color    : COLOR0;
+    float2 normal   : NORMAL0;   // octahedral encoded
+    float2 tangent  : TANGENT0;  // octahedral encoded
+    float2 texCoord : TEXCOORD0;
+};
+#else
 struct VSInput
 {
     float3 position : POSITION0;
     float3 color    : COLOR0;
     float3 normal   : NORMAL0;
-    float3 tangent  : TANGENT0;
+    float4 tangent  : TANGENT0;  // handedness in w
     float2 texCoord : TEXCOORD0;
 };
+#endif
+
+struct VertexAttributes
+{
+    float3 position;
+    float3 color;
+    float3 normal;
+    float3 tangent;
+    float tangentSign;
+    float2 texCoord;
+};
 
 struct PSInput
 {
@@ -27,33 +48,77 @@ cbuffer SceneData : register(b0)
     float3 ambientLight;
     float3 cameraPosition;
     float4x4 viewproject;
+    float specularity;
+};
+
+cbuffer MeshConstants : register(b1)
+{
+    float4 positionMin;
+    float4 positionExtent;
+};
+
+struct InstanceData
+{
     float4x4 model;
     float4x4 normal;
-    float specularity;
 };
 
+StructuredBuffer<InstanceData> instances : register(t2); // after the material textures, vs_5_0 has no register spaces
+
 Texture2D colorTexture : register(t0);
 Texture2D normalTexture : register(t1);
 SamplerState textureSampler : register(s0);
 
-PSInput VSForward(VSInput input)
+float3 octDecode(float2 encoded)
 {
+    float3 direction = float3(encoded, 1. - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-direction.z);
+    direction.xy += (direction.xy >= 0.) ? -t : t;
+    return normalize(direction);
+}
+
+VertexAttributes decodeVertex(VSInput input)
+{
+    VertexAttributes attributes;
+#ifdef PACKED_VERTICES
+    attributes.position = positionMin.xyz + input.position.xyz * positionExtent.xyz;
+    attributes.color = input.color.rgb;
+    attributes.normal = octDecode(input.normal);
+    attributes.tangent = octDecode(input.tangent);
+    attributes.tangentSign = input.position.w * 2. - 1.;
+    attributes.texCoord = input.texCoord;
+#else
+    attributes.position = input.position;
+    attributes.color = input.color;
+    attributes.normal = input.normal;
+    attributes.tangent = input.tangent.xyz;
+    attributes.tangentSign = input.tangent.w;
+    attributes.texCoord = input.texCoord;
+#endif
+    return attributes;
+}
+
+PSInput VSForward(VSInput input, uint instanceID : SV_InstanceID)
+{
+    VertexAttributes attributes = decodeVertex(input);
+    InstanceData instance = instances[instanceID];
+
     // calc world pos
-    float4 position = mul(model, float4(input.position, 1.));
+    float4 position = mul(instance.model, float4(attributes.position, 1.));
     
     // calc tangent and normal vectors
-    float3 T = normalize(mul(normal, float4(input.tangent, 0.)).xyz);
-    float3 N = normalize(mul(normal, float4(input.normal, 0.)).xyz);
+    float3 T = normalize(mul(instance.normal, float4(attributes.tangent, 0.)).xyz);
+    float3 N = normalize(mul(instance.normal, float4(attributes.normal, 0.)).xyz);
     
     // Re-orthogonalize T and N & calc B
     T = normalize(T - dot(T, N) * N);
-    float3 B = cross(N, T);
+    float3 B = cross(N, T) * attributes.tangentSign;
     
     PSInput result;
     result.position = mul(viewproject, position);
     result.vertexPos = position.xyz / position.w;
-    result.color = input.color;
-    result.texCoord = input.texCoord;
+    result.color = attributes.color;
+    result.texCoord = attributes.texCoord;
     result.TBN = transpose(float3x3(T, B, N));
     
     return result;
@@ -62,8 +127,9 @@ PSInput VSForward(VSInput input)
 float4 PSForward(PSInput input) : SV_TARGET0
 {    
     float3 color = pow(colorTexture.Sample(textureSampler, input.texCoord).rgb, INV_GAMMA); // Convert from SRGB to linear colors    
-    float3 normal = normalTexture.Sample(textureSampler, input.texCoord).rgb; // Assume normals stored in linear format
-    normal = (2.0 * normal) - 1.0;
+    float3 normal = 0.0;
+    normal.xy = (2.0 * normalTexture.Sample(textureSampler, input.texCoord).rg) - 1.0; // Two channel (BC5) normals, Z reconstructed
+    normal.z = sqrt(saturate(1.0 - dot(normal.xy, normal.xy)));
  
     float3 L = normalize(sunDirection);
     float3 V = normalize(cameraPosition - input.vertexPos);
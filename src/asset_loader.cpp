@@ -0,0 +1,75 @@
+#include "asset_loader.hpp"
+
+#include <cstdio>
+#include <string>
+
+#include "block_compression.hpp"
+#include "texture_import.hpp"
+#include "timer.hpp"
+
+namespace Engine
+{
+    namespace AssetLoader
+    {
+        bool readMesh(char const* path, MeshSource& source)
+        {
+            Timer loadTimer{};
+
+            // Try the binary mesh cache first, its arrays can be copied straight into upload memory
+            std::string const cachePath = MeshCache::cachePath(path);
+            if (MeshCache::load(path, cachePath.c_str(), source.cachedMesh))
+            {
+                loadTimer.tick();
+                printf("Loaded cached mesh [%s] (%.2f ms)\n", cachePath.c_str(), loadTimer.deltaTimeMS());
+                source.cached = true;
+                return true;
+            }
+
+            if (!MeshHelpers::parseOBJ(path, source.meshData)) {
+                return false;
+            }
+
+            MeshHelpers::processMesh(source.meshData);
+
+            loadTimer.tick();
+            printf("Processed OBJ mesh [%s] (%.2f ms)\n", path, loadTimer.deltaTimeMS());
+
+            MeshCache::SourceInfo sourceInfo{};
+            if (!MeshCache::querySource(path, sourceInfo, true)
+                || !MeshCache::write(cachePath.c_str(), sourceInfo, source.meshData))
+            {
+                printf("Mesh cache write failed [%s]\n", cachePath.c_str()); //< not fatal, OBJ is parsed again next launch
+            }
+
+            source.cached = false;
+            return true;
+        }
+
+        bool readTexture(char const* path, TextureType type, TextureSource& source)
+        {
+            Timer loadTimer{};
+            std::string const cachePath = TextureCache::cachePath(path);
+            if (TextureCache::load(path, cachePath.c_str(), source.cachedTexture))
+            {
+                loadTimer.tick();
+                printf("Loaded cached texture [%s] (%s, %u levels, %.2f ms)\n", cachePath.c_str(), BlockCompression::formatName(source.cachedTexture.format()), source.cachedTexture.pHeader->levelCount, loadTimer.deltaTimeMS());
+                source.cached = true;
+                return true;
+            }
+
+            if (!TextureImport::importImage(path, type, source.textureData)) {
+                return false;
+            }
+
+            MeshCache::SourceInfo sourceInfo{};
+            if (!MeshCache::querySource(path, sourceInfo, true)
+                || !TextureCache::write(cachePath.c_str(), sourceInfo, source.textureData))
+            {
+                printf("Texture cache write failed [%s]\n", cachePath.c_str()); //< not fatal, image is imported again next launch
+            }
+
+            source.cached = false;
+            return true;
+        }
+    } // namespace AssetLoader
+} // namespace Engine
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "texture_cache.hpp"
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace AssetLoader
+    {
+        /// @brief CPU side mesh contents, a memory mapped cache or freshly processed data if the cache was missing or stale.
+        struct MeshSource
+        {
+            MeshCache::CachedMesh cachedMesh{};
+            MeshData meshData{};
+            bool cached = false;
+        };
+
+        /// @brief CPU side texture contents, a memory mapped cooked cache or freshly imported data if the cache was missing or stale.
+        struct TextureSource
+        {
+            TextureCache::CachedTexture cachedTexture{};
+            TextureData textureData{};
+            bool cached = false;
+        };
+
+        /// @brief Map the mesh cache, or parse & process the OBJ and write its cache for the next launch. Thread safe.
+        bool readMesh(char const* path, MeshSource& source);
+
+        /// @brief Map the cooked texture cache, or import the image & write its cache for the next launch. Thread safe.
+        bool readTexture(char const* path, TextureType type, TextureSource& source);
+    } // namespace AssetLoader
+} // namespace Engine
@@ -0,0 +1,856 @@
+#include "block_compression.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    namespace BlockCompression
+    {
+        constexpr size_t BlockRowGrainSize = 4; //< block rows per parallel job
+        constexpr int RefineIterations = 2;     //< least squares endpoint refits after the principal axis guess
+        constexpr int PowerIterations = 8;
+
+        constexpr uint8_t Bc7Mode6 = 0x40;      //< mode bits of BC7 mode 6, single subset RGBA with 4-bit indices
+        constexpr uint32_t Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        /// @brief Block texels as floats in [0, 255].
+        struct BlockTexels
+        {
+            float texels[BlockTexelCount][4];
+        };
+
+        struct Endpoint
+        {
+            float channels[4];
+        };
+
+        /// @brief LSB first bit stream over a zeroed block.
+        struct BitWriter
+        {
+            uint8_t* pData;
+            uint32_t position = 0;
+
+            void write(uint32_t value, uint32_t bitCount)
+            {
+                for (uint32_t bit = 0; bit < bitCount; bit++, position++) {
+                    pData[position >> 3] |= static_cast<uint8_t>(((value >> bit) & 1U) << (position & 7U));
+                }
+            }
+        };
+
+        struct BitReader
+        {
+            uint8_t const* pData;
+            uint32_t position = 0;
+
+            uint32_t read(uint32_t bitCount)
+            {
+                uint32_t value = 0;
+                for (uint32_t bit = 0; bit < bitCount; bit++, position++) {
+                    value |= static_cast<uint32_t>((pData[position >> 3] >> (position & 7U)) & 1U) << bit;
+                }
+
+                return value;
+            }
+        };
+
+        static float clampChannel(float value)
+        {
+            return std::min(std::max(value, 0.0F), 255.0F);
+        }
+
+        static float distanceSquared(float const* pA, float const* pB, int channelCount)
+        {
+            float distance = 0.0F;
+            for (int channel = 0; channel < channelCount; channel++) {
+                distance += (pA[channel] - pB[channel]) * (pA[channel] - pB[channel]);
+            }
+
+            return distance;
+        }
+
+        /// @brief Endpoints at the extremes of the texels projected onto their principal axis, found by power iteration.
+        static void principalEndpoints(BlockTexels const& block, int channelCount, Endpoint& e0, Endpoint& e1)
+        {
+            float mean[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            float minimum[4] = { 255.0F, 255.0F, 255.0F, 255.0F };
+            float maximum[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            for (auto const& texel : block.texels)
+            {
+                for (int channel = 0; channel < channelCount; channel++)
+                {
+                    mean[channel] += texel[channel] / static_cast<float>(BlockTexelCount);
+                    minimum[channel] = std::min(minimum[channel], texel[channel]);
+                    maximum[channel] = std::max(maximum[channel], texel[channel]);
+                }
+            }
+
+            float covariance[4][4] = {};
+            for (auto const& texel : block.texels)
+            {
+                for (int row = 0; row < channelCount; row++)
+                {
+                    for (int column = 0; column < channelCount; column++) {
+                        covariance[row][column] += (texel[row] - mean[row]) * (texel[column] - mean[column]);
+                    }
+                }
+            }
+
+            // Start along the bounding box diagonal, converges in a few steps as blocks are mostly one dimensional
+            float axis[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            for (int channel = 0; channel < channelCount; channel++) {
+                axis[channel] = maximum[channel] - minimum[channel];
+            }
+
+            for (int iteration = 0; iteration < PowerIterations; iteration++)
+            {
+                float next[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+                float largest = 0.0F;
+                for (int row = 0; row < channelCount; row++)
+                {
+                    for (int column = 0; column < channelCount; column++) {
+                        next[row] += covariance[row][column] * axis[column];
+                    }
+
+                    largest = std::max(largest, std::abs(next[row]));
+                }
+
+                if (largest <= 0.0F) {
+                    break;
+                }
+
+                for (int channel = 0; channel < channelCount; channel++) {
+                    axis[channel] = next[channel] / largest;
+                }
+            }
+
+            float const zero[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            float const length = std::sqrt(distanceSquared(axis, zero, channelCount));
+            float minProjection = 0.0F;
+            float maxProjection = 0.0F;
+            if (length > 0.0F)
+            {
+                minProjection = std::numeric_limits<float>::max();
+                maxProjection = std::numeric_limits<float>::lowest();
+                for (auto const& texel : block.texels)
+                {
+                    float projection = 0.0F;
+                    for (int channel = 0; channel < channelCount; channel++) {
+                        projection += (texel[channel] - mean[channel]) * axis[channel] / length;
+                    }
+
+                    minProjection = std::min(minProjection, projection);
+                    maxProjection = std::max(maxProjection, projection);
+                }
+            }
+
+            for (int channel = 0; channel < 4; channel++)
+            {
+                float const direction = (length > 0.0F) ? axis[channel] / length : 0.0F;
+                e0.channels[channel] = (channel < channelCount) ? clampChannel(mean[channel] + direction * minProjection) : 255.0F;
+                e1.channels[channel] = (channel < channelCount) ? clampChannel(mean[channel] + direction * maxProjection) : 255.0F;
+            }
+        }
+
+        /// @brief Least squares endpoints for fixed interpolation weights, texel = (1 - w) * e0 + w * e1.
+        static bool fitEndpoints(BlockTexels const& block, float const* pWeights, int channelCount, Endpoint& e0, Endpoint& e1)
+        {
+            float aa = 0.0F;
+            float ab = 0.0F;
+            float bb = 0.0F;
+            float ax[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            float bx[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                float const a = 1.0F - pWeights[texelIdx];
+                float const b = pWeights[texelIdx];
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (int channel = 0; channel < channelCount; channel++)
+                {
+                    ax[channel] += a * block.texels[texelIdx][channel];
+                    bx[channel] += b * block.texels[texelIdx][channel];
+                }
+            }
+
+            float const determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) < 1e-6F) { //< all texels on one weight, nothing to solve for
+                return false;
+            }
+
+            for (int channel = 0; channel < channelCount; channel++)
+            {
+                e0.channels[channel] = clampChannel((ax[channel] * bb - bx[channel] * ab) / determinant);
+                e1.channels[channel] = clampChannel((bx[channel] * aa - ax[channel] * ab) / determinant);
+            }
+
+            return true;
+        }
+
+        static uint16_t packRgb565(Endpoint const& endpoint)
+        {
+            uint32_t const r = static_cast<uint32_t>(std::lround(endpoint.channels[0] * 31.0F / 255.0F));
+            uint32_t const g = static_cast<uint32_t>(std::lround(endpoint.channels[1] * 63.0F / 255.0F));
+            uint32_t const b = static_cast<uint32_t>(std::lround(endpoint.channels[2] * 31.0F / 255.0F));
+            return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+        }
+
+        static void unpackRgb565(uint16_t packed, uint32_t* pColor)
+        {
+            uint32_t const r = (packed >> 11) & 0x1F;
+            uint32_t const g = (packed >> 5) & 0x3F;
+            uint32_t const b = packed & 0x1F;
+            pColor[0] = (r << 3) | (r >> 2);
+            pColor[1] = (g << 2) | (g >> 4);
+            pColor[2] = (b << 3) | (b >> 2);
+        }
+
+        /// @brief BC1 palette, 4 color mode when c0 > c1 (or forced as in BC3), else 3 colors plus transparent black.
+        static void colorPalette(uint16_t c0, uint16_t c1, bool forceFourColor, uint32_t (&palette)[4][4])
+        {
+            unpackRgb565(c0, palette[0]);
+            unpackRgb565(c1, palette[1]);
+            bool const fourColor = forceFourColor || c0 > c1;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                uint32_t const a = palette[0][channel];
+                uint32_t const b = palette[1][channel];
+                palette[2][channel] = fourColor ? (2 * a + b + 1) / 3 : (a + b + 1) / 2;
+                palette[3][channel] = fourColor ? (a + 2 * b + 1) / 3 : 0;
+            }
+
+            palette[0][3] = 255;
+            palette[1][3] = 255;
+            palette[2][3] = 255;
+            palette[3][3] = fourColor ? 255 : 0;
+        }
+
+        static void encodeColorBlock(BlockTexels const& block, uint8_t* pBlock)
+        {
+            constexpr float IndexWeights[4] = { 0.0F, 1.0F, 1.0F / 3.0F, 2.0F / 3.0F };
+
+            Endpoint e0{};
+            Endpoint e1{};
+            principalEndpoints(block, 3, e0, e1);
+
+            float bestError = std::numeric_limits<float>::max();
+            uint16_t bestC0 = 0;
+            uint16_t bestC1 = 0;
+            uint32_t bestIndices = 0;
+            for (int iteration = 0; iteration <= RefineIterations; iteration++)
+            {
+                // Keep c0 > c1 so the block stays in 4 color mode, equal endpoints only ever use index 0
+                uint16_t c0 = packRgb565(e0);
+                uint16_t c1 = packRgb565(e1);
+                if (c0 < c1) {
+                    std::swap(c0, c1);
+                }
+
+                uint32_t palette[4][4];
+                colorPalette(c0, c1, true, palette);
+
+                float error = 0.0F;
+                uint32_t indices = 0;
+                float weights[BlockTexelCount];
+                for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                {
+                    uint32_t bestIndex = 0;
+                    float bestDistance = std::numeric_limits<float>::max();
+                    for (uint32_t index = 0; index < (c0 == c1 ? 1U : 4U); index++)
+                    {
+                        float const entry[3] = { static_cast<float>(palette[index][0]), static_cast<float>(palette[index][1]), static_cast<float>(palette[index][2]) };
+                        float const distance = distanceSquared(block.texels[texelIdx], entry, 3);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = index;
+                        }
+                    }
+
+                    error += bestDistance;
+                    indices |= bestIndex << (texelIdx * 2);
+                    weights[texelIdx] = IndexWeights[bestIndex];
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestC0 = c0;
+                    bestC1 = c1;
+                    bestIndices = indices;
+                }
+
+                if (c0 == c1 || !fitEndpoints(block, weights, 3, e0, e1)) {
+                    break;
+                }
+            }
+
+            pBlock[0] = static_cast<uint8_t>(bestC0 & 0xFF);
+            pBlock[1] = static_cast<uint8_t>(bestC0 >> 8);
+            pBlock[2] = static_cast<uint8_t>(bestC1 & 0xFF);
+            pBlock[3] = static_cast<uint8_t>(bestC1 >> 8);
+            for (int byte = 0; byte < 4; byte++) {
+                pBlock[4 + byte] = static_cast<uint8_t>(bestIndices >> (byte * 8));
+            }
+        }
+
+        static void decodeColorBlock(uint8_t const* pBlock, bool forceFourColor, uint8_t* pTexels)
+        {
+            uint16_t const c0 = static_cast<uint16_t>(pBlock[0] | (pBlock[1] << 8));
+            uint16_t const c1 = static_cast<uint16_t>(pBlock[2] | (pBlock[3] << 8));
+            uint32_t const indices = static_cast<uint32_t>(pBlock[4]) | (static_cast<uint32_t>(pBlock[5]) << 8) | (static_cast<uint32_t>(pBlock[6]) << 16) | (static_cast<uint32_t>(pBlock[7]) << 24);
+
+            uint32_t palette[4][4];
+            colorPalette(c0, c1, forceFourColor, palette);
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                uint32_t const index = (indices >> (texelIdx * 2)) & 0x3;
+                for (int channel = 0; channel < 4; channel++) {
+                    pTexels[texelIdx * 4 + channel] = static_cast<uint8_t>(palette[index][channel]);
+                }
+            }
+        }
+
+        /// @brief BC4 palette, 8 interpolated values when a0 > a1, else 6 values plus explicit 0 & 255.
+        static void alphaPalette(uint32_t a0, uint32_t a1, uint32_t (&palette)[8])
+        {
+            palette[0] = a0;
+            palette[1] = a1;
+            if (a0 > a1)
+            {
+                for (uint32_t index = 2; index < 8; index++) {
+                    palette[index] = ((8 - index) * a0 + (index - 1) * a1 + 3) / 7;
+                }
+            }
+            else
+            {
+                for (uint32_t index = 2; index < 6; index++) {
+                    palette[index] = ((6 - index) * a0 + (index - 1) * a1 + 2) / 5;
+                }
+
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+        }
+
+        /// @brief Single channel BC4 block, tries the 8 value mode over the full range & the 6 value mode over the range
+        /// without 0 & 255, keeping the one with less error.
+        static void encodeAlphaBlock(uint8_t const* pValues, uint8_t* pBlock)
+        {
+            uint32_t minimum = 255;
+            uint32_t maximum = 0;
+            uint32_t innerMinimum = 255;
+            uint32_t innerMaximum = 0;
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                uint32_t const value = pValues[texelIdx];
+                minimum = std::min(minimum, value);
+                maximum = std::max(maximum, value);
+                if (value != 0 && value != 255)
+                {
+                    innerMinimum = std::min(innerMinimum, value);
+                    innerMaximum = std::max(innerMaximum, value);
+                }
+            }
+
+            if (innerMinimum > innerMaximum) { //< only 0 & 255 in the block
+                innerMinimum = innerMaximum = 0;
+            }
+
+            uint32_t const candidates[2][2] = { { maximum, minimum }, { innerMinimum, innerMaximum } };
+            uint32_t bestError = std::numeric_limits<uint32_t>::max();
+            for (auto const& candidate : candidates)
+            {
+                uint32_t palette[8];
+                alphaPalette(candidate[0], candidate[1], palette);
+
+                uint32_t error = 0;
+                uint64_t indices = 0;
+                for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                {
+                    uint32_t bestIndex = 0;
+                    uint32_t bestDistance = std::numeric_limits<uint32_t>::max();
+                    for (uint32_t index = 0; index < 8; index++)
+                    {
+                        int32_t const difference = static_cast<int32_t>(palette[index]) - static_cast<int32_t>(pValues[texelIdx]);
+                        uint32_t const distance = static_cast<uint32_t>(difference * difference);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = index;
+                        }
+                    }
+
+                    error += bestDistance;
+                    indices |= static_cast<uint64_t>(bestIndex) << (texelIdx * 3);
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBlock[0] = static_cast<uint8_t>(candidate[0]);
+                    pBlock[1] = static_cast<uint8_t>(candidate[1]);
+                    for (int byte = 0; byte < 6; byte++) {
+                        pBlock[2 + byte] = static_cast<uint8_t>(indices >> (byte * 8));
+                    }
+                }
+            }
+        }
+
+        static void decodeAlphaBlock(uint8_t const* pBlock, uint8_t* pValues, size_t stride)
+        {
+            uint32_t palette[8];
+            alphaPalette(pBlock[0], pBlock[1], palette);
+
+            uint64_t indices = 0;
+            for (int byte = 0; byte < 6; byte++) {
+                indices |= static_cast<uint64_t>(pBlock[2 + byte]) << (byte * 8);
+            }
+
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++) {
+                pValues[texelIdx * stride] = static_cast<uint8_t>(palette[(indices >> (texelIdx * 3)) & 0x7]);
+            }
+        }
+
+        /// @brief Nearest 7-bit endpoint & shared p-bit, the p-bit becomes the low bit of all four 8-bit channels.
+        static void quantizeBc7Endpoint(Endpoint const& endpoint, uint32_t (&quantized)[4], uint32_t& pBit)
+        {
+            float bestError = std::numeric_limits<float>::max();
+            for (uint32_t bit = 0; bit < 2; bit++)
+            {
+                uint32_t candidate[4];
+                float error = 0.0F;
+                for (int channel = 0; channel < 4; channel++)
+                {
+                    long const value = std::lround((endpoint.channels[channel] - static_cast<float>(bit)) * 0.5F);
+                    candidate[channel] = static_cast<uint32_t>(std::min(std::max(value, 0L), 127L));
+                    float const reconstructed = static_cast<float>((candidate[channel] << 1) | bit);
+                    error += (reconstructed - endpoint.channels[channel]) * (reconstructed - endpoint.channels[channel]);
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBit = bit;
+                    std::copy(candidate, candidate + 4, quantized);
+                }
+            }
+        }
+
+        static void bc7Palette(uint32_t const (&e0)[4], uint32_t const (&e1)[4], uint32_t (&palette)[16][4])
+        {
+            for (uint32_t index = 0; index < 16; index++)
+            {
+                for (int channel = 0; channel < 4; channel++) {
+                    palette[index][channel] = ((64 - Bc7Weights[index]) * e0[channel] + Bc7Weights[index] * e1[channel] + 32) >> 6;
+                }
+            }
+        }
+
+        /// @brief BC7 mode 6 only, one RGBA subset with 16 interpolation steps. Quality is close to the partitioned modes on
+        /// smooth content at a fraction of the search cost.
+        static void encodeBc7Block(BlockTexels const& block, uint8_t* pBlock)
+        {
+            Endpoint e0{};
+            Endpoint e1{};
+            principalEndpoints(block, 4, e0, e1);
+
+            float bestError = std::numeric_limits<float>::max();
+            uint32_t bestEndpoints[2][4] = {};
+            uint32_t bestPBits[2] = {};
+            uint32_t bestIndices[BlockTexelCount] = {};
+            for (int iteration = 0; iteration <= RefineIterations; iteration++)
+            {
+                uint32_t quantized[2][4];
+                uint32_t pBits[2];
+                quantizeBc7Endpoint(e0, quantized[0], pBits[0]);
+                quantizeBc7Endpoint(e1, quantized[1], pBits[1]);
+
+                uint32_t expanded[2][4];
+                for (int endpoint = 0; endpoint < 2; endpoint++)
+                {
+                    for (int channel = 0; channel < 4; channel++) {
+                        expanded[endpoint][channel] = (quantized[endpoint][channel] << 1) | pBits[endpoint];
+                    }
+                }
+
+                uint32_t palette[16][4];
+                bc7Palette(expanded[0], expanded[1], palette);
+
+                float error = 0.0F;
+                uint32_t indices[BlockTexelCount];
+                float weights[BlockTexelCount];
+                for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                {
+                    uint32_t bestIndex = 0;
+                    float bestDistance = std::numeric_limits<float>::max();
+                    for (uint32_t index = 0; index < 16; index++)
+                    {
+                        float const entry[4] = {
+                            static_cast<float>(palette[index][0]), static_cast<float>(palette[index][1]),
+                            static_cast<float>(palette[index][2]), static_cast<float>(palette[index][3]),
+                        };
+                        float const distance = distanceSquared(block.texels[texelIdx], entry, 4);
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = index;
+                        }
+                    }
+
+                    error += bestDistance;
+                    indices[texelIdx] = bestIndex;
+                    weights[texelIdx] = static_cast<float>(Bc7Weights[bestIndex]) / 64.0F;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    std::copy(&quantized[0][0], &quantized[0][0] + 8, &bestEndpoints[0][0]);
+                    std::copy(pBits, pBits + 2, bestPBits);
+                    std::copy(indices, indices + BlockTexelCount, bestIndices);
+                }
+
+                if (!fitEndpoints(block, weights, 4, e0, e1)) {
+                    break;
+                }
+            }
+
+            // The anchor texel's index MSB is implicit zero, flip the endpoints if it's set
+            if (bestIndices[0] >= 8)
+            {
+                std::swap(bestEndpoints[0], bestEndpoints[1]);
+                std::swap(bestPBits[0], bestPBits[1]);
+                for (auto& index : bestIndices) {
+                    index = 15 - index;
+                }
+            }
+
+            std::memset(pBlock, 0, 16);
+            BitWriter writer{ pBlock };
+            writer.write(Bc7Mode6, 7);
+            for (int channel = 0; channel < 4; channel++)
+            {
+                writer.write(bestEndpoints[0][channel], 7);
+                writer.write(bestEndpoints[1][channel], 7);
+            }
+
+            writer.write(bestPBits[0], 1);
+            writer.write(bestPBits[1], 1);
+            writer.write(bestIndices[0], 3);
+            for (uint32_t texelIdx = 1; texelIdx < BlockTexelCount; texelIdx++) {
+                writer.write(bestIndices[texelIdx], 4);
+            }
+        }
+
+        static bool decodeBc7Block(uint8_t const* pBlock, uint8_t* pTexels)
+        {
+            if ((pBlock[0] & 0x7F) != Bc7Mode6)
+            {
+                std::memset(pTexels, 0, BlockTexelCount * 4);
+                return false;
+            }
+
+            BitReader reader{ pBlock };
+            reader.read(7);
+
+            uint32_t endpoints[2][4];
+            for (int channel = 0; channel < 4; channel++)
+            {
+                endpoints[0][channel] = reader.read(7) << 1;
+                endpoints[1][channel] = reader.read(7) << 1;
+            }
+
+            uint32_t const pBit0 = reader.read(1);
+            uint32_t const pBit1 = reader.read(1);
+            for (int channel = 0; channel < 4; channel++)
+            {
+                endpoints[0][channel] |= pBit0;
+                endpoints[1][channel] |= pBit1;
+            }
+
+            uint32_t palette[16][4];
+            bc7Palette(endpoints[0], endpoints[1], palette);
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                uint32_t const index = reader.read(texelIdx == 0 ? 3 : 4);
+                for (int channel = 0; channel < 4; channel++) {
+                    pTexels[texelIdx * 4 + channel] = static_cast<uint8_t>(palette[index][channel]);
+                }
+            }
+
+            return true;
+        }
+
+        uint32_t blockSize(TextureFormat format)
+        {
+            switch (format)
+            {
+            case TextureFormat::BC1: return 8;
+            case TextureFormat::BC3: return 16;
+            case TextureFormat::BC4: return 8;
+            case TextureFormat::BC5: return 16;
+            case TextureFormat::BC7: return 16;
+            default: return 0;
+            }
+        }
+
+        size_t rowPitch(TextureFormat format, uint32_t width)
+        {
+            if (format == TextureFormat::RGBA8) {
+                return static_cast<size_t>(width) * 4;
+            }
+
+            return static_cast<size_t>((width + BlockDimension - 1) / BlockDimension) * blockSize(format);
+        }
+
+        uint32_t rowCount(TextureFormat format, uint32_t height)
+        {
+            return (format == TextureFormat::RGBA8) ? height : (height + BlockDimension - 1) / BlockDimension;
+        }
+
+        TextureFormat defaultFormat(TextureType type, uint32_t channelCount)
+        {
+            if (type == TextureType::Normal) {
+                return TextureFormat::BC5;
+            }
+
+            return (type == TextureType::Linear && channelCount == 1) ? TextureFormat::BC4 : TextureFormat::BC7;
+        }
+
+        void encodeBlock(TextureFormat format, uint8_t const* pTexels, uint8_t* pBlock)
+        {
+            BlockTexels block{};
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                for (int channel = 0; channel < 4; channel++) {
+                    block.texels[texelIdx][channel] = static_cast<float>(pTexels[texelIdx * 4 + channel]);
+                }
+            }
+
+            uint8_t channelValues[2][BlockTexelCount];
+            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+            {
+                channelValues[0][texelIdx] = pTexels[texelIdx * 4 + (format == TextureFormat::BC3 ? 3 : 0)];
+                channelValues[1][texelIdx] = pTexels[texelIdx * 4 + 1];
+            }
+
+            switch (format)
+            {
+            case TextureFormat::BC1:
+                encodeColorBlock(block, pBlock);
+                break;
+            case TextureFormat::BC3:
+                encodeAlphaBlock(channelValues[0], pBlock);
+                encodeColorBlock(block, pBlock + 8);
+                break;
+            case TextureFormat::BC4:
+                encodeAlphaBlock(channelValues[0], pBlock);
+                break;
+            case TextureFormat::BC5:
+                encodeAlphaBlock(channelValues[0], pBlock);
+                encodeAlphaBlock(channelValues[1], pBlock + 8);
+                break;
+            case TextureFormat::BC7:
+                encodeBc7Block(block, pBlock);
+                break;
+            default:
+                assert(false && "Not a block compressed format");
+                break;
+            }
+        }
+
+        bool decodeBlock(TextureFormat format, uint8_t const* pBlock, uint8_t* pTexels)
+        {
+            switch (format)
+            {
+            case TextureFormat::BC1:
+                decodeColorBlock(pBlock, false, pTexels);
+                return true;
+            case TextureFormat::BC3:
+                decodeColorBlock(pBlock + 8, true, pTexels);
+                decodeAlphaBlock(pBlock, pTexels + 3, 4);
+                return true;
+            case TextureFormat::BC4:
+            case TextureFormat::BC5:
+                for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                {
+                    pTexels[texelIdx * 4 + 1] = 0;
+                    pTexels[texelIdx * 4 + 2] = 0;
+                    pTexels[texelIdx * 4 + 3] = 255;
+                }
+
+                if (format == TextureFormat::BC4)
+                {
+                    decodeAlphaBlock(pBlock, pTexels + 0, 4);
+                    return true;
+                }
+
+                decodeAlphaBlock(pBlock, pTexels + 0, 4);
+                decodeAlphaBlock(pBlock + 8, pTexels + 1, 4);
+                return true;
+            case TextureFormat::BC7:
+                return decodeBc7Block(pBlock, pTexels);
+            default:
+                assert(false && "Not a block compressed format");
+                return false;
+            }
+        }
+
+        bool compress(TextureData& texture, TextureFormat format)
+        {
+            assert(texture.format == TextureFormat::RGBA8 && format != TextureFormat::RGBA8);
+            assert(!texture.levels.empty());
+            if (texture.levels[0].width % BlockDimension != 0 || texture.levels[0].height % BlockDimension != 0) {
+                return false;
+            }
+
+            uint32_t const size = blockSize(format);
+            for (auto& level : texture.levels)
+            {
+                uint32_t const blocksWide = (level.width + BlockDimension - 1) / BlockDimension;
+                uint32_t const blocksHigh = (level.height + BlockDimension - 1) / BlockDimension;
+                std::vector<uint8_t> blocks(static_cast<size_t>(blocksWide) * blocksHigh * size);
+
+                JobSystem::parallelForCurrent(blocksHigh, BlockRowGrainSize, [&](size_t blockRowBegin, size_t blockRowEnd)
+                {
+                    uint8_t texels[BlockTexelCount * 4];
+                    for (size_t blockY = blockRowBegin; blockY < blockRowEnd; blockY++)
+                    {
+                        for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+                        {
+                            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                            {
+                                size_t const x = std::min<size_t>(blockX * BlockDimension + texelIdx % BlockDimension, level.width - 1);
+                                size_t const y = std::min<size_t>(blockY * BlockDimension + texelIdx / BlockDimension, level.height - 1);
+                                std::memcpy(&texels[texelIdx * 4], &level.data[(y * level.width + x) * 4], 4);
+                            }
+
+                            encodeBlock(format, texels, &blocks[(blockY * blocksWide + blockX) * size]);
+                        }
+                    }
+                });
+
+                level.data = std::move(blocks);
+            }
+
+            texture.format = format;
+            return true;
+        }
+
+        bool decompress(TextureData const& texture, TextureData& decoded)
+        {
+            assert(texture.format != TextureFormat::RGBA8);
+
+            decoded.type = texture.type;
+            decoded.format = TextureFormat::RGBA8;
+            decoded.levels.resize(texture.levels.size());
+
+            std::atomic<bool> success{ true };
+            uint32_t const size = blockSize(texture.format);
+            for (size_t levelIdx = 0; levelIdx < texture.levels.size(); levelIdx++)
+            {
+                TextureLevel const& level = texture.levels[levelIdx];
+                TextureLevel& decodedLevel = decoded.levels[levelIdx];
+                decodedLevel.width = level.width;
+                decodedLevel.height = level.height;
+                decodedLevel.data.resize(static_cast<size_t>(level.width) * level.height * 4);
+
+                uint32_t const blocksWide = (level.width + BlockDimension - 1) / BlockDimension;
+                uint32_t const blocksHigh = (level.height + BlockDimension - 1) / BlockDimension;
+                JobSystem::parallelForCurrent(blocksHigh, BlockRowGrainSize, [&](size_t blockRowBegin, size_t blockRowEnd)
+                {
+                    uint8_t texels[BlockTexelCount * 4];
+                    for (size_t blockY = blockRowBegin; blockY < blockRowEnd; blockY++)
+                    {
+                        for (uint32_t blockX = 0; blockX < blocksWide; blockX++)
+                        {
+                            if (!decodeBlock(texture.format, &level.data[(blockY * blocksWide + blockX) * size], texels)) {
+                                success = false;
+                            }
+
+                            for (uint32_t texelIdx = 0; texelIdx < BlockTexelCount; texelIdx++)
+                            {
+                                size_t const x = blockX * BlockDimension + texelIdx % BlockDimension;
+                                size_t const y = blockY * BlockDimension + texelIdx / BlockDimension;
+                                if (x < level.width && y < level.height) {
+                                    std::memcpy(&decodedLevel.data[(y * level.width + x) * 4], &texels[texelIdx * 4], 4);
+                                }
+                            }
+                        }
+                    }
+                });
+            }
+
+            return success;
+        }
+
+        double psnr(TextureLevel const& reference, TextureLevel const& decoded, uint32_t channelCount)
+        {
+            assert(reference.width == decoded.width && reference.height == decoded.height);
+            assert(channelCount > 0 && channelCount <= 4);
+
+            double squaredError = 0.0;
+            for (size_t idx = 0; idx < reference.data.size(); idx += 4)
+            {
+                for (uint32_t channel = 0; channel < channelCount; channel++)
+                {
+                    double const difference = static_cast<double>(reference.data[idx + channel]) - static_cast<double>(decoded.data[idx + channel]);
+                    squaredError += difference * difference;
+                }
+            }
+
+            double const meanSquaredError = squaredError / (static_cast<double>(reference.data.size() / 4) * channelCount);
+            if (meanSquaredError <= 0.0) {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+        }
+
+        char const* formatName(TextureFormat format)
+        {
+            switch (format)
+            {
+            case TextureFormat::RGBA8: return "RGBA8";
+            case TextureFormat::BC1: return "BC1";
+            case TextureFormat::BC3: return "BC3";
+            case TextureFormat::BC4: return "BC4";
+            case TextureFormat::BC5: return "BC5";
+            case TextureFormat::BC7: return "BC7";
+            default: return "Unknown";
+            }
+        }
+
+        bool parseFormat(char const* name, TextureFormat& format)
+        {
+            constexpr TextureFormat Formats[] = { TextureFormat::RGBA8, TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC4, TextureFormat::BC5, TextureFormat::BC7 };
+            for (TextureFormat candidate : Formats)
+            {
+                char const* candidateName = formatName(candidate);
+                size_t charIdx = 0;
+                while (name[charIdx] != '\0' && std::tolower(static_cast<unsigned char>(candidateName[charIdx])) == name[charIdx]) {
+                    charIdx++;
+                }
+
+                if (name[charIdx] == '\0' && candidateName[charIdx] == '\0')
+                {
+                    format = candidate;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+    } // namespace BlockCompression
+} // namespace Engine
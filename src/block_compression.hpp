@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace BlockCompression
+    {
+        constexpr uint32_t BlockDimension = 4;
+        constexpr uint32_t BlockTexelCount = BlockDimension * BlockDimension;
+
+        /// @brief Bytes per 4x4 block, 0 for uncompressed formats.
+        uint32_t blockSize(TextureFormat format);
+
+        /// @brief Bytes per row of texels (RGBA8) or per row of blocks (BC).
+        size_t rowPitch(TextureFormat format, uint32_t width);
+
+        /// @brief Number of texel rows (RGBA8) or block rows (BC) in a level.
+        uint32_t rowCount(TextureFormat format, uint32_t height);
+
+        /// @brief Compressed format matching a texture type & source channel count, BC5 for normal map XY, BC4 for single channel
+        /// linear data, BC7 otherwise.
+        TextureFormat defaultFormat(TextureType type, uint32_t channelCount = 4);
+
+        /// @brief Encode 16 RGBA8 texels in row major order into one block.
+        void encodeBlock(TextureFormat format, uint8_t const* pTexels, uint8_t* pBlock);
+
+        /// @brief Decode one block into 16 RGBA8 texels. Channels missing from the format read as the GPU would (0, alpha 255).
+        /// Only BC7 mode 6 is decoded, the mode written by the encoder, other modes return false.
+        bool decodeBlock(TextureFormat format, uint8_t const* pBlock, uint8_t* pTexels);
+
+        /// @brief Compress all levels of an RGBA8 texture in place, blocks are encoded in parallel. Edge blocks of levels smaller
+        /// than a block replicate the last texel. Returns false & leaves the texture as is if level 0 isn't a multiple of 4.
+        bool compress(TextureData& texture, TextureFormat format);
+
+        /// @brief Decode all levels of a block compressed texture into RGBA8.
+        bool decompress(TextureData const& texture, TextureData& decoded);
+
+        /// @brief Peak signal to noise ratio in dB over the first channelCount channels of two RGBA8 levels, infinity if equal.
+        double psnr(TextureLevel const& reference, TextureLevel const& decoded, uint32_t channelCount);
+
+        char const* formatName(TextureFormat format);
+
+        /// @brief Parse a lower case format name as printed by formatName, returns false if unknown.
+        bool parseFormat(char const* name, TextureFormat& format);
+    } // namespace BlockCompression
+} // namespace Engine
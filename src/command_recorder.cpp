@@ -0,0 +1,94 @@
+#include "command_recorder.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Engine
+{
+    void CommandRecorder::beginFrame(uint32_t frameIdx)
+    {
+        assert(frameIdx < m_poolSizes.size());
+        m_frameIndex = frameIdx;
+        m_statistics.listCount = 0;
+        m_statistics.chunkCount = 0;
+    }
+
+    uint32_t CommandRecorder::acquireList()
+    {
+        // Lists are acquired in pool order, so the acquisition index is the pool index
+        uint32_t const listIdx = m_statistics.listCount;
+        if (listIdx < m_poolSizes[m_frameIndex])
+        {
+            if (!m_backend.resetList(m_frameIndex, listIdx)) {
+                return InvalidList;
+            }
+        }
+        else
+        {
+            if (!m_backend.createList(m_frameIndex, listIdx)) {
+                return InvalidList;
+            }
+
+            m_poolSizes[m_frameIndex]++;
+            m_statistics.createdCount++;
+        }
+
+        m_statistics.listCount++;
+        return listIdx;
+    }
+
+    bool CommandRecorder::recordParallel(JobSystem& jobs, uint32_t drawCount, uint32_t minDrawsPerChunk, RecordChunk const& record)
+    {
+        std::vector<DrawChunk> const chunks = splitDraws(drawCount, jobs.threadCount(), minDrawsPerChunk);
+        uint32_t const firstListIdx = m_statistics.listCount;
+        for (size_t chunkIdx = 0; chunkIdx < chunks.size(); chunkIdx++)
+        {
+            if (acquireList() == InvalidList) {
+                return false;
+            }
+        }
+
+        jobs.parallelFor(chunks.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t chunkIdx = begin; chunkIdx < end; chunkIdx++) {
+                record(firstListIdx + static_cast<uint32_t>(chunkIdx), chunks[chunkIdx]);
+            }
+        });
+
+        m_statistics.chunkCount += static_cast<uint32_t>(chunks.size());
+        return true;
+    }
+
+    bool CommandRecorder::submit()
+    {
+        bool success = true;
+        for (uint32_t listIdx = 0; listIdx < m_statistics.listCount; listIdx++) {
+            success = m_backend.closeList(m_frameIndex, listIdx) && success;
+        }
+
+        if (success && m_statistics.listCount > 0) {
+            m_backend.executeLists(m_frameIndex, m_statistics.listCount);
+        }
+
+        return success;
+    }
+
+    std::vector<DrawChunk> CommandRecorder::splitDraws(uint32_t drawCount, uint32_t maxChunkCount, uint32_t minDrawsPerChunk)
+    {
+        std::vector<DrawChunk> chunks;
+        if (drawCount == 0) {
+            return chunks;
+        }
+
+        uint32_t const chunkCount = std::max(1U, std::min(maxChunkCount, drawCount / std::max(1U, minDrawsPerChunk)));
+        chunks.reserve(chunkCount);
+        for (uint32_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+        {
+            uint32_t const firstDraw = static_cast<uint32_t>((static_cast<uint64_t>(drawCount) * chunkIdx) / chunkCount);
+            uint32_t const endDraw = static_cast<uint32_t>((static_cast<uint64_t>(drawCount) * (chunkIdx + 1)) / chunkCount);
+            chunks.push_back(DrawChunk{ firstDraw, endDraw - firstDraw });
+        }
+
+        return chunks;
+    }
+} // namespace Engine
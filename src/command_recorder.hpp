@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    /// @brief Contiguous range of a sorted draw list, recorded into one command list.
+    struct DrawChunk
+    {
+        uint32_t firstDraw;
+        uint32_t drawCount;
+    };
+
+    /// @brief Command list operations of the renderer, stubbed by a recording mock in tests. Lists are addressed by frame slot
+    /// & pool index, each list has its own allocator.
+    struct CommandListBackend
+    {
+        std::function<bool(uint32_t frameIdx, uint32_t listIdx)> createList;   //< create the allocator & an open list
+        std::function<bool(uint32_t frameIdx, uint32_t listIdx)> resetList;    //< reset the allocator & reopen the list
+        std::function<bool(uint32_t frameIdx, uint32_t listIdx)> closeList;
+        std::function<void(uint32_t frameIdx, uint32_t listCount)> executeLists; //< lists 0 to listCount - 1 in one submit
+    };
+
+    /// @brief Pools of command lists per frame slot. The lists acquired in a frame are submitted in acquisition order & reset
+    /// when the slot comes around again, so an allocator is only reset after its GPU work completed. Chunks recorded in parallel
+    /// get a list each, so no allocator is ever used by two threads.
+    class CommandRecorder
+    {
+    public:
+        static constexpr uint32_t InvalidList = UINT32_MAX;
+
+        using RecordChunk = std::function<void(uint32_t listIdx, DrawChunk const& chunk)>;
+
+        struct Statistics
+        {
+            uint32_t listCount;     //< acquired by the current frame
+            uint32_t chunkCount;    //< recorded in parallel by the current frame
+            uint32_t createdCount;  //< lists created over all frame slots
+        };
+
+        explicit CommandRecorder(uint32_t frameCount) : m_poolSizes(frameCount, 0) {}
+
+        void setBackend(CommandListBackend backend) { m_backend = std::move(backend); }
+
+        /// @brief Start recording into the frame slot, its previous frame must have completed.
+        void beginFrame(uint32_t frameIdx);
+
+        /// @brief Open the frame's next list, reusing the slot's lists before creating new ones. Returns InvalidList on failure.
+        /// Not thread safe, lists for parallel recording are acquired up front.
+        uint32_t acquireList();
+
+        /// @brief Split the draws into chunks, one per worker at most, & record each into its own list on the job system. The
+        /// lists follow the ones acquired before in submission order. Returns false if a list couldn't be opened.
+        bool recordParallel(JobSystem& jobs, uint32_t drawCount, uint32_t minDrawsPerChunk, RecordChunk const& record);
+
+        /// @brief Close the frame's lists & execute them in acquisition order with a single submit.
+        bool submit();
+
+        /// @brief Split [0, drawCount) into at most maxChunkCount contiguous chunks of at least minDrawsPerChunk draws, in
+        /// order. Chunk sizes differ by at most one draw.
+        static std::vector<DrawChunk> splitDraws(uint32_t drawCount, uint32_t maxChunkCount, uint32_t minDrawsPerChunk);
+
+        uint32_t frameIndex() const { return m_frameIndex; }
+
+        uint32_t poolSize(uint32_t frameIdx) const { return m_poolSizes[frameIdx]; }
+
+        Statistics const& statistics() const { return m_statistics; }
+
+    private:
+        CommandListBackend m_backend;
+        std::vector<uint32_t> m_poolSizes; //< created lists per frame slot
+        uint32_t m_frameIndex = 0;
+        Statistics m_statistics{};
+    };
+} // namespace Engine
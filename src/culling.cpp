@@ -0,0 +1,229 @@
+#include "culling.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__AVX__)
+#define CULLING_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__)
+#define CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Engine
+{
+    namespace Culling
+    {
+        static glm::vec4 normalizePlane(glm::vec4 const& plane)
+        {
+            float const length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+            return (length > 0.0F) ? plane / length : plane;
+        }
+
+        Frustum extractFrustum(glm::mat4 const& viewproject)
+        {
+            // glm is column major, rows are gathered across columns
+            glm::vec4 const row0 = glm::vec4(viewproject[0][0], viewproject[1][0], viewproject[2][0], viewproject[3][0]);
+            glm::vec4 const row1 = glm::vec4(viewproject[0][1], viewproject[1][1], viewproject[2][1], viewproject[3][1]);
+            glm::vec4 const row2 = glm::vec4(viewproject[0][2], viewproject[1][2], viewproject[2][2], viewproject[3][2]);
+            glm::vec4 const row3 = glm::vec4(viewproject[0][3], viewproject[1][3], viewproject[2][3], viewproject[3][3]);
+
+            Frustum frustum{};
+            frustum.planes[0] = normalizePlane(row3 + row0); //< left
+            frustum.planes[1] = normalizePlane(row3 - row0); //< right
+            frustum.planes[2] = normalizePlane(row3 + row1); //< bottom
+            frustum.planes[3] = normalizePlane(row3 - row1); //< top
+            frustum.planes[4] = normalizePlane(row2);        //< near, depth range is [0, 1]
+            frustum.planes[5] = normalizePlane(row3 - row2); //< far
+            return frustum;
+        }
+
+        Frustum extractFrustum(Camera const& camera)
+        {
+            return extractFrustum(camera.matrix());
+        }
+
+        Frustum transformFrustum(Frustum const& frustum, glm::mat4 const& model)
+        {
+            glm::mat4 const planeTransform = glm::transpose(model);
+
+            Frustum result{};
+            for (int planeIdx = 0; planeIdx < 6; planeIdx++) {
+                result.planes[planeIdx] = normalizePlane(planeTransform * frustum.planes[planeIdx]);
+            }
+
+            return result;
+        }
+
+        bool testSphere(Frustum const& frustum, glm::vec3 const& center, float radius)
+        {
+            for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+            {
+                glm::vec4 const& plane = frustum.planes[planeIdx];
+                if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool testAABB(Frustum const& frustum, glm::vec3 const& aabbMin, glm::vec3 const& aabbMax)
+        {
+            for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+            {
+                // Test the box corner furthest along the plane normal
+                glm::vec4 const& plane = frustum.planes[planeIdx];
+                glm::vec3 const positiveVertex = glm::vec3(
+                    plane.x >= 0.0F ? aabbMax.x : aabbMin.x,
+                    plane.y >= 0.0F ? aabbMax.y : aabbMin.y,
+                    plane.z >= 0.0F ? aabbMax.z : aabbMin.z
+                );
+
+                if (plane.x * positiveVertex.x + plane.y * positiveVertex.y + plane.z * positiveVertex.z + plane.w < 0.0F) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        MeshBounds computeBounds(Vertex const* pVertices, size_t vertexCount)
+        {
+            MeshBounds bounds{ glm::vec3(0.0F), glm::vec3(0.0F), glm::vec3(0.0F), 0.0F };
+            if (vertexCount == 0) {
+                return bounds;
+            }
+
+            bounds.aabbMin = pVertices[0].position;
+            bounds.aabbMax = pVertices[0].position;
+            for (size_t vertexIdx = 1; vertexIdx < vertexCount; vertexIdx++)
+            {
+                bounds.aabbMin = glm::min(bounds.aabbMin, pVertices[vertexIdx].position);
+                bounds.aabbMax = glm::max(bounds.aabbMax, pVertices[vertexIdx].position);
+            }
+
+            // Centered on the box, tighter than its half diagonal for rounded meshes
+            bounds.sphereCenter = (bounds.aabbMin + bounds.aabbMax) * 0.5F;
+            float maxDistanceSquared = 0.0F;
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++)
+            {
+                glm::vec3 const offset = pVertices[vertexIdx].position - bounds.sphereCenter;
+                maxDistanceSquared = std::max(maxDistanceSquared, glm::dot(offset, offset));
+            }
+
+            bounds.sphereRadius = std::sqrt(maxDistanceSquared);
+            return bounds;
+        }
+
+        size_t cullSpheres(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* pVisible)
+        {
+            assert(begin <= end && end <= spheres.size());
+            size_t visibleCount = 0;
+            size_t idx = begin;
+
+            // A sphere is culled once its center lies further than its radius behind any plane, the same sums as testSphere
+            // so both agree exactly. Indices are stored unconditionally & the count only advances for visible spheres.
+#if defined(CULLING_AVX)
+            __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+            for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+            {
+                planeX[planeIdx] = _mm256_set1_ps(frustum.planes[planeIdx].x);
+                planeY[planeIdx] = _mm256_set1_ps(frustum.planes[planeIdx].y);
+                planeZ[planeIdx] = _mm256_set1_ps(frustum.planes[planeIdx].z);
+                planeW[planeIdx] = _mm256_set1_ps(frustum.planes[planeIdx].w);
+            }
+
+            __m256 const signMask = _mm256_set1_ps(-0.0F);
+            for (; idx + BatchSize <= end; idx += BatchSize)
+            {
+                __m256 const centerX = _mm256_loadu_ps(&spheres.centerX[idx]);
+                __m256 const centerY = _mm256_loadu_ps(&spheres.centerY[idx]);
+                __m256 const centerZ = _mm256_loadu_ps(&spheres.centerZ[idx]);
+                __m256 const negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(&spheres.radius[idx]), signMask);
+                __m256 culled = _mm256_setzero_ps();
+                for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+                {
+                    __m256 const distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+                        _mm256_mul_ps(planeX[planeIdx], centerX), _mm256_mul_ps(planeY[planeIdx], centerY)), _mm256_mul_ps(planeZ[planeIdx], centerZ)), planeW[planeIdx]);
+                    culled = _mm256_or_ps(culled, _mm256_cmp_ps(distance, negativeRadius, _CMP_LT_OQ));
+                }
+
+                uint32_t const visibleMask = ~static_cast<uint32_t>(_mm256_movemask_ps(culled));
+                for (uint32_t lane = 0; lane < BatchSize; lane++)
+                {
+                    pVisible[visibleCount] = static_cast<uint32_t>(idx + lane);
+                    visibleCount += (visibleMask >> lane) & 1;
+                }
+            }
+#elif defined(CULLING_SSE)
+            __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+            for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+            {
+                planeX[planeIdx] = _mm_set1_ps(frustum.planes[planeIdx].x);
+                planeY[planeIdx] = _mm_set1_ps(frustum.planes[planeIdx].y);
+                planeZ[planeIdx] = _mm_set1_ps(frustum.planes[planeIdx].z);
+                planeW[planeIdx] = _mm_set1_ps(frustum.planes[planeIdx].w);
+            }
+
+            __m128 const signMask = _mm_set1_ps(-0.0F);
+            for (; idx + BatchSize <= end; idx += BatchSize)
+            {
+                // Two halves of four spheres, interleaved so their plane tests overlap
+                __m128 const centerX0 = _mm_loadu_ps(&spheres.centerX[idx]);
+                __m128 const centerY0 = _mm_loadu_ps(&spheres.centerY[idx]);
+                __m128 const centerZ0 = _mm_loadu_ps(&spheres.centerZ[idx]);
+                __m128 const negativeRadius0 = _mm_xor_ps(_mm_loadu_ps(&spheres.radius[idx]), signMask);
+                __m128 const centerX1 = _mm_loadu_ps(&spheres.centerX[idx + 4]);
+                __m128 const centerY1 = _mm_loadu_ps(&spheres.centerY[idx + 4]);
+                __m128 const centerZ1 = _mm_loadu_ps(&spheres.centerZ[idx + 4]);
+                __m128 const negativeRadius1 = _mm_xor_ps(_mm_loadu_ps(&spheres.radius[idx + 4]), signMask);
+                __m128 culled0 = _mm_setzero_ps();
+                __m128 culled1 = _mm_setzero_ps();
+                for (int planeIdx = 0; planeIdx < 6; planeIdx++)
+                {
+                    __m128 const distance0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(planeX[planeIdx], centerX0), _mm_mul_ps(planeY[planeIdx], centerY0)), _mm_mul_ps(planeZ[planeIdx], centerZ0)), planeW[planeIdx]);
+                    __m128 const distance1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                        _mm_mul_ps(planeX[planeIdx], centerX1), _mm_mul_ps(planeY[planeIdx], centerY1)), _mm_mul_ps(planeZ[planeIdx], centerZ1)), planeW[planeIdx]);
+                    culled0 = _mm_or_ps(culled0, _mm_cmplt_ps(distance0, negativeRadius0));
+                    culled1 = _mm_or_ps(culled1, _mm_cmplt_ps(distance1, negativeRadius1));
+                }
+
+                uint32_t const visibleMask = ~static_cast<uint32_t>(_mm_movemask_ps(culled0) | (_mm_movemask_ps(culled1) << 4));
+                for (uint32_t lane = 0; lane < BatchSize; lane++)
+                {
+                    pVisible[visibleCount] = static_cast<uint32_t>(idx + lane);
+                    visibleCount += (visibleMask >> lane) & 1;
+                }
+            }
+#endif
+
+            for (; idx < end; idx++)
+            {
+                glm::vec3 const center = glm::vec3(spheres.centerX[idx], spheres.centerY[idx], spheres.centerZ[idx]);
+                pVisible[visibleCount] = static_cast<uint32_t>(idx);
+                visibleCount += testSphere(frustum, center, spheres.radius[idx]) ? 1 : 0;
+            }
+
+            return visibleCount;
+        }
+
+        size_t cullSpheresScalar(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* pVisible)
+        {
+            assert(begin <= end && end <= spheres.size());
+            size_t visibleCount = 0;
+            for (size_t idx = begin; idx < end; idx++)
+            {
+                glm::vec3 const center = glm::vec3(spheres.centerX[idx], spheres.centerY[idx], spheres.centerZ[idx]);
+                if (testSphere(frustum, center, spheres.radius[idx])) {
+                    pVisible[visibleCount++] = static_cast<uint32_t>(idx);
+                }
+            }
+
+            return visibleCount;
+        }
+    } // namespace Culling
+} // namespace Engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "math.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+
+namespace Engine
+{
+    /// @brief View frustum planes, normals point inwards and are normalized (xyz normal, w distance).
+    struct Frustum
+    {
+        glm::vec4 planes[6];
+    };
+
+    /// @brief Axis aligned bounding box.
+    struct BoundingBox
+    {
+        glm::vec3 aabbMin;
+        glm::vec3 aabbMax;
+    };
+
+    /// @brief Bounding spheres in structure of arrays layout, so a batch of spheres loads with one vector load per component.
+    struct SphereArray
+    {
+        void resize(size_t count)
+        {
+            centerX.resize(count);
+            centerY.resize(count);
+            centerZ.resize(count);
+            radius.resize(count);
+        }
+
+        size_t size() const { return radius.size(); }
+
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> radius;
+    };
+
+    namespace Culling
+    {
+        constexpr size_t BatchSize = 8; //< spheres tested per iteration, one AVX or two SSE registers
+
+        /// @brief Extract frustum planes from a view projection matrix (Gribb-Hartmann), assumes zero to one depth.
+        Frustum extractFrustum(glm::mat4 const& viewproject);
+
+        /// @brief World space frustum of the camera.
+        Frustum extractFrustum(Camera const& camera);
+
+        /// @brief Transform world space frustum planes into the object space of the given model matrix.
+        Frustum transformFrustum(Frustum const& frustum, glm::mat4 const& model);
+
+        bool testSphere(Frustum const& frustum, glm::vec3 const& center, float radius);
+
+        bool testAABB(Frustum const& frustum, glm::vec3 const& aabbMin, glm::vec3 const& aabbMax);
+
+        /// @brief AABB & bounding sphere around the vertex positions.
+        MeshBounds computeBounds(Vertex const* pVertices, size_t vertexCount);
+
+        /// @brief Write the indices of the spheres in [begin, end) intersecting the frustum to pVisible in ascending order &
+        /// return their count. Batches of BatchSize spheres are tested with SIMD, pVisible must hold end - begin indices.
+        size_t cullSpheres(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* pVisible);
+
+        /// @brief One sphere at a time with testSphere, the reference for cullSpheres.
+        size_t cullSpheresScalar(Frustum const& frustum, SphereArray const& spheres, size_t begin, size_t end, uint32_t* pVisible);
+    } // namespace Culling
+} // namespace Engine
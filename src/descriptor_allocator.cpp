@@ -0,0 +1,114 @@
+#include "descriptor_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+namespace Engine
+{
+    DescriptorFreeList::DescriptorFreeList(uint32_t offset, uint32_t capacity)
+    {
+        m_offset = offset;
+        m_capacity = capacity;
+        m_freeCount = capacity;
+        if (capacity > 0) {
+            m_freeRanges.push_back(Range{ offset, capacity });
+        }
+    }
+
+    uint32_t DescriptorFreeList::allocate(uint32_t count)
+    {
+        if (count == 0) {
+            return InvalidIndex;
+        }
+
+        for (size_t rangeIdx = 0; rangeIdx < m_freeRanges.size(); rangeIdx++)
+        {
+            Range& range = m_freeRanges[rangeIdx];
+            if (range.count < count) {
+                continue;
+            }
+
+            uint32_t const index = range.offset;
+            range.offset += count;
+            range.count -= count;
+            if (range.count == 0) {
+                m_freeRanges.erase(m_freeRanges.begin() + static_cast<ptrdiff_t>(rangeIdx));
+            }
+
+            m_freeCount -= count;
+            return index;
+        }
+
+        return InvalidIndex;
+    }
+
+    void DescriptorFreeList::free(uint32_t index, uint32_t count)
+    {
+        assert(index >= m_offset && index + count <= m_offset + m_capacity);
+        if (count == 0) {
+            return;
+        }
+
+        auto const next = std::lower_bound(m_freeRanges.begin(), m_freeRanges.end(), index, [](Range const& range, uint32_t offset) { return range.offset < offset; });
+        assert(next == m_freeRanges.end() || index + count <= next->offset);
+        assert(next == m_freeRanges.begin() || std::prev(next)->offset + std::prev(next)->count <= index);
+
+        bool const mergePrevious = next != m_freeRanges.begin() && std::prev(next)->offset + std::prev(next)->count == index;
+        bool const mergeNext = next != m_freeRanges.end() && index + count == next->offset;
+        if (mergePrevious && mergeNext)
+        {
+            std::prev(next)->count += count + next->count;
+            m_freeRanges.erase(next);
+        }
+        else if (mergePrevious) {
+            std::prev(next)->count += count;
+        }
+        else if (mergeNext)
+        {
+            next->offset = index;
+            next->count += count;
+        }
+        else {
+            m_freeRanges.insert(next, Range{ index, count });
+        }
+
+        m_freeCount += count;
+    }
+
+    uint32_t DescriptorFreeList::largestFreeRange() const
+    {
+        uint32_t largest = 0;
+        for (auto const& range : m_freeRanges) {
+            largest = std::max(largest, range.count);
+        }
+
+        return largest;
+    }
+
+    DescriptorFrameAllocator::DescriptorFrameAllocator(uint32_t offset, uint32_t capacity, uint32_t frameCount)
+    {
+        assert(frameCount > 0);
+        m_offset = offset;
+        m_frameCapacity = capacity / frameCount;
+        m_frameStart = offset;
+    }
+
+    void DescriptorFrameAllocator::beginFrame(uint32_t frameIdx)
+    {
+        m_frameStart = m_offset + frameIdx * m_frameCapacity;
+        m_usedCount = 0;
+    }
+
+    uint32_t DescriptorFrameAllocator::allocate(uint32_t count)
+    {
+        if (count == 0 || count > m_frameCapacity - m_usedCount) {
+            return InvalidIndex;
+        }
+
+        uint32_t const index = m_frameStart + m_usedCount;
+        m_usedCount += count;
+        m_peakCount = std::max(m_peakCount, m_usedCount);
+        return index;
+    }
+} // namespace Engine
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief Free list of descriptor index ranges for long lived descriptors. First fit, freed ranges are merged with their free
+    /// neighbours so the heap doesn't splinter.
+    class DescriptorFreeList
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+        DescriptorFreeList(uint32_t offset, uint32_t capacity);
+
+        /// @brief Returns the first index of a contiguous range, InvalidIndex if no free range is large enough.
+        uint32_t allocate(uint32_t count);
+
+        void free(uint32_t index, uint32_t count);
+
+        uint32_t capacity() const { return m_capacity; }
+
+        uint32_t freeCount() const { return m_freeCount; }
+
+        uint32_t largestFreeRange() const;
+
+        uint32_t freeRangeCount() const { return static_cast<uint32_t>(m_freeRanges.size()); }
+
+    private:
+        struct Range
+        {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        std::vector<Range> m_freeRanges; //< sorted by offset
+        uint32_t m_offset = 0;
+        uint32_t m_capacity = 0;
+        uint32_t m_freeCount = 0;
+    };
+
+    /// @brief Linear allocator for descriptors written every frame, one region per frame slot that is reset when the slot is
+    /// reused, so nothing is freed individually.
+    class DescriptorFrameAllocator
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+        DescriptorFrameAllocator(uint32_t offset, uint32_t capacity, uint32_t frameCount);
+
+        /// @brief Reset the slot's region, its previous frame must have completed.
+        void beginFrame(uint32_t frameIdx);
+
+        /// @brief Returns the first index of a contiguous range in the current frame's region, InvalidIndex once it is full.
+        uint32_t allocate(uint32_t count);
+
+        uint32_t frameCapacity() const { return m_frameCapacity; }
+
+        uint32_t usedCount() const { return m_usedCount; } //< by the current frame
+
+        uint32_t peakCount() const { return m_peakCount; } //< most used by any frame
+
+    private:
+        uint32_t m_offset = 0;
+        uint32_t m_frameCapacity = 0;
+        uint32_t m_frameStart = 0;
+        uint32_t m_usedCount = 0;
+        uint32_t m_peakCount = 0;
+    };
+} // namespace Engine
@@ -0,0 +1,191 @@
+#include "draw_packet.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Engine
+{
+    namespace DrawKeys
+    {
+        uint64_t encode(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+        {
+            assert(pass < (1U << PassBits));
+            assert(pipeline < (1U << PipelineBits));
+            assert(material < (1U << MaterialBits));
+            assert(mesh < (1U << MeshBits));
+            assert(depth < (1U << DepthBits));
+            return (uint64_t(pass) << PassShift)
+                | (uint64_t(pipeline) << PipelineShift)
+                | (uint64_t(material) << MaterialShift)
+                | (uint64_t(mesh) << MeshShift)
+                | (uint64_t(depth) << DepthShift);
+        }
+
+        uint32_t quantizeDepth(float distance, float maxDistance)
+        {
+            assert(maxDistance > 0.0F);
+            constexpr uint32_t MaxDepth = (1U << DepthBits) - 1;
+            float const normalized = std::min(std::max(distance / maxDistance, 0.0F), 1.0F);
+            return static_cast<uint32_t>(normalized * static_cast<float>(MaxDepth));
+        }
+    } // namespace DrawKeys
+
+    namespace DrawPackets
+    {
+        void sort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch, JobSystem* pJobs)
+        {
+            constexpr uint32_t DigitBits = 8;
+            constexpr uint32_t DigitCount = 64 / DigitBits;
+            constexpr uint32_t BucketCount = 1U << DigitBits;
+
+            size_t const count = packets.size();
+            if (count < 2) {
+                return;
+            }
+
+            assert(count <= UINT32_MAX);
+            scratch.resize(count);
+
+            // Chunks keep their ranges over all passes, so scattering them in order keeps the sort stable
+            size_t const maxChunkCount = (pJobs != nullptr) ? pJobs->threadCount() : 1;
+            size_t const chunkCount = std::max<size_t>(1, std::min(maxChunkCount, count / MinSortChunkSize));
+            auto const forChunks = [pJobs, chunkCount](auto const& function)
+            {
+                if (chunkCount == 1)
+                {
+                    function(size_t(0));
+                    return;
+                }
+
+                pJobs->parallelFor(chunkCount, 1, [&function](size_t chunkBegin, size_t chunkEnd)
+                {
+                    for (size_t chunkIdx = chunkBegin; chunkIdx < chunkEnd; chunkIdx++) {
+                        function(chunkIdx);
+                    }
+                });
+            };
+            auto const chunkStart = [count, chunkCount](size_t chunkIdx) { return (count * chunkIdx) / chunkCount; };
+
+            // Bits that differ from the first key in any key, digits without any are already sorted
+            uint64_t const firstKey = packets[0].key;
+            std::vector<uint64_t> chunkVaryingBits(chunkCount, 0);
+            forChunks([&](size_t chunkIdx)
+            {
+                uint64_t varyingBits = 0;
+                for (size_t packetIdx = chunkStart(chunkIdx); packetIdx < chunkStart(chunkIdx + 1); packetIdx++) {
+                    varyingBits |= packets[packetIdx].key ^ firstKey;
+                }
+                chunkVaryingBits[chunkIdx] = varyingBits;
+            });
+
+            uint64_t varyingBits = 0;
+            for (uint64_t const chunkBits : chunkVaryingBits) {
+                varyingBits |= chunkBits;
+            }
+
+            std::vector<uint32_t> offsets(chunkCount * BucketCount);
+            DrawPacket* pSource = packets.data();
+            DrawPacket* pDestination = scratch.data();
+            for (uint32_t digitIdx = 0; digitIdx < DigitCount; digitIdx++)
+            {
+                uint32_t const shift = digitIdx * DigitBits;
+                if (((varyingBits >> shift) & (BucketCount - 1)) == 0) {
+                    continue;
+                }
+
+                forChunks([&](size_t chunkIdx)
+                {
+                    uint32_t* pCounts = &offsets[chunkIdx * BucketCount];
+                    std::fill(pCounts, pCounts + BucketCount, 0U);
+                    for (size_t packetIdx = chunkStart(chunkIdx); packetIdx < chunkStart(chunkIdx + 1); packetIdx++) {
+                        pCounts[(pSource[packetIdx].key >> shift) & (BucketCount - 1)]++;
+                    }
+                });
+
+                // Bucket major, chunk minor, so every chunk writes its share of a bucket after the previous chunks' share
+                uint32_t offset = 0;
+                for (uint32_t bucketIdx = 0; bucketIdx < BucketCount; bucketIdx++)
+                {
+                    for (size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+                    {
+                        uint32_t const bucketCount = offsets[chunkIdx * BucketCount + bucketIdx];
+                        offsets[chunkIdx * BucketCount + bucketIdx] = offset;
+                        offset += bucketCount;
+                    }
+                }
+
+                forChunks([&](size_t chunkIdx)
+                {
+                    uint32_t* pOffsets = &offsets[chunkIdx * BucketCount];
+                    for (size_t packetIdx = chunkStart(chunkIdx); packetIdx < chunkStart(chunkIdx + 1); packetIdx++) {
+                        pDestination[pOffsets[(pSource[packetIdx].key >> shift) & (BucketCount - 1)]++] = pSource[packetIdx];
+                    }
+                });
+
+                std::swap(pSource, pDestination);
+            }
+
+            if (pSource != packets.data()) {
+                packets.swap(scratch);
+            }
+        }
+
+        std::pair<size_t, size_t> passRange(std::vector<DrawPacket> const& packets, uint32_t pass)
+        {
+            auto const first = std::lower_bound(packets.begin(), packets.end(), pass, [](DrawPacket const& packet, uint32_t value) { return DrawKeys::pass(packet.key) < value; });
+            auto const last = std::upper_bound(first, packets.end(), pass, [](uint32_t value, DrawPacket const& packet) { return value < DrawKeys::pass(packet.key); });
+            return { static_cast<size_t>(first - packets.begin()), static_cast<size_t>(last - packets.begin()) };
+        }
+
+        DrawStatistics submit(DrawPacket const* pPackets, size_t count, DrawStateBackend const& backend)
+        {
+            constexpr uint32_t Unbound = UINT32_MAX;
+
+            DrawStatistics statistics{};
+            uint32_t boundPipeline = Unbound;
+            uint32_t boundMaterial = Unbound;
+            uint32_t boundMesh = Unbound;
+            for (size_t packetIdx = 0; packetIdx < count; packetIdx++)
+            {
+                DrawPacket const& packet = pPackets[packetIdx];
+                uint32_t const pipeline = DrawKeys::pipeline(packet.key);
+                uint32_t const material = DrawKeys::material(packet.key);
+                uint32_t const mesh = DrawKeys::mesh(packet.key);
+                if (pipeline != boundPipeline)
+                {
+                    backend.setPipeline(pipeline);
+                    boundPipeline = pipeline;
+                    statistics.pipelineChanges++;
+                }
+                else {
+                    statistics.skippedChanges++;
+                }
+
+                if (material != boundMaterial)
+                {
+                    backend.setMaterial(material);
+                    boundMaterial = material;
+                    statistics.materialChanges++;
+                }
+                else {
+                    statistics.skippedChanges++;
+                }
+
+                if (mesh != boundMesh)
+                {
+                    backend.setMesh(mesh);
+                    boundMesh = mesh;
+                    statistics.meshChanges++;
+                }
+                else {
+                    statistics.skippedChanges++;
+                }
+
+                backend.draw(packet);
+                statistics.drawCount++;
+            }
+
+            return statistics;
+        }
+    } // namespace DrawPackets
+} // namespace Engine
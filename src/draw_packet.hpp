@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    /// @brief Indexed draw of a range of the frame's instance buffer, ordered by its sort key.
+    struct DrawPacket
+    {
+        uint64_t key;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    static_assert(sizeof(DrawPacket) == 24, "draw packets are sorted by value & should stay small");
+
+    /// @brief 64 bit draw sort keys, most significant field first: pass, pipeline, material, mesh & quantized depth. Sorting the
+    /// keys groups draws by pass & then by the state that is most expensive to change.
+    namespace DrawKeys
+    {
+        constexpr uint32_t PassBits = 4;
+        constexpr uint32_t PipelineBits = 10;
+        constexpr uint32_t MaterialBits = 16;
+        constexpr uint32_t MeshBits = 14;
+        constexpr uint32_t DepthBits = 20;
+
+        constexpr uint32_t DepthShift = 0;
+        constexpr uint32_t MeshShift = DepthShift + DepthBits;
+        constexpr uint32_t MaterialShift = MeshShift + MeshBits;
+        constexpr uint32_t PipelineShift = MaterialShift + MaterialBits;
+        constexpr uint32_t PassShift = PipelineShift + PipelineBits;
+
+        static_assert(PassShift + PassBits == 64, "key fields must fill the 64 bit key");
+
+        /// @brief Every field must fit its bit count.
+        uint64_t encode(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth);
+
+        constexpr uint32_t field(uint64_t key, uint32_t shift, uint32_t bits) { return static_cast<uint32_t>((key >> shift) & ((uint64_t(1) << bits) - 1)); }
+
+        constexpr uint32_t pass(uint64_t key) { return field(key, PassShift, PassBits); }
+        constexpr uint32_t pipeline(uint64_t key) { return field(key, PipelineShift, PipelineBits); }
+        constexpr uint32_t material(uint64_t key) { return field(key, MaterialShift, MaterialBits); }
+        constexpr uint32_t mesh(uint64_t key) { return field(key, MeshShift, MeshBits); }
+        constexpr uint32_t depth(uint64_t key) { return field(key, DepthShift, DepthBits); }
+
+        /// @brief View distance quantized to the depth field, front to back. Back to front passes use the field's max minus this.
+        uint32_t quantizeDepth(float distance, float maxDistance);
+    } // namespace DrawKeys
+
+    /// @brief State set by submitDraws, counted per frame to see what sorting saves.
+    struct DrawStatistics
+    {
+        uint32_t drawCount = 0;
+        uint32_t pipelineChanges = 0;
+        uint32_t materialChanges = 0;
+        uint32_t meshChanges = 0;
+        uint32_t skippedChanges = 0;    //< state already bound by the previous draw
+
+        void add(DrawStatistics const& other)
+        {
+            drawCount += other.drawCount;
+            pipelineChanges += other.pipelineChanges;
+            materialChanges += other.materialChanges;
+            meshChanges += other.meshChanges;
+            skippedChanges += other.skippedChanges;
+        }
+    };
+
+    /// @brief Command list operations of a draw walk, stubbed by a recording mock in tests. Ids are the key fields.
+    struct DrawStateBackend
+    {
+        std::function<void(uint32_t pipeline)> setPipeline;
+        std::function<void(uint32_t material)> setMaterial;     //< descriptor tables of the material
+        std::function<void(uint32_t mesh)> setMesh;             //< vertex & index buffers & the mesh's constants
+        std::function<void(DrawPacket const& packet)> draw;
+    };
+
+    namespace DrawPackets
+    {
+        constexpr size_t MinSortChunkSize = 4096; //< packets per parallel histogram & scatter chunk
+
+        /// @brief Stable LSD radix sort by key, 8 bits per pass. Passes over bytes that are equal in every key are skipped, e.g.
+        /// the pass & pipeline bytes in a frame with few pipelines. Histograms & scatters run in chunks on the job system if
+        /// given, the scratch buffer is resized to the packet count.
+        void sort(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch, JobSystem* pJobs = nullptr);
+
+        /// @brief Range [first, second) of the sorted packets in the pass.
+        std::pair<size_t, size_t> passRange(std::vector<DrawPacket> const& packets, uint32_t pass);
+
+        /// @brief Walk the packets in order, setting pipeline, material & mesh only when they differ from the previous draw's.
+        /// State starts out unbound, as on a freshly opened command list.
+        DrawStatistics submit(DrawPacket const* pPackets, size_t count, DrawStateBackend const& backend);
+    } // namespace DrawPackets
+} // namespace Engine
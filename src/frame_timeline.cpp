@@ -0,0 +1,17 @@
+#include "frame_timeline.hpp"
+
+namespace Engine
+{
+    uint64_t FrameTimeline::beginFrame()
+    {
+        m_frameIndex = static_cast<uint32_t>(m_frameNumber % m_slotFenceValues.size());
+        m_frameNumber++;
+        return m_slotFenceValues[m_frameIndex];
+    }
+
+    uint64_t FrameTimeline::endFrame()
+    {
+        m_slotFenceValues[m_frameIndex] = nextSignal();
+        return m_slotFenceValues[m_frameIndex];
+    }
+} // namespace Engine
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief Frame slot & fence value bookkeeping for frames in flight. Independent of the graphics API, the caller signals the
+    /// values handed out & waits for the value returned when a slot comes around again.
+    class FrameTimeline
+    {
+    public:
+        explicit FrameTimeline(uint32_t frameCount) : m_slotFenceValues(frameCount, 0) {}
+
+        /// @brief Move to the next frame slot. Returns the fence value that must have completed before the slot's resources are
+        /// reused, 0 if the slot was never submitted.
+        uint64_t beginFrame();
+
+        /// @brief Fence value to signal after the current frame's submit, waited on before its slot is reused.
+        uint64_t endFrame();
+
+        /// @brief Fence value to signal outside of the frame loop, e.g. to flush the queue.
+        uint64_t nextSignal() { return ++m_lastSignaledValue; }
+
+        uint32_t frameIndex() const { return m_frameIndex; }
+
+        uint32_t frameCount() const { return static_cast<uint32_t>(m_slotFenceValues.size()); }
+
+        uint64_t frameNumber() const { return m_frameNumber; } //< frames begun so far
+
+        uint64_t lastSignaledValue() const { return m_lastSignaledValue; }
+
+    private:
+        std::vector<uint64_t> m_slotFenceValues;
+        uint32_t m_frameIndex = 0;
+        uint64_t m_frameNumber = 0;
+        uint64_t m_lastSignaledValue = 0;
+    };
+} // namespace Engine
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Hash
+{
+    constexpr uint64_t FNV1aOffsetBasis = 0xCBF29CE484222325ULL;
+    constexpr uint64_t FNV1aPrime = 0x00000100000001B3ULL;
+
+    /// @brief 64-bit FNV-1a hash, pass a previous hash as seed to hash discontiguous data.
+    inline uint64_t fnv1a(void const* pData, size_t size, uint64_t hash = FNV1aOffsetBasis)
+    {
+        uint8_t const* pBytes = static_cast<uint8_t const*>(pData);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= FNV1aPrime;
+        }
+
+        return hash;
+    }
+} // namespace Hash
@@ -0,0 +1,343 @@
+#include "job_system.hpp"
+
+#include <cassert>
+
+namespace Engine
+{
+    constexpr uint32_t IdleSpinCount = 64; //< failed job searches before a worker sleeps
+    constexpr uint32_t SlotSearchCount = 16; //< busy job slots skipped before running a job to free one
+
+    static thread_local JobSystem* t_pJobSystem = nullptr;
+    static thread_local uint32_t t_workerIdx = 0;
+
+    bool JobSystem::WorkQueue::push(Job* pJob)
+    {
+        int64_t const bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t const top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= Capacity) {
+            return false;
+        }
+
+        m_jobs[bottom & (Capacity - 1)].store(pJob, std::memory_order_relaxed);
+        m_bottom.store(bottom + 1, std::memory_order_release); //< publishes the job to thieves loading bottom
+        return true;
+    }
+
+    JobSystem::Job* JobSystem::WorkQueue::pop()
+    {
+        // Reserve the bottom job first, thieves racing for the same job are resolved on top
+        int64_t const bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        Job* pJob = m_jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                pJob = nullptr;
+            }
+
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return pJob;
+    }
+
+    JobSystem::Job* JobSystem::WorkQueue::steal()
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t const bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        Job* pJob = m_jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        return pJob;
+    }
+
+    JobSystem::JobSystem(uint32_t threadCount)
+    {
+        assert(t_pJobSystem == nullptr && "The constructing thread can only be a worker of one job system");
+        if (threadCount == 0) {
+            threadCount = std::max(1U, std::thread::hardware_concurrency());
+        }
+
+        m_workerCount = threadCount;
+        m_workers = std::make_unique<Worker[]>(threadCount);
+        for (uint32_t workerIdx = 0; workerIdx < threadCount; workerIdx++)
+        {
+            m_workers[workerIdx].pJobs = std::make_unique<Job[]>(JobPoolSize);
+            m_workers[workerIdx].randomState = 0x9E3779B9U * (workerIdx + 1);
+        }
+
+        t_pJobSystem = this;
+        t_workerIdx = 0;
+
+        m_threads.reserve(threadCount - 1);
+        for (uint32_t workerIdx = 1; workerIdx < threadCount; workerIdx++) {
+            m_threads.emplace_back(&JobSystem::workerLoop, this, workerIdx);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_stopping.store(true);
+        }
+
+        m_jobQueued.notify_all();
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+
+        t_pJobSystem = nullptr;
+    }
+
+    JobSystem* JobSystem::current()
+    {
+        return t_pJobSystem;
+    }
+
+    void JobSystem::wait(Counter& counter)
+    {
+        Worker& worker = currentWorker();
+        while (!counter.done())
+        {
+            Job* pJob = findJob(worker);
+            if (pJob != nullptr) {
+                execute(worker, pJob);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        // The last job drops the counter to zero under the lock, wait for it to release the counter
+        std::lock_guard<std::mutex> lock(counter.m_mutex);
+    }
+
+    JobSystem::Statistics JobSystem::statistics() const
+    {
+        Statistics statistics{};
+        for (uint32_t workerIdx = 0; workerIdx < m_workerCount; workerIdx++)
+        {
+            Worker const& worker = m_workers[workerIdx];
+            statistics.executedCount += worker.executedCount.load(std::memory_order_relaxed);
+            statistics.stolenCount += worker.stolenCount.load(std::memory_order_relaxed);
+            statistics.failedStealCount += worker.failedStealCount.load(std::memory_order_relaxed);
+            statistics.sleepCount += worker.sleepCount.load(std::memory_order_relaxed);
+        }
+
+        return statistics;
+    }
+
+    void JobSystem::resetStatistics()
+    {
+        for (uint32_t workerIdx = 0; workerIdx < m_workerCount; workerIdx++)
+        {
+            Worker& worker = m_workers[workerIdx];
+            worker.executedCount.store(0, std::memory_order_relaxed);
+            worker.stolenCount.store(0, std::memory_order_relaxed);
+            worker.failedStealCount.store(0, std::memory_order_relaxed);
+            worker.sleepCount.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    JobSystem::Job* JobSystem::allocateJob(Counter* pCounter)
+    {
+        // Skip slots whose jobs are pending or running, possibly further up this worker's own stack
+        Worker& worker = currentWorker();
+        Job* pJob = nullptr;
+        while (pJob == nullptr)
+        {
+            for (uint32_t slotOffset = 0; slotOffset < SlotSearchCount && pJob == nullptr; slotOffset++)
+            {
+                Job& slot = worker.pJobs[worker.nextJob++ & (JobPoolSize - 1)];
+                if (slot.free.load(std::memory_order_acquire)) {
+                    pJob = &slot;
+                }
+            }
+
+            if (pJob == nullptr)
+            {
+                // Own oldest job first, it frees the slot at the allocation cursor
+                Job* pOtherJob = worker.queue.steal();
+                if (pOtherJob != nullptr) {
+                    m_queuedCount.fetch_sub(1);
+                }
+                else {
+                    pOtherJob = findJob(worker);
+                }
+
+                if (pOtherJob != nullptr) {
+                    execute(worker, pOtherJob);
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        pJob->free.store(false, std::memory_order_relaxed);
+        pJob->pCounter = pCounter;
+        if (pCounter != nullptr) {
+            pCounter->m_value.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return pJob;
+    }
+
+    void JobSystem::push(Job* pJob)
+    {
+        // A full deque means the worker is far ahead of the others, running the job inline keeps it making progress
+        Worker& worker = currentWorker();
+        if (!worker.queue.push(pJob))
+        {
+            execute(worker, pJob);
+            return;
+        }
+
+        m_queuedCount.fetch_add(1);
+        if (m_sleepingCount.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+            }
+
+            m_jobQueued.notify_one();
+        }
+    }
+
+    void JobSystem::pushAfter(Counter& dependency, Job* pJob)
+    {
+        {
+            std::lock_guard<std::mutex> lock(dependency.m_mutex);
+            if (!dependency.done())
+            {
+                dependency.m_continuations.push_back(pJob);
+                return;
+            }
+        }
+
+        push(pJob);
+    }
+
+    JobSystem::Worker& JobSystem::currentWorker()
+    {
+        assert(t_pJobSystem == this && "Jobs can only be spawned & waited for by the job system's workers");
+        return m_workers[t_workerIdx];
+    }
+
+    JobSystem::Job* JobSystem::findJob(Worker& worker)
+    {
+        Job* pJob = worker.queue.pop();
+        if (pJob == nullptr && m_workerCount > 1)
+        {
+            worker.randomState ^= worker.randomState << 13;
+            worker.randomState ^= worker.randomState >> 17;
+            worker.randomState ^= worker.randomState << 5;
+            uint32_t const workerIdx = static_cast<uint32_t>(&worker - m_workers.get());
+            uint32_t const firstVictim = worker.randomState % m_workerCount;
+            for (uint32_t victimOffset = 0; victimOffset < m_workerCount && pJob == nullptr; victimOffset++)
+            {
+                uint32_t const victimIdx = (firstVictim + victimOffset) % m_workerCount;
+                if (victimIdx != workerIdx) {
+                    pJob = m_workers[victimIdx].queue.steal();
+                }
+            }
+
+            if (pJob != nullptr) {
+                worker.stolenCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                worker.failedStealCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (pJob != nullptr) {
+            m_queuedCount.fetch_sub(1);
+        }
+
+        return pJob;
+    }
+
+    void JobSystem::execute(Worker& worker, Job* pJob)
+    {
+        Counter* pCounter = pJob->pCounter;
+        pJob->pInvoke(*pJob);
+        pJob->free.store(true, std::memory_order_release);
+        worker.executedCount.fetch_add(1, std::memory_order_relaxed);
+        if (pCounter != nullptr) {
+            finish(*pCounter);
+        }
+    }
+
+    void JobSystem::finish(Counter& counter)
+    {
+        uint32_t value = counter.m_value.load(std::memory_order_relaxed);
+        while (value > 1)
+        {
+            if (counter.m_value.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        // Possibly the last job, drop to zero under the lock so a waiter can't release the counter while it's still used
+        std::vector<Job*> continuations;
+        {
+            std::lock_guard<std::mutex> lock(counter.m_mutex);
+            if (counter.m_value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter.m_continuations);
+            }
+        }
+
+        for (Job* pContinuation : continuations) {
+            push(pContinuation);
+        }
+    }
+
+    void JobSystem::workerLoop(uint32_t workerIdx)
+    {
+        t_pJobSystem = this;
+        t_workerIdx = workerIdx;
+
+        Worker& worker = m_workers[workerIdx];
+        uint32_t idleCount = 0;
+        while (!m_stopping.load(std::memory_order_relaxed))
+        {
+            Job* pJob = findJob(worker);
+            if (pJob != nullptr)
+            {
+                execute(worker, pJob);
+                idleCount = 0;
+                continue;
+            }
+
+            if (++idleCount < IdleSpinCount)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Sleep until a job is queued, the seq_cst sleeper count & queued count make either side see the other
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_sleepingCount.fetch_add(1);
+            worker.sleepCount.fetch_add(1, std::memory_order_relaxed);
+            m_jobQueued.wait(lock, [this]() { return m_stopping.load() || m_queuedCount.load() > 0; });
+            m_sleepingCount.fetch_sub(1);
+            idleCount = 0;
+        }
+    }
+} // namespace Engine
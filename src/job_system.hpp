@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief Work stealing job scheduler. Each worker pushes & pops jobs at the bottom of its own deque while idle workers
+    /// steal from the top, so spawned jobs stay on the spawning core until another one runs dry. The constructing thread is
+    /// worker 0 & runs jobs while it waits, other threads may not spawn jobs.
+    class JobSystem
+    {
+        struct Job;
+
+    public:
+        static constexpr size_t JobDataSize = 96;       //< captured state of a job, stored inline
+        static constexpr uint32_t JobPoolSize = 4096;   //< jobs in flight per worker, spawning runs jobs while all are used
+
+        /// @brief Number of unfinished jobs. Waiting on it runs other jobs, continuations are scheduled once it drops to zero.
+        /// Must outlive its jobs & may only be destroyed after a wait returned.
+        class Counter
+        {
+        public:
+            bool done() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+        private:
+            friend class JobSystem;
+
+            std::atomic<uint32_t> m_value{ 0 };
+            std::mutex m_mutex;                 //< guards continuations & the drop to zero
+            std::vector<Job*> m_continuations;
+        };
+
+        struct Statistics
+        {
+            uint64_t executedCount;
+            uint64_t stolenCount;
+            uint64_t failedStealCount;  //< steal attempts that found every other deque empty or lost a race
+            uint64_t sleepCount;
+        };
+
+        /// @brief Zero threads uses one worker per hardware thread, the calling thread counts as one of them.
+        explicit JobSystem(uint32_t threadCount = 0);
+
+        ~JobSystem();
+
+        JobSystem(JobSystem const&) = delete;
+        JobSystem& operator=(JobSystem const&) = delete;
+
+        /// @brief Push a job to the calling worker's deque, the counter is incremented until the job finished.
+        template<typename Function>
+        void run(Function&& function, Counter* pCounter = nullptr)
+        {
+            push(createJob(std::forward<Function>(function), pCounter));
+        }
+
+        /// @brief Continuation, pushed once the dependency dropped to zero or right away if it already has. The counter is
+        /// incremented immediately so waiting on it covers the continuation while it's pending.
+        template<typename Function>
+        void runAfter(Counter& dependency, Function&& function, Counter* pCounter = nullptr)
+        {
+            pushAfter(dependency, createJob(std::forward<Function>(function), pCounter));
+        }
+
+        /// @brief Run jobs until the counter dropped to zero.
+        void wait(Counter& counter);
+
+        /// @brief Call function(begin, end) on ranges of [0, count) of at most grainSize & wait for them. Ranges are split in
+        /// halves, the upper half being pushed as a job, so thieves take the largest remaining ranges first.
+        template<typename Function>
+        void parallelFor(size_t count, size_t grainSize, Function const& function)
+        {
+            Counter counter;
+            splitRange(0, count, std::max<size_t>(grainSize, 1), function, counter);
+            wait(counter);
+        }
+
+        /// @brief parallelFor on the job system the calling thread is a worker of, otherwise one range on the calling thread.
+        /// Lets asset processing split its loops when run from jobs without passing a job system through every call.
+        template<typename Function>
+        static void parallelForCurrent(size_t count, size_t grainSize, Function const& function)
+        {
+            JobSystem* pJobSystem = current();
+            if (pJobSystem != nullptr) {
+                pJobSystem->parallelFor(count, grainSize, function);
+            }
+            else if (count > 0) {
+                function(size_t(0), count);
+            }
+        }
+
+        /// @brief Job system the calling thread is a worker of, null on other threads.
+        static JobSystem* current();
+
+        uint32_t threadCount() const { return m_workerCount; }
+
+        /// @brief Totals over all workers since construction or the last reset.
+        Statistics statistics() const;
+
+        void resetStatistics();
+
+    private:
+        /// @brief Job slot, free once its function ran. Functions run & are destroyed by the invoke trampoline.
+        struct alignas(64) Job
+        {
+            void (*pInvoke)(Job& job);
+            Counter* pCounter;
+            std::atomic<bool> free{ true };
+            alignas(16) unsigned char data[JobDataSize];
+        };
+
+        /// @brief Chase-Lev deque of job pointers with a fixed capacity. The owner pushes & pops at the bottom, thieves
+        /// take from the top & only the last job is contended.
+        class WorkQueue
+        {
+        public:
+            /// @brief Owner only, fails if full.
+            bool push(Job* pJob);
+
+            /// @brief Owner only, newest job first.
+            Job* pop();
+
+            /// @brief Any thread, oldest job first. Returns null if empty or another thread took the job.
+            Job* steal();
+
+        private:
+            static constexpr int64_t Capacity = JobPoolSize;
+
+            alignas(64) std::atomic<int64_t> m_top{ 0 };
+            alignas(64) std::atomic<int64_t> m_bottom{ 0 };
+            std::atomic<Job*> m_jobs[Capacity]{};
+        };
+
+        struct alignas(64) Worker
+        {
+            WorkQueue queue;
+            std::unique_ptr<Job[]> pJobs;
+            uint32_t nextJob = 0;
+            uint32_t randomState = 0;
+            std::atomic<uint64_t> executedCount{ 0 };
+            std::atomic<uint64_t> stolenCount{ 0 };
+            std::atomic<uint64_t> failedStealCount{ 0 };
+            std::atomic<uint64_t> sleepCount{ 0 };
+        };
+
+        template<typename Function>
+        static void invoke(Job& job)
+        {
+            using Stored = std::decay_t<Function>;
+            Stored* pFunction = std::launder(reinterpret_cast<Stored*>(job.data));
+            (*pFunction)();
+            pFunction->~Stored();
+        }
+
+        template<typename Function>
+        Job* createJob(Function&& function, Counter* pCounter)
+        {
+            using Stored = std::decay_t<Function>;
+            static_assert(sizeof(Stored) <= JobDataSize, "job function exceeds the inline job data");
+            static_assert(alignof(Stored) <= 16, "job function alignment exceeds the inline job data");
+
+            Job* pJob = allocateJob(pCounter);
+            new (pJob->data) Stored(std::forward<Function>(function));
+            pJob->pInvoke = &invoke<Function>;
+            return pJob;
+        }
+
+        template<typename Function>
+        void splitRange(size_t begin, size_t end, size_t grainSize, Function const& function, Counter& counter)
+        {
+            while (end - begin > grainSize)
+            {
+                size_t const middle = begin + (end - begin) / 2;
+                run([this, middle, end, grainSize, &function, &counter]() { splitRange(middle, end, grainSize, function, counter); }, &counter);
+                end = middle;
+            }
+
+            if (begin < end) {
+                function(begin, end);
+            }
+        }
+
+        /// @brief Next free slot of the calling worker's pool, running other jobs while every slot is in use.
+        Job* allocateJob(Counter* pCounter);
+
+        void push(Job* pJob);
+
+        void pushAfter(Counter& dependency, Job* pJob);
+
+        Worker& currentWorker();
+
+        /// @brief Pop from the worker's own deque, otherwise steal from the others starting at a random victim.
+        Job* findJob(Worker& worker);
+
+        void execute(Worker& worker, Job* pJob);
+
+        /// @brief Decrement the counter, pushing its continuations if it dropped to zero.
+        void finish(Counter& counter);
+
+        void workerLoop(uint32_t workerIdx);
+
+        uint32_t m_workerCount = 0;
+        std::unique_ptr<Worker[]> m_workers;
+        std::vector<std::thread> m_threads;
+
+        // Idle workers sleep until a job is queued, queued jobs & sleepers are seq_cst so no wake up is lost
+        std::atomic<int64_t> m_queuedCount{ 0 };
+        std::atomic<uint32_t> m_sleepingCount{ 0 };
+        std::mutex m_sleepMutex;
+        std::condition_variable m_jobQueued;
+        std::atomic<bool> m_stopping{ false };
+    };
+} // namespace Engine
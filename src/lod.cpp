@@ -0,0 +1,508 @@
+#include "lod.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <queue>
+#include <unordered_set>
+
+#include "mesh_optimizer.hpp"
+
+namespace Engine
+{
+    namespace Lods
+    {
+        constexpr float AttributeWeight = 0.1F; //< a unit attribute difference costs as much as 10% of the mesh radius in distance
+        constexpr size_t MaxErrorSamples = 20'000'000; //< point triangle tests before measureError starts skipping vertices
+
+        /// @brief Area weighted sum of squared plane distances, stored as the upper triangle of a symmetric 4x4 matrix.
+        struct Quadric
+        {
+            double a00, a01, a02, a03;
+            double a11, a12, a13;
+            double a22, a23;
+            double a33;
+            double weight;
+
+            static Quadric fromPlane(glm::vec3 const& normal, float distance, float weight)
+            {
+                double const a = normal.x;
+                double const b = normal.y;
+                double const c = normal.z;
+                double const d = distance;
+                double const w = weight;
+                return Quadric{ w * a * a, w * a * b, w * a * c, w * a * d, w * b * b, w * b * c, w * b * d, w * c * c, w * c * d, w * d * d, w };
+            }
+
+            void add(Quadric const& other)
+            {
+                a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+                a11 += other.a11; a12 += other.a12; a13 += other.a13;
+                a22 += other.a22; a23 += other.a23;
+                a33 += other.a33;
+                weight += other.weight;
+            }
+
+            /// @brief Weighted mean squared distance of a point to the accumulated planes.
+            double evaluate(glm::vec3 const& point) const
+            {
+                double const x = point.x;
+                double const y = point.y;
+                double const z = point.z;
+                double const error = a00 * x * x + 2.0 * a01 * x * y + 2.0 * a02 * x * z + 2.0 * a03 * x
+                    + a11 * y * y + 2.0 * a12 * y * z + 2.0 * a13 * y
+                    + a22 * z * z + 2.0 * a23 * z
+                    + a33;
+                return (weight > 0.0) ? std::max(error, 0.0) / weight : 0.0;
+            }
+        };
+
+        /// @brief Directed edge collapse, source is removed & its triangles are moved to the target.
+        struct Collapse
+        {
+            float cost;
+            float positionError;
+            uint32_t source;
+            uint32_t target;
+            uint32_t sourceVersion;
+
+            bool operator>(Collapse const& other) const
+            {
+                return cost > other.cost;
+            }
+        };
+
+        /// @brief Progressive half edge collapse state over a triangle list.
+        class Simplifier
+        {
+        public:
+            Simplifier(std::vector<Vertex> const& vertices, std::vector<uint32_t> const& indices)
+                : m_vertices(vertices)
+                , m_triangles(indices)
+                , m_triangleAlive(indices.size() / 3, true)
+                , m_vertexTriangles(vertices.size())
+                , m_quadrics(vertices.size(), Quadric{})
+                , m_locked(vertices.size(), false)
+                , m_collapsed(vertices.size(), false)
+                , m_versions(vertices.size(), 0)
+                , m_triangleCount(indices.size() / 3)
+            {
+                glm::vec3 boundsMin = glm::vec3(INFINITY);
+                glm::vec3 boundsMax = glm::vec3(-INFINITY);
+                for (auto const& vertex : vertices)
+                {
+                    boundsMin = glm::min(boundsMin, vertex.position);
+                    boundsMax = glm::max(boundsMax, vertex.position);
+                }
+
+                float const radius = vertices.empty() ? 0.0F : glm::length(boundsMax - boundsMin) * 0.5F;
+                m_attributeScale = (AttributeWeight * radius) * (AttributeWeight * radius);
+
+                // Plane quadrics & vertex to triangle adjacency
+                for (size_t triangleIdx = 0; triangleIdx < m_triangleCount; triangleIdx++)
+                {
+                    uint32_t const* pTriangle = &m_triangles[triangleIdx * 3];
+                    glm::vec3 const& p0 = vertices[pTriangle[0]].position;
+                    glm::vec3 const normal = glm::cross(vertices[pTriangle[1]].position - p0, vertices[pTriangle[2]].position - p0);
+                    float const doubleArea = glm::length(normal);
+                    if (doubleArea > 0.0F)
+                    {
+                        glm::vec3 const unitNormal = normal / doubleArea;
+                        Quadric const quadric = Quadric::fromPlane(unitNormal, -glm::dot(unitNormal, p0), doubleArea * 0.5F);
+                        for (int corner = 0; corner < 3; corner++) {
+                            m_quadrics[pTriangle[corner]].add(quadric);
+                        }
+                    }
+
+                    for (int corner = 0; corner < 3; corner++) {
+                        m_vertexTriangles[pTriangle[corner]].push_back(static_cast<uint32_t>(triangleIdx));
+                    }
+                }
+
+                // Edges without an opposite half edge are borders, or attribute seams since vertices are welded by attributes
+                std::unordered_set<uint64_t> halfEdges;
+                halfEdges.reserve(indices.size());
+                for (size_t cornerIdx = 0; cornerIdx < indices.size(); cornerIdx++)
+                {
+                    uint32_t const a = indices[cornerIdx];
+                    uint32_t const b = indices[(cornerIdx % 3 == 2) ? cornerIdx - 2 : cornerIdx + 1];
+                    if (!halfEdges.insert(edgeKey(a, b)).second)
+                    {
+                        m_locked[a] = true; //< non-manifold
+                        m_locked[b] = true;
+                    }
+                }
+
+                for (uint64_t const halfEdge : halfEdges)
+                {
+                    uint32_t const a = static_cast<uint32_t>(halfEdge >> 32);
+                    uint32_t const b = static_cast<uint32_t>(halfEdge);
+                    if (halfEdges.count(edgeKey(b, a)) == 0)
+                    {
+                        m_locked[a] = true;
+                        m_locked[b] = true;
+                    }
+                }
+
+                for (uint32_t vertexIdx = 0; vertexIdx < vertices.size(); vertexIdx++) {
+                    pushCollapses(vertexIdx);
+                }
+            }
+
+            /// @brief Collapse edges until at most targetTriangleCount triangles remain or no valid collapse is left.
+            void simplify(size_t targetTriangleCount)
+            {
+                while (m_triangleCount > targetTriangleCount && !m_queue.empty())
+                {
+                    Collapse const collapse = m_queue.top();
+                    m_queue.pop();
+
+                    if (m_collapsed[collapse.source] || m_collapsed[collapse.target]
+                        || m_versions[collapse.source] != collapse.sourceVersion
+                        || !isValid(collapse.source, collapse.target))
+                    {
+                        continue;
+                    }
+
+                    apply(collapse);
+                }
+            }
+
+            void writeIndices(std::vector<uint32_t>& indices) const
+            {
+                for (size_t triangleIdx = 0; triangleIdx < m_triangleAlive.size(); triangleIdx++)
+                {
+                    if (m_triangleAlive[triangleIdx]) {
+                        indices.insert(indices.end(), &m_triangles[triangleIdx * 3], &m_triangles[triangleIdx * 3] + 3);
+                    }
+                }
+            }
+
+            size_t triangleCount() const
+            {
+                return m_triangleCount;
+            }
+
+            float error() const
+            {
+                return std::sqrt(m_maxPositionError);
+            }
+
+        private:
+            static uint64_t edgeKey(uint32_t a, uint32_t b)
+            {
+                return (static_cast<uint64_t>(a) << 32) | b;
+            }
+
+            bool contains(uint32_t triangleIdx, uint32_t vertexIdx) const
+            {
+                uint32_t const* pTriangle = &m_triangles[triangleIdx * 3];
+                return pTriangle[0] == vertexIdx || pTriangle[1] == vertexIdx || pTriangle[2] == vertexIdx;
+            }
+
+            template<typename Function>
+            void forEachNeighbour(uint32_t vertexIdx, Function const& function) const
+            {
+                for (uint32_t const triangleIdx : m_vertexTriangles[vertexIdx])
+                {
+                    if (!m_triangleAlive[triangleIdx]) {
+                        continue;
+                    }
+
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        uint32_t const neighbour = m_triangles[triangleIdx * 3 + corner];
+                        if (neighbour != vertexIdx) {
+                            function(neighbour);
+                        }
+                    }
+                }
+            }
+
+            void pushCollapse(uint32_t source, uint32_t target)
+            {
+                Vertex const& sourceVertex = m_vertices[source];
+                Vertex const& targetVertex = m_vertices[target];
+                glm::vec3 const normalDelta = sourceVertex.normal - targetVertex.normal;
+                glm::vec2 const texCoordDelta = sourceVertex.texCoord - targetVertex.texCoord;
+                float const attributeError = m_attributeScale * (glm::dot(normalDelta, normalDelta) + glm::dot(texCoordDelta, texCoordDelta));
+                float const positionError = static_cast<float>(m_quadrics[source].evaluate(targetVertex.position));
+                m_queue.push(Collapse{ positionError + attributeError, positionError, source, target, m_versions[source] });
+            }
+
+            void pushCollapses(uint32_t vertexIdx)
+            {
+                forEachNeighbour(vertexIdx, [&](uint32_t neighbour)
+                {
+                    if (!m_locked[vertexIdx]) {
+                        pushCollapse(vertexIdx, neighbour);
+                    }
+
+                    if (!m_locked[neighbour]) {
+                        pushCollapse(neighbour, vertexIdx);
+                    }
+                });
+            }
+
+            bool isValid(uint32_t source, uint32_t target) const
+            {
+                // Link condition, an interior edge may only share its two opposite vertices or the collapse pinches the surface
+                std::vector<uint32_t> sourceNeighbours;
+                bool edgeExists = false;
+                forEachNeighbour(source, [&](uint32_t neighbour)
+                {
+                    edgeExists |= (neighbour == target);
+                    sourceNeighbours.push_back(neighbour);
+                });
+
+                if (!edgeExists) {
+                    return false;
+                }
+
+                std::sort(sourceNeighbours.begin(), sourceNeighbours.end());
+                sourceNeighbours.erase(std::unique(sourceNeighbours.begin(), sourceNeighbours.end()), sourceNeighbours.end());
+
+                std::vector<uint32_t> sharedNeighbours;
+                forEachNeighbour(target, [&](uint32_t neighbour)
+                {
+                    if (std::binary_search(sourceNeighbours.begin(), sourceNeighbours.end(), neighbour)) {
+                        sharedNeighbours.push_back(neighbour);
+                    }
+                });
+
+                std::sort(sharedNeighbours.begin(), sharedNeighbours.end());
+                if (std::unique(sharedNeighbours.begin(), sharedNeighbours.end()) - sharedNeighbours.begin() > 2) {
+                    return false;
+                }
+
+                // Reject collapses that flip or degenerate a remaining triangle
+                glm::vec3 const& targetPosition = m_vertices[target].position;
+                for (uint32_t const triangleIdx : m_vertexTriangles[source])
+                {
+                    if (!m_triangleAlive[triangleIdx] || contains(triangleIdx, target)) {
+                        continue;
+                    }
+
+                    glm::vec3 before[3];
+                    glm::vec3 after[3];
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        uint32_t const vertexIdx = m_triangles[triangleIdx * 3 + corner];
+                        before[corner] = m_vertices[vertexIdx].position;
+                        after[corner] = (vertexIdx == source) ? targetPosition : before[corner];
+                    }
+
+                    glm::vec3 const normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 const normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    if (glm::dot(normalBefore, normalAfter) <= 0.0F) {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            void apply(Collapse const& collapse)
+            {
+                uint32_t const source = collapse.source;
+                uint32_t const target = collapse.target;
+                for (uint32_t const triangleIdx : m_vertexTriangles[source])
+                {
+                    if (!m_triangleAlive[triangleIdx]) {
+                        continue;
+                    }
+
+                    if (contains(triangleIdx, target))
+                    {
+                        m_triangleAlive[triangleIdx] = false;
+                        m_triangleCount--;
+                        continue;
+                    }
+
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        if (m_triangles[triangleIdx * 3 + corner] == source) {
+                            m_triangles[triangleIdx * 3 + corner] = target;
+                        }
+                    }
+                    m_vertexTriangles[target].push_back(triangleIdx);
+                }
+
+                m_vertexTriangles[source].clear();
+                m_collapsed[source] = true;
+                m_quadrics[target].add(m_quadrics[source]);
+                m_versions[target]++;
+                m_maxPositionError = std::max(m_maxPositionError, collapse.positionError);
+
+                // Drop dead triangles from the grown adjacency list, then requeue the edges around the target
+                auto& targetTriangles = m_vertexTriangles[target];
+                targetTriangles.erase(std::remove_if(targetTriangles.begin(), targetTriangles.end(), [&](uint32_t triangleIdx) { return !m_triangleAlive[triangleIdx]; }), targetTriangles.end());
+                pushCollapses(target);
+            }
+
+            std::vector<Vertex> const& m_vertices;
+            std::vector<uint32_t> m_triangles;
+            std::vector<bool> m_triangleAlive;
+            std::vector<std::vector<uint32_t>> m_vertexTriangles;
+            std::vector<Quadric> m_quadrics;
+            std::vector<bool> m_locked;
+            std::vector<bool> m_collapsed;
+            std::vector<uint32_t> m_versions;
+            std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_queue;
+            size_t m_triangleCount = 0;
+            float m_attributeScale = 0.0F;
+            float m_maxPositionError = 0.0F;
+        };
+
+        void buildLods(MeshData const& meshData, LodData& lodData, float const* pRatios, size_t ratioCount)
+        {
+            assert(meshData.indices.size() % 3 == 0);
+            lodData.levels.clear();
+            lodData.indices.clear();
+
+            Simplifier simplifier(meshData.vertices, meshData.indices);
+            size_t parentTriangleCount = meshData.indices.size() / 3;
+            for (size_t ratioIdx = 0; ratioIdx < ratioCount; ratioIdx++)
+            {
+                size_t const targetTriangleCount = static_cast<size_t>(static_cast<float>(meshData.indices.size() / 3) * pRatios[ratioIdx]);
+                simplifier.simplify(targetTriangleCount);
+
+                // Locked borders & seams can stall simplification, further levels would barely differ
+                if (simplifier.triangleCount() == 0 || static_cast<float>(simplifier.triangleCount()) > static_cast<float>(parentTriangleCount) * MinLodReduction) {
+                    break;
+                }
+
+                LodLevel level{};
+                level.indexOffset = static_cast<uint32_t>(lodData.indices.size());
+                level.indexCount = static_cast<uint32_t>(simplifier.triangleCount() * 3);
+                level.error = simplifier.error();
+                simplifier.writeIndices(lodData.indices);
+                lodData.levels.push_back(level);
+                parentTriangleCount = simplifier.triangleCount();
+            }
+        }
+
+        void buildLods(MeshData& meshData)
+        {
+            buildLods(meshData, meshData.lods, DefaultLodRatios, sizeof(DefaultLodRatios) / sizeof(DefaultLodRatios[0]));
+
+            // Levels are drawn as plain triangle lists, only the vertex cache order matters
+            for (auto const& level : meshData.lods.levels)
+            {
+                auto const levelBegin = meshData.lods.indices.begin() + level.indexOffset;
+                std::vector<uint32_t> const levelIndices(levelBegin, levelBegin + level.indexCount);
+                std::vector<uint32_t> clusters;
+                std::vector<uint32_t> const optimizedIndices = MeshOptimizer::optimizeVertexCache(levelIndices, meshData.vertices.size(), MeshOptimizer::DefaultCacheSize, clusters);
+                std::copy(optimizedIndices.begin(), optimizedIndices.end(), levelBegin);
+
+                printf("Built LOD %zu (%u triangles, %.1f%%, error %g)\n",
+                    static_cast<size_t>(&level - meshData.lods.levels.data()) + 1,
+                    level.indexCount / 3,
+                    100.0 * static_cast<double>(level.indexCount) / static_cast<double>(meshData.indices.size()),
+                    static_cast<double>(level.error)
+                );
+            }
+        }
+
+        /// @brief Squared distance from a point to a triangle, closest feature search from Real-Time Collision Detection 5.1.5.
+        static float pointTriangleDistanceSquared(glm::vec3 const& p, glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c)
+        {
+            glm::vec3 const ab = b - a;
+            glm::vec3 const ac = c - a;
+            glm::vec3 const ap = p - a;
+            float const d1 = glm::dot(ab, ap);
+            float const d2 = glm::dot(ac, ap);
+            if (d1 <= 0.0F && d2 <= 0.0F) {
+                return glm::dot(ap, ap);
+            }
+
+            glm::vec3 const bp = p - b;
+            float const d3 = glm::dot(ab, bp);
+            float const d4 = glm::dot(ac, bp);
+            if (d3 >= 0.0F && d4 <= d3) {
+                return glm::dot(bp, bp);
+            }
+
+            float const vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.0F && d1 >= 0.0F && d3 <= 0.0F)
+            {
+                glm::vec3 const delta = ap - ab * (d1 / (d1 - d3));
+                return glm::dot(delta, delta);
+            }
+
+            glm::vec3 const cp = p - c;
+            float const d5 = glm::dot(ab, cp);
+            float const d6 = glm::dot(ac, cp);
+            if (d6 >= 0.0F && d5 <= d6) {
+                return glm::dot(cp, cp);
+            }
+
+            float const vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.0F && d2 >= 0.0F && d6 <= 0.0F)
+            {
+                glm::vec3 const delta = ap - ac * (d2 / (d2 - d6));
+                return glm::dot(delta, delta);
+            }
+
+            float const va = d3 * d6 - d5 * d4;
+            if (va <= 0.0F && (d4 - d3) >= 0.0F && (d5 - d6) >= 0.0F)
+            {
+                glm::vec3 const delta = bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+                return glm::dot(delta, delta);
+            }
+
+            float const denominator = 1.0F / (va + vb + vc);
+            glm::vec3 const delta = ap - ab * (vb * denominator) - ac * (vc * denominator);
+            return glm::dot(delta, delta);
+        }
+
+        float measureError(std::vector<Vertex> const& vertices, uint32_t const* pIndices, size_t indexCount)
+        {
+            assert(indexCount % 3 == 0);
+            size_t const triangleCount = indexCount / 3;
+            if (triangleCount == 0 || vertices.empty()) {
+                return 0.0F;
+            }
+
+            size_t const vertexStride = std::max<size_t>(1, (vertices.size() * triangleCount) / MaxErrorSamples);
+            float maxDistanceSquared = 0.0F;
+            for (size_t vertexIdx = 0; vertexIdx < vertices.size(); vertexIdx += vertexStride)
+            {
+                glm::vec3 const& point = vertices[vertexIdx].position;
+                float minDistanceSquared = INFINITY;
+                for (size_t triangleIdx = 0; triangleIdx < triangleCount && minDistanceSquared > 0.0F; triangleIdx++)
+                {
+                    minDistanceSquared = std::min(minDistanceSquared, pointTriangleDistanceSquared(point,
+                        vertices[pIndices[triangleIdx * 3 + 0]].position,
+                        vertices[pIndices[triangleIdx * 3 + 1]].position,
+                        vertices[pIndices[triangleIdx * 3 + 2]].position
+                    ));
+                }
+
+                maxDistanceSquared = std::max(maxDistanceSquared, minDistanceSquared);
+            }
+
+            return std::sqrt(maxDistanceSquared);
+        }
+
+        uint32_t selectLod(std::vector<LodLevel> const& levels, glm::vec3 const& center, float radius, float scale, Camera const& camera, float viewportHeight, float thresholdPixels)
+        {
+            // Closest point of the bounding sphere, clamped to the near plane when the camera is inside
+            float const distance = std::max(glm::length(center - camera.position) - radius, camera.zNear);
+            float const pixelsPerUnit = viewportHeight / (2.0F * distance * std::tan(glm::radians(camera.FOVy) * 0.5F));
+
+            uint32_t selected = 0;
+            for (size_t levelIdx = 0; levelIdx < levels.size(); levelIdx++)
+            {
+                if (levels[levelIdx].error * scale * pixelsPerUnit > thresholdPixels) {
+                    break;
+                }
+
+                selected = static_cast<uint32_t>(levelIdx + 1);
+            }
+
+            return selected;
+        }
+    } // namespace Lods
+} // namespace Engine
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+
+namespace Engine
+{
+    namespace Lods
+    {
+        constexpr float DefaultLodRatios[] = { 0.5F, 0.25F, 0.125F };
+        constexpr float DefaultErrorThreshold = 1.0F;  //< pixels
+        constexpr float MinLodReduction = 0.9F;         //< stop the chain if a level keeps more than this ratio of its parent's triangles
+
+        /// @brief Simplify the mesh with quadric error ordered half edge collapses, snapshotting a level at each triangle ratio.
+        /// Levels keep referencing the full detail vertices. Border & attribute seam vertices are locked, attribute
+        /// differences add to the collapse cost. Ratios must be descending.
+        void buildLods(MeshData const& meshData, LodData& lodData, float const* pRatios, size_t ratioCount);
+
+        /// @brief Build the default 50 / 25 / 12.5% chain & vertex cache optimize each level.
+        void buildLods(MeshData& meshData);
+
+        /// @brief Maximum distance from the full detail vertices to a simplified triangle list, the measured geometric error.
+        float measureError(std::vector<Vertex> const& vertices, uint32_t const* pIndices, size_t indexCount);
+
+        /// @brief Pick the coarsest level whose error projects to less than thresholdPixels on screen, 0 is full detail.
+        /// Center & radius are the world space bounding sphere, scale the largest object to world scale factor.
+        uint32_t selectLod(std::vector<LodLevel> const& levels, glm::vec3 const& center, float radius, float scale, Camera const& camera, float viewportHeight, float thresholdPixels = DefaultErrorThreshold);
+    } // namespace Lods
+} // namespace Engine
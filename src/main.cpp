@@ -1,17 +1,19 @@
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
 #include <vector>
 
 #define SDL_MAIN_HANDLED
-#define STB_IMAGE_IMPLEMENTATION
-#define TINYOBJLOADER_IMPLEMENTATION
 #include <imgui.h>
 #include <imgui_impl_sdl2.h>
 #include <imgui_impl_dx12.h>
 #include <SDL.h>
 #include <SDL_syswm.h>
-#include <stb_image.h>
-#include <tiny_obj_loader.h>
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
@@ -22,9 +24,30 @@
 #include <directx/d3dx12.h>
 #include <d3dcompiler.h>
 
+#include "asset_loader.hpp"
+#include "block_compression.hpp"
+#include "command_recorder.hpp"
+#include "culling.hpp"
+#include "draw_packet.hpp"
+#include "job_system.hpp"
+#include "lod.hpp"
 #include "math.hpp"
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "meshlet.hpp"
+#include "render_graph.hpp"
 #include "renderer.hpp"
+#include "scene.hpp"
+#include "scene_bvh.hpp"
+#include "shader_cache.hpp"
+#include "startup.hpp"
+#include "task_graph.hpp"
+#include "texture_cache.hpp"
+#include "texture_data.hpp"
 #include "timer.hpp"
+#include "transform_array.hpp"
+#include "triangle_bvh.hpp"
+#include "vertex_packing.hpp"
 
 #define sizeof_array(val)   (sizeof((val)) / sizeof((val)[0]))
 
@@ -32,56 +55,18 @@ using Microsoft::WRL::ComPtr;
 
 namespace Engine
 {
-    /// @brief Interleaved vertex data.
-    struct Vertex
-    {
-        glm::vec3 position;
-        glm::vec3 color;
-        glm::vec3 normal;
-        glm::vec3 tangent;
-        glm::vec2 texCoord;
-    };
-
-    /// @brief Simple TRS transform.
-    struct Transform
-    {
-        glm::mat4 matrix() const
-        {
-            return glm::translate(glm::identity<glm::mat4>(), position)
-                * glm::mat4_cast(rotation)
-                * glm::scale(glm::identity<glm::mat4>(), scale);
-        }
-
-        glm::vec3 position = glm::vec3(0.0F);
-        glm::quat rotation = glm::quat(1.0F, 0.0F, 0.0F, 0.0F);
-        glm::vec3 scale = glm::vec3(1.0F);
-    };
-
-    /// @brief Virtual camera.
-    struct Camera
-    {
-        glm::mat4 matrix() const
-        {
-            return glm::perspective(glm::radians(FOVy), aspectRatio, zNear, zFar) * glm::lookAt(position, position + forward, up);
-        }
-
-        // Camera transform
-        glm::vec3 position = glm::vec3(0.0F);
-        glm::vec3 forward = glm::vec3(0.0F, 0.0F, 1.0F);
-        glm::vec3 up = glm::vec3(0.0F, 1.0F, 0.0F);
-
-        // Perspective camera data
-        float FOVy = 60.0F;
-        float aspectRatio = 1.0F;
-        float zNear = 0.1F;
-        float zFar = 100.0F;
-    };
-
     /// @brief Mesh data with indexed vertices.
     struct Mesh
     {
         uint32_t vertexCount = 0;
         uint32_t indexCount = 0;
+        uint32_t vertexStride = 0;
+        DXGI_FORMAT indexFormat = DXGI_FORMAT_UNKNOWN;
+        VertexPacking::QuantizationBounds quantizationBounds{};
+        MeshBounds bounds{}; //< object space culling bounds
+        MeshletData meshlets{}; //< CPU side culling data, meshlet triangles are contiguous in the index buffer
+        std::vector<LodLevel> lodLevels{}; //< LOD indices follow the full detail indices in the index buffer
+        TriangleBvh triangleBvh{}; //< object space triangles of the full detail mesh for picking
         Buffer vertexBuffer{};
         Buffer indexBuffer{};
 
@@ -92,6 +77,26 @@ namespace Engine
         }
     };
 
+    /// @brief Cooked texture whose levels above the mip tail are uploaded one at a time, most detailed last.
+    struct TextureStream
+    {
+        char const* path = nullptr;
+        std::unique_ptr<AssetLoader::TextureSource> pSource;
+        Texture* pTexture = nullptr;
+        uint32_t textureIdx = 0;
+        uint32_t residentLevel = 0; //< most detailed level with a completed copy
+        uint32_t pendingLevel = 0;  //< level being copied, resident once the frame copying it completed
+        uint64_t pendingFenceValue = 0;
+    };
+
+    /// @brief Startup uploads recorded by concurrent resource creation & submitted together with a single GPU wait. Staging
+    /// memory comes from the upload ring, guarded by the batch lock until startup finished.
+    struct UploadBatch
+    {
+        std::mutex mutex;
+        ComPtr<ID3D12GraphicsCommandList> commandList;
+    };
+
     /// @brief Scene constant buffer data.
     struct alignas(256) SceneData
     {
@@ -100,40 +105,69 @@ namespace Engine
         alignas(16) glm::vec3 ambientLight;
         alignas(16) glm::vec3 cameraPosition;
         alignas(16) glm::mat4 viewproject;
-        alignas(16) glm::mat4 model;
-        alignas(16) glm::mat4 normal;
         alignas(4)  float specularity;
     };
 
+    /// @brief Per mesh root constants, used to dequantize packed vertex positions.
+    struct MeshConstants
+    {
+        glm::vec4 positionMin;
+        glm::vec4 positionExtent;
+    };
+
     constexpr char const* WindowTitle = "DX12 Renderer";
     constexpr uint32_t DefaultWindowWidth = 1600;
     constexpr uint32_t DefaultWindowHeight = 900;
+    constexpr bool UsePackedVertices = true; //< upload meshes as PackedVertex instead of full float Vertex
+    constexpr uint64_t MeshUploadAlignment = 16;
+    constexpr size_t MeshletCullGrainSize = 64; //< meshlets culled per job
+    constexpr uint32_t MinDrawsPerCommandList = 256; //< fewer draws aren't worth another command list
+    constexpr uint32_t MaxInstanceCount = 65536; //< capacity of the per frame instance buffers
+    constexpr size_t InstanceGrainSize = 4096; //< instance transforms animated, culled & written per job
+    constexpr float InstanceSpacing = 3.0F; //< distance between instances on the scene grid
+    constexpr uint32_t ForwardPass = 0; //< draw key ids, the scene has a single pipeline, material & mesh so far
+    constexpr uint32_t ForwardPipeline = 0;
+    constexpr uint32_t SceneMaterial = 0;
+    constexpr uint32_t SceneMesh = 0;
 
     bool isRunning = true;
     SDL_Window* window = nullptr;
     Timer frameTimer{};
+    std::unique_ptr<JobSystem> jobSystem; //< per frame CPU work, the main thread is worker 0
 
-    // ImGui Heap
-    ComPtr<ID3D12DescriptorHeap> ImGuiSRVHeap = nullptr; //< SRV heap specifically for ImGUI usage
+    // ImGui data
+    uint32_t ImGuiFontDescriptor = DescriptorFreeList::InvalidIndex; //< static descriptor for the ImGui font atlas
 
     // Per pass data
     ComPtr<ID3D12RootSignature> rootSignature = nullptr; //< determines shader bind points
     ComPtr<ID3D12PipelineState> graphicsPipeline = nullptr; //< determines pipeline stages & programming
     D3D12_VIEWPORT viewport{};
     D3D12_RECT scissor{};
+    RenderGraphResources frameGraphResources{}; //< frame graph transients, kept while their descriptions are unchanged
 
     // Per scene data
-    ComPtr<ID3D12DescriptorHeap> descriptorResourceHeap = nullptr;
-    Buffer sceneDataBuffer{};
+    uint32_t materialDescriptors = DescriptorFreeList::InvalidIndex; //< static material SRV table, replaced by a full one once every texture is resident
+    uint32_t retiredMaterialDescriptors = DescriptorFreeList::InvalidIndex; //< replaced table, freed once the frames that could bind it completed
+    uint64_t retiredMaterialFenceValue = 0;
+    Buffer sceneDataBuffers[Renderer::FrameCount]{}; //< per frame slot, written once the slot's previous frame completed
+    Buffer instanceBuffers[Renderer::FrameCount]{}; //< per frame slot instance matrices, indexed by SV_InstanceID
 
     // Scene objects
     Camera camera{};
-    Transform transform{};
+    TransformArray transforms{}; //< instances of the mesh
+    SceneBvh instanceBvh{}; //< instance bounds, refit with the moved instances while BVH culling is enabled
+    bool instanceBvhStale = true; //< instances moved while BVH culling was disabled, the tree is rebuilt once it's enabled
     Mesh mesh{};
 
     // Material data
     Texture colorTexture{};
     Texture normalTexture{};
+    Texture* materialTextures[Startup::MaterialTextureCount] = { &colorTexture, &normalTexture };
+    std::vector<TextureStream> textureStreams;
+    std::mutex textureStreamMutex; //< textures are created concurrently at startup
+
+    // Startup uploads
+    UploadBatch uploadBatch{};
 
     // CPU side renderer data
     float sunAzimuth = 0.0F;
@@ -141,185 +175,571 @@ namespace Engine
     glm::vec3 sunColor = glm::vec3(1.0F);
     glm::vec3 ambientLight = glm::vec3(0.1F);
     float specularity = 0.5F;
+    bool meshletCulling = false;
+    int instanceCount = 1;
+    bool instanceCulling = true;
+    bool bvhCulling = false; //< cull instances through the scene BVH instead of testing every sphere
+    int forcedLod = -1; //< -1 selects by screen space error
+    float lodErrorThreshold = Lods::DefaultErrorThreshold;
+    std::vector<uint8_t> instanceLods; //< LOD selected per drawn visible instance, in visible order
+    std::vector<uint32_t> lodInstanceCounts; //< drawn instances per LOD, full detail first
+    std::vector<uint32_t> lodInstanceScratch; //< visible instances bucketed by LOD before they replace the visible list
+    uint32_t visibleMeshlets = 0;
+    uint32_t visibleTriangles = 0;
+    std::vector<DrawPacket> drawPackets; //< sorted by key once selected, contiguous index ranges in each draw
+    std::vector<DrawPacket> drawPacketScratch;
+    DrawStatistics drawStatistics{}; //< state set by the last frame's forward pass
+    std::vector<uint8_t> meshletVisibility; //< written by the culling jobs, merged into draw ranges in order
+    SphereArray instanceSpheres; //< world space instance bounds, updated for the moved instances
+    std::vector<uint32_t> movedInstances; //< per culling chunk, the instances whose spheres were updated this frame
+    std::vector<uint32_t> instanceMovedCounts; //< moved instances per culling chunk
+    uint32_t movedInstanceCount = 0;
+    bool spinInstances = true;
+    std::vector<uint32_t> visibleInstances; //< the instances drawn this frame in index order, grouped by LOD once draws are selected
+    std::vector<uint32_t> instanceCullCounts; //< visible instances per culling chunk
+    uint32_t visibleInstanceCount = 0;
+    bool picking = false; //< pick the instance & triangle under the cursor on left click
+    uint32_t pickedInstance = TransformArray::InvalidIndex;
+    TriangleHit pickedHit{}; //< world space distance & position, triangle & barycentrics of the picked mesh
+    double pickTimeMS = 0.0;
     SceneData sceneData = SceneData{};
 
     namespace D3D12Helpers
     {
-        bool createMesh(Mesh& mesh, Vertex* pVertices, uint32_t vertexCount, uint32_t* pIndices, uint32_t indexCount)
+        /// @brief Execute the recorded uploads & wait for them, called with the batch lock held.
+        bool flushUploadBatch()
         {
-            assert(pVertices != nullptr);
-            assert(pIndices != nullptr);
-            assert(vertexCount > 0);
-            assert(indexCount > 0);
-         
-            uint32_t const vertexBufferSize = vertexCount * sizeof(Vertex);
-            uint32_t const indexBufferSize = indexCount * sizeof(uint32_t);
-
-            mesh.vertexCount = vertexCount;
-            mesh.indexCount = indexCount;
+            if (uploadBatch.commandList == nullptr) {
+                return true;
+            }
 
-            if (!Renderer::createBuffer(mesh.vertexBuffer, vertexBufferSize, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD)) {
+            if (FAILED(uploadBatch.commandList->Close()))
+            {
+                printf("D3D12 upload command list close failed\n");
                 return false;
             }
 
-            if (!Renderer::createBuffer(mesh.indexBuffer, indexBufferSize, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD)) {
+            ID3D12CommandList* ppUploadCommandLists[] = { uploadBatch.commandList.Get() };
+            Renderer::commandQueue->ExecuteCommandLists(1, ppUploadCommandLists);
+            Renderer::fenceUploads();
+            Renderer::waitForGPU();
+
+            uploadBatch.commandList.Reset();
+            return SUCCEEDED(Renderer::uploadCommandAllocator->Reset());
+        }
+
+        /// @brief Sub-allocate staging memory & open the batch command list, called with the batch lock held. A full upload ring
+        /// flushes the batch once to reclaim its staging memory.
+        bool allocateBatchUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+        {
+            if (!Renderer::allocateUpload(size, alignment, allocation)
+                && (!flushUploadBatch() || !Renderer::allocateUpload(size, alignment, allocation)))
+            {
+                printf("D3D12 upload ring exhausted (%llu B requested)\n", static_cast<unsigned long long>(size));
                 return false;
             }
 
-            mesh.vertexBuffer.map();
-            memcpy(mesh.vertexBuffer.pData, pVertices, vertexBufferSize);
-            mesh.vertexBuffer.unmap();
-
-            mesh.indexBuffer.map();
-            memcpy(mesh.indexBuffer.pData, pIndices, indexBufferSize);
-            mesh.indexBuffer.unmap();
+            if (uploadBatch.commandList == nullptr
+                && FAILED(Renderer::device->CreateCommandList(0x00, D3D12_COMMAND_LIST_TYPE_DIRECT, Renderer::uploadCommandAllocator.Get(), nullptr, IID_PPV_ARGS(&uploadBatch.commandList))))
+            {
+                printf("D3D12 upload command list create failed\n");
+                return false;
+            }
 
             return true;
         }
 
-        bool loadOBJ(char const* path, Mesh& mesh)
+        /// @brief Execute all recorded startup uploads & wait for them once.
+        bool submitUploads()
         {
-            tinyobj::ObjReader reader;
-            tinyobj::ObjReaderConfig config;
+            std::lock_guard<std::mutex> lock(uploadBatch.mutex);
+            return flushUploadBatch();
+        }
 
-            config.triangulate = true;
-            config.triangulation_method = "earcut";
-            config.vertex_color = true;
+        bool createMesh(Mesh& mesh, Vertex const* pVertices, uint32_t vertexCount, uint32_t const* pIndices, uint32_t indexCount, uint32_t const* pLodIndices, uint32_t lodIndexCount)
+        {
+            assert(pVertices != nullptr);
+            assert(pIndices != nullptr);
+            assert(pLodIndices != nullptr || lodIndexCount == 0);
+            assert(vertexCount > 0);
+            assert(indexCount > 0);
 
-            if (!reader.ParseFromFile(path))
-            {
-                printf("TinyOBJ OBJ load failed [%s]\n", path);
+            bool const useShortIndices = VertexPacking::indexFormat(vertexCount) == VertexPacking::IndexFormat::R16_UINT;
+            uint32_t const vertexStride = UsePackedVertices ? sizeof(PackedVertex) : sizeof(Vertex);
+            uint32_t const indexStride = useShortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+            uint32_t const vertexBufferSize = vertexCount * vertexStride;
+            uint32_t const indexBufferSize = (indexCount + lodIndexCount) * indexStride;
+
+            mesh.vertexCount = vertexCount;
+            mesh.indexCount = indexCount;
+            mesh.vertexStride = vertexStride;
+            mesh.indexFormat = useShortIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+            mesh.quantizationBounds = VertexPacking::computeBounds(pVertices, vertexCount);
+            mesh.bounds = Culling::computeBounds(pVertices, vertexCount);
+            mesh.triangleBvh.build(pVertices, vertexCount, pIndices, indexCount);
+
+            // Static geometry lives in the default heap, filled through the upload ring by the startup batch
+            if (!Renderer::createBuffer(mesh.vertexBuffer, vertexBufferSize, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_DEFAULT)) {
+                return false;
+            }
+
+            if (!Renderer::createBuffer(mesh.indexBuffer, indexBufferSize, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_DEFAULT)) {
                 return false;
             }
-            printf("Loaded OBJ mesh [%s]\n", path);
 
-            auto const& attrib = reader.GetAttrib();
-            auto const& shapes = reader.GetShapes();
+            // Vertices & indices share one staging allocation, a second one could flush the batch before the first is copied
+            uint64_t const indexUploadOffset = (vertexBufferSize + MeshUploadAlignment - 1) & ~(MeshUploadAlignment - 1);
+            std::lock_guard<std::mutex> lock(uploadBatch.mutex);
+            UploadAllocation upload{};
+            if (!allocateBatchUpload(indexUploadOffset + indexBufferSize, MeshUploadAlignment, upload)) {
+                return false;
+            }
 
-            std::vector<Vertex> vertices;
-            std::vector<uint32_t> indices;
-            for (auto const& shape : shapes)
+            void* const pVertexUpload = upload.pData;
+            void* const pIndexUpload = static_cast<uint8_t*>(upload.pData) + indexUploadOffset;
+            if constexpr (UsePackedVertices) {
+                VertexPacking::packVertices(pVertices, vertexCount, mesh.quantizationBounds, static_cast<PackedVertex*>(pVertexUpload));
+            }
+            else {
+                memcpy(pVertexUpload, pVertices, vertexBufferSize);
+            }
+
+            if (useShortIndices)
             {
-                vertices.reserve(vertices.size() + shape.mesh.indices.size());
-                indices.reserve(indices.size() + shape.mesh.indices.size());
+                uint16_t* pShortIndices = static_cast<uint16_t*>(pIndexUpload);
+                for (uint32_t i = 0; i < indexCount; i++) {
+                    pShortIndices[i] = static_cast<uint16_t>(pIndices[i]);
+                }
 
-                for (auto const& index : shape.mesh.indices)
-                {
-                    size_t vertexIdx = index.vertex_index * 3;
-                    size_t normalIdx = index.normal_index * 3;
-                    size_t texIdx = index.texcoord_index * 2;
-
-                    vertices.push_back(Vertex{
-                        { attrib.vertices[vertexIdx + 0], attrib.vertices[vertexIdx + 1], attrib.vertices[vertexIdx + 2] },
-                        { attrib.colors[vertexIdx + 0], attrib.colors[vertexIdx + 1], attrib.colors[vertexIdx + 2] },
-                        { attrib.normals[normalIdx + 0], attrib.normals[normalIdx + 1], attrib.normals[normalIdx + 2] },
-                        { 0.0F, 0.0F, 0.0F }, //< tangents are calculated after loading
-                        { attrib.texcoords[texIdx + 0], attrib.texcoords[texIdx + 1] },
-                    });
-                    indices.push_back(static_cast<uint32_t>(indices.size())); //< works because mesh is triangulated
+                for (uint32_t i = 0; i < lodIndexCount; i++) {
+                    pShortIndices[indexCount + i] = static_cast<uint16_t>(pLodIndices[i]);
+                }
+            }
+            else
+            {
+                memcpy(pIndexUpload, pIndices, indexCount * sizeof(uint32_t));
+                if (lodIndexCount > 0) {
+                    memcpy(static_cast<uint32_t*>(pIndexUpload) + indexCount, pLodIndices, lodIndexCount * sizeof(uint32_t));
                 }
             }
 
-            // calculate tangents based on position & texture coords
-            assert(indices.size() % 3 == 0); //< Need multiple of 3 for triangle indices
-            for (size_t i = 0; i < indices.size(); i += 3)
+            uploadBatch.commandList->CopyBufferRegion(mesh.vertexBuffer.handle.Get(), 0, upload.pResource, upload.offset, vertexBufferSize);
+            uploadBatch.commandList->CopyBufferRegion(mesh.indexBuffer.handle.Get(), 0, upload.pResource, upload.offset + indexUploadOffset, indexBufferSize);
+
+            D3D12_RESOURCE_BARRIER const meshUploadBarriers[] = {
+                CD3DX12_RESOURCE_BARRIER::Transition(mesh.vertexBuffer.handle.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER),
+                CD3DX12_RESOURCE_BARRIER::Transition(mesh.indexBuffer.handle.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER),
+            };
+            uploadBatch.commandList->ResourceBarrier(sizeof_array(meshUploadBarriers), meshUploadBarriers);
+
+            uint32_t const fullSize = vertexCount * static_cast<uint32_t>(sizeof(Vertex)) + indexCount * static_cast<uint32_t>(sizeof(uint32_t));
+            uint32_t const fetchSize = vertexBufferSize + indexCount * indexStride;
+            printf("Created mesh (%u vertices @ %u B, %u + %u LOD indices @ %u B): %.1f KiB per full detail draw fetch, %.1f KiB unpacked (%.0f%%)\n",
+                vertexCount, vertexStride,
+                indexCount, lodIndexCount, indexStride,
+                static_cast<double>(fetchSize) / 1024.0,
+                static_cast<double>(fullSize) / 1024.0,
+                100.0 * static_cast<double>(fetchSize) / static_cast<double>(fullSize)
+            );
+
+            return true;
+        }
+
+        /// @brief Create the mesh buffers from a mapped cache or freshly processed mesh data.
+        bool loadMesh(Mesh& mesh, AssetLoader::MeshSource& source)
+        {
+            if (source.cached)
             {
-                Vertex& v0 = vertices[indices[i + 0]];
-                Vertex& v1 = vertices[indices[i + 1]];
-                Vertex& v2 = vertices[indices[i + 2]];
+                MeshCache::CachedMesh const& cachedMesh = source.cachedMesh;
+                MeshCache::readMeshlets(cachedMesh, mesh.meshlets);
 
-                glm::vec3 const e1 = v1.position - v0.position;
-                glm::vec3 const e2 = v2.position - v0.position;
-                glm::vec2 const dUV1 = v1.texCoord - v0.texCoord;
-                glm::vec2 const dUV2 = v2.texCoord - v0.texCoord;
+                LodData lods{};
+                MeshCache::readLods(cachedMesh, lods);
+                mesh.lodLevels = std::move(lods.levels);
+                return createMesh(mesh, cachedMesh.pVertices, cachedMesh.vertexCount, cachedMesh.pIndices, cachedMesh.indexCount, lods.indices.data(), static_cast<uint32_t>(lods.indices.size()));
+            }
+
+            MeshData& meshData = source.meshData;
+            mesh.meshlets = std::move(meshData.meshlets);
+            mesh.lodLevels = meshData.lods.levels;
 
-                float const f = 1.0F / (dUV1.x * dUV2.y - dUV1.y * dUV2.x);
-                glm::vec3 const tangent = f * (dUV2.y * e1 - dUV1.y * e2);
+            return createMesh(
+                mesh,
+                meshData.vertices.data(), static_cast<uint32_t>(meshData.vertices.size()),
+                meshData.indices.data(), static_cast<uint32_t>(meshData.indices.size()),
+                meshData.lods.indices.data(), static_cast<uint32_t>(meshData.lods.indices.size())
+            );
+        }
 
-                v0.tangent = tangent;
-                v1.tangent = tangent;
-                v2.tangent = tangent;
+        DXGI_FORMAT textureFormat(TextureFormat format)
+        {
+            switch (format)
+            {
+            case TextureFormat::BC1: return DXGI_FORMAT_BC1_UNORM;
+            case TextureFormat::BC3: return DXGI_FORMAT_BC3_UNORM;
+            case TextureFormat::BC4: return DXGI_FORMAT_BC4_UNORM;
+            case TextureFormat::BC5: return DXGI_FORMAT_BC5_UNORM;
+            case TextureFormat::BC7: return DXGI_FORMAT_BC7_UNORM;
+            default: return DXGI_FORMAT_R8G8B8A8_UNORM;
             }
+        }
 
-            return createMesh(mesh, vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()));
+        void createTextureSRV(Texture const& texture, uint32_t descriptorIdx, uint32_t mostDetailedLevel)
+        {
+            D3D12_SHADER_RESOURCE_VIEW_DESC textureViewDesc{};
+            textureViewDesc.Format = texture.format;
+            textureViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            textureViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            textureViewDesc.Texture2D.MostDetailedMip = mostDetailedLevel;
+            textureViewDesc.Texture2D.MipLevels = texture.levels - mostDetailedLevel;
+            textureViewDesc.Texture2D.PlaneSlice = 0;
+            textureViewDesc.Texture2D.ResourceMinLODClamp = 0.0F;
+            Renderer::device->CreateShaderResourceView(texture.handle.Get(), &textureViewDesc, Renderer::cpuDescriptor(descriptorIdx));
         }
 
-        bool loadTexture(char const* path, Texture& texture)
+        /// @brief Record the upload of a range of levels into the startup batch & transition them to shader resources, other
+        /// levels stay in the copy destination state. Thread safe, the copy happens once the batch is submitted.
+        bool uploadTextureLevels(Texture& texture, D3D12_SUBRESOURCE_DATA const* pSubresources, uint32_t firstLevel, uint32_t levelCount)
         {
-            assert(path != nullptr);
+            uint64_t const uploadSize = GetRequiredIntermediateSize(texture.handle.Get(), firstLevel, levelCount);
 
-            int texWidth = 0;
-            int texHeight = 0;
-            int texChannels = 0;
-            stbi_uc* pTextureData = stbi_load(path, &texWidth, &texHeight, &texChannels, 4); // XXX: assumes 4 channels always, is this OK?
-            if (pTextureData == nullptr)
-            {
-                printf("STB Image texture load failed [%s]\n", path);
+            std::lock_guard<std::mutex> lock(uploadBatch.mutex);
+            UploadAllocation upload{};
+            if (!allocateBatchUpload(uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, upload)) {
                 return false;
             }
-            printf("Loaded texture [%s] (%d x %d x %d)\n", path, texWidth, texHeight, texChannels);
 
+            UpdateSubresources(uploadBatch.commandList.Get(), texture.handle.Get(), upload.pResource, upload.offset, firstLevel, levelCount, pSubresources);
+
+            std::vector<D3D12_RESOURCE_BARRIER> textureUploadBarriers;
+            for (uint32_t levelIdx = firstLevel; levelIdx < firstLevel + levelCount; levelIdx++) {
+                textureUploadBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(texture.handle.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, levelIdx));
+            }
+            uploadBatch.commandList->ResourceBarrier(static_cast<UINT>(textureUploadBarriers.size()), textureUploadBarriers.data());
+            return true;
+        }
+
+        bool createTexture(Texture& texture, TextureFormat format, uint32_t width, uint32_t height, uint32_t levelCount)
+        {
             if (!Renderer::createTexture(
                 texture,
                 D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-                DXGI_FORMAT_R8G8B8A8_UNORM,
+                textureFormat(format),
                 D3D12_RESOURCE_FLAG_NONE,
                 D3D12_RESOURCE_STATE_COPY_DEST,
                 D3D12_HEAP_TYPE_DEFAULT,
-                texWidth, texHeight, 1
+                width, height, 1,
+                levelCount
             ))
             {
                 printf("D3D12 texture create failed\n");
-                stbi_image_free(pTextureData);
                 return false;
             }
 
-            uint64_t uploadBufferSize = GetRequiredIntermediateSize(texture.handle.Get(), 0, 1);
-            Buffer uploadBuffer{};
-            if (!Renderer::createBuffer(uploadBuffer, uploadBufferSize, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD))
-            {
-                printf("D3D12 texture upload buffer create failed\n");
-                stbi_image_free(pTextureData);
+            return true;
+        }
+
+        bool createTexture(Texture& texture, TextureData const& textureData)
+        {
+            assert(!textureData.levels.empty());
+
+            uint32_t const levelCount = static_cast<uint32_t>(textureData.levels.size());
+            if (!createTexture(texture, textureData.format, textureData.levels[0].width, textureData.levels[0].height, levelCount)) {
                 return false;
             }
 
-            // Perform upload using transient commandlist
+            std::vector<D3D12_SUBRESOURCE_DATA> subresourceData(levelCount);
+            for (uint32_t levelIdx = 0; levelIdx < levelCount; levelIdx++)
             {
-                ComPtr<ID3D12GraphicsCommandList> uploadCommandList;
-                if (FAILED(Renderer::device->CreateCommandList(0x00, D3D12_COMMAND_LIST_TYPE_DIRECT, Renderer::commandAllocator.Get(), nullptr, IID_PPV_ARGS(&uploadCommandList))))
-                {
-                    printf("D3D12 upload command list create failed\n");
-                    stbi_image_free(pTextureData);
+                TextureLevel const& level = textureData.levels[levelIdx];
+                subresourceData[levelIdx].pData = level.data.data();
+                subresourceData[levelIdx].RowPitch = static_cast<LONG_PTR>(BlockCompression::rowPitch(textureData.format, level.width));
+                subresourceData[levelIdx].SlicePitch = subresourceData[levelIdx].RowPitch * BlockCompression::rowCount(textureData.format, level.height);
+            }
+
+            return uploadTextureLevels(texture, subresourceData.data(), 0, levelCount);
+        }
+
+        /// @brief Cached levels are already in their final format & row pitch, subresources point straight into the mapping.
+        D3D12_SUBRESOURCE_DATA cachedSubresource(TextureCache::CachedTexture const& cachedTexture, uint32_t levelIdx)
+        {
+            TextureCache::Level const& level = cachedTexture.pHeader->levels[levelIdx];
+            D3D12_SUBRESOURCE_DATA subresource{};
+            subresource.pData = cachedTexture.levelData(levelIdx);
+            subresource.RowPitch = static_cast<LONG_PTR>(level.rowPitch);
+            subresource.SlicePitch = static_cast<LONG_PTR>(level.rowPitch) * level.rowCount;
+            return subresource;
+        }
+
+        /// @brief Create the texture & its static SRV. Imported data is uploaded whole, cooked caches upload their mip tail now &
+        /// stream the remaining levels in from streamTextures, the SRVs only covering resident levels.
+        bool loadTexture(Texture& texture, uint32_t textureIdx, char const* path, std::unique_ptr<AssetLoader::TextureSource>& pSource)
+        {
+            if (!pSource->cached)
+            {
+                if (!createTexture(texture, pSource->textureData)) {
                     return false;
                 }
 
-                D3D12_SUBRESOURCE_DATA textureResourceData{};
-                textureResourceData.pData = pTextureData;
-                textureResourceData.RowPitch = texWidth * 4;
-                textureResourceData.SlicePitch = texWidth * texHeight * 4;
+                createTextureSRV(texture, materialDescriptors + textureIdx, 0);
+                return true;
+            }
+
+            TextureCache::CachedTexture const& cachedTexture = pSource->cachedTexture;
+            TextureCache::Header const& header = *cachedTexture.pHeader;
+            if (!createTexture(texture, cachedTexture.format(), header.levels[0].width, header.levels[0].height, header.levelCount)) {
+                return false;
+            }
+
+            uint32_t const tailLevel = cachedTexture.tailLevel();
+            std::vector<D3D12_SUBRESOURCE_DATA> subresourceData;
+            for (uint32_t levelIdx = tailLevel; levelIdx < header.levelCount; levelIdx++) {
+                subresourceData.push_back(cachedSubresource(cachedTexture, levelIdx));
+            }
+
+            if (!uploadTextureLevels(texture, subresourceData.data(), tailLevel, header.levelCount - tailLevel)) {
+                return false;
+            }
+
+            createTextureSRV(texture, materialDescriptors + textureIdx, tailLevel);
+            if (tailLevel == 0) {
+                return true;
+            }
+
+            TextureStream stream{};
+            stream.path = path;
+            stream.pSource = std::move(pSource);
+            stream.pTexture = &texture;
+            stream.textureIdx = textureIdx;
+            stream.residentLevel = tailLevel;
+            stream.pendingLevel = tailLevel;
 
-                UpdateSubresources(uploadCommandList.Get(), texture.handle.Get(), uploadBuffer.handle.Get(), 0, 0, 1, &textureResourceData);
+            std::lock_guard<std::mutex> lock(textureStreamMutex);
+            textureStreams.push_back(std::move(stream));
+            return true;
+        }
 
-                D3D12_RESOURCE_BARRIER textureUploadBarrier = CD3DX12_RESOURCE_BARRIER::Transition(texture.handle.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                uploadCommandList->ResourceBarrier(1, &textureUploadBarrier);
-                
-                if (FAILED(uploadCommandList->Close()))
+        /// @brief Promote completed levels & record the copy of the next more detailed level of each streaming texture on the
+        /// frame's command list, one level in flight per texture. Switches to a full static table once every level is resident.
+        void streamTextures()
+        {
+            uint64_t const completedValue = Renderer::fence->GetCompletedValue();
+            for (auto& stream : textureStreams)
+            {
+                if (stream.pendingLevel < stream.residentLevel && stream.pendingFenceValue <= completedValue)
                 {
-                    printf("D3D12 upload command list close failed\n");
-                    stbi_image_free(pTextureData);
-                    return false;
+                    stream.residentLevel = stream.pendingLevel;
+                    if (stream.residentLevel == 0) {
+                        printf("Streamed texture fully resident [%s]\n", stream.path);
+                    }
+                }
+
+                if (stream.residentLevel == 0 || stream.pendingLevel < stream.residentLevel) {
+                    continue;
+                }
+
+                // Retried next frame while the upload ring is still busy with earlier copies
+                uint32_t const levelIdx = stream.residentLevel - 1;
+                UploadAllocation upload{};
+                if (!Renderer::allocateUpload(GetRequiredIntermediateSize(stream.pTexture->handle.Get(), levelIdx, 1), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, upload)) {
+                    continue;
+                }
+
+                D3D12_SUBRESOURCE_DATA const subresource = cachedSubresource(stream.pSource->cachedTexture, levelIdx);
+                UpdateSubresources(Renderer::commandList.Get(), stream.pTexture->handle.Get(), upload.pResource, upload.offset, levelIdx, 1, &subresource);
+
+                D3D12_RESOURCE_BARRIER levelBarrier = CD3DX12_RESOURCE_BARRIER::Transition(stream.pTexture->handle.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, levelIdx);
+                Renderer::commandList->ResourceBarrier(1, &levelBarrier);
+                stream.pendingLevel = levelIdx;
+                stream.pendingFenceValue = Renderer::frameTimeline.lastSignaledValue() + 1; //< signaled by this frame's endFrame
+            }
+
+            if (retiredMaterialDescriptors != DescriptorFreeList::InvalidIndex && retiredMaterialFenceValue <= completedValue)
+            {
+                Renderer::freeDescriptors(retiredMaterialDescriptors, Startup::MaterialTextureCount);
+                retiredMaterialDescriptors = DescriptorFreeList::InvalidIndex;
+            }
+
+            bool const resident = !textureStreams.empty() && std::all_of(textureStreams.begin(), textureStreams.end(), [](TextureStream const& stream) { return stream.residentLevel == 0; });
+            if (!resident) {
+                return;
+            }
+
+            // Frames in flight may have bound the static table if they ran out of transient descriptors, so it's never
+            // rewritten. The full SRVs go to a fresh table & the old one is retired until every frame up to this one completed.
+            uint32_t const residentTable = Renderer::allocateDescriptors(Startup::MaterialTextureCount);
+            if (residentTable == DescriptorFreeList::InvalidIndex) {
+                return; //< per frame tables keep covering the resident levels, retried next frame
+            }
+
+            for (uint32_t textureIdx = 0; textureIdx < Startup::MaterialTextureCount; textureIdx++) {
+                createTextureSRV(*materialTextures[textureIdx], residentTable + textureIdx, 0);
+            }
+
+            assert(retiredMaterialDescriptors == DescriptorFreeList::InvalidIndex);
+            retiredMaterialDescriptors = materialDescriptors;
+            retiredMaterialFenceValue = Renderer::frameTimeline.lastSignaledValue() + 1; //< signaled by this frame's endFrame
+            materialDescriptors = residentTable;
+            textureStreams.clear(); //< releases the cache mappings
+        }
+
+        /// @brief Material table for the current frame. While textures stream, each frame writes a transient table with the levels
+        /// resident so far, so descriptors are never rewritten while a frame in flight reads them.
+        uint32_t materialTable()
+        {
+            if (textureStreams.empty()) {
+                return materialDescriptors;
+            }
+
+            // The static table only exposes mip tails of streaming textures, still valid if transient descriptors ran out
+            uint32_t const table = Renderer::allocateTransientDescriptors(Startup::MaterialTextureCount);
+            if (table == DescriptorFrameAllocator::InvalidIndex) {
+                return materialDescriptors;
+            }
+
+            uint32_t residentLevels[Startup::MaterialTextureCount]{};
+            for (auto const& stream : textureStreams) {
+                residentLevels[stream.textureIdx] = stream.residentLevel;
+            }
+
+            for (uint32_t textureIdx = 0; textureIdx < Startup::MaterialTextureCount; textureIdx++) {
+                createTextureSRV(*materialTextures[textureIdx], table + textureIdx, residentLevels[textureIdx]);
+            }
+
+            return table;
+        }
+
+        /// @brief Compile a shader from its description, the shader cache's compiler. Thread safe.
+        bool compileShader(ShaderCache::ShaderDesc const& desc, std::vector<uint8_t>& bytecode)
+        {
+            std::vector<D3D_SHADER_MACRO> shaderDefines;
+            for (ShaderCache::Define const& define : desc.defines) {
+                shaderDefines.push_back(D3D_SHADER_MACRO{ define.name.c_str(), define.value.c_str() });
+            }
+            shaderDefines.push_back(D3D_SHADER_MACRO{ nullptr, nullptr });
+            std::wstring const shaderPath(desc.sourcePath.begin(), desc.sourcePath.end());
+
+            // Includes resolve relative to the including file, as the shader cache expects when hashing them
+            ComPtr<ID3DBlob> shader;
+            ComPtr<ID3DBlob> shaderError;
+            if (FAILED(D3DCompileFromFile(shaderPath.c_str(), shaderDefines.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE, desc.entryPoint.c_str(), desc.profile.c_str(), desc.compileFlags, 0, &shader, &shaderError)))
+            {
+                printf("D3D12 shader compilation failed [%s]\n", desc.entryPoint.c_str());
+                if (shaderError != nullptr) {
+                    printf("Shader error:\n%s\n", (char*)(shaderError->GetBufferPointer()));
                 }
 
-                ID3D12CommandList* ppUploadCommandLists[] = { uploadCommandList.Get() };
-                Renderer::commandQueue->ExecuteCommandLists(1, ppUploadCommandLists);
-                Renderer::waitForGPU();
+                return false;
+            }
+
+            uint8_t const* pBytecode = static_cast<uint8_t const*>(shader->GetBufferPointer());
+            bytecode.assign(pBytecode, pBytecode + shader->GetBufferSize());
+            return true;
+        }
+
+        /// @brief Load an entry point of the forward shader from the shader cache, compiling & caching it on a miss. Thread safe.
+        bool loadShader(char const* entryPoint, char const* target, std::vector<uint8_t>& bytecode)
+        {
+            ShaderCache::ShaderDesc desc{};
+            desc.sourcePath = Startup::ShaderPath;
+            desc.entryPoint = entryPoint;
+            desc.profile = target;
+#ifndef NDEBUG
+            desc.compileFlags |= D3DCOMPILE_DEBUG
+                | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+            if constexpr (UsePackedVertices) {
+                desc.defines.push_back(ShaderCache::Define{ "PACKED_VERTICES", "1" });
+            }
+
+            ShaderCache::LoadResult const result = ShaderCache::load(Startup::ShaderCacheDirectory, desc, compileShader, bytecode);
+            if (result == ShaderCache::LoadResult::Compiled) {
+                printf("Compiled shader [%s] into the shader cache\n", entryPoint);
+            }
+
+            return result != ShaderCache::LoadResult::Failed;
+        }
+
+        bool createGraphicsPipeline(std::vector<uint8_t> const& vertexShader, std::vector<uint8_t> const& pixelShader)
+        {
+            D3D12_INPUT_ELEMENT_DESC inputElements[] = {
+                D3D12_INPUT_ELEMENT_DESC{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+                D3D12_INPUT_ELEMENT_DESC{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, color), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, texCoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            };
+
+            D3D12_INPUT_ELEMENT_DESC packedInputElements[] = {
+                D3D12_INPUT_ELEMENT_DESC{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(PackedVertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+                D3D12_INPUT_ELEMENT_DESC{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, offsetof(PackedVertex, color), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(PackedVertex, normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(PackedVertex, tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+                D3D12_INPUT_ELEMENT_DESC{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, offsetof(PackedVertex, texCoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+            };
+
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineDesc{};
+            graphicsPipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+            graphicsPipelineDesc.pRootSignature = rootSignature.Get();
+            graphicsPipelineDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.data(), vertexShader.size());
+            graphicsPipelineDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.data(), pixelShader.size());
+            graphicsPipelineDesc.StreamOutput = D3D12_STREAM_OUTPUT_DESC{};
+            graphicsPipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+            graphicsPipelineDesc.SampleMask = UINT32_MAX;
+            graphicsPipelineDesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+            graphicsPipelineDesc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+            graphicsPipelineDesc.RasterizerState.FrontCounterClockwise = TRUE;
+            graphicsPipelineDesc.RasterizerState.DepthBias = 0;
+            graphicsPipelineDesc.RasterizerState.DepthBiasClamp = 0.0F;
+            graphicsPipelineDesc.RasterizerState.SlopeScaledDepthBias = 0.0F;
+            graphicsPipelineDesc.RasterizerState.DepthClipEnable = TRUE;
+            graphicsPipelineDesc.RasterizerState.MultisampleEnable = FALSE;
+            graphicsPipelineDesc.RasterizerState.AntialiasedLineEnable = FALSE;
+            graphicsPipelineDesc.RasterizerState.ForcedSampleCount = 0;
+            graphicsPipelineDesc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+            graphicsPipelineDesc.DepthStencilState.DepthEnable = TRUE;
+            graphicsPipelineDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+            graphicsPipelineDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+            graphicsPipelineDesc.DepthStencilState.StencilEnable = FALSE;
+            graphicsPipelineDesc.DepthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+            graphicsPipelineDesc.DepthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+            graphicsPipelineDesc.DepthStencilState.FrontFace = D3D12_DEPTH_STENCILOP_DESC{ D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+            graphicsPipelineDesc.DepthStencilState.BackFace = D3D12_DEPTH_STENCILOP_DESC{ D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+            graphicsPipelineDesc.InputLayout.NumElements = UsePackedVertices ? sizeof_array(packedInputElements) : sizeof_array(inputElements);
+            graphicsPipelineDesc.InputLayout.pInputElementDescs = UsePackedVertices ? packedInputElements : inputElements;
+            graphicsPipelineDesc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+            graphicsPipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+            graphicsPipelineDesc.NumRenderTargets = 1;
+            graphicsPipelineDesc.RTVFormats[0] = Renderer::SwapColorSRGBFormat;
+            graphicsPipelineDesc.DSVFormat = Renderer::SwapDepthStencilFormat;
+            graphicsPipelineDesc.SampleDesc.Count = 1;
+            graphicsPipelineDesc.SampleDesc.Quality = 0;
+            graphicsPipelineDesc.NodeMask = 0x00;
+
+            if (FAILED(Renderer::device->CreateGraphicsPipelineState(&graphicsPipelineDesc, IID_PPV_ARGS(&graphicsPipeline))))
+            {
+                printf("D3D12 graphics pipeline create failed\n");
+                return false;
             }
 
-            stbi_image_free(pTextureData);
             return true;
         }
     } // namespace D3D12Helpers
 
+    /// @brief Place the mesh instances on a square grid in the XZ plane, centered on the origin.
+    void layoutInstances(uint32_t count)
+    {
+        uint32_t const side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        float const center = static_cast<float>(side - 1) * 0.5F;
+        transforms.resize(count);
+        for (uint32_t instanceIdx = 0; instanceIdx < count; instanceIdx++)
+        {
+            Transform transform{};
+            transform.position = glm::vec3(static_cast<float>(instanceIdx % side) - center, 0.0F, static_cast<float>(instanceIdx / side) - center) * InstanceSpacing;
+            transforms.set(instanceIdx, transform);
+        }
+    }
+
     bool init()
     {
         IMGUI_CHECKVERSION();
@@ -330,6 +750,8 @@ namespace Engine
 
         ImGui::StyleColorsDark();
 
+        jobSystem = std::make_unique<JobSystem>();
+
         if (SDL_Init(SDL_INIT_VIDEO) != 0)
         {
             printf("SDL init failed: %s\n", SDL_GetError());
@@ -361,38 +783,35 @@ namespace Engine
         }
 
         // Init ImGui backend
-        D3D12_DESCRIPTOR_HEAP_DESC ImGuiSRVHeapDesc{};
-        ImGuiSRVHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        ImGuiSRVHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        ImGuiSRVHeapDesc.NumDescriptors = 1;
-        ImGuiSRVHeapDesc.NodeMask = 0x00;
-        if (FAILED(Renderer::device->CreateDescriptorHeap(&ImGuiSRVHeapDesc, IID_PPV_ARGS(&ImGuiSRVHeap))))
-        {
-            printf("D3D12 ImGui SRV heap create failed\n");
+        ImGuiFontDescriptor = Renderer::allocateDescriptors(1);
+        if (ImGuiFontDescriptor == DescriptorFreeList::InvalidIndex) {
             return false;
         }
 
-        if (!ImGui_ImplDX12_Init(Renderer::device.Get(), 1, Renderer::SwapColorSRGBFormat, ImGuiSRVHeap.Get(), ImGuiSRVHeap->GetCPUDescriptorHandleForHeapStart(), ImGuiSRVHeap->GetGPUDescriptorHandleForHeapStart()))
+        if (!ImGui_ImplDX12_Init(Renderer::device.Get(), Renderer::FrameCount, Renderer::SwapColorSRGBFormat, Renderer::descriptorHeap.Get(), Renderer::cpuDescriptor(ImGuiFontDescriptor), Renderer::gpuDescriptor(ImGuiFontDescriptor)))
         {
             printf("ImGui init for D3D12 failed\n");
             return false;
         }
 
-        // Create root signature for graphics pipeline
-        CD3DX12_DESCRIPTOR_RANGE1 sceneDataDescriptorRange;
-        sceneDataDescriptorRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+        // Create root signature for graphics pipeline, scene data is a root CBV so each frame slot binds its own buffer
+        CD3DX12_ROOT_PARAMETER1 sceneRootParameter;
+        sceneRootParameter.InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_ALL);
 
         CD3DX12_DESCRIPTOR_RANGE1 textureDataDescriptorRange;
-        textureDataDescriptorRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-
-        CD3DX12_ROOT_PARAMETER1 vsRootParameter;
-        D3D12_DESCRIPTOR_RANGE1 vsRanges[] = { sceneDataDescriptorRange };
-        vsRootParameter.InitAsDescriptorTable(sizeof_array(vsRanges), vsRanges, D3D12_SHADER_VISIBILITY_VERTEX);
+        textureDataDescriptorRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, Startup::MaterialTextureCount, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
 
         CD3DX12_ROOT_PARAMETER1 psRootParameter;
-        D3D12_DESCRIPTOR_RANGE1 psRanges[] = { sceneDataDescriptorRange, textureDataDescriptorRange };
+        D3D12_DESCRIPTOR_RANGE1 psRanges[] = { textureDataDescriptorRange };
         psRootParameter.InitAsDescriptorTable(sizeof_array(psRanges), psRanges, D3D12_SHADER_VISIBILITY_PIXEL);
 
+        CD3DX12_ROOT_PARAMETER1 meshRootParameter;
+        meshRootParameter.InitAsConstants(sizeof(MeshConstants) / sizeof(uint32_t), 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+        // Instance matrices are a root SRV like the scene data, each frame slot binds its own buffer
+        CD3DX12_ROOT_PARAMETER1 instanceRootParameter;
+        instanceRootParameter.InitAsShaderResourceView(2, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+
         D3D12_STATIC_SAMPLER_DESC textureSamplerDesc{};
         textureSamplerDesc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
         textureSamplerDesc.AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
@@ -408,7 +827,7 @@ namespace Engine
         textureSamplerDesc.RegisterSpace = 0;
         textureSamplerDesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 
-        D3D12_ROOT_PARAMETER1 rootParameters[] = { vsRootParameter, psRootParameter, };
+        D3D12_ROOT_PARAMETER1 rootParameters[] = { sceneRootParameter, psRootParameter, meshRootParameter, instanceRootParameter, };
         D3D12_STATIC_SAMPLER_DESC staticSamplers[] = { textureSamplerDesc };
         D3D12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc{};
         rootSignatureDesc.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -436,154 +855,74 @@ namespace Engine
             return false;
         }
 
-        // Create graphics pipeline
-        ComPtr<ID3DBlob> vertexShader;
-        ComPtr<ID3DBlob> pixelShader;
-        ComPtr<ID3DBlob> shaderError;
-
-        uint32_t compileFlags = 0;
-#ifndef NDEBUG
-        compileFlags |= D3DCOMPILE_DEBUG
-            | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-        if (FAILED(D3DCompileFromFile(L"data/shaders/shader.hlsl", nullptr, nullptr, "VSForward", "vs_5_0", compileFlags, 0, &vertexShader, &shaderError))
-            || FAILED(D3DCompileFromFile(L"data/shaders/shader.hlsl", nullptr, nullptr, "PSForward", "ps_5_0", compileFlags, 0, &pixelShader, &shaderError)))
-        {
-            printf("D3D12 shader compilation failed\n");
-            if (shaderError != nullptr) {
-                printf("Shader error:\n%s\n", (char*)(shaderError->GetBufferPointer()));
-            }
-
-            return false;
-        }
-
-        D3D12_INPUT_ELEMENT_DESC inputElements[] = {
-            D3D12_INPUT_ELEMENT_DESC{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-            D3D12_INPUT_ELEMENT_DESC{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, color), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            D3D12_INPUT_ELEMENT_DESC{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            D3D12_INPUT_ELEMENT_DESC{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, tangent), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-            D3D12_INPUT_ELEMENT_DESC{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, texCoord), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        };
-
-        D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineDesc{};
-        graphicsPipelineDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
-        graphicsPipelineDesc.pRootSignature = rootSignature.Get();
-        graphicsPipelineDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
-        graphicsPipelineDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
-        graphicsPipelineDesc.StreamOutput = D3D12_STREAM_OUTPUT_DESC{};
-        graphicsPipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-        graphicsPipelineDesc.SampleMask = UINT32_MAX;
-        graphicsPipelineDesc.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
-        graphicsPipelineDesc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-        graphicsPipelineDesc.RasterizerState.FrontCounterClockwise = TRUE;
-        graphicsPipelineDesc.RasterizerState.DepthBias = 0;
-        graphicsPipelineDesc.RasterizerState.DepthBiasClamp = 0.0F;
-        graphicsPipelineDesc.RasterizerState.SlopeScaledDepthBias = 0.0F;
-        graphicsPipelineDesc.RasterizerState.DepthClipEnable = TRUE;
-        graphicsPipelineDesc.RasterizerState.MultisampleEnable = FALSE;
-        graphicsPipelineDesc.RasterizerState.AntialiasedLineEnable = FALSE;
-        graphicsPipelineDesc.RasterizerState.ForcedSampleCount = 0;
-        graphicsPipelineDesc.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-        graphicsPipelineDesc.DepthStencilState.DepthEnable = TRUE;
-        graphicsPipelineDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-        graphicsPipelineDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
-        graphicsPipelineDesc.DepthStencilState.StencilEnable = FALSE;
-        graphicsPipelineDesc.DepthStencilState.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
-        graphicsPipelineDesc.DepthStencilState.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
-        graphicsPipelineDesc.DepthStencilState.FrontFace = D3D12_DEPTH_STENCILOP_DESC{ D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
-        graphicsPipelineDesc.DepthStencilState.BackFace = D3D12_DEPTH_STENCILOP_DESC{ D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
-        graphicsPipelineDesc.InputLayout.NumElements = sizeof_array(inputElements);
-        graphicsPipelineDesc.InputLayout.pInputElementDescs = inputElements;
-        graphicsPipelineDesc.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
-        graphicsPipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-        graphicsPipelineDesc.NumRenderTargets = 1;
-        graphicsPipelineDesc.RTVFormats[0] = Renderer::SwapColorSRGBFormat;
-        graphicsPipelineDesc.DSVFormat = Renderer::SwapDepthStencilFormat;
-        graphicsPipelineDesc.SampleDesc.Count = 1;
-        graphicsPipelineDesc.SampleDesc.Quality = 0;
-        graphicsPipelineDesc.NodeMask = 0x00;
-
-        if (FAILED(Renderer::device->CreateGraphicsPipelineState(&graphicsPipelineDesc, IID_PPV_ARGS(&graphicsPipeline))))
-        {
-            printf("D3D12 graphics pipeline create failed\n");
-            return false;
-        }
-
         // Set up render viewport & scissor
         viewport = CD3DX12_VIEWPORT(0.0F, 0.0F, static_cast<float>(DefaultWindowWidth), static_cast<float>(DefaultWindowHeight), 0.0F, 1.0F);
         scissor = CD3DX12_RECT(0, 0, DefaultWindowWidth, DefaultWindowHeight);
 
-        // Create descriptor resource heap
-        D3D12_DESCRIPTOR_HEAP_DESC descriptorResourceHeapDesc{};
-        descriptorResourceHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        descriptorResourceHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        descriptorResourceHeapDesc.NumDescriptors = 3; // cbv + 2 textures
-        descriptorResourceHeapDesc.NodeMask = 0x00;
-
-        if (FAILED(Renderer::device->CreateDescriptorHeap(&descriptorResourceHeapDesc, IID_PPV_ARGS(&descriptorResourceHeap))))
-        {
-            printf("D3D12 scene data cbv heap create failed\n");
+        // Allocate the static material table, textures write their SRVs as they are created
+        materialDescriptors = Renderer::allocateDescriptors(Startup::MaterialTextureCount);
+        if (materialDescriptors == DescriptorFreeList::InvalidIndex) {
             return false;
         }
 
-        // Create scene data buffer
-        if (!Renderer::createBuffer(sceneDataBuffer, sizeof(SceneData), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD, true))
+        // Create scene data buffers
+        for (auto& sceneDataBuffer : sceneDataBuffers)
         {
-            printf("D3D12 scene data buffer create failed\n");
-            return false;
+            if (!Renderer::createBuffer(sceneDataBuffer, sizeof(SceneData), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD, true))
+            {
+                printf("D3D12 scene data buffer create failed\n");
+                return false;
+            }
         }
 
-        D3D12_CONSTANT_BUFFER_VIEW_DESC sceneDataBufferView = D3D12_CONSTANT_BUFFER_VIEW_DESC{ sceneDataBuffer.handle->GetGPUVirtualAddress(), static_cast<UINT>(sceneDataBuffer.size) };
-        Renderer::device->CreateConstantBufferView(&sceneDataBufferView, CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptorResourceHeap->GetCPUDescriptorHandleForHeapStart(), 0, Renderer::cbvsrvHeapIncrementSize));
+        // Create instance buffers
+        for (auto& instanceBuffer : instanceBuffers)
+        {
+            if (!Renderer::createBuffer(instanceBuffer, MaxInstanceCount * sizeof(InstanceData), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD, true))
+            {
+                printf("D3D12 instance buffer create failed\n");
+                return false;
+            }
+        }
 
         // Set camera state
         camera.position = glm::vec3(0.0F, 0.0F, -5.0F);
         camera.forward = glm::normalize(glm::vec3(0.0F) - camera.position);
         camera.aspectRatio = static_cast<float>(DefaultWindowWidth) / static_cast<float>(DefaultWindowHeight);
 
-        // Set transform state
-        transform = Transform{};
+        // Set instance transforms
+        layoutInstances(static_cast<uint32_t>(instanceCount));
+
+        // Load assets & cached shaders as a task graph, resources are created as soon as their inputs are ready & their
+        // uploads are submitted together at the end
+        std::vector<uint8_t> vertexShader;
+        std::vector<uint8_t> pixelShader;
 
-        // Load mesh data
-        if (!D3D12Helpers::loadOBJ("data/assets/suzanne.obj", mesh))
+        Startup::Stages stages{};
+        stages.compileVertexShader = [&vertexShader]() { return D3D12Helpers::loadShader("VSForward", "vs_5_0", vertexShader); };
+        stages.compilePixelShader = [&pixelShader]() { return D3D12Helpers::loadShader("PSForward", "ps_5_0", pixelShader); };
+        stages.createPipeline = [&vertexShader, &pixelShader]() { return D3D12Helpers::createGraphicsPipeline(vertexShader, pixelShader); };
+        stages.createMesh = [](AssetLoader::MeshSource& source) { return D3D12Helpers::loadMesh(mesh, source); };
+        stages.createTexture = [](uint32_t textureIdx, std::unique_ptr<AssetLoader::TextureSource>& pSource)
         {
-            printf("Mesh load failed\n");
-            return false;
-        }
+            // Cooked textures stream their detailed levels in over the first frames
+            return D3D12Helpers::loadTexture(*materialTextures[textureIdx], textureIdx, Startup::MaterialTextures[textureIdx].path, pSource);
+        };
+        stages.submitUploads = []() { return D3D12Helpers::submitUploads(); };
 
-        // Load material data
-        if (!D3D12Helpers::loadTexture("data/assets/brickwall.jpg", colorTexture)) {
-            printf("Color map load failed\n");
-            return false;
-        }
+        TaskGraph startupGraph{};
+        Startup::Assets startupAssets{};
+        Startup::buildGraph(startupGraph, startupAssets, stages);
 
-        if (!D3D12Helpers::loadTexture("data/assets/brickwall_normal.jpg", normalTexture)) {
-            printf("Normal map load failed\n");
+        bool const startupSucceeded = startupGraph.execute(*jobSystem);
+        startupGraph.report("Startup");
+        Renderer::reportMemory();
+        if (!startupSucceeded)
+        {
+            printf("Startup asset load failed\n");
             return false;
         }
 
-        // Create material SRVs
-        D3D12_SHADER_RESOURCE_VIEW_DESC colorTextureViewDesc{};
-        colorTextureViewDesc.Format = colorTexture.format;
-        colorTextureViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        colorTextureViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        colorTextureViewDesc.Texture2D.MostDetailedMip = 0;
-        colorTextureViewDesc.Texture2D.MipLevels = colorTexture.levels;
-        colorTextureViewDesc.Texture2D.PlaneSlice = 0;
-        colorTextureViewDesc.Texture2D.ResourceMinLODClamp = 0.0F;
-        Renderer::device->CreateShaderResourceView(colorTexture.handle.Get(), &colorTextureViewDesc, CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptorResourceHeap->GetCPUDescriptorHandleForHeapStart(), 1, Renderer::cbvsrvHeapIncrementSize));
-
-        D3D12_SHADER_RESOURCE_VIEW_DESC normalTextureViewDesc{};
-        normalTextureViewDesc.Format = normalTexture.format;
-        normalTextureViewDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-        normalTextureViewDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        normalTextureViewDesc.Texture2D.MostDetailedMip = 0;
-        normalTextureViewDesc.Texture2D.MipLevels = normalTexture.levels;
-        normalTextureViewDesc.Texture2D.PlaneSlice = 0;
-        normalTextureViewDesc.Texture2D.ResourceMinLODClamp = 0.0F;
-        Renderer::device->CreateShaderResourceView(normalTexture.handle.Get(), &normalTextureViewDesc, CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptorResourceHeap->GetCPUDescriptorHandleForHeapStart(), 2, Renderer::cbvsrvHeapIncrementSize));
-
-        Renderer::waitForGPU(); // Wait until GPU uploads are finished
         printf("Initialized DX12 Renderer\n");
         return true;
     }
@@ -594,12 +933,28 @@ namespace Engine
 
         Renderer::waitForGPU();
 
+        textureStreams.clear();
+
         normalTexture.destroy();
         colorTexture.destroy();
         mesh.destroy();
-        sceneDataBuffer.unmap();
-        sceneDataBuffer.destroy();
+        for (auto& instanceBuffer : instanceBuffers) {
+            instanceBuffer.destroy();
+        }
+        for (auto& sceneDataBuffer : sceneDataBuffers) {
+            sceneDataBuffer.destroy();
+        }
         ImGui_ImplDX12_Shutdown();
+        if (materialDescriptors != DescriptorFreeList::InvalidIndex) {
+            Renderer::freeDescriptors(materialDescriptors, Startup::MaterialTextureCount);
+        }
+        if (retiredMaterialDescriptors != DescriptorFreeList::InvalidIndex) {
+            Renderer::freeDescriptors(retiredMaterialDescriptors, Startup::MaterialTextureCount);
+        }
+        if (ImGuiFontDescriptor != DescriptorFreeList::InvalidIndex) {
+            Renderer::freeDescriptors(ImGuiFontDescriptor);
+        }
+        frameGraphResources.destroy();
 
         Renderer::shutdown();
 
@@ -608,6 +963,9 @@ namespace Engine
         SDL_Quit();
 
         ImGui::DestroyContext();
+
+        instanceBvh.waitRebuild();
+        jobSystem.reset();
     }
 
     void resize()
@@ -638,6 +996,270 @@ namespace Engine
         camera.aspectRatio = static_cast<float>(width) / static_cast<float>(height);
     }
 
+    /// @brief Select each visible instance's LOD, bucket the instances by level & cull meshlets into draw ranges, runs as a job
+    /// once the instances were culled.
+    void selectDraws()
+    {
+        drawPackets.clear();
+        visibleMeshlets = 0;
+        visibleTriangles = 0;
+        uint32_t const levelCount = static_cast<uint32_t>(mesh.lodLevels.size()) + 1;
+        lodInstanceCounts.assign(levelCount, 0);
+        uint32_t const drawnInstanceCount = std::min(visibleInstanceCount, MaxInstanceCount);
+        if (drawnInstanceCount == 0) {
+            return;
+        }
+
+        // Select the LOD of every drawn instance from the projected error of its world space bounding sphere
+        instanceLods.resize(drawnInstanceCount);
+        jobSystem->parallelFor(drawnInstanceCount, InstanceGrainSize, [levelCount](size_t begin, size_t end)
+        {
+            for (size_t drawIdx = begin; drawIdx < end; drawIdx++)
+            {
+                if (forcedLod >= 0)
+                {
+                    instanceLods[drawIdx] = static_cast<uint8_t>(std::min(static_cast<uint32_t>(forcedLod), levelCount - 1));
+                    continue;
+                }
+
+                uint32_t const instanceIdx = visibleInstances[drawIdx];
+                glm::vec3 const center = glm::vec3(instanceSpheres.centerX[instanceIdx], instanceSpheres.centerY[instanceIdx], instanceSpheres.centerZ[instanceIdx]);
+                float const radius = instanceSpheres.radius[instanceIdx];
+                float const scale = (mesh.bounds.sphereRadius > 0.0F) ? radius / mesh.bounds.sphereRadius : 1.0F;
+                instanceLods[drawIdx] = static_cast<uint8_t>(Lods::selectLod(mesh.lodLevels, center, radius, scale, camera, viewport.Height, lodErrorThreshold));
+            }
+        });
+
+        // Counting sort the drawn instances by LOD, keeping their visible order in each level, so every level reads a
+        // contiguous range of the instance buffer. The nearest instance of a level gives its packet's depth.
+        std::vector<float> lodNearest(levelCount, camera.zFar);
+        for (uint32_t drawIdx = 0; drawIdx < drawnInstanceCount; drawIdx++)
+        {
+            uint32_t const instanceIdx = visibleInstances[drawIdx];
+            glm::vec3 const center = glm::vec3(instanceSpheres.centerX[instanceIdx], instanceSpheres.centerY[instanceIdx], instanceSpheres.centerZ[instanceIdx]);
+            float& nearest = lodNearest[instanceLods[drawIdx]];
+            nearest = std::min(nearest, glm::length(center - camera.position));
+            lodInstanceCounts[instanceLods[drawIdx]]++;
+        }
+
+        std::vector<uint32_t> lodFirstInstance(levelCount, 0);
+        for (uint32_t levelIdx = 1; levelIdx < levelCount; levelIdx++) {
+            lodFirstInstance[levelIdx] = lodFirstInstance[levelIdx - 1] + lodInstanceCounts[levelIdx - 1];
+        }
+
+        lodInstanceScratch.resize(visibleInstances.size());
+        std::vector<uint32_t> lodCursor = lodFirstInstance;
+        for (uint32_t drawIdx = 0; drawIdx < drawnInstanceCount; drawIdx++) {
+            lodInstanceScratch[lodCursor[instanceLods[drawIdx]]++] = visibleInstances[drawIdx];
+        }
+        std::copy(lodInstanceScratch.begin(), lodInstanceScratch.begin() + drawnInstanceCount, visibleInstances.begin());
+
+        // One instanced packet per populated level. Meshlets only cover full detail & are culled in object space of a single
+        // instance, merging consecutive visible meshlets into packets in order.
+        for (uint32_t levelIdx = 0; levelIdx < levelCount; levelIdx++)
+        {
+            uint32_t const firstInstance = lodFirstInstance[levelIdx];
+            uint32_t const levelInstanceCount = lodInstanceCounts[levelIdx];
+            if (levelInstanceCount == 0) {
+                continue;
+            }
+
+            uint64_t const key = DrawKeys::encode(ForwardPass, ForwardPipeline, SceneMaterial, SceneMesh, DrawKeys::quantizeDepth(lodNearest[levelIdx], camera.zFar));
+            if (levelIdx > 0)
+            {
+                LodLevel const& level = mesh.lodLevels[levelIdx - 1];
+                drawPackets.push_back(DrawPacket{ key, mesh.indexCount + level.indexOffset, level.indexCount, firstInstance, levelInstanceCount });
+                visibleTriangles += level.indexCount / 3 * levelInstanceCount;
+            }
+            else if (meshletCulling && transforms.size() == 1 && !mesh.meshlets.meshlets.empty())
+            {
+                // Normal cones are only valid under rotation & uniform scale, which holds for the scene transforms
+                glm::mat4 const model = transforms.get(visibleInstances[firstInstance]).matrix();
+                Frustum const frustum = Culling::transformFrustum(Culling::extractFrustum(sceneData.viewproject), model);
+                glm::vec3 const objectCameraPosition = glm::vec3(glm::inverse(model) * glm::vec4(camera.position, 1.0F));
+                meshletVisibility.resize(mesh.meshlets.meshlets.size());
+                jobSystem->parallelFor(mesh.meshlets.meshlets.size(), MeshletCullGrainSize, [&frustum, &objectCameraPosition](size_t begin, size_t end)
+                {
+                    for (size_t meshletIdx = begin; meshletIdx < end; meshletIdx++) {
+                        meshletVisibility[meshletIdx] = Meshlets::cullMeshlet(mesh.meshlets.bounds[meshletIdx], frustum, objectCameraPosition) == Meshlets::CullResult::Visible;
+                    }
+                });
+
+                size_t const firstPacket = drawPackets.size();
+                for (size_t meshletIdx = 0; meshletIdx < mesh.meshlets.meshlets.size(); meshletIdx++)
+                {
+                    Meshlet const& meshlet = mesh.meshlets.meshlets[meshletIdx];
+                    if (!meshletVisibility[meshletIdx]) {
+                        continue;
+                    }
+
+                    uint32_t const firstIndex = meshlet.triangleOffset * 3;
+                    if (drawPackets.size() > firstPacket && drawPackets.back().firstIndex + drawPackets.back().indexCount == firstIndex) {
+                        drawPackets.back().indexCount += meshlet.triangleCount * 3;
+                    }
+                    else {
+                        drawPackets.push_back(DrawPacket{ key, firstIndex, meshlet.triangleCount * 3, firstInstance, levelInstanceCount });
+                    }
+
+                    visibleMeshlets++;
+                    visibleTriangles += meshlet.triangleCount;
+                }
+            }
+            else
+            {
+                drawPackets.push_back(DrawPacket{ key, 0, mesh.indexCount, firstInstance, levelInstanceCount });
+                visibleMeshlets += static_cast<uint32_t>(mesh.meshlets.meshlets.size()) * levelInstanceCount;
+                visibleTriangles += mesh.indexCount / 3 * levelInstanceCount;
+            }
+        }
+
+        // Sorting groups the draws by pass & state, so recording binds each pipeline, material & mesh once per command list
+        DrawPackets::sort(drawPackets, drawPacketScratch, jobSystem.get());
+    }
+
+    /// @brief Update the moved instances' world space bounding spheres & cull them in parallel chunks, compacting the visible
+    /// indices in order, or query the scene BVH over them & sort its result. Runs as a job once the transforms were animated.
+    void cullInstances()
+    {
+        uint32_t const count = transforms.size();
+        size_t const chunkCount = (count + InstanceGrainSize - 1) / InstanceGrainSize;
+        instanceSpheres.resize(count);
+        visibleInstances.resize(count);
+        movedInstances.resize(count);
+        instanceCullCounts.resize(chunkCount);
+        instanceMovedCounts.resize(chunkCount);
+
+        // Chunks write their moved & visible indices in place, they never exceed the chunk's own range
+        Frustum const frustum = Culling::extractFrustum(camera);
+        bool const useBvh = instanceCulling && bvhCulling;
+        jobSystem->parallelFor(chunkCount, 1, [&frustum, count, useBvh](size_t chunkBegin, size_t chunkEnd)
+        {
+            for (size_t chunkIdx = chunkBegin; chunkIdx < chunkEnd; chunkIdx++)
+            {
+                size_t const begin = chunkIdx * InstanceGrainSize;
+                size_t const end = std::min<size_t>(begin + InstanceGrainSize, count);
+                instanceMovedCounts[chunkIdx] = static_cast<uint32_t>(transforms.updateMovedSpheres(begin, end, mesh.bounds, instanceSpheres, &movedInstances[begin]));
+                if (useBvh) {
+                    continue;
+                }
+
+                if (instanceCulling) {
+                    instanceCullCounts[chunkIdx] = static_cast<uint32_t>(Culling::cullSpheres(frustum, instanceSpheres, begin, end, &visibleInstances[begin]));
+                }
+                else
+                {
+                    std::iota(visibleInstances.begin() + begin, visibleInstances.begin() + end, static_cast<uint32_t>(begin));
+                    instanceCullCounts[chunkIdx] = static_cast<uint32_t>(end - begin);
+                }
+            }
+        });
+
+        movedInstanceCount = 0;
+        for (uint32_t const movedCount : instanceMovedCounts) {
+            movedInstanceCount += movedCount;
+        }
+
+        // The tree is rebuilt when the instance count changed or it missed moves while unused, otherwise the moved boxes are refit
+        if (useBvh)
+        {
+            auto const sphereBox = [](uint32_t instanceIdx)
+            {
+                glm::vec3 const center = glm::vec3(instanceSpheres.centerX[instanceIdx], instanceSpheres.centerY[instanceIdx], instanceSpheres.centerZ[instanceIdx]);
+                return BoundingBox{ center - instanceSpheres.radius[instanceIdx], center + instanceSpheres.radius[instanceIdx] };
+            };
+
+            if (instanceBvhStale || instanceBvh.statistics().objectCount != count)
+            {
+                std::vector<BoundingBox> boxes(count);
+                for (uint32_t instanceIdx = 0; instanceIdx < count; instanceIdx++) {
+                    boxes[instanceIdx] = sphereBox(instanceIdx);
+                }
+                std::iota(visibleInstances.begin(), visibleInstances.end(), 0U);
+                instanceBvh.build(visibleInstances.data(), boxes.data(), count);
+                instanceBvhStale = false;
+            }
+            else
+            {
+                for (size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+                {
+                    uint32_t const* pMoved = &movedInstances[chunkIdx * InstanceGrainSize];
+                    for (uint32_t movedIdx = 0; movedIdx < instanceMovedCounts[chunkIdx]; movedIdx++) {
+                        instanceBvh.update(pMoved[movedIdx], sphereBox(pMoved[movedIdx]));
+                    }
+                }
+                instanceBvh.refit(jobSystem.get());
+            }
+
+            // The BVH returns instances in traversal order, sorting matches the compacted order of the flat path
+            visibleInstances.clear();
+            instanceBvh.queryFrustum(frustum, visibleInstances);
+            std::sort(visibleInstances.begin(), visibleInstances.end());
+            visibleInstanceCount = static_cast<uint32_t>(visibleInstances.size());
+            visibleInstances.resize(count);
+            return;
+        }
+
+        instanceBvhStale = instanceBvhStale || movedInstanceCount > 0;
+        visibleInstanceCount = 0;
+        for (size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+        {
+            auto const chunkVisible = visibleInstances.begin() + chunkIdx * InstanceGrainSize;
+            std::copy(chunkVisible, chunkVisible + instanceCullCounts[chunkIdx], visibleInstances.begin() + visibleInstanceCount);
+            visibleInstanceCount += instanceCullCounts[chunkIdx];
+        }
+    }
+
+    /// @brief Find the closest instance triangle under the pixel. Instances are found through the scene BVH while it's used
+    /// for culling, otherwise every bounding sphere is tested, & the ray is taken into each candidate's object space.
+    void pickInstance(glm::vec2 const& pixel)
+    {
+        Timer timer{};
+        timer.reset();
+
+        Ray const ray = camera.pickingRay(pixel, glm::vec2(viewport.Width, viewport.Height));
+        pickedInstance = TransformArray::InvalidIndex;
+        pickedHit = TriangleHit{ TriangleBvh::InvalidIndex, camera.zFar, glm::vec2(0.0F), glm::vec3(0.0F) };
+
+        // The object space direction keeps its length, so distances stay in world units & compare across instances
+        auto const intersectInstance = [&ray](uint32_t instanceIdx, float maxDistance)
+        {
+            glm::mat4 const inverseModel = glm::inverse(transforms.get(instanceIdx).matrix());
+            Ray const objectRay{ glm::vec3(inverseModel * glm::vec4(ray.origin, 1.0F)), glm::vec3(inverseModel * glm::vec4(ray.direction, 0.0F)) };
+            TriangleHit hit{};
+            if (!mesh.triangleBvh.intersect(objectRay, maxDistance, hit)) {
+                return -1.0F;
+            }
+
+            if (hit.distance < pickedHit.distance)
+            {
+                pickedInstance = instanceIdx;
+                pickedHit = hit;
+                pickedHit.position = ray.origin + ray.direction * hit.distance;
+            }
+            return hit.distance;
+        };
+
+        uint32_t const count = transforms.size();
+        if (instanceCulling && bvhCulling && instanceBvh.statistics().objectCount == count) {
+            instanceBvh.raycast(ray.origin, ray.direction, camera.zFar, intersectInstance);
+        }
+        else if (instanceSpheres.size() == count)
+        {
+            for (uint32_t instanceIdx = 0; instanceIdx < count; instanceIdx++)
+            {
+                glm::vec3 const offset = glm::vec3(instanceSpheres.centerX[instanceIdx], instanceSpheres.centerY[instanceIdx], instanceSpheres.centerZ[instanceIdx]) - ray.origin;
+                float const along = glm::dot(offset, ray.direction);
+                float const radius = instanceSpheres.radius[instanceIdx];
+                if (glm::dot(offset, offset) - along * along <= radius * radius && along + radius >= 0.0F && along - radius < pickedHit.distance) {
+                    intersectInstance(instanceIdx, pickedHit.distance);
+                }
+            }
+        }
+
+        timer.tick();
+        pickTimeMS = timer.deltaTimeMS();
+    }
+
     void update()
     {
         // Tick frame timer
@@ -677,13 +1299,34 @@ namespace Engine
             ImGui::SeparatorText("Statistics");
             ImGui::Text("Frame time: %10.2f ms", frameTimer.deltaTimeMS());
             ImGui::Text("FPS:        %10.2f fps", 1'000.0 / frameTimer.deltaTimeMS());
+            ImGui::Text("Instances:  %10u / %u (%u moved)", visibleInstanceCount, transforms.size(), movedInstanceCount);
+            ImGui::Text("Meshlets:   %10u / %zu", visibleMeshlets, mesh.meshlets.meshlets.size());
+            ImGui::Text("Triangles:  %10u / %u", visibleTriangles, mesh.indexCount / 3);
+            for (size_t levelIdx = 0; levelIdx < lodInstanceCounts.size(); levelIdx++) {
+                ImGui::Text("LOD %zu:      %10u instances", levelIdx, lodInstanceCounts[levelIdx]);
+            }
+            ImGui::Text("State sets: %10u pipeline, %u material, %u mesh (%u skipped, %u draws)", drawStatistics.pipelineChanges, drawStatistics.materialChanges, drawStatistics.meshChanges, drawStatistics.skippedChanges, drawStatistics.drawCount);
+            SceneBvh::Statistics const bvhStatistics = instanceBvh.statistics();
+            ImGui::Text("BVH SAH:    %10.1f / %.1f (%u rebuilds)", bvhStatistics.sahCost, bvhStatistics.builtSahCost, bvhStatistics.rebuildCount);
+            Renderer::MemoryStatistics const memoryStatistics = Renderer::memoryStatistics();
+            ImGui::Text("GPU memory: %10.1f / %.1f MiB (%u blocks)", memoryStatistics.usedSize / (1024.0 * 1024.0), memoryStatistics.reservedSize / (1024.0 * 1024.0), memoryStatistics.blockCount);
+            ImGui::Text("Fragmented: %10.1f %% (%u movable)", memoryStatistics.fragmentation * 100.0F, memoryStatistics.defragmentationCandidates);
 
             ImGui::SeparatorText("Settings");
             ImGui::RadioButton("VSync Enabled", true);
             ImGui::RadioButton("VSync Disabled", false);
             ImGui::RadioButton("VSync Disabled with tearing", false);
+            ImGui::Checkbox("Instance culling", &instanceCulling);
+            ImGui::Checkbox("Scene BVH culling", &bvhCulling);
+            ImGui::Checkbox("Meshlet culling (single instance)", &meshletCulling);
+            ImGui::SliderInt("Forced LOD", &forcedLod, -1, static_cast<int>(mesh.lodLevels.size()));
+            ImGui::DragFloat("LOD error threshold (px)", &lodErrorThreshold, 0.05F, 0.1F, 16.0F);
 
             ImGui::SeparatorText("Scene");
+            if (ImGui::SliderInt("Instances", &instanceCount, 1, static_cast<int>(MaxInstanceCount), "%d", ImGuiSliderFlags_Logarithmic)) {
+                layoutInstances(static_cast<uint32_t>(instanceCount));
+            }
+            ImGui::Checkbox("Spin instances", &spinInstances);
             ImGui::DragFloat("Sun Azimuth", &sunAzimuth, 1.0F, 0.0F, 360.0F);
             ImGui::DragFloat("Sun Zenith", &sunZenith, 1.0F, -90.0F, 90.0F);
             ImGui::ColorEdit3("Sun Color", &sunColor[0], ImGuiColorEditFlags_DisplayHex | ImGuiColorEditFlags_InputRGB);
@@ -691,19 +1334,52 @@ namespace Engine
 
             ImGui::SeparatorText("Material");
             ImGui::DragFloat("Specularity", &specularity, 0.01F, 0.0F, 1.0F);
+
+            ImGui::SeparatorText("Picking");
+            ImGui::Checkbox("Pick on left click", &picking);
+            if (pickedInstance != TransformArray::InvalidIndex)
+            {
+                ImGui::Text("Instance:     %10u", pickedInstance);
+                ImGui::Text("Triangle:     %10u", pickedHit.triangle);
+                ImGui::Text("Position:     %.3f, %.3f, %.3f", pickedHit.position.x, pickedHit.position.y, pickedHit.position.z);
+                ImGui::Text("Barycentrics: %.3f, %.3f", pickedHit.barycentrics.x, pickedHit.barycentrics.y);
+            }
+            else {
+                ImGui::Text("Nothing picked");
+            }
+            ImGui::Text("Pick time:    %10.3f ms", pickTimeMS);
         }
         ImGui::End();
 
+        if (picking && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !ImGui::GetIO().WantCaptureMouse) {
+            pickInstance(glm::vec2(ImGui::GetIO().MousePos.x, ImGui::GetIO().MousePos.y));
+        }
+
         ImGui::Render();
 
         // Update camera data
         camera.position = glm::vec3(2.0F, 2.0F, -5.0F);
         camera.forward = glm::normalize(glm::vec3(0.0F) - camera.position);
 
-        // Update transform data
-        transform.rotation = glm::rotate(transform.rotation, (float)frameTimer.deltaTimeMS() / 1000.0F, glm::vec3(0.0F, 1.0F, 0.0F));
+        // Transforms, instance culling & draw selection run as jobs, culling continues once the transforms are animated & selection
+        // once the instances are culled
+        JobSystem::Counter transformsUpdated;
+        JobSystem::Counter instancesCulled;
+        JobSystem::Counter drawsSelected;
+        float const deltaTime = static_cast<float>(frameTimer.deltaTimeMS()) / 1000.0F;
+        jobSystem->run([deltaTime]()
+        {
+            glm::quat const spin = glm::angleAxis(deltaTime, glm::vec3(0.0F, 1.0F, 0.0F));
+            if (spinInstances) {
+                jobSystem->parallelFor(transforms.size(), InstanceGrainSize, [&spin](size_t begin, size_t end) { transforms.rotate(begin, end, spin); });
+            }
+            sceneData.cameraPosition = camera.position;
+            sceneData.viewproject = camera.matrix();
+        }, &transformsUpdated);
+        jobSystem->runAfter(transformsUpdated, []() { cullInstances(); }, &instancesCulled);
+        jobSystem->runAfter(instancesCulled, []() { selectDraws(); }, &drawsSelected);
 
-        // Update scene data
+        // Update lighting from the GUI settings meanwhile
         sceneData.sunDirection = glm::normalize(glm::vec3{
             glm::cos(glm::radians(sunAzimuth)) * glm::sin(glm::radians(90.0F - sunZenith)),
             glm::cos(glm::radians(90.0F - sunZenith)),
@@ -711,91 +1387,154 @@ namespace Engine
         });
         sceneData.sunColor = sunColor;
         sceneData.ambientLight = ambientLight;
-        sceneData.cameraPosition = camera.position;
-        sceneData.viewproject = camera.matrix();
-        sceneData.model = transform.matrix();
-        sceneData.normal = glm::mat4(glm::inverse(glm::transpose(glm::mat3(sceneData.model))));
         sceneData.specularity = specularity;
 
-        // Upload render data to GPU visible buffers
-        assert(sceneDataBuffer.mapped);
-        memcpy(sceneDataBuffer.pData, &sceneData, sizeof(SceneData));
+        jobSystem->wait(drawsSelected);
+
     }
 
     void render()
     {
-        Renderer::waitForGPU();
-        uint32_t const backbufferIndex = Renderer::swapchain->GetCurrentBackBufferIndex();
-
-        // Reset command list
-        if (FAILED(Renderer::commandAllocator->Reset())
-            || FAILED(Renderer::commandList->Reset(Renderer::commandAllocator.Get(), nullptr)))
+        // Wait for the frame slot's previous frame & reset the command list
+        if (!Renderer::beginFrame())
         {
             printf("D3D12 command list reset failed\n");
             isRunning = false;
             return;
         }
+
+        uint32_t const frameIdx = Renderer::frameIndex();
+        uint32_t const backbufferIndex = Renderer::swapchain->GetCurrentBackBufferIndex();
+
+        // Upload render data to the frame slot's buffer, no longer read by the GPU
+        Buffer& sceneDataBuffer = sceneDataBuffers[frameIdx];
+        assert(sceneDataBuffer.mapped);
+        memcpy(sceneDataBuffer.pData, &sceneData, sizeof(SceneData));
+
+        // Matrices of the visible instances are generated in SIMD batches straight into the frame slot's buffer
+        Buffer& instanceBuffer = instanceBuffers[frameIdx];
+        assert(instanceBuffer.mapped);
+        InstanceData* pInstances = static_cast<InstanceData*>(instanceBuffer.pData);
+        uint32_t const drawnInstanceCount = std::min(visibleInstanceCount, MaxInstanceCount);
+        jobSystem->parallelFor(drawnInstanceCount, InstanceGrainSize, [pInstances](size_t begin, size_t end) { transforms.gatherMatrices(&visibleInstances[begin], end - begin, pInstances + begin); });
+
+        // Copy streamed texture levels ahead of this frame's draws
+        D3D12Helpers::streamTextures();
+        uint32_t const materialTable = D3D12Helpers::materialTable();
         
-        // Record render commands
-        {
-            // Transition to render target state
-            CD3DX12_RESOURCE_BARRIER swapRenderTargetBarrier = CD3DX12_RESOURCE_BARRIER::Transition(Renderer::renderTargets[backbufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-            Renderer::commandList->ResourceBarrier(1, &swapRenderTargetBarrier);
+        // Build this frame's graph, the swap buffer is imported & depth is a transient in the graph's aliased heap
+        RenderGraph frameGraph{};
+        RenderGraph::ResourceId const backbuffer = Renderer::importGraphResource(frameGraph, frameGraphResources, "Backbuffer", Renderer::renderTargets[backbufferIndex].Get(), ResourceState::Present, ResourceState::Present);
+        D3D12_RESOURCE_DESC const depthDesc = CD3DX12_RESOURCE_DESC::Tex2D(Renderer::SwapDepthStencilFormat, static_cast<UINT64>(scissor.right), static_cast<UINT>(scissor.bottom), 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+        RenderGraph::ResourceId const depth = Renderer::declareGraphTransient(frameGraph, frameGraphResources, "Depth", depthDesc, CD3DX12_CLEAR_VALUE(Renderer::SwapDepthStencilFormat, 1.0F, 0x00));
 
-            // Get current swap RTV
-            CD3DX12_CPU_DESCRIPTOR_HANDLE currentSwapRTV(Renderer::rtvHeap->GetCPUDescriptorHandleForHeapStart(), backbufferIndex, Renderer::rtvHeapIncrementSize);
-            CD3DX12_CPU_DESCRIPTOR_HANDLE currentSwapDSV(Renderer::dsvHeap->GetCPUDescriptorHandleForHeapStart(), 0, Renderer::dsvHeapIncrementSize);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE const currentSwapRTV(Renderer::rtvHeap->GetCPUDescriptorHandleForHeapStart(), backbufferIndex, Renderer::rtvHeapIncrementSize);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE const depthDSV(Renderer::dsvHeap->GetCPUDescriptorHandleForHeapStart(), 0, Renderer::dsvHeapIncrementSize);
+
+        RenderGraph::PassId const forwardPass = frameGraph.addPass("Forward", [&]() {
+            // Depth is cleared before any read, as required after its memory was aliased
             float const clearColor[] = { 0.1F, 0.1F, 0.1F, 1.0F };
-            Renderer::commandList->OMSetRenderTargets(1, &currentSwapRTV, FALSE, &currentSwapDSV);
+            Renderer::commandList->OMSetRenderTargets(1, &currentSwapRTV, FALSE, &depthDSV);
             Renderer::commandList->ClearRenderTargetView(currentSwapRTV, clearColor, 0, nullptr);
-            Renderer::commandList->ClearDepthStencilView(currentSwapDSV, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0F, 0x00, 0, nullptr);
-
-            // Set used descriptor heaps for this frame
-            ID3D12DescriptorHeap* ppDescriptorHeaps[] = { descriptorResourceHeap.Get() };
-            Renderer::commandList->SetDescriptorHeaps(sizeof_array(ppDescriptorHeaps), ppDescriptorHeaps);
-
-            // Set root signature
-            Renderer::commandList->SetGraphicsRootSignature(rootSignature.Get());
-            Renderer::commandList->SetGraphicsRootDescriptorTable(0, descriptorResourceHeap->GetGPUDescriptorHandleForHeapStart());
-            Renderer::commandList->SetGraphicsRootDescriptorTable(1, descriptorResourceHeap->GetGPUDescriptorHandleForHeapStart());
-
-            // Set pipeline state
-            Renderer::commandList->SetPipelineState(graphicsPipeline.Get());
-            Renderer::commandList->RSSetViewports(1, &viewport);
-            Renderer::commandList->RSSetScissorRects(1, &scissor);
-
-            // Draw mesh
-            D3D12_VERTEX_BUFFER_VIEW vertexBufferView = { mesh.vertexBuffer.handle->GetGPUVirtualAddress(), static_cast<uint32_t>(mesh.vertexBuffer.size), sizeof(Vertex) };
-            D3D12_INDEX_BUFFER_VIEW indexBufferView = { mesh.indexBuffer.handle->GetGPUVirtualAddress(), static_cast<uint32_t>(mesh.indexBuffer.size), DXGI_FORMAT_R32_UINT };
-
-            D3D12_VERTEX_BUFFER_VIEW pVertexBuffers[] = { vertexBufferView };
-            Renderer::commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-            Renderer::commandList->IASetVertexBuffers(0, sizeof_array(pVertexBuffers), pVertexBuffers);
-            Renderer::commandList->IASetIndexBuffer(&indexBufferView);
-            Renderer::commandList->DrawIndexedInstanced(mesh.indexCount, 1, 0, 0, 0);
-
-            // Draw GUI
-            ID3D12DescriptorHeap* ppImGuiHeaps[] = { ImGuiSRVHeap.Get() };
-            Renderer::commandList->SetDescriptorHeaps(sizeof_array(ppImGuiHeaps), ppImGuiHeaps);
+            Renderer::commandList->ClearDepthStencilView(depthDSV, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0F, 0x00, 0, nullptr);
+
+            // Sorted packets are recorded in parallel chunks, each list binds the per pass state & the packets' pipeline,
+            // material & mesh only where they change, & draws each packet's range of the visible instances
+            MeshConstants const meshConstants = MeshConstants{ glm::vec4(mesh.quantizationBounds.min, 0.0F), glm::vec4(mesh.quantizationBounds.extent, 0.0F) };
+            D3D12_VERTEX_BUFFER_VIEW const vertexBufferView = { mesh.vertexBuffer.handle->GetGPUVirtualAddress(), static_cast<uint32_t>(mesh.vertexBuffer.size), mesh.vertexStride };
+            D3D12_INDEX_BUFFER_VIEW const indexBufferView = { mesh.indexBuffer.handle->GetGPUVirtualAddress(), static_cast<uint32_t>(mesh.indexBuffer.size), mesh.indexFormat };
+            std::pair<size_t, size_t> const forwardPackets = DrawPackets::passRange(drawPackets, ForwardPass);
+            uint32_t const drawCount = (drawnInstanceCount > 0) ? static_cast<uint32_t>(forwardPackets.second - forwardPackets.first) : 0;
+            std::mutex statisticsMutex;
+            drawStatistics = DrawStatistics{};
+            bool const recorded = Renderer::recordParallel(*jobSystem, drawCount, MinDrawsPerCommandList, [&](ID3D12GraphicsCommandList* pCommandList, DrawChunk const& chunk)
+            {
+                pCommandList->OMSetRenderTargets(1, &currentSwapRTV, FALSE, &depthDSV);
+
+                // Set root signature
+                pCommandList->SetGraphicsRootSignature(rootSignature.Get());
+                pCommandList->SetGraphicsRootConstantBufferView(0, sceneDataBuffer.handle->GetGPUVirtualAddress());
+                pCommandList->RSSetViewports(1, &viewport);
+                pCommandList->RSSetScissorRects(1, &scissor);
+                pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+                DrawStateBackend backend{};
+                backend.setPipeline = [pCommandList](uint32_t pipeline)
+                {
+                    assert(pipeline == ForwardPipeline);
+                    pCommandList->SetPipelineState(graphicsPipeline.Get());
+                };
+                backend.setMaterial = [pCommandList, materialTable](uint32_t material)
+                {
+                    assert(material == SceneMaterial);
+                    pCommandList->SetGraphicsRootDescriptorTable(1, Renderer::gpuDescriptor(materialTable));
+                };
+                backend.setMesh = [&](uint32_t meshId)
+                {
+                    assert(meshId == SceneMesh);
+                    D3D12_VERTEX_BUFFER_VIEW pVertexBuffers[] = { vertexBufferView };
+                    pCommandList->SetGraphicsRoot32BitConstants(2, sizeof(MeshConstants) / sizeof(uint32_t), &meshConstants, 0);
+                    pCommandList->IASetVertexBuffers(0, sizeof_array(pVertexBuffers), pVertexBuffers);
+                    pCommandList->IASetIndexBuffer(&indexBufferView);
+                };
+                backend.draw = [pCommandList, &instanceBuffer](DrawPacket const& packet)
+                {
+                    // SV_InstanceID ignores the start instance, so each packet's instance range is bound by offsetting the SRV
+                    pCommandList->SetGraphicsRootShaderResourceView(3, instanceBuffer.handle->GetGPUVirtualAddress() + packet.firstInstance * sizeof(InstanceData));
+                    pCommandList->DrawIndexedInstanced(packet.indexCount, packet.instanceCount, packet.firstIndex, 0, 0);
+                };
+
+                DrawStatistics const chunkStatistics = DrawPackets::submit(&drawPackets[forwardPackets.first + chunk.firstDraw], chunk.drawCount, backend);
+                std::lock_guard<std::mutex> lock(statisticsMutex);
+                drawStatistics.add(chunkStatistics);
+            });
+
+            if (!recorded) {
+                isRunning = false;
+            }
+        });
+        frameGraph.write(forwardPass, backbuffer, ResourceState::RenderTarget);
+        frameGraph.write(forwardPass, depth, ResourceState::DepthWrite);
+
+        RenderGraph::PassId const guiPass = frameGraph.addPass("GUI", [&]() {
+            // The font atlas is in the shared descriptor heap bound by beginFrame
+            Renderer::commandList->OMSetRenderTargets(1, &currentSwapRTV, FALSE, nullptr);
             ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), Renderer::commandList.Get());
+        });
+        frameGraph.write(guiPass, backbuffer, ResourceState::RenderTarget);
 
-            // Transition to present state
-            CD3DX12_RESOURCE_BARRIER swapPresentBarrier = CD3DX12_RESOURCE_BARRIER::Transition(Renderer::renderTargets[backbufferIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-            Renderer::commandList->ResourceBarrier(1, &swapPresentBarrier);
+        // Transients are only recreated when the window size changes, their views follow
+        frameGraph.compile();
+        bool transientsRecreated = false;
+        if (!Renderer::realizeGraphTransients(frameGraph, frameGraphResources, transientsRecreated))
+        {
+            isRunning = false;
+            return;
         }
 
-        // Close command list
-        if (FAILED(Renderer::commandList->Close()))
+        if (transientsRecreated)
+        {
+            D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
+            dsvDesc.Format = Renderer::SwapDepthStencilFormat;
+            dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+            dsvDesc.Texture2D.MipSlice = 0;
+            Renderer::device->CreateDepthStencilView(frameGraphResources.resources[depth], &dsvDesc, depthDSV);
+            frameGraph.report("Frame graph");
+        }
+
+        // Record render commands, barriers between passes come from the graph
+        Renderer::executeGraph(frameGraph, frameGraphResources);
+
+        // Close the frame's command lists, execute them in recording order & present
+        if (!Renderer::submitFrame())
         {
             printf("D3D12 command list close failed\n");
             isRunning = false;
             return;
         }
 
-        // Execute & present
-        ID3D12CommandList* ppCommandLists[] = { Renderer::commandList.Get() };
-        Renderer::commandQueue->ExecuteCommandLists(sizeof_array(ppCommandLists), ppCommandLists);
         Renderer::swapchain->Present(1, 0);
+        Renderer::endFrame();
     }
 } // namespace Engine
 
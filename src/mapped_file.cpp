@@ -0,0 +1,124 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(char const* path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+	if (m_size == 0) //< empty files cannot be mapped, but are valid
+	{
+		m_open = true;
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	m_pData = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	m_fd = ::open(path, O_RDONLY);
+	if (m_fd < 0) {
+		return false;
+	}
+
+	struct stat fileStat{};
+	if (fstat(m_fd, &fileStat) != 0)
+	{
+		close();
+		return false;
+	}
+
+	m_size = static_cast<size_t>(fileStat.st_size);
+	if (m_size == 0) //< empty files cannot be mapped, but are valid
+	{
+		m_open = true;
+		return true;
+	}
+
+	void* pData = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (pData == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+
+	madvise(pData, m_size, MADV_SEQUENTIAL);
+	m_pData = pData;
+#endif
+
+	m_open = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_pData != nullptr) {
+		UnmapViewOfFile(m_pData);
+	}
+
+	if (m_mapping != nullptr) {
+		CloseHandle(static_cast<HANDLE>(m_mapping));
+	}
+
+	if (m_file != nullptr) {
+		CloseHandle(static_cast<HANDLE>(m_file));
+	}
+
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_pData != nullptr) {
+		munmap(const_cast<void*>(m_pData), m_size);
+	}
+
+	if (m_fd >= 0) {
+		::close(m_fd);
+	}
+
+	m_fd = -1;
+#endif
+
+	m_open = false;
+	m_pData = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+/// @brief Read only memory mapped file view.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	~MappedFile();
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	bool open(char const* path);
+
+	void close();
+
+	bool isOpen() const { return m_open; }
+
+	void const* data() const { return m_pData; }
+
+	size_t size() const { return m_size; }
+
+private:
+	bool m_open = false;
+	void const* m_pData = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+};
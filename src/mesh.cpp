@@ -0,0 +1,131 @@
+#include "mesh.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <unordered_map>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include "lod.hpp"
+#include "mesh_optimizer.hpp"
+#include "meshlet.hpp"
+#include "obj_parser.hpp"
+#include "tangent_space.hpp"
+
+namespace Engine
+{
+    namespace MeshHelpers
+    {
+        /// @brief OBJ attribute index tuple, identifies a unique vertex.
+        struct ObjIndexKey
+        {
+            int vertexIndex;
+            int normalIndex;
+            int texCoordIndex;
+
+            bool operator==(ObjIndexKey const& other) const
+            {
+                return vertexIndex == other.vertexIndex && normalIndex == other.normalIndex && texCoordIndex == other.texCoordIndex;
+            }
+        };
+
+        struct ObjIndexKeyHash
+        {
+            size_t operator()(ObjIndexKey const& key) const
+            {
+                uint64_t hash = static_cast<uint32_t>(key.vertexIndex);
+                hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(key.normalIndex);
+                hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(key.texCoordIndex);
+                return static_cast<size_t>(hash ^ (hash >> 32));
+            }
+        };
+
+        bool parseOBJ(char const* path, MeshData& meshData)
+        {
+            if (!ObjParser::parse(path, meshData)) {
+                return false;
+            }
+
+            TangentSpace::generateTangents(meshData);
+            return true;
+        }
+
+        bool parseOBJTinyObj(char const* path, MeshData& meshData)
+        {
+            tinyobj::ObjReader reader;
+            tinyobj::ObjReaderConfig config;
+
+            config.triangulate = true;
+            config.triangulation_method = "earcut";
+            config.vertex_color = true;
+
+            if (!reader.ParseFromFile(path, config))
+            {
+                printf("TinyOBJ OBJ load failed [%s]\n", path);
+                return false;
+            }
+            printf("Loaded OBJ mesh [%s]\n", path);
+
+            auto const& attrib = reader.GetAttrib();
+            auto const& shapes = reader.GetShapes();
+
+            std::vector<Vertex>& vertices = meshData.vertices;
+            std::vector<uint32_t>& indices = meshData.indices;
+            vertices.clear();
+            indices.clear();
+
+            size_t cornerCount = 0;
+            for (auto const& shape : shapes) {
+                cornerCount += shape.mesh.indices.size();
+            }
+
+            // Weld face corners that reference the same attribute tuple, colors share the position index
+            std::unordered_map<ObjIndexKey, uint32_t, ObjIndexKeyHash> vertexLUT;
+            vertexLUT.reserve(cornerCount);
+            vertices.reserve(cornerCount);
+            indices.reserve(cornerCount);
+            for (auto const& shape : shapes)
+            {
+                for (auto const& index : shape.mesh.indices)
+                {
+                    ObjIndexKey const key{ index.vertex_index, index.normal_index, index.texcoord_index };
+                    auto const [it, inserted] = vertexLUT.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+                    indices.push_back(it->second);
+                    if (!inserted) {
+                        continue;
+                    }
+
+                    size_t vertexIdx = index.vertex_index * 3;
+                    size_t normalIdx = index.normal_index * 3;
+                    size_t texIdx = index.texcoord_index * 2;
+
+                    // missing normals & texture coords have a negative index
+                    vertices.push_back(Vertex{
+                        { attrib.vertices[vertexIdx + 0], attrib.vertices[vertexIdx + 1], attrib.vertices[vertexIdx + 2] },
+                        { attrib.colors[vertexIdx + 0], attrib.colors[vertexIdx + 1], attrib.colors[vertexIdx + 2] },
+                        (index.normal_index >= 0) ? glm::vec3(attrib.normals[normalIdx + 0], attrib.normals[normalIdx + 1], attrib.normals[normalIdx + 2]) : glm::vec3(0.0F),
+                        glm::vec4(0.0F), //< tangents are calculated after loading
+                        (index.texcoord_index >= 0) ? glm::vec2(attrib.texcoords[texIdx + 0], attrib.texcoords[texIdx + 1]) : glm::vec2(0.0F),
+                    });
+                }
+            }
+
+            printf("Welded OBJ mesh [%s] (%zu -> %zu vertices, %.1f -> %.1f KiB)\n",
+                path,
+                cornerCount, vertices.size(),
+                static_cast<double>(cornerCount * sizeof(Vertex)) / 1024.0, static_cast<double>(vertices.size() * sizeof(Vertex)) / 1024.0
+            );
+
+            TangentSpace::generateTangents(meshData);
+            return true;
+        }
+
+        void processMesh(MeshData& meshData)
+        {
+            MeshOptimizer::optimizeMesh(meshData);
+            Meshlets::buildMeshlets(meshData, meshData.meshlets);
+            Lods::buildLods(meshData);
+        }
+    } // namespace MeshHelpers
+} // namespace Engine
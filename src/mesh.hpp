@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "math.hpp"
+
+namespace Engine
+{
+    /// @brief Interleaved vertex data.
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 color;
+        glm::vec3 normal;
+        glm::vec4 tangent;          //< handedness in w, bitangent = cross(normal, tangent) * w
+        glm::vec2 texCoord;
+    };
+
+    /// @brief Object space culling bounds of a whole mesh.
+    struct MeshBounds
+    {
+        glm::vec3 aabbMin;
+        glm::vec3 aabbMax;
+        glm::vec3 sphereCenter;     //< AABB center
+        float sphereRadius;         //< furthest vertex from the center
+    };
+
+    /// @brief Triangle cluster, its triangles are also contiguous in the mesh index buffer.
+    struct Meshlet
+    {
+        uint32_t vertexOffset;      //< into MeshletData::vertices
+        uint32_t triangleOffset;    //< into MeshletData::triangles, times 3 gives the first mesh index
+        uint32_t vertexCount;
+        uint32_t triangleCount;
+    };
+
+    /// @brief Meshlet culling bounds in mesh object space.
+    struct MeshletBounds
+    {
+        glm::vec3 center;
+        float radius;
+        glm::vec3 aabbMin;
+        glm::vec3 aabbMax;
+        glm::vec3 coneApex;
+        glm::vec3 coneAxis;         //< zero if the cluster normals are too spread out to cull
+        float coneCutoff;           //< sine of the normal cone half angle
+    };
+
+    /// @brief Meshlet partition of a mesh, with meshlet local vertex & triangle lists.
+    struct MeshletData
+    {
+        std::vector<Meshlet> meshlets;
+        std::vector<MeshletBounds> bounds;
+        std::vector<uint32_t> vertices;     //< meshlet local to mesh vertex index
+        std::vector<uint8_t> triangles;     //< 3 meshlet local vertex indices per triangle
+    };
+
+    /// @brief Simplified level of detail, its indices reference the full detail vertices.
+    struct LodLevel
+    {
+        uint32_t indexOffset;       //< into LodData::indices
+        uint32_t indexCount;
+        float error;                //< object space geometric error relative to full detail
+    };
+
+    /// @brief Chain of simplified index buffers, coarser with each level. Full detail is not included.
+    struct LodData
+    {
+        std::vector<LodLevel> levels;
+        std::vector<uint32_t> indices;
+    };
+
+    /// @brief CPU side mesh data, ready to be uploaded.
+    struct MeshData
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        MeshletData meshlets;
+        LodData lods;
+    };
+
+    namespace MeshHelpers
+    {
+        /// @brief Parse an OBJ file into triangulated mesh data, including tangents.
+        bool parseOBJ(char const* path, MeshData& meshData);
+
+        /// @brief Parse an OBJ file with TinyOBJ, reference for the custom parser.
+        bool parseOBJTinyObj(char const* path, MeshData& meshData);
+
+        /// @brief Run the load time processing stages on parsed mesh data, before it is cached & uploaded.
+        void processMesh(MeshData& meshData);
+    } // namespace MeshHelpers
+} // namespace Engine
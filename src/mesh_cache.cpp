@@ -0,0 +1,223 @@
+#include "mesh_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#include "hash.hpp"
+
+namespace Engine
+{
+    namespace MeshCache
+    {
+        static uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        std::string cachePath(char const* sourcePath)
+        {
+            return std::string(sourcePath) + FileExtension;
+        }
+
+        bool querySource(char const* sourcePath, SourceInfo& sourceInfo, bool computeHash)
+        {
+            std::error_code error;
+            std::filesystem::path const path(sourcePath);
+            uint64_t const size = std::filesystem::file_size(path, error);
+            if (error) {
+                return false;
+            }
+
+            std::filesystem::file_time_type const timestamp = std::filesystem::last_write_time(path, error);
+            if (error) {
+                return false;
+            }
+
+            sourceInfo.size = size;
+            sourceInfo.timestamp = static_cast<int64_t>(timestamp.time_since_epoch().count());
+            sourceInfo.hash = 0;
+
+            if (computeHash)
+            {
+                MappedFile source;
+                if (!source.open(sourcePath)) {
+                    return false;
+                }
+
+                sourceInfo.hash = Hash::fnv1a(source.data(), source.size());
+            }
+
+            return true;
+        }
+
+        bool write(char const* path, SourceInfo const& sourceInfo, MeshData const& meshData)
+        {
+            struct SectionSource
+            {
+                void const* pData;
+                uint64_t count;
+                uint64_t stride;
+            };
+
+            MeshletData const& meshlets = meshData.meshlets;
+            SectionSource const sources[SectionCount] = {
+                SectionSource{ meshData.vertices.data(), meshData.vertices.size(), sizeof(Vertex) },
+                SectionSource{ meshData.indices.data(), meshData.indices.size(), sizeof(uint32_t) },
+                SectionSource{ meshlets.meshlets.data(), meshlets.meshlets.size(), sizeof(Meshlet) },
+                SectionSource{ meshlets.bounds.data(), meshlets.bounds.size(), sizeof(MeshletBounds) },
+                SectionSource{ meshlets.vertices.data(), meshlets.vertices.size(), sizeof(uint32_t) },
+                SectionSource{ meshlets.triangles.data(), meshlets.triangles.size(), sizeof(uint8_t) },
+                SectionSource{ meshData.lods.levels.data(), meshData.lods.levels.size(), sizeof(LodLevel) },
+                SectionSource{ meshData.lods.indices.data(), meshData.lods.indices.size(), sizeof(uint32_t) },
+            };
+
+            Header header{};
+            header.magic = Magic;
+            header.version = Version;
+            header.sourceSize = sourceInfo.size;
+            header.sourceTimestamp = sourceInfo.timestamp;
+            header.sourceHash = sourceInfo.hash;
+
+            uint64_t offset = sizeof(Header);
+            for (uint32_t sectionIdx = 0; sectionIdx < SectionCount; sectionIdx++)
+            {
+                offset = alignUp(offset, DataAlignment);
+                header.sections[sectionIdx] = Section{ offset, sources[sectionIdx].count, sources[sectionIdx].stride };
+                offset += sources[sectionIdx].count * sources[sectionIdx].stride;
+            }
+
+            // Write to a temporary file first, so a crash never leaves a truncated cache behind
+            std::string const tempPath = std::string(path) + ".tmp";
+            FILE* pFile = fopen(tempPath.c_str(), "wb");
+            if (pFile == nullptr) {
+                return false;
+            }
+
+            static uint8_t const padding[DataAlignment] = {};
+            bool success = fwrite(&header, sizeof(Header), 1, pFile) == 1;
+            uint64_t written = sizeof(Header);
+            for (uint32_t sectionIdx = 0; sectionIdx < SectionCount && success; sectionIdx++)
+            {
+                Section const& section = header.sections[sectionIdx];
+                uint64_t const paddingSize = section.offset - written;
+                uint64_t const sectionSize = section.count * section.stride;
+                success = fwrite(padding, 1, paddingSize, pFile) == paddingSize;
+                success = success && (sectionSize == 0 || fwrite(sources[sectionIdx].pData, 1, sectionSize, pFile) == sectionSize);
+                written = section.offset + sectionSize;
+            }
+            success = (fclose(pFile) == 0) && success;
+
+            std::error_code error;
+            if (success) {
+                std::filesystem::rename(tempPath, path, error);
+            }
+
+            if (!success || error)
+            {
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        bool open(char const* path, CachedMesh& cachedMesh)
+        {
+            MappedFile& file = cachedMesh.file;
+            if (!file.open(path)) {
+                return false;
+            }
+
+            if (file.size() < sizeof(Header))
+            {
+                file.close();
+                return false;
+            }
+
+            Header const* pHeader = static_cast<Header const*>(file.data());
+            if (pHeader->magic != Magic || pHeader->version != Version)
+            {
+                file.close();
+                return false;
+            }
+
+            uint64_t const expectedStrides[SectionCount] = { sizeof(Vertex), sizeof(uint32_t), sizeof(Meshlet), sizeof(MeshletBounds), sizeof(uint32_t), sizeof(uint8_t), sizeof(LodLevel), sizeof(uint32_t) };
+            for (uint32_t sectionIdx = 0; sectionIdx < SectionCount; sectionIdx++)
+            {
+                Section const& section = pHeader->sections[sectionIdx];
+                if (section.stride != expectedStrides[sectionIdx]
+                    || section.offset % DataAlignment != 0
+                    || section.offset + section.count * section.stride > file.size())
+                {
+                    file.close();
+                    return false;
+                }
+            }
+
+            cachedMesh.pHeader = pHeader;
+            cachedMesh.pVertices = cachedMesh.section<Vertex>(SectionVertices);
+            cachedMesh.pIndices = cachedMesh.section<uint32_t>(SectionIndices);
+            cachedMesh.vertexCount = cachedMesh.count(SectionVertices);
+            cachedMesh.indexCount = cachedMesh.count(SectionIndices);
+            return true;
+        }
+
+        bool load(char const* sourcePath, char const* path, CachedMesh& cachedMesh)
+        {
+            if (!open(path, cachedMesh)) {
+                return false;
+            }
+
+            // Cooked caches may be shipped without their source asset
+            SourceInfo sourceInfo{};
+            if (!querySource(sourcePath, sourceInfo, false)) {
+                return true;
+            }
+
+            Header const* pHeader = cachedMesh.pHeader;
+            if (pHeader->sourceSize == sourceInfo.size && pHeader->sourceTimestamp == sourceInfo.timestamp) {
+                return true;
+            }
+
+            // Timestamp changed (e.g. fresh checkout), fall back to comparing content hashes
+            if (pHeader->sourceSize == sourceInfo.size
+                && querySource(sourcePath, sourceInfo, true)
+                && pHeader->sourceHash == sourceInfo.hash)
+            {
+                return true;
+            }
+
+            cachedMesh.file.close();
+            cachedMesh.pHeader = nullptr;
+            cachedMesh.pVertices = nullptr;
+            cachedMesh.pIndices = nullptr;
+            cachedMesh.vertexCount = 0;
+            cachedMesh.indexCount = 0;
+            return false;
+        }
+
+        void readMeshlets(CachedMesh const& cachedMesh, MeshletData& meshletData)
+        {
+            Meshlet const* pMeshlets = cachedMesh.section<Meshlet>(SectionMeshlets);
+            MeshletBounds const* pBounds = cachedMesh.section<MeshletBounds>(SectionMeshletBounds);
+            uint32_t const* pVertices = cachedMesh.section<uint32_t>(SectionMeshletVertices);
+            uint8_t const* pTriangles = cachedMesh.section<uint8_t>(SectionMeshletTriangles);
+
+            meshletData.meshlets.assign(pMeshlets, pMeshlets + cachedMesh.count(SectionMeshlets));
+            meshletData.bounds.assign(pBounds, pBounds + cachedMesh.count(SectionMeshletBounds));
+            meshletData.vertices.assign(pVertices, pVertices + cachedMesh.count(SectionMeshletVertices));
+            meshletData.triangles.assign(pTriangles, pTriangles + cachedMesh.count(SectionMeshletTriangles));
+        }
+
+        void readLods(CachedMesh const& cachedMesh, LodData& lodData)
+        {
+            LodLevel const* pLevels = cachedMesh.section<LodLevel>(SectionLodLevels);
+            uint32_t const* pIndices = cachedMesh.section<uint32_t>(SectionLodIndices);
+
+            lodData.levels.assign(pLevels, pLevels + cachedMesh.count(SectionLodLevels));
+            lodData.indices.assign(pIndices, pIndices + cachedMesh.count(SectionLodIndices));
+        }
+    } // namespace MeshCache
+} // namespace Engine
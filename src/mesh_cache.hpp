@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+
+namespace Engine
+{
+    namespace MeshCache
+    {
+        constexpr uint32_t Magic = 0x4843534D; //< "MSCH"
+        constexpr uint32_t Version = 7; //< bump whenever the layout or mesh processing changes cached contents
+        constexpr uint64_t DataAlignment = 64;
+        constexpr char const* FileExtension = ".meshcache";
+
+        enum SectionType : uint32_t
+        {
+            SectionVertices = 0,
+            SectionIndices,
+            SectionMeshlets,
+            SectionMeshletBounds,
+            SectionMeshletVertices,
+            SectionMeshletTriangles,
+            SectionLodLevels,
+            SectionLodIndices,
+            SectionCount,
+        };
+
+        /// @brief Array stored in the cache file, aligned to DataAlignment.
+        struct Section
+        {
+            uint64_t offset;
+            uint64_t count;
+            uint64_t stride;
+        };
+
+        /// @brief Cache file header, followed by the section arrays.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceSize;
+            int64_t sourceTimestamp;
+            uint64_t sourceHash;
+            Section sections[SectionCount];
+        };
+
+        /// @brief Identifies the source asset a cache file was generated from.
+        struct SourceInfo
+        {
+            uint64_t size = 0;
+            int64_t timestamp = 0;
+            uint64_t hash = 0;
+        };
+
+        /// @brief Memory mapped cache file, data pointers point directly into the mapped view.
+        struct CachedMesh
+        {
+            template<typename Type>
+            Type const* section(SectionType type) const
+            {
+                return reinterpret_cast<Type const*>(static_cast<uint8_t const*>(file.data()) + pHeader->sections[type].offset);
+            }
+
+            uint32_t count(SectionType type) const
+            {
+                return static_cast<uint32_t>(pHeader->sections[type].count);
+            }
+
+            MappedFile file;
+            Header const* pHeader = nullptr;
+            Vertex const* pVertices = nullptr;
+            uint32_t const* pIndices = nullptr;
+            uint32_t vertexCount = 0;
+            uint32_t indexCount = 0;
+        };
+
+        std::string cachePath(char const* sourcePath);
+
+        bool querySource(char const* sourcePath, SourceInfo& sourceInfo, bool computeHash);
+
+        bool write(char const* path, SourceInfo const& sourceInfo, MeshData const& meshData);
+
+        bool open(char const* path, CachedMesh& cachedMesh);
+
+        /// @brief Open a cache file and validate it against its source, using the source hash only if size or timestamp changed.
+        bool load(char const* sourcePath, char const* path, CachedMesh& cachedMesh);
+
+        /// @brief Copy the cached meshlet partition into CPU side meshlet data.
+        void readMeshlets(CachedMesh const& cachedMesh, MeshletData& meshletData);
+
+        /// @brief Copy the cached LOD chain into CPU side LOD data.
+        void readLods(CachedMesh const& cachedMesh, LodData& lodData);
+    } // namespace MeshCache
+} // namespace Engine
@@ -0,0 +1,485 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <numeric>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    namespace MeshOptimizer
+    {
+        constexpr float EmptyDepth = -std::numeric_limits<float>::infinity(); //< cleared depth, behind every fragment
+
+        /// @brief Vertex to triangle adjacency in CSR layout.
+        struct TriangleAdjacency
+        {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+        };
+
+        static TriangleAdjacency buildAdjacency(std::vector<uint32_t> const& indices, size_t vertexCount)
+        {
+            TriangleAdjacency adjacency{};
+            adjacency.offsets.resize(vertexCount + 1, 0);
+            adjacency.triangles.resize(indices.size());
+
+            for (uint32_t const index : indices) {
+                adjacency.offsets[index + 1]++;
+            }
+
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++) {
+                adjacency.offsets[vertexIdx + 1] += adjacency.offsets[vertexIdx];
+            }
+
+            std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++) {
+                adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+
+            return adjacency;
+        }
+
+        /// @brief FIFO cache lookup of a triangle's vertices, returns the number of misses.
+        static uint32_t updateCache(uint32_t const* pTriangle, uint32_t cacheSize, std::vector<uint32_t>& cacheTimestamps, uint32_t& timestamp)
+        {
+            uint32_t misses = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t const vertex = pTriangle[corner];
+                if (timestamp - cacheTimestamps[vertex] > cacheSize)
+                {
+                    cacheTimestamps[vertex] = timestamp++;
+                    misses++;
+                }
+            }
+
+            return misses;
+        }
+
+        VertexCacheStats analyzeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize)
+        {
+            assert(indices.size() % 3 == 0);
+
+            VertexCacheStats stats{};
+            if (indices.empty()) {
+                return stats;
+            }
+
+            // FIFO cache simulation using per vertex insertion timestamps
+            std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+            std::vector<bool> referenced(vertexCount, false);
+            uint32_t timestamp = cacheSize + 1;
+            uint32_t uniqueVertices = 0;
+            for (uint32_t const index : indices)
+            {
+                if (timestamp - cacheTimestamps[index] > cacheSize)
+                {
+                    cacheTimestamps[index] = timestamp++;
+                    stats.transformedVertices++;
+                }
+
+                if (!referenced[index])
+                {
+                    referenced[index] = true;
+                    uniqueVertices++;
+                }
+            }
+
+            stats.ACMR = static_cast<float>(stats.transformedVertices) / static_cast<float>(indices.size() / 3);
+            stats.ATVR = static_cast<float>(stats.transformedVertices) / static_cast<float>(uniqueVertices);
+            return stats;
+        }
+
+        OverdrawStats analyzeOverdraw(std::vector<uint32_t> const& indices, std::vector<Vertex> const& vertices)
+        {
+            constexpr uint32_t ViewCount = 6;
+
+            OverdrawStats stats{};
+            if (indices.empty()) {
+                return stats;
+            }
+
+            glm::vec3 minBound(std::numeric_limits<float>::max());
+            glm::vec3 maxBound(-std::numeric_limits<float>::max());
+            for (auto const& vertex : vertices)
+            {
+                minBound = glm::min(minBound, vertex.position);
+                maxBound = glm::max(maxBound, vertex.position);
+            }
+
+            glm::vec3 const size = maxBound - minBound;
+            float const scale = static_cast<float>(OverdrawViewSize - 1) / std::max(std::max(size.x, size.y), std::max(size.z, 1e-12F));
+
+            // Views look down -X, +X, -Y, +Y, -Z & +Z, larger depth is closer to the viewer
+            uint32_t coveredPixels[ViewCount]{};
+            uint32_t shadedPixels[ViewCount]{};
+            JobSystem::parallelForCurrent(ViewCount, 1, [&](size_t viewBegin, size_t viewEnd)
+            {
+                std::vector<float> depthBuffer(static_cast<size_t>(OverdrawViewSize) * OverdrawViewSize);
+                for (size_t viewIdx = viewBegin; viewIdx < viewEnd; viewIdx++)
+                {
+                    int const axis = static_cast<int>(viewIdx / 2);
+                    int const uAxis = (axis + 1) % 3;
+                    int const vAxis = (axis + 2) % 3;
+                    float const direction = (viewIdx % 2 == 0) ? 1.0F : -1.0F;
+                    std::fill(depthBuffer.begin(), depthBuffer.end(), EmptyDepth);
+
+                    for (size_t i = 0; i < indices.size(); i += 3)
+                    {
+                        glm::vec3 const& p0 = vertices[indices[i + 0]].position;
+                        glm::vec3 const& p1 = vertices[indices[i + 1]].position;
+                        glm::vec3 const& p2 = vertices[indices[i + 2]].position;
+
+                        // Counter clockwise triangles face the viewer, the projected area has the sign of the normal
+                        float const facing = glm::cross(p1 - p0, p2 - p0)[axis] * direction;
+                        if (facing <= 0.0F) {
+                            continue;
+                        }
+
+                        glm::vec3 const screen[3] = {
+                            glm::vec3((p0[uAxis] - minBound[uAxis]) * scale + 0.5F, (p0[vAxis] - minBound[vAxis]) * scale + 0.5F, p0[axis] * direction),
+                            glm::vec3((p1[uAxis] - minBound[uAxis]) * scale + 0.5F, (p1[vAxis] - minBound[vAxis]) * scale + 0.5F, p1[axis] * direction),
+                            glm::vec3((p2[uAxis] - minBound[uAxis]) * scale + 0.5F, (p2[vAxis] - minBound[vAxis]) * scale + 0.5F, p2[axis] * direction),
+                        };
+
+                        auto const edge = [](glm::vec3 const& a, glm::vec3 const& b, float x, float y) { return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x); };
+                        float const area = edge(screen[0], screen[1], screen[2].x, screen[2].y);
+                        if (area == 0.0F) {
+                            continue;
+                        }
+
+                        // Pixel centers inside the triangle's bounding box
+                        int const minX = std::max(0, static_cast<int>(std::ceil(std::min({ screen[0].x, screen[1].x, screen[2].x }) - 0.5F)));
+                        int const maxX = std::min(static_cast<int>(OverdrawViewSize) - 1, static_cast<int>(std::floor(std::max({ screen[0].x, screen[1].x, screen[2].x }) - 0.5F)));
+                        int const minY = std::max(0, static_cast<int>(std::ceil(std::min({ screen[0].y, screen[1].y, screen[2].y }) - 0.5F)));
+                        int const maxY = std::min(static_cast<int>(OverdrawViewSize) - 1, static_cast<int>(std::floor(std::max({ screen[0].y, screen[1].y, screen[2].y }) - 0.5F)));
+                        for (int y = minY; y <= maxY; y++)
+                        {
+                            float const centerY = static_cast<float>(y) + 0.5F;
+                            for (int x = minX; x <= maxX; x++)
+                            {
+                                float const centerX = static_cast<float>(x) + 0.5F;
+                                float const w0 = edge(screen[1], screen[2], centerX, centerY) / area;
+                                float const w1 = edge(screen[2], screen[0], centerX, centerY) / area;
+                                float const w2 = edge(screen[0], screen[1], centerX, centerY) / area;
+                                if (w0 < 0.0F || w1 < 0.0F || w2 < 0.0F) {
+                                    continue;
+                                }
+
+                                float& depth = depthBuffer[static_cast<size_t>(y) * OverdrawViewSize + x];
+                                float const fragmentDepth = w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z;
+                                if (fragmentDepth > depth)
+                                {
+                                    depth = fragmentDepth;
+                                    shadedPixels[viewIdx]++;
+                                }
+                            }
+                        }
+                    }
+
+                    coveredPixels[viewIdx] = static_cast<uint32_t>(std::count_if(depthBuffer.begin(), depthBuffer.end(), [](float depth) { return depth != EmptyDepth; }));
+                }
+            });
+
+            for (uint32_t viewIdx = 0; viewIdx < ViewCount; viewIdx++)
+            {
+                stats.coveredPixels += coveredPixels[viewIdx];
+                stats.shadedPixels += shadedPixels[viewIdx];
+            }
+
+            stats.overdraw = static_cast<float>(stats.shadedPixels) / static_cast<float>(std::max(stats.coveredPixels, 1U));
+            return stats;
+        }
+
+        std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>& clusters)
+        {
+            assert(indices.size() % 3 == 0);
+
+            size_t const triangleCount = indices.size() / 3;
+            TriangleAdjacency const adjacency = buildAdjacency(indices, vertexCount);
+
+            std::vector<uint32_t> liveTriangles(vertexCount);
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++) {
+                liveTriangles[vertexIdx] = adjacency.offsets[vertexIdx + 1] - adjacency.offsets[vertexIdx];
+            }
+
+            std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+            std::vector<bool> emitted(triangleCount, false);
+            std::vector<uint32_t> deadEndStack;
+            std::vector<uint32_t> candidates;
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            clusters.clear();
+
+            uint32_t timestamp = cacheSize + 1;
+            size_t cursor = 0;
+            int64_t fanningVertex = vertexCount > 0 ? 0 : -1;
+            bool startCluster = true;
+
+            while (fanningVertex >= 0)
+            {
+                if (startCluster)
+                {
+                    clusters.push_back(static_cast<uint32_t>(result.size() / 3));
+                    startCluster = false;
+                }
+
+                // Emit all live triangles around the fanning vertex
+                candidates.clear();
+                for (uint32_t adjIdx = adjacency.offsets[fanningVertex]; adjIdx < adjacency.offsets[fanningVertex + 1]; adjIdx++)
+                {
+                    uint32_t const triangle = adjacency.triangles[adjIdx];
+                    if (emitted[triangle]) {
+                        continue;
+                    }
+
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        uint32_t const vertex = indices[triangle * 3 + corner];
+                        result.push_back(vertex);
+                        deadEndStack.push_back(vertex);
+                        candidates.push_back(vertex);
+                        liveTriangles[vertex]--;
+
+                        if (timestamp - cacheTimestamps[vertex] > cacheSize) {
+                            cacheTimestamps[vertex] = timestamp++;
+                        }
+                    }
+
+                    emitted[triangle] = true;
+                }
+
+                // Pick the candidate that stays in cache longest while fanning out all its triangles
+                int64_t nextVertex = -1;
+                int64_t bestPriority = -1;
+                for (uint32_t const vertex : candidates)
+                {
+                    if (liveTriangles[vertex] == 0) {
+                        continue;
+                    }
+
+                    int64_t priority = 0;
+                    if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                        priority = timestamp - cacheTimestamps[vertex];
+                    }
+
+                    if (priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        nextVertex = vertex;
+                    }
+                }
+
+                if (nextVertex >= 0)
+                {
+                    fanningVertex = nextVertex;
+                    continue;
+                }
+
+                // Dead end, locality is lost so the next triangles start a new cluster
+                startCluster = true;
+                fanningVertex = -1;
+                while (!deadEndStack.empty())
+                {
+                    uint32_t const vertex = deadEndStack.back();
+                    deadEndStack.pop_back();
+                    if (liveTriangles[vertex] > 0)
+                    {
+                        fanningVertex = vertex;
+                        break;
+                    }
+                }
+
+                while (fanningVertex < 0 && cursor < vertexCount)
+                {
+                    if (liveTriangles[cursor] > 0) {
+                        fanningVertex = static_cast<int64_t>(cursor);
+                    }
+                    cursor++;
+                }
+            }
+
+            if (!clusters.empty() && clusters.back() == result.size() / 3) {
+                clusters.pop_back(); //< drop trailing empty cluster
+            }
+
+            assert(result.size() == indices.size());
+            return result;
+        }
+
+        void splitClusters(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize, float threshold, std::vector<uint32_t>& clusters)
+        {
+            size_t const triangleCount = indices.size() / 3;
+            std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+            uint32_t timestamp = cacheSize + 1;
+
+            std::vector<uint32_t> result;
+            result.reserve(clusters.size());
+            for (size_t clusterIdx = 0; clusterIdx < clusters.size(); clusterIdx++)
+            {
+                size_t const begin = clusters[clusterIdx];
+                size_t const end = (clusterIdx + 1 < clusters.size()) ? clusters[clusterIdx + 1] : triangleCount;
+
+                // Clusters may be drawn in any order after the overdraw sort, so each one starts from a cold cache
+                timestamp += cacheSize + 1;
+                uint32_t clusterMisses = 0;
+                for (size_t triangle = begin; triangle < end; triangle++) {
+                    clusterMisses += updateCache(&indices[triangle * 3], cacheSize, cacheTimestamps, timestamp);
+                }
+
+                float const maxACMR = threshold * static_cast<float>(clusterMisses) / static_cast<float>(std::max<size_t>(end - begin, 1));
+                size_t const firstCut = result.size();
+                result.push_back(static_cast<uint32_t>(begin));
+
+                // Cut as soon as the running ACMR came down to the limit, the cache is flushed at every cut
+                timestamp += cacheSize + 1;
+                uint32_t runningMisses = 0;
+                uint32_t runningTriangles = 0;
+                for (size_t triangle = begin; triangle < end; triangle++)
+                {
+                    runningMisses += updateCache(&indices[triangle * 3], cacheSize, cacheTimestamps, timestamp);
+                    runningTriangles++;
+                    if (static_cast<float>(runningMisses) <= maxACMR * static_cast<float>(runningTriangles))
+                    {
+                        result.push_back(static_cast<uint32_t>(triangle + 1));
+                        timestamp += cacheSize + 1;
+                        runningMisses = 0;
+                        runningTriangles = 0;
+                    }
+                }
+
+                // The last cut either ends the cluster or leaves a tail above the limit, which is merged into the cluster
+                // before it
+                if (result.size() > firstCut + 1) {
+                    result.pop_back();
+                }
+            }
+
+            clusters = std::move(result);
+        }
+
+        std::vector<uint32_t> optimizeOverdraw(std::vector<uint32_t> const& indices, std::vector<Vertex> const& vertices, std::vector<uint32_t> const& clusters)
+        {
+            size_t const triangleCount = indices.size() / 3;
+            if (clusters.size() <= 1) {
+                return indices;
+            }
+
+            // Area weighted mesh centroid
+            glm::vec3 meshCentroid(0.0F);
+            float meshArea = 0.0F;
+            for (size_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                glm::vec3 const& p0 = vertices[indices[triangle * 3 + 0]].position;
+                glm::vec3 const& p1 = vertices[indices[triangle * 3 + 1]].position;
+                glm::vec3 const& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+                float const area = glm::length(glm::cross(p1 - p0, p2 - p0));
+                meshCentroid += (p0 + p1 + p2) * (area / 3.0F);
+                meshArea += area;
+            }
+
+            if (meshArea > 0.0F) {
+                meshCentroid /= meshArea;
+            }
+
+            // Clusters that face away from the mesh center are more likely to occlude others
+            std::vector<float> sortKeys(clusters.size());
+            for (size_t clusterIdx = 0; clusterIdx < clusters.size(); clusterIdx++)
+            {
+                size_t const begin = clusters[clusterIdx];
+                size_t const end = (clusterIdx + 1 < clusters.size()) ? clusters[clusterIdx + 1] : triangleCount;
+
+                glm::vec3 clusterCentroid(0.0F);
+                glm::vec3 clusterNormal(0.0F);
+                float clusterArea = 0.0F;
+                for (size_t triangle = begin; triangle < end; triangle++)
+                {
+                    glm::vec3 const& p0 = vertices[indices[triangle * 3 + 0]].position;
+                    glm::vec3 const& p1 = vertices[indices[triangle * 3 + 1]].position;
+                    glm::vec3 const& p2 = vertices[indices[triangle * 3 + 2]].position;
+
+                    glm::vec3 const normal = glm::cross(p1 - p0, p2 - p0); //< length is twice the triangle area
+                    float const area = glm::length(normal);
+                    clusterCentroid += (p0 + p1 + p2) * (area / 3.0F);
+                    clusterNormal += normal;
+                    clusterArea += area;
+                }
+
+                float const normalLength = glm::length(clusterNormal);
+                if (clusterArea <= 0.0F || normalLength <= 0.0F)
+                {
+                    sortKeys[clusterIdx] = 0.0F;
+                    continue;
+                }
+
+                clusterCentroid /= clusterArea;
+                clusterNormal /= normalLength;
+                sortKeys[clusterIdx] = glm::dot(clusterCentroid - meshCentroid, clusterNormal);
+            }
+
+            std::vector<uint32_t> clusterOrder(clusters.size());
+            std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+            std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+            std::vector<uint32_t> result;
+            result.reserve(indices.size());
+            for (uint32_t const clusterIdx : clusterOrder)
+            {
+                size_t const begin = clusters[clusterIdx];
+                size_t const end = (clusterIdx + 1 < clusters.size()) ? clusters[clusterIdx + 1] : triangleCount;
+                result.insert(result.end(), indices.begin() + begin * 3, indices.begin() + end * 3);
+            }
+
+            return result;
+        }
+
+        void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+        {
+            constexpr uint32_t Unmapped = UINT32_MAX;
+
+            std::vector<uint32_t> remap(vertices.size(), Unmapped);
+            std::vector<Vertex> result;
+            result.reserve(vertices.size());
+            for (uint32_t& index : indices)
+            {
+                if (remap[index] == Unmapped)
+                {
+                    remap[index] = static_cast<uint32_t>(result.size());
+                    result.push_back(vertices[index]);
+                }
+
+                index = remap[index];
+            }
+
+            vertices = std::move(result);
+        }
+
+        void optimizeMesh(MeshData& meshData, uint32_t cacheSize)
+        {
+            VertexCacheStats const before = analyzeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize);
+            OverdrawStats const overdrawBefore = analyzeOverdraw(meshData.indices, meshData.vertices);
+
+            std::vector<uint32_t> clusters;
+            meshData.indices = optimizeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize, clusters);
+            size_t const tipsifyClusters = clusters.size();
+            splitClusters(meshData.indices, meshData.vertices.size(), cacheSize, DefaultClusterThreshold, clusters);
+            meshData.indices = optimizeOverdraw(meshData.indices, meshData.vertices, clusters);
+            optimizeVertexFetch(meshData.vertices, meshData.indices);
+
+            VertexCacheStats const after = analyzeVertexCache(meshData.indices, meshData.vertices.size(), cacheSize);
+            OverdrawStats const overdrawAfter = analyzeOverdraw(meshData.indices, meshData.vertices);
+            printf("Optimized mesh (cache size %u, %zu -> %zu clusters at lambda %.2f): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overdraw %.3f -> %.3f\n",
+                cacheSize, tipsifyClusters, clusters.size(), static_cast<double>(DefaultClusterThreshold),
+                before.ACMR, after.ACMR,
+                before.ATVR, after.ATVR,
+                overdrawBefore.overdraw, overdrawAfter.overdraw
+            );
+        }
+    } // namespace MeshOptimizer
+} // namespace Engine
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.hpp"
+
+namespace Engine
+{
+    namespace MeshOptimizer
+    {
+        constexpr uint32_t DefaultCacheSize = 16;
+        constexpr float DefaultClusterThreshold = 1.25F; //< lambda, ACMR a split cluster may reach relative to the whole cluster
+        constexpr uint32_t OverdrawViewSize = 256;       //< pixels per side of the views overdraw is measured from
+
+        /// @brief Post-transform cache efficiency of an index buffer, simulated with a FIFO cache.
+        struct VertexCacheStats
+        {
+            uint32_t transformedVertices = 0;
+            float ACMR = 0.0F; //< average cache miss ratio, transformed vertices per triangle
+            float ATVR = 0.0F; //< average transform to vertex ratio, 1.0 is optimal
+        };
+
+        /// @brief Fragments shaded against pixels covered when drawing in index order, measured from six axis aligned views.
+        struct OverdrawStats
+        {
+            uint32_t coveredPixels = 0;
+            uint32_t shadedPixels = 0;
+            float overdraw = 0.0F; //< shaded per covered pixel, 1.0 is optimal
+        };
+
+        VertexCacheStats analyzeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+        /// @brief Rasterize the mesh with backface culling & a depth test into orthographic views along each axis.
+        OverdrawStats analyzeOverdraw(std::vector<uint32_t> const& indices, std::vector<Vertex> const& vertices);
+
+        /// @brief Tipsify triangle reordering, outputs the triangle offsets at which the cache was flushed as clusters.
+        std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize, std::vector<uint32_t>& clusters);
+
+        /// @brief Tipsify's lambda split, cuts clusters once the ACMR since the previous cut dropped to threshold times the ACMR
+        /// of the whole cluster. Each cut restarts from a cold cache, so the overdraw sort gets smaller clusters for a bounded
+        /// cache cost.
+        void splitClusters(std::vector<uint32_t> const& indices, size_t vertexCount, uint32_t cacheSize, float threshold, std::vector<uint32_t>& clusters);
+
+        /// @brief View independent overdraw reduction, sorts clusters so outward facing geometry is drawn first.
+        std::vector<uint32_t> optimizeOverdraw(std::vector<uint32_t> const& indices, std::vector<Vertex> const& vertices, std::vector<uint32_t> const& clusters);
+
+        /// @brief Reorder vertices in order of first use and remap indices, drops unreferenced vertices.
+        void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        /// @brief Run vertex cache, overdraw and vertex fetch optimization in sequence, logging cache & overdraw stats.
+        void optimizeMesh(MeshData& meshData, uint32_t cacheSize = DefaultCacheSize);
+    } // namespace MeshOptimizer
+} // namespace Engine
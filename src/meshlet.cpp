@@ -0,0 +1,187 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Engine
+{
+    namespace Meshlets
+    {
+        void buildMeshlets(MeshData const& meshData, MeshletData& meshletData, uint32_t maxVertices, uint32_t maxTriangles)
+        {
+            assert(meshData.indices.size() % 3 == 0);
+            assert(maxVertices >= 3 && maxVertices <= 256);
+            assert(maxTriangles >= 1);
+
+            constexpr uint32_t Unassigned = UINT32_MAX;
+
+            meshletData = MeshletData{};
+            std::vector<uint32_t> localIndices(meshData.vertices.size(), Unassigned);
+
+            Meshlet current{};
+            auto const flush = [&]()
+            {
+                if (current.triangleCount == 0) {
+                    return;
+                }
+
+                for (uint32_t localIdx = 0; localIdx < current.vertexCount; localIdx++) {
+                    localIndices[meshletData.vertices[current.vertexOffset + localIdx]] = Unassigned;
+                }
+
+                meshletData.meshlets.push_back(current);
+                current = Meshlet{};
+                current.vertexOffset = static_cast<uint32_t>(meshletData.vertices.size());
+                current.triangleOffset = static_cast<uint32_t>(meshletData.triangles.size() / 3);
+            };
+
+            size_t const triangleCount = meshData.indices.size() / 3;
+            for (size_t triangle = 0; triangle < triangleCount; triangle++)
+            {
+                uint32_t const* pTriangle = &meshData.indices[triangle * 3];
+                uint32_t newVertices = 0;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    if (localIndices[pTriangle[corner]] == Unassigned) {
+                        newVertices++;
+                    }
+                }
+
+                if (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles) {
+                    flush();
+                }
+
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    uint32_t const vertex = pTriangle[corner];
+                    if (localIndices[vertex] == Unassigned)
+                    {
+                        localIndices[vertex] = current.vertexCount++;
+                        meshletData.vertices.push_back(vertex);
+                    }
+
+                    meshletData.triangles.push_back(static_cast<uint8_t>(localIndices[vertex]));
+                }
+
+                current.triangleCount++;
+            }
+
+            flush();
+
+            meshletData.bounds.reserve(meshletData.meshlets.size());
+            for (auto const& meshlet : meshletData.meshlets) {
+                meshletData.bounds.push_back(computeBounds(meshData, meshlet, meshletData));
+            }
+        }
+
+        MeshletBounds computeBounds(MeshData const& meshData, Meshlet const& meshlet, MeshletData const& meshletData)
+        {
+            MeshletBounds bounds{};
+
+            // AABB & bounding sphere around the AABB center
+            glm::vec3 aabbMin = meshData.vertices[meshletData.vertices[meshlet.vertexOffset]].position;
+            glm::vec3 aabbMax = aabbMin;
+            for (uint32_t localIdx = 1; localIdx < meshlet.vertexCount; localIdx++)
+            {
+                glm::vec3 const& position = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + localIdx]].position;
+                aabbMin = glm::min(aabbMin, position);
+                aabbMax = glm::max(aabbMax, position);
+            }
+
+            glm::vec3 const center = (aabbMin + aabbMax) * 0.5F;
+            float radius = 0.0F;
+            for (uint32_t localIdx = 0; localIdx < meshlet.vertexCount; localIdx++)
+            {
+                glm::vec3 const& position = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + localIdx]].position;
+                radius = std::max(radius, glm::length(position - center));
+            }
+
+            bounds.center = center;
+            bounds.radius = radius;
+            bounds.aabbMin = aabbMin;
+            bounds.aabbMax = aabbMax;
+
+            // Normal cone around the average triangle normal
+            auto const trianglePosition = [&](uint32_t triangle, uint32_t corner) -> glm::vec3 const&
+            {
+                uint8_t const localIdx = meshletData.triangles[(meshlet.triangleOffset + triangle) * 3 + corner];
+                return meshData.vertices[meshletData.vertices[meshlet.vertexOffset + localIdx]].position;
+            };
+
+            glm::vec3 axis(0.0F);
+            for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+            {
+                glm::vec3 const& p0 = trianglePosition(triangle, 0);
+                glm::vec3 const normal = glm::cross(trianglePosition(triangle, 1) - p0, trianglePosition(triangle, 2) - p0);
+                float const length = glm::length(normal);
+                if (length > 0.0F) {
+                    axis += normal / length;
+                }
+            }
+
+            bounds.coneApex = center;
+            bounds.coneAxis = glm::vec3(0.0F);
+            bounds.coneCutoff = 1.0F;
+
+            float const axisLength = glm::length(axis);
+            if (axisLength <= 0.0F) {
+                return bounds;
+            }
+
+            axis /= axisLength;
+
+            float minDot = 1.0F;
+            for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+            {
+                glm::vec3 const& p0 = trianglePosition(triangle, 0);
+                glm::vec3 const normal = glm::cross(trianglePosition(triangle, 1) - p0, trianglePosition(triangle, 2) - p0);
+                float const length = glm::length(normal);
+                if (length > 0.0F) {
+                    minDot = std::min(minDot, glm::dot(normal / length, axis));
+                }
+            }
+
+            if (minDot <= 0.1F) {
+                return bounds; //< cone wider than ~84 degrees, backface culling would almost never succeed
+            }
+
+            // Move the apex back along the axis until every triangle plane is in front of it
+            float maxT = 0.0F;
+            for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+            {
+                glm::vec3 const& p0 = trianglePosition(triangle, 0);
+                glm::vec3 const normal = glm::cross(trianglePosition(triangle, 1) - p0, trianglePosition(triangle, 2) - p0);
+                float const length = glm::length(normal);
+                if (length <= 0.0F) {
+                    continue;
+                }
+
+                glm::vec3 const unitNormal = normal / length;
+                float const distance = glm::dot(center - p0, unitNormal);
+                float const cosine = glm::dot(axis, unitNormal);
+                maxT = std::max(maxT, distance / cosine);
+            }
+
+            bounds.coneApex = center - axis * maxT;
+            bounds.coneAxis = axis;
+            bounds.coneCutoff = std::sqrt(1.0F - minDot * minDot);
+            return bounds;
+        }
+
+        CullResult cullMeshlet(MeshletBounds const& bounds, Frustum const& frustum, glm::vec3 const& cameraPosition)
+        {
+            if (!Culling::testSphere(frustum, bounds.center, bounds.radius)) {
+                return CullResult::Frustum;
+            }
+
+            glm::vec3 const apexDirection = bounds.coneApex - cameraPosition;
+            float const apexDistance = glm::length(apexDirection);
+            if (apexDistance > 0.0F && glm::dot(apexDirection, bounds.coneAxis) >= bounds.coneCutoff * apexDistance) {
+                return CullResult::Backface;
+            }
+
+            return CullResult::Visible;
+        }
+    } // namespace Meshlets
+} // namespace Engine
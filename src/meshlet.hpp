@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+#include "culling.hpp"
+#include "math.hpp"
+#include "mesh.hpp"
+
+namespace Engine
+{
+    namespace Meshlets
+    {
+        constexpr uint32_t DefaultMaxVertices = 64;
+        constexpr uint32_t DefaultMaxTriangles = 124;
+
+        enum class CullResult
+        {
+            Visible,
+            Frustum,
+            Backface,
+        };
+
+        /// @brief Greedily split the mesh into meshlets in index buffer order, so cache optimized meshes yield compact clusters.
+        void buildMeshlets(MeshData const& meshData, MeshletData& meshletData, uint32_t maxVertices = DefaultMaxVertices, uint32_t maxTriangles = DefaultMaxTriangles);
+
+        MeshletBounds computeBounds(MeshData const& meshData, Meshlet const& meshlet, MeshletData const& meshletData);
+
+        /// @brief Cull a meshlet against an object space frustum & camera position.
+        CullResult cullMeshlet(MeshletBounds const& bounds, Frustum const& frustum, glm::vec3 const& cameraPosition);
+    } // namespace Meshlets
+} // namespace Engine
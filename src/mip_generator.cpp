@@ -0,0 +1,316 @@
+#include "mip_generator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    namespace MipGenerator
+    {
+        constexpr int MaxTaps = 16;
+        constexpr float KaiserSupport = 3.0F;   //< kernel radius in source texels at a 2:1 reduction
+        constexpr float KaiserAlpha = 4.0F;
+        constexpr size_t RowGrainSize = 16;     //< rows per parallel job
+        constexpr float Pi = 3.14159265F;
+
+        /// @brief Source texels & weights contributing to one destination texel along an axis, addresses clamped to the edge.
+        struct FilterTaps
+        {
+            int count;
+            int indices[MaxTaps];
+            float weights[MaxTaps];
+        };
+
+        /// @brief Gamma decode table & exact nearest code encoding through a coarse table plus thresholds.
+        struct GammaTables
+        {
+            static constexpr size_t EncodeTableSize = 65536;
+
+            GammaTables()
+            {
+                for (int code = 0; code < 256; code++) {
+                    decode[code] = std::pow(static_cast<float>(code) / 255.0F, Gamma);
+                }
+
+                for (int code = 0; code < 255; code++) {
+                    thresholds[code] = std::pow((static_cast<float>(code) + 0.5F) / 255.0F, Gamma);
+                }
+
+                for (size_t entry = 0; entry < EncodeTableSize; entry++)
+                {
+                    float const linear = static_cast<float>(entry) / static_cast<float>(EncodeTableSize - 1);
+                    encodeTable[entry] = static_cast<uint8_t>(std::lround(std::pow(linear, 1.0F / Gamma) * 255.0F));
+                }
+            }
+
+            uint8_t encode(float linear) const
+            {
+                linear = std::min(std::max(linear, 0.0F), 1.0F);
+                int code = encodeTable[static_cast<size_t>(linear * static_cast<float>(EncodeTableSize - 1) + 0.5F)];
+                while (code < 255 && linear >= thresholds[code]) {
+                    code++;
+                }
+
+                while (code > 0 && linear < thresholds[code - 1]) {
+                    code--;
+                }
+
+                return static_cast<uint8_t>(code);
+            }
+
+            float decode[256];
+            float thresholds[255];  //< linear value at which code k rounds up to k + 1
+            uint8_t encodeTable[EncodeTableSize];
+        };
+
+        static GammaTables const& gammaTables()
+        {
+            static GammaTables const tables{};
+            return tables;
+        }
+
+        /// @brief Modified Bessel function of the first kind, order 0, power series.
+        static double besselI0(double x)
+        {
+            double sum = 1.0;
+            double term = 1.0;
+            double const halfSquared = x * x * 0.25;
+            for (int k = 1; k < 32 && term > sum * 1e-12; k++)
+            {
+                term *= halfSquared / (static_cast<double>(k) * static_cast<double>(k));
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        /// @brief Filter kernel, u in source texels at a 2:1 reduction.
+        static float kernel(MipFilter filter, float u)
+        {
+            float const absU = std::abs(u);
+            if (filter == MipFilter::Box) {
+                return (absU < 1.0F) ? 1.0F : 0.0F;
+            }
+
+            if (absU >= KaiserSupport) {
+                return 0.0F;
+            }
+
+            float const x = u * 0.5F; //< sinc cutoff at the destination Nyquist frequency
+            float const sinc = (x == 0.0F) ? 1.0F : std::sin(Pi * x) / (Pi * x);
+            float const ratio = absU / KaiserSupport;
+            double const window = besselI0(KaiserAlpha * std::sqrt(1.0 - static_cast<double>(ratio * ratio))) / besselI0(KaiserAlpha);
+            return sinc * static_cast<float>(window);
+        }
+
+        static std::vector<FilterTaps> computeTaps(MipFilter filter, uint32_t sourceSize, uint32_t destinationSize)
+        {
+            float const scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+            float const support = ((filter == MipFilter::Box) ? 1.0F : KaiserSupport) * scale * 0.5F;
+
+            std::vector<FilterTaps> taps(destinationSize);
+            for (uint32_t destinationIdx = 0; destinationIdx < destinationSize; destinationIdx++)
+            {
+                FilterTaps& filterTaps = taps[destinationIdx];
+                filterTaps.count = 0;
+
+                float const center = (static_cast<float>(destinationIdx) + 0.5F) * scale;
+                int const first = static_cast<int>(std::floor(center - support - 0.5F));
+                int const last = static_cast<int>(std::ceil(center + support - 0.5F));
+                float weightSum = 0.0F;
+                for (int sourceIdx = first; sourceIdx <= last && filterTaps.count < MaxTaps; sourceIdx++)
+                {
+                    float const weight = kernel(filter, (static_cast<float>(sourceIdx) + 0.5F - center) * 2.0F / scale);
+                    if (weight == 0.0F) {
+                        continue;
+                    }
+
+                    filterTaps.indices[filterTaps.count] = std::min(std::max(sourceIdx, 0), static_cast<int>(sourceSize) - 1);
+                    filterTaps.weights[filterTaps.count] = weight;
+                    filterTaps.count++;
+                    weightSum += weight;
+                }
+
+                assert(filterTaps.count > 0 && weightSum != 0.0F);
+                for (int tapIdx = 0; tapIdx < filterTaps.count; tapIdx++) {
+                    filterTaps.weights[tapIdx] /= weightSum;
+                }
+            }
+
+            return taps;
+        }
+
+        static void decodeRow(TextureLevel const& level, TextureType type, size_t row, float* pTexels)
+        {
+            GammaTables const& tables = gammaTables();
+            uint8_t const* pRow = &level.data[row * level.width * 4];
+            for (size_t idx = 0; idx < static_cast<size_t>(level.width) * 4; idx += 4)
+            {
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    switch (type)
+                    {
+                    case TextureType::Color:
+                        pTexels[idx + channel] = tables.decode[pRow[idx + channel]];
+                        break;
+                    case TextureType::Normal:
+                        pTexels[idx + channel] = static_cast<float>(pRow[idx + channel]) / 255.0F * 2.0F - 1.0F;
+                        break;
+                    default:
+                        pTexels[idx + channel] = static_cast<float>(pRow[idx + channel]) / 255.0F;
+                        break;
+                    }
+                }
+
+                pTexels[idx + 3] = static_cast<float>(pRow[idx + 3]) / 255.0F;
+            }
+        }
+
+        static void encodeLevel(std::vector<float> const& texels, TextureType type, TextureLevel& level)
+        {
+            GammaTables const& tables = gammaTables();
+            level.data.resize(static_cast<size_t>(level.width) * level.height * 4);
+            JobSystem::parallelForCurrent(level.height, RowGrainSize, [&](size_t rowBegin, size_t rowEnd)
+            {
+                auto const quantize = [](float value) { return static_cast<uint8_t>(std::min(std::max(value, 0.0F), 1.0F) * 255.0F + 0.5F); };
+                for (size_t idx = rowBegin * level.width * 4; idx < rowEnd * level.width * 4; idx += 4)
+                {
+                    float const* pTexel = &texels[idx];
+                    uint8_t* pOutput = &level.data[idx];
+                    if (type == TextureType::Color)
+                    {
+                        pOutput[0] = tables.encode(pTexel[0]);
+                        pOutput[1] = tables.encode(pTexel[1]);
+                        pOutput[2] = tables.encode(pTexel[2]);
+                    }
+                    else if (type == TextureType::Normal)
+                    {
+                        // Filtered normals shorten where they disagree, store unit length & keep the filtered chain as is
+                        float const length = std::sqrt(pTexel[0] * pTexel[0] + pTexel[1] * pTexel[1] + pTexel[2] * pTexel[2]);
+                        float const scale = (length > 0.0F) ? 0.5F / length : 0.0F;
+                        pOutput[0] = quantize(pTexel[0] * scale + 0.5F);
+                        pOutput[1] = quantize(pTexel[1] * scale + 0.5F);
+                        pOutput[2] = (length > 0.0F) ? quantize(pTexel[2] * scale + 0.5F) : 255;
+                    }
+                    else
+                    {
+                        pOutput[0] = quantize(pTexel[0]);
+                        pOutput[1] = quantize(pTexel[1]);
+                        pOutput[2] = quantize(pTexel[2]);
+                    }
+
+                    pOutput[3] = quantize(pTexel[3]);
+                }
+            });
+        }
+
+        /// @brief Separable downsample, horizontal pass per source row then vertical pass per destination row.
+        /// The row source returns a float row, decoding into the scratch row if needed.
+        template<typename RowSource>
+        static void downsample(RowSource const& sourceRow, uint32_t sourceWidth, uint32_t sourceHeight, std::vector<float>& destination, uint32_t destinationWidth, uint32_t destinationHeight, MipFilter filter)
+        {
+            std::vector<FilterTaps> const horizontalTaps = computeTaps(filter, sourceWidth, destinationWidth);
+            std::vector<FilterTaps> const verticalTaps = computeTaps(filter, sourceHeight, destinationHeight);
+
+            std::vector<float> horizontal(static_cast<size_t>(destinationWidth) * sourceHeight * 4);
+            JobSystem::parallelForCurrent(sourceHeight, RowGrainSize, [&](size_t rowBegin, size_t rowEnd)
+            {
+                std::vector<float> scratchRow(static_cast<size_t>(sourceWidth) * 4);
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    float const* pSourceRow = sourceRow(row, scratchRow.data());
+                    float* pOutputRow = &horizontal[row * destinationWidth * 4];
+                    for (uint32_t column = 0; column < destinationWidth; column++)
+                    {
+                        FilterTaps const& taps = horizontalTaps[column];
+                        float texel[4] = { 0.0F, 0.0F, 0.0F, 0.0F };
+                        for (int tapIdx = 0; tapIdx < taps.count; tapIdx++)
+                        {
+                            float const* pSource = &pSourceRow[taps.indices[tapIdx] * 4];
+                            float const weight = taps.weights[tapIdx];
+                            for (int channel = 0; channel < 4; channel++) {
+                                texel[channel] += pSource[channel] * weight;
+                            }
+                        }
+
+                        for (int channel = 0; channel < 4; channel++) {
+                            pOutputRow[column * 4 + channel] = texel[channel];
+                        }
+                    }
+                }
+            });
+
+            destination.assign(static_cast<size_t>(destinationWidth) * destinationHeight * 4, 0.0F);
+            size_t const rowLength = static_cast<size_t>(destinationWidth) * 4;
+            JobSystem::parallelForCurrent(destinationHeight, RowGrainSize, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    FilterTaps const& taps = verticalTaps[row];
+                    float* pOutputRow = &destination[row * rowLength];
+                    for (int tapIdx = 0; tapIdx < taps.count; tapIdx++)
+                    {
+                        float const* pSourceRow = &horizontal[static_cast<size_t>(taps.indices[tapIdx]) * rowLength];
+                        float const weight = taps.weights[tapIdx];
+                        for (size_t idx = 0; idx < rowLength; idx++) { //< contiguous multiply add, vectorizes
+                            pOutputRow[idx] += pSourceRow[idx] * weight;
+                        }
+                    }
+                }
+            });
+        }
+
+        uint32_t mipCount(uint32_t width, uint32_t height)
+        {
+            uint32_t count = 1;
+            while (width > 1 || height > 1)
+            {
+                width = std::max(width / 2, 1U);
+                height = std::max(height / 2, 1U);
+                count++;
+            }
+
+            return count;
+        }
+
+        void generateMips(TextureData& texture, MipFilter filter)
+        {
+            assert(!texture.levels.empty());
+            assert(texture.format == TextureFormat::RGBA8);
+            texture.levels.resize(1);
+
+            uint32_t const levelCount = mipCount(texture.levels[0].width, texture.levels[0].height);
+            texture.levels.reserve(levelCount);
+
+            // Filter from the previous float level, so quantization error doesn't accumulate down the chain
+            std::vector<float> current;
+            std::vector<float> next;
+            for (uint32_t levelIdx = 1; levelIdx < levelCount; levelIdx++)
+            {
+                TextureLevel const& previous = texture.levels[levelIdx - 1];
+                TextureLevel level{};
+                level.width = std::max(previous.width / 2, 1U);
+                level.height = std::max(previous.height / 2, 1U);
+
+                if (levelIdx == 1)
+                {
+                    // Decode the base level row by row instead of keeping a full float copy around
+                    auto const baseRow = [&](size_t row, float* pScratch) { decodeRow(previous, texture.type, row, pScratch); return static_cast<float const*>(pScratch); };
+                    downsample(baseRow, previous.width, previous.height, next, level.width, level.height, filter);
+                }
+                else
+                {
+                    auto const floatRow = [&](size_t row, float*) { return static_cast<float const*>(&current[row * previous.width * 4]); };
+                    downsample(floatRow, previous.width, previous.height, next, level.width, level.height, filter);
+                }
+
+                encodeLevel(next, texture.type, level);
+                texture.levels.push_back(std::move(level));
+                std::swap(current, next);
+            }
+        }
+    } // namespace MipGenerator
+} // namespace Engine
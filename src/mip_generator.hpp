@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace MipGenerator
+    {
+        enum class MipFilter
+        {
+            Box,        //< 2x2 average, cheapest
+            Kaiser,     //< Kaiser windowed sinc, sharper & less aliasing
+        };
+
+        constexpr float Gamma = 2.2F; //< matches the shader side gamma decode of color textures
+
+        /// @brief Number of levels in a full mip chain down to 1x1.
+        uint32_t mipCount(uint32_t width, uint32_t height);
+
+        /// @brief Replace all but the first level with a full mip chain generated from it. Color textures are filtered in
+        /// linear space, normal maps are renormalized. Rows are filtered in parallel.
+        void generateMips(TextureData& texture, MipFilter filter = MipFilter::Kaiser);
+    } // namespace MipGenerator
+} // namespace Engine
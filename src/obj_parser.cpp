@@ -0,0 +1,590 @@
+#include "obj_parser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+#include "job_system.hpp"
+#include "mapped_file.hpp"
+
+namespace Engine
+{
+    namespace ObjParser
+    {
+        constexpr int32_t MissingIndex = INT32_MIN;
+        constexpr size_t MinChunkSize = 256 * 1024;
+
+        /// @brief Face corner as written in the file, relative indices are chunk local until resolved.
+        struct RawCorner
+        {
+            int32_t position;
+            int32_t texCoord;
+            int32_t normal;
+            uint32_t relativeMask; //< bit per attribute, set if the index is relative to the chunk start
+        };
+
+        /// @brief Resolved face corner, indices are global & zero based, -1 if missing.
+        struct Corner
+        {
+            int32_t position;
+            int32_t texCoord;
+            int32_t normal;
+        };
+
+        /// @brief Line aligned part of the file, parsed independently.
+        struct Chunk
+        {
+            char const* pBegin = nullptr;
+            char const* pEnd = nullptr;
+
+            std::vector<float> positions;
+            std::vector<float> colors;
+            std::vector<float> normals;
+            std::vector<float> texCoords;
+            std::vector<uint32_t> polygonSizes;
+            std::vector<RawCorner> rawCorners;
+            std::vector<Corner> triangleCorners;
+
+            size_t positionBase = 0;
+            size_t normalBase = 0;
+            size_t texCoordBase = 0;
+            bool success = true;
+        };
+
+        static bool isBlank(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+
+        static char const* skipBlank(char const* p, char const* pEnd)
+        {
+            while (p < pEnd && isBlank(*p)) {
+                p++;
+            }
+
+            return p;
+        }
+
+        static bool parseFloat(char const*& p, char const* pEnd, float& value)
+        {
+            p = skipBlank(p, pEnd);
+            if (p < pEnd && *p == '+') { //< from_chars does not accept a leading plus
+                p++;
+            }
+
+            std::from_chars_result const result = std::from_chars(p, pEnd, value);
+            if (result.ec != std::errc()) {
+                return false;
+            }
+
+            p = result.ptr;
+            return true;
+        }
+
+        static bool parseInt(char const*& p, char const* pEnd, int32_t& value)
+        {
+            if (p < pEnd && *p == '+') {
+                p++;
+            }
+
+            std::from_chars_result const result = std::from_chars(p, pEnd, value);
+            if (result.ec != std::errc()) {
+                return false;
+            }
+
+            p = result.ptr;
+            return true;
+        }
+
+        /// @brief Convert an OBJ index (1 based, or negative relative to the current end) into a zero based index.
+        static int32_t convertIndex(int32_t index, size_t localCount, uint32_t relativeBit, uint32_t& relativeMask)
+        {
+            if (index > 0) {
+                return index - 1;
+            }
+
+            relativeMask |= relativeBit;
+            return static_cast<int32_t>(localCount) + index;
+        }
+
+        static bool parseFace(char const* p, char const* pEnd, Chunk& chunk)
+        {
+            uint32_t cornerCount = 0;
+            for (p = skipBlank(p, pEnd); p < pEnd; p = skipBlank(p, pEnd))
+            {
+                RawCorner corner{ MissingIndex, MissingIndex, MissingIndex, 0 };
+
+                int32_t index = 0;
+                if (!parseInt(p, pEnd, index) || index == 0) {
+                    return false;
+                }
+                corner.position = convertIndex(index, chunk.positions.size() / 3, 0x1, corner.relativeMask);
+
+                if (p < pEnd && *p == '/')
+                {
+                    p++;
+                    if (p < pEnd && *p != '/')
+                    {
+                        if (!parseInt(p, pEnd, index) || index == 0) {
+                            return false;
+                        }
+                        corner.texCoord = convertIndex(index, chunk.texCoords.size() / 2, 0x2, corner.relativeMask);
+                    }
+
+                    if (p < pEnd && *p == '/')
+                    {
+                        p++;
+                        if (!parseInt(p, pEnd, index) || index == 0) {
+                            return false;
+                        }
+                        corner.normal = convertIndex(index, chunk.normals.size() / 3, 0x4, corner.relativeMask);
+                    }
+                }
+
+                if (p < pEnd && !isBlank(*p)) {
+                    return false;
+                }
+
+                chunk.rawCorners.push_back(corner);
+                cornerCount++;
+            }
+
+            if (cornerCount < 3) {
+                return false;
+            }
+
+            chunk.polygonSizes.push_back(cornerCount);
+            return true;
+        }
+
+        static void parseChunk(Chunk& chunk)
+        {
+            char const* p = chunk.pBegin;
+            char const* const pEnd = chunk.pEnd;
+            while (p < pEnd)
+            {
+                char const* pLineEnd = static_cast<char const*>(memchr(p, '\n', static_cast<size_t>(pEnd - p)));
+                if (pLineEnd == nullptr) {
+                    pLineEnd = pEnd;
+                }
+
+                char const* const pLine = skipBlank(p, pLineEnd);
+                p = pLineEnd + 1;
+
+                char const* pValue = pLine;
+                while (pValue < pLineEnd && !isBlank(*pValue)) {
+                    pValue++;
+                }
+
+                size_t const keywordLength = static_cast<size_t>(pValue - pLine);
+                if (keywordLength == 0 || keywordLength > 2) {
+                    continue; //< empty line or a statement we don't use (mtllib, usemtl, ...)
+                }
+
+                if (keywordLength == 2 && pLine[0] == 'v' && pLine[1] == 't')
+                {
+                    float texCoord[2] = { 0.0F, 0.0F };
+                    if (!parseFloat(pValue, pLineEnd, texCoord[0])) {
+                        chunk.success = false;
+                        return;
+                    }
+                    parseFloat(pValue, pLineEnd, texCoord[1]); //< v is optional
+
+                    chunk.texCoords.insert(chunk.texCoords.end(), texCoord, texCoord + 2);
+                }
+                else if (keywordLength == 2 && pLine[0] == 'v' && pLine[1] == 'n')
+                {
+                    float normal[3] = {};
+                    if (!parseFloat(pValue, pLineEnd, normal[0]) || !parseFloat(pValue, pLineEnd, normal[1]) || !parseFloat(pValue, pLineEnd, normal[2])) {
+                        chunk.success = false;
+                        return;
+                    }
+
+                    chunk.normals.insert(chunk.normals.end(), normal, normal + 3);
+                }
+                else if (keywordLength == 1 && pLine[0] == 'v')
+                {
+                    // x y z [w] or x y z r g b
+                    float values[6] = {};
+                    uint32_t valueCount = 0;
+                    while (valueCount < 6 && parseFloat(pValue, pLineEnd, values[valueCount])) {
+                        valueCount++;
+                    }
+
+                    if (valueCount < 3) {
+                        chunk.success = false;
+                        return;
+                    }
+
+                    chunk.positions.insert(chunk.positions.end(), values, values + 3);
+                    if (valueCount == 6) {
+                        chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+                    }
+                    else {
+                        chunk.colors.insert(chunk.colors.end(), { 1.0F, 1.0F, 1.0F });
+                    }
+                }
+                else if (keywordLength == 1 && pLine[0] == 'f')
+                {
+                    if (!parseFace(pValue, pLineEnd, chunk)) {
+                        chunk.success = false;
+                        return;
+                    }
+                }
+            }
+        }
+
+        static bool resolveCorner(RawCorner const& rawCorner, Chunk const& chunk, size_t positionCount, size_t texCoordCount, size_t normalCount, Corner& corner)
+        {
+            auto const resolve = [](int32_t index, bool relative, size_t base, size_t count, int32_t& result)
+            {
+                if (index == MissingIndex)
+                {
+                    result = -1;
+                    return true;
+                }
+
+                int64_t const resolved = relative ? static_cast<int64_t>(base) + index : index;
+                result = static_cast<int32_t>(resolved);
+                return resolved >= 0 && resolved < static_cast<int64_t>(count);
+            };
+
+            return resolve(rawCorner.position, (rawCorner.relativeMask & 0x1) != 0, chunk.positionBase, positionCount, corner.position)
+                && resolve(rawCorner.texCoord, (rawCorner.relativeMask & 0x2) != 0, chunk.texCoordBase, texCoordCount, corner.texCoord)
+                && resolve(rawCorner.normal, (rawCorner.relativeMask & 0x4) != 0, chunk.normalBase, normalCount, corner.normal)
+                && corner.position >= 0;
+        }
+
+        /// @brief Buffers reused across a chunk's polygons, so ear clipping doesn't allocate per face.
+        struct TriangulationScratch
+        {
+            std::vector<glm::vec2> points;
+            std::vector<uint32_t> remaining;
+        };
+
+        /// @brief Ear clipping triangulation in the polygon's dominant plane, keeps the polygon winding.
+        static void triangulatePolygon(Corner const* pCorners, uint32_t cornerCount, std::vector<float> const& positions, TriangulationScratch& scratch, std::vector<Corner>& triangleCorners)
+        {
+            auto const position = [&](Corner const& corner)
+            {
+                return glm::vec3(positions[corner.position * 3 + 0], positions[corner.position * 3 + 1], positions[corner.position * 3 + 2]);
+            };
+
+            if (cornerCount == 3)
+            {
+                triangleCorners.insert(triangleCorners.end(), pCorners, pCorners + 3);
+                return;
+            }
+
+            // Convex quads, the bulk of quad meshes, are the fan ear clipping would produce: every corner turns the same way
+            if (cornerCount == 4)
+            {
+                glm::vec3 const p0 = position(pCorners[0]);
+                glm::vec3 const p1 = position(pCorners[1]);
+                glm::vec3 const p2 = position(pCorners[2]);
+                glm::vec3 const p3 = position(pCorners[3]);
+                glm::vec3 const turn0 = glm::cross(p1 - p0, p2 - p1);
+                glm::vec3 const turn1 = glm::cross(p2 - p1, p3 - p2);
+                glm::vec3 const turn2 = glm::cross(p3 - p2, p0 - p3);
+                glm::vec3 const turn3 = glm::cross(p0 - p3, p1 - p0);
+                if (glm::dot(turn0, turn1) > 0.0F && glm::dot(turn1, turn2) > 0.0F && glm::dot(turn2, turn3) > 0.0F && glm::dot(turn3, turn0) > 0.0F)
+                {
+                    Corner const fan[] = { pCorners[0], pCorners[1], pCorners[2], pCorners[0], pCorners[2], pCorners[3] };
+                    triangleCorners.insert(triangleCorners.end(), fan, fan + 6);
+                    return;
+                }
+            }
+
+            // Newell normal gives the projection plane & orientation
+            glm::vec3 normal(0.0F);
+            for (uint32_t cornerIdx = 0; cornerIdx < cornerCount; cornerIdx++)
+            {
+                glm::vec3 const current = position(pCorners[cornerIdx]);
+                glm::vec3 const next = position(pCorners[(cornerIdx + 1) % cornerCount]);
+                normal += glm::vec3((current.y - next.y) * (current.z + next.z), (current.z - next.z) * (current.x + next.x), (current.x - next.x) * (current.y + next.y));
+            }
+
+            glm::vec3 const absNormal = glm::abs(normal);
+            int const dropAxis = (absNormal.x >= absNormal.y && absNormal.x >= absNormal.z) ? 0 : (absNormal.y >= absNormal.z ? 1 : 2);
+            int const axisU = (dropAxis + 1) % 3;
+            int const axisV = (dropAxis + 2) % 3;
+            float const orientation = (normal[dropAxis] >= 0.0F) ? 1.0F : -1.0F;
+
+            std::vector<glm::vec2>& points = scratch.points;
+            points.resize(cornerCount);
+            for (uint32_t cornerIdx = 0; cornerIdx < cornerCount; cornerIdx++)
+            {
+                glm::vec3 const p = position(pCorners[cornerIdx]);
+                points[cornerIdx] = glm::vec2(p[axisU], p[axisV] * orientation);
+            }
+
+            auto const cross2D = [](glm::vec2 const& a, glm::vec2 const& b, glm::vec2 const& c)
+            {
+                return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            };
+
+            std::vector<uint32_t>& remaining = scratch.remaining;
+            remaining.resize(cornerCount);
+            for (uint32_t cornerIdx = 0; cornerIdx < cornerCount; cornerIdx++) {
+                remaining[cornerIdx] = cornerIdx;
+            }
+
+            size_t cursor = 1; //< convex polygons end up as a fan around the first corner
+            size_t attempts = 0;
+            while (remaining.size() > 3)
+            {
+                size_t const count = remaining.size();
+                uint32_t const prev = remaining[(cursor + count - 1) % count];
+                uint32_t const curr = remaining[cursor % count];
+                uint32_t const next = remaining[(cursor + 1) % count];
+
+                bool isEar = cross2D(points[prev], points[curr], points[next]) > 0.0F;
+                for (size_t otherIdx = 0; isEar && otherIdx < count; otherIdx++)
+                {
+                    uint32_t const other = remaining[otherIdx];
+                    if (other == prev || other == curr || other == next) {
+                        continue;
+                    }
+
+                    glm::vec2 const& point = points[other];
+                    isEar = !(cross2D(points[prev], points[curr], point) >= 0.0F
+                        && cross2D(points[curr], points[next], point) >= 0.0F
+                        && cross2D(points[next], points[prev], point) >= 0.0F);
+                }
+
+                if (isEar || attempts >= count) //< degenerate polygon, clip anyway
+                {
+                    triangleCorners.push_back(pCorners[prev]);
+                    triangleCorners.push_back(pCorners[curr]);
+                    triangleCorners.push_back(pCorners[next]);
+                    remaining.erase(remaining.begin() + static_cast<ptrdiff_t>(cursor % count));
+                    cursor = (cursor % count) % remaining.size();
+                    attempts = 0;
+                    continue;
+                }
+
+                cursor = (cursor + 1) % count;
+                attempts++;
+            }
+
+            triangleCorners.push_back(pCorners[remaining[0]]);
+            triangleCorners.push_back(pCorners[remaining[1]]);
+            triangleCorners.push_back(pCorners[remaining[2]]);
+        }
+
+        static bool triangulateChunk(Chunk& chunk, std::vector<float> const& positions, size_t texCoordCount, size_t normalCount)
+        {
+            size_t const positionCount = positions.size() / 3;
+            std::vector<Corner> polygon;
+            TriangulationScratch scratch;
+            chunk.triangleCorners.reserve(chunk.rawCorners.size());
+
+            size_t rawIdx = 0;
+            for (uint32_t const polygonSize : chunk.polygonSizes)
+            {
+                polygon.resize(polygonSize);
+                for (uint32_t cornerIdx = 0; cornerIdx < polygonSize; cornerIdx++)
+                {
+                    if (!resolveCorner(chunk.rawCorners[rawIdx++], chunk, positionCount, texCoordCount, normalCount, polygon[cornerIdx])) {
+                        return false;
+                    }
+                }
+
+                triangulatePolygon(polygon.data(), polygonSize, positions, scratch, chunk.triangleCorners);
+            }
+
+            return true;
+        }
+
+        bool parse(char const* path, MeshData& meshData, uint32_t threadCount, ParseStats* pStats)
+        {
+            MappedFile file;
+            if (!file.open(path))
+            {
+                printf("OBJ file open failed [%s]\n", path);
+                return false;
+            }
+
+            char const* const pData = static_cast<char const*>(file.data());
+            size_t const size = file.size();
+            if (threadCount == 0) {
+                threadCount = (JobSystem::current() != nullptr) ? JobSystem::current()->threadCount() : 1;
+            }
+
+            // Split at line boundaries
+            size_t const chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, size / MinChunkSize));
+            std::vector<Chunk> chunks(chunkCount);
+            char const* pChunkBegin = pData;
+            for (size_t chunkIdx = 0; chunkIdx < chunkCount; chunkIdx++)
+            {
+                char const* pChunkEnd = pData + size;
+                if (chunkIdx + 1 < chunkCount)
+                {
+                    pChunkEnd = std::max(pChunkBegin, pData + (size * (chunkIdx + 1)) / chunkCount);
+                    char const* pNewline = static_cast<char const*>(memchr(pChunkEnd, '\n', static_cast<size_t>(pData + size - pChunkEnd)));
+                    pChunkEnd = (pNewline != nullptr) ? pNewline + 1 : pData + size;
+                }
+
+                chunks[chunkIdx].pBegin = pChunkBegin;
+                chunks[chunkIdx].pEnd = pChunkEnd;
+                pChunkBegin = pChunkEnd;
+            }
+
+            JobSystem::parallelForCurrent(chunks.size(), 1, [&](size_t begin, size_t end)
+            {
+                for (size_t chunkIdx = begin; chunkIdx < end; chunkIdx++) {
+                    parseChunk(chunks[chunkIdx]);
+                }
+            });
+
+            // Merge attribute arrays, chunk bases resolve relative indices
+            size_t positionCount = 0;
+            size_t texCoordCount = 0;
+            size_t normalCount = 0;
+            for (auto& chunk : chunks)
+            {
+                if (!chunk.success)
+                {
+                    printf("OBJ parse failed [%s]\n", path);
+                    return false;
+                }
+
+                chunk.positionBase = positionCount;
+                chunk.texCoordBase = texCoordCount;
+                chunk.normalBase = normalCount;
+                positionCount += chunk.positions.size() / 3;
+                texCoordCount += chunk.texCoords.size() / 2;
+                normalCount += chunk.normals.size() / 3;
+            }
+
+            std::vector<float> positions(positionCount * 3);
+            std::vector<float> colors(positionCount * 3);
+            std::vector<float> texCoords(texCoordCount * 2);
+            std::vector<float> normals(normalCount * 3);
+            JobSystem::parallelForCurrent(chunks.size(), 1, [&](size_t begin, size_t end)
+            {
+                for (size_t chunkIdx = begin; chunkIdx < end; chunkIdx++)
+                {
+                    Chunk& chunk = chunks[chunkIdx];
+                    std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3);
+                    std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + chunk.positionBase * 3);
+                    std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase * 2);
+                    std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3);
+                    chunk.positions = {};
+                    chunk.colors = {};
+                    chunk.texCoords = {};
+                    chunk.normals = {};
+                }
+            });
+
+            JobSystem::parallelForCurrent(chunks.size(), 1, [&](size_t begin, size_t end)
+            {
+                for (size_t chunkIdx = begin; chunkIdx < end; chunkIdx++)
+                {
+                    Chunk& chunk = chunks[chunkIdx];
+                    chunk.success = triangulateChunk(chunk, positions, texCoordCount, normalCount);
+                    chunk.rawCorners = {};
+                }
+            });
+
+            size_t cornerCount = 0;
+            size_t polygonCount = 0;
+            for (auto const& chunk : chunks)
+            {
+                if (!chunk.success)
+                {
+                    printf("OBJ face index out of range [%s]\n", path);
+                    return false;
+                }
+
+                cornerCount += chunk.triangleCorners.size();
+                polygonCount += chunk.polygonSizes.size();
+            }
+
+            // Weld corners into the final vertex & index arrays, open addressing keyed on the attribute index tuple
+            size_t tableSize = 16;
+            while (tableSize < cornerCount * 2) {
+                tableSize *= 2;
+            }
+
+            struct WeldEntry
+            {
+                Corner key;
+                uint32_t vertex;
+            };
+
+            constexpr uint32_t EmptyEntry = UINT32_MAX;
+            std::vector<WeldEntry> weldTable(tableSize, WeldEntry{ Corner{ 0, 0, 0 }, EmptyEntry });
+
+            std::vector<Vertex>& vertices = meshData.vertices;
+            std::vector<uint32_t>& indices = meshData.indices;
+            vertices.clear();
+            indices.clear();
+            vertices.reserve(std::min(cornerCount, positionCount * 2));
+            indices.reserve(cornerCount);
+            for (auto const& chunk : chunks)
+            {
+                for (Corner const& corner : chunk.triangleCorners)
+                {
+                    uint64_t hash = static_cast<uint32_t>(corner.position);
+                    hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(corner.normal);
+                    hash = hash * 0x9E3779B97F4A7C15ULL + static_cast<uint32_t>(corner.texCoord);
+                    size_t slot = static_cast<size_t>(hash ^ (hash >> 29)) & (tableSize - 1);
+
+                    while (weldTable[slot].vertex != EmptyEntry
+                        && (weldTable[slot].key.position != corner.position || weldTable[slot].key.normal != corner.normal || weldTable[slot].key.texCoord != corner.texCoord))
+                    {
+                        slot = (slot + 1) & (tableSize - 1);
+                    }
+
+                    if (weldTable[slot].vertex == EmptyEntry)
+                    {
+                        size_t const positionIdx = static_cast<size_t>(corner.position) * 3;
+                        Vertex vertex{};
+                        vertex.position = glm::vec3(positions[positionIdx + 0], positions[positionIdx + 1], positions[positionIdx + 2]);
+                        vertex.color = glm::vec3(colors[positionIdx + 0], colors[positionIdx + 1], colors[positionIdx + 2]);
+                        vertex.normal = glm::vec3(0.0F);
+                        vertex.tangent = glm::vec4(0.0F); //< tangents are calculated after loading
+                        vertex.texCoord = glm::vec2(0.0F);
+
+                        if (corner.normal >= 0)
+                        {
+                            size_t const normalIdx = static_cast<size_t>(corner.normal) * 3;
+                            vertex.normal = glm::vec3(normals[normalIdx + 0], normals[normalIdx + 1], normals[normalIdx + 2]);
+                        }
+
+                        if (corner.texCoord >= 0)
+                        {
+                            size_t const texIdx = static_cast<size_t>(corner.texCoord) * 2;
+                            vertex.texCoord = glm::vec2(texCoords[texIdx + 0], texCoords[texIdx + 1]);
+                        }
+
+                        weldTable[slot] = WeldEntry{ corner, static_cast<uint32_t>(vertices.size()) };
+                        vertices.push_back(vertex);
+                    }
+
+                    indices.push_back(weldTable[slot].vertex);
+                }
+            }
+
+            if (pStats != nullptr)
+            {
+                pStats->fileSize = size;
+                pStats->polygonCount = polygonCount;
+                pStats->triangleCount = indices.size() / 3;
+                pStats->cornerCount = cornerCount;
+                pStats->chunkCount = static_cast<uint32_t>(chunkCount);
+            }
+
+            printf("Loaded OBJ mesh [%s] (%zu chunks)\n", path, chunkCount);
+            printf("Welded OBJ mesh [%s] (%zu -> %zu vertices, %.1f -> %.1f KiB)\n",
+                path,
+                cornerCount, vertices.size(),
+                static_cast<double>(cornerCount * sizeof(Vertex)) / 1024.0, static_cast<double>(vertices.size() * sizeof(Vertex)) / 1024.0
+            );
+
+            return true;
+        }
+    } // namespace ObjParser
+} // namespace Engine
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include "mesh.hpp"
+
+namespace Engine
+{
+    namespace ObjParser
+    {
+        /// @brief OBJ parse statistics.
+        struct ParseStats
+        {
+            size_t fileSize = 0;
+            size_t polygonCount = 0;
+            size_t triangleCount = 0;
+            size_t cornerCount = 0;
+            uint32_t chunkCount = 0;
+        };
+
+        /// @brief Parse a memory mapped OBJ file in parallel line aligned chunks, triangulating polygons & welding vertices
+        /// straight into the output mesh data. Tangents are not calculated. Chunks run on the calling thread's job system, if
+        /// any, & a threadCount of 0 splits one chunk per worker.
+        bool parse(char const* path, MeshData& meshData, uint32_t threadCount = 0, ParseStats* pStats = nullptr);
+    } // namespace ObjParser
+} // namespace Engine
@@ -0,0 +1,451 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+namespace Engine
+{
+    static bool isWrite(ResourceState state)
+    {
+        return (state & WriteStates) != ResourceState::Undefined;
+    }
+
+    /// @brief Whether a resource in the current state can be accessed in the needed one without a transition.
+    static bool covers(ResourceState current, ResourceState needed)
+    {
+        if (current == needed) {
+            return true;
+        }
+
+        return current != ResourceState::Undefined && current != ResourceState::Present && needed != ResourceState::Present
+            && !isWrite(current) && !isWrite(needed) && (current & needed) == needed;
+    }
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static std::string stateName(ResourceState state)
+    {
+        constexpr char const* StateNames[] = {
+            "RenderTarget", "DepthWrite", "UnorderedAccess", "CopyDest", "DepthRead",
+            "PixelShaderResource", "NonPixelShaderResource", "CopySource", "Present",
+        };
+
+        std::string name;
+        for (uint32_t bit = 0; bit < sizeof(StateNames) / sizeof(StateNames[0]); bit++)
+        {
+            if ((static_cast<uint32_t>(state) & (1U << bit)) != 0) {
+                name += (name.empty() ? "" : "|") + std::string(StateNames[bit]);
+            }
+        }
+
+        return name.empty() ? "Undefined" : name;
+    }
+
+    RenderGraph::ResourceId RenderGraph::importResource(char const* name, ResourceState initialState, ResourceState finalState)
+    {
+        Resource resource{};
+        resource.name = name;
+        resource.imported = true;
+        resource.initialState = initialState;
+        resource.finalState = finalState;
+        m_resources.push_back(std::move(resource));
+        return static_cast<ResourceId>(m_resources.size() - 1);
+    }
+
+    RenderGraph::ResourceId RenderGraph::createTransient(char const* name, uint64_t size, uint64_t alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+        Resource resource{};
+        resource.name = name;
+        resource.size = size;
+        resource.alignment = alignment;
+        m_resources.push_back(std::move(resource));
+        return static_cast<ResourceId>(m_resources.size() - 1);
+    }
+
+    RenderGraph::PassId RenderGraph::addPass(char const* name, Execute execute, bool sideEffects)
+    {
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        pass.sideEffects = sideEffects;
+        m_passes.push_back(std::move(pass));
+        return static_cast<PassId>(m_passes.size() - 1);
+    }
+
+    void RenderGraph::read(PassId pass, ResourceId resource, ResourceState state)
+    {
+        assert(!isWrite(state));
+        access(pass, resource, state);
+    }
+
+    void RenderGraph::write(PassId pass, ResourceId resource, ResourceState state)
+    {
+        assert(isWrite(state));
+        access(pass, resource, state);
+    }
+
+    void RenderGraph::access(PassId pass, ResourceId resource, ResourceState state)
+    {
+        assert(pass < m_passes.size() && resource < m_resources.size() && state != ResourceState::Undefined);
+        for (auto& access : m_passes[pass].accesses)
+        {
+            if (access.resource != resource) {
+                continue;
+            }
+
+            // Multiple reads of a resource in one pass are combined, a written resource has a single state
+            assert(covers(access.state | state, access.state) && covers(access.state | state, state) && "A pass accesses a resource in conflicting states");
+            access.state = access.state | state;
+            return;
+        }
+
+        m_passes[pass].accesses.push_back(Access{ resource, state });
+    }
+
+    void RenderGraph::compile()
+    {
+        m_finalBarriers.clear();
+        m_statistics = Statistics{};
+        for (auto& resource : m_resources)
+        {
+            resource.firstPass = InvalidId;
+            resource.lastPass = InvalidId;
+            resource.heapOffset = 0;
+            if (!resource.imported) {
+                resource.initialState = ResourceState::Undefined;
+            }
+        }
+
+        for (auto& pass : m_passes) {
+            pass.barriers.clear();
+        }
+
+        cullPasses();
+        placeTransients();
+        computeBarriers();
+
+        m_statistics.passCount = static_cast<uint32_t>(m_passes.size());
+        auto const countBarriers = [this](std::vector<Barrier> const& barriers)
+        {
+            m_statistics.barrierCount += static_cast<uint32_t>(barriers.size());
+            m_statistics.barrierBatchCount += barriers.empty() ? 0 : 1;
+            for (auto const& barrier : barriers)
+            {
+                m_statistics.splitBarrierCount += (barrier.type == BarrierType::SplitBegin) ? 1 : 0;
+                m_statistics.aliasingBarrierCount += (barrier.type == BarrierType::Aliasing) ? 1 : 0;
+            }
+        };
+
+        for (auto const& pass : m_passes)
+        {
+            m_statistics.culledPassCount += pass.culled ? 1 : 0;
+            countBarriers(pass.barriers);
+        }
+        countBarriers(m_finalBarriers);
+    }
+
+    void RenderGraph::cullPasses()
+    {
+        // Walk back from the imported resources, a pass is needed if it writes a resource a later needed pass accesses. Writes
+        // count as read-modify-write, so earlier writers of a resource a needed pass writes stay too.
+        std::vector<bool> needed(m_resources.size(), false);
+        for (ResourceId resourceId = 0; resourceId < m_resources.size(); resourceId++) {
+            needed[resourceId] = m_resources[resourceId].imported;
+        }
+
+        for (size_t passIdx = m_passes.size(); passIdx-- > 0;)
+        {
+            Pass& pass = m_passes[passIdx];
+            pass.culled = !pass.sideEffects && std::none_of(pass.accesses.begin(), pass.accesses.end(), [&needed](Access const& access)
+            {
+                return isWrite(access.state) && needed[access.resource];
+            });
+
+            if (pass.culled) {
+                continue;
+            }
+
+            for (auto const& access : pass.accesses) {
+                needed[access.resource] = true;
+            }
+        }
+    }
+
+    void RenderGraph::placeTransients()
+    {
+        for (PassId passId = 0; passId < m_passes.size(); passId++)
+        {
+            if (m_passes[passId].culled) {
+                continue;
+            }
+
+            for (auto const& access : m_passes[passId].accesses)
+            {
+                Resource& resource = m_resources[access.resource];
+                resource.firstPass = std::min(resource.firstPass, passId);
+                resource.lastPass = passId;
+            }
+        }
+
+        // Largest first, each at the lowest offset not overlapping the memory of a placed transient whose lifetime overlaps
+        std::vector<ResourceId> transients;
+        for (ResourceId resourceId = 0; resourceId < m_resources.size(); resourceId++)
+        {
+            if (!m_resources[resourceId].imported && m_resources[resourceId].firstPass != InvalidId) {
+                transients.push_back(resourceId);
+            }
+        }
+
+        std::stable_sort(transients.begin(), transients.end(), [this](ResourceId a, ResourceId b) { return m_resources[a].size > m_resources[b].size; });
+
+        std::vector<ResourceId> placed;
+        for (ResourceId resourceId : transients)
+        {
+            Resource& resource = m_resources[resourceId];
+            std::vector<ResourceId> concurrent;
+            std::vector<uint64_t> candidates = { 0 };
+            for (ResourceId placedId : placed)
+            {
+                Resource const& other = m_resources[placedId];
+                if (other.lastPass < resource.firstPass || resource.lastPass < other.firstPass) {
+                    continue;
+                }
+
+                concurrent.push_back(placedId);
+                candidates.push_back(other.heapOffset + other.size);
+            }
+
+            std::sort(candidates.begin(), candidates.end());
+            for (uint64_t candidate : candidates)
+            {
+                uint64_t const offset = alignUp(candidate, resource.alignment);
+                bool const fits = std::none_of(concurrent.begin(), concurrent.end(), [&](ResourceId otherId)
+                {
+                    Resource const& other = m_resources[otherId];
+                    return offset < other.heapOffset + other.size && other.heapOffset < offset + resource.size;
+                });
+
+                if (fits)
+                {
+                    resource.heapOffset = offset;
+                    break;
+                }
+            }
+
+            placed.push_back(resourceId);
+            m_statistics.transientCount++;
+            m_statistics.transientMemory = std::max(m_statistics.transientMemory, resource.heapOffset + resource.size);
+            m_statistics.unaliasedTransientMemory = alignUp(m_statistics.unaliasedTransientMemory, resource.alignment) + resource.size;
+        }
+    }
+
+    ResourceState RenderGraph::combinedReadState(ResourceId resource, PassId pass) const
+    {
+        ResourceState combined = ResourceState::Undefined;
+        for (PassId passId = pass; passId < m_passes.size(); passId++)
+        {
+            if (m_passes[passId].culled) {
+                continue;
+            }
+
+            for (auto const& access : m_passes[passId].accesses)
+            {
+                if (access.resource != resource) {
+                    continue;
+                }
+
+                if (isWrite(access.state) || (combined != ResourceState::Undefined && !covers(combined | access.state, access.state))) {
+                    return combined;
+                }
+
+                if (access.state == ResourceState::Present) {
+                    return ResourceState::Present;
+                }
+
+                combined = combined | access.state;
+            }
+        }
+
+        return combined;
+    }
+
+    void RenderGraph::computeBarriers()
+    {
+        std::vector<PassId> alivePasses;
+        for (PassId passId = 0; passId < m_passes.size(); passId++)
+        {
+            if (!m_passes[passId].culled) {
+                alivePasses.push_back(passId);
+            }
+        }
+
+        // Barrier batches by position in the alive passes, one past the last pass is the final batch
+        auto const batch = [&](size_t position) -> std::vector<Barrier>&
+        {
+            return (position < alivePasses.size()) ? m_passes[alivePasses[position]].barriers : m_finalBarriers;
+        };
+
+        // Transitions with at least one pass between the previous & next access are split around those passes
+        auto const transition = [&](ResourceId resource, ResourceState before, ResourceState after, int64_t fromPosition, size_t toPosition)
+        {
+            if (static_cast<int64_t>(toPosition) - fromPosition >= 2)
+            {
+                batch(static_cast<size_t>(fromPosition + 1)).push_back(Barrier{ BarrierType::SplitBegin, resource, InvalidId, before, after });
+                batch(toPosition).push_back(Barrier{ BarrierType::SplitEnd, resource, InvalidId, before, after });
+            }
+            else {
+                batch(toPosition).push_back(Barrier{ BarrierType::Transition, resource, InvalidId, before, after });
+            }
+        };
+
+        std::vector<ResourceState> states(m_resources.size(), ResourceState::Undefined);
+        std::vector<int64_t> lastPositions(m_resources.size(), -1); //< -1 is before the first pass
+        for (ResourceId resourceId = 0; resourceId < m_resources.size(); resourceId++) {
+            states[resourceId] = m_resources[resourceId].initialState;
+        }
+
+        for (size_t position = 0; position < alivePasses.size(); position++)
+        {
+            PassId const passId = alivePasses[position];
+            Pass& pass = m_passes[passId];
+
+            // Transients starting here take over memory from the transients overlapping them, used earlier in this execution or
+            // later in the previous one. With several of them the barrier names none, so it covers any placed resource.
+            for (auto const& access : pass.accesses)
+            {
+                Resource const& resource = m_resources[access.resource];
+                if (resource.imported || resource.firstPass != passId) {
+                    continue;
+                }
+
+                uint32_t aliasedCount = 0;
+                ResourceId aliasedId = InvalidId;
+                for (ResourceId otherId = 0; otherId < m_resources.size(); otherId++)
+                {
+                    Resource const& other = m_resources[otherId];
+                    if (otherId != access.resource && !other.imported && other.firstPass != InvalidId
+                        && resource.heapOffset < other.heapOffset + other.size && other.heapOffset < resource.heapOffset + resource.size)
+                    {
+                        aliasedCount++;
+                        aliasedId = otherId;
+                    }
+                }
+
+                if (aliasedCount > 0) {
+                    pass.barriers.push_back(Barrier{ BarrierType::Aliasing, access.resource, (aliasedCount == 1) ? aliasedId : InvalidId, ResourceState::Undefined, ResourceState::Undefined });
+                }
+            }
+
+            // Reads transition straight to the combined state of all reads up to the next write
+            for (auto const& access : pass.accesses)
+            {
+                ResourceState& state = states[access.resource];
+                ResourceState const target = isWrite(access.state) ? access.state : combinedReadState(access.resource, passId);
+                if (state == ResourceState::Undefined)
+                {
+                    state = target;
+                    m_resources[access.resource].initialState = target;
+                }
+                else if (!covers(state, access.state))
+                {
+                    transition(access.resource, state, target, lastPositions[access.resource], position);
+                    state = target;
+                }
+
+                lastPositions[access.resource] = static_cast<int64_t>(position);
+            }
+
+            // Transients return to their initial state right after their last use, before another transient aliases them
+            for (auto const& access : pass.accesses)
+            {
+                Resource const& resource = m_resources[access.resource];
+                if (!resource.imported && resource.lastPass == passId && states[access.resource] != resource.initialState)
+                {
+                    batch(position + 1).push_back(Barrier{ BarrierType::Transition, access.resource, InvalidId, states[access.resource], resource.initialState });
+                    states[access.resource] = resource.initialState;
+                }
+            }
+        }
+
+        for (ResourceId resourceId = 0; resourceId < m_resources.size(); resourceId++)
+        {
+            Resource const& resource = m_resources[resourceId];
+            if (resource.imported && states[resourceId] != resource.finalState) {
+                transition(resourceId, states[resourceId], resource.finalState, lastPositions[resourceId], alivePasses.size());
+            }
+        }
+    }
+
+    void RenderGraph::execute(std::function<void(std::vector<Barrier> const&)> const& recordBarriers) const
+    {
+        for (auto const& pass : m_passes)
+        {
+            if (pass.culled) {
+                continue;
+            }
+
+            if (!pass.barriers.empty()) {
+                recordBarriers(pass.barriers);
+            }
+
+            if (pass.execute) {
+                pass.execute();
+            }
+        }
+
+        if (!m_finalBarriers.empty()) {
+            recordBarriers(m_finalBarriers);
+        }
+    }
+
+    void RenderGraph::report(char const* title) const
+    {
+        constexpr double MiB = 1024.0 * 1024.0;
+        printf("%s (%u passes, %u culled, %u barriers in %u batches, %u split, %u aliasing, %.2f MiB transient memory, %.2f MiB unaliased)\n",
+            title, m_statistics.passCount, m_statistics.culledPassCount, m_statistics.barrierCount, m_statistics.barrierBatchCount,
+            m_statistics.splitBarrierCount, m_statistics.aliasingBarrierCount, m_statistics.transientMemory / MiB, m_statistics.unaliasedTransientMemory / MiB);
+
+        auto const printBarriers = [this](std::vector<Barrier> const& barriers)
+        {
+            constexpr char const* BarrierTypeNames[] = { "Transition", "Split begin", "Split end", "Aliasing" };
+            for (auto const& barrier : barriers)
+            {
+                if (barrier.type == BarrierType::Aliasing)
+                {
+                    char const* aliasedName = (barrier.aliasedResource != InvalidId) ? m_resources[barrier.aliasedResource].name.c_str() : "(any)";
+                    printf("      %-12s %s -> %s\n", BarrierTypeNames[static_cast<uint32_t>(barrier.type)], aliasedName, m_resources[barrier.resource].name.c_str());
+                }
+                else {
+                    printf("      %-12s %s %s -> %s\n", BarrierTypeNames[static_cast<uint32_t>(barrier.type)], m_resources[barrier.resource].name.c_str(), stateName(barrier.before).c_str(), stateName(barrier.after).c_str());
+                }
+            }
+        };
+
+        for (auto const& pass : m_passes)
+        {
+            printf("  Pass %s%s\n", pass.name.c_str(), pass.culled ? " (culled)" : "");
+            printBarriers(pass.barriers);
+        }
+
+        if (!m_finalBarriers.empty())
+        {
+            printf("  End\n");
+            printBarriers(m_finalBarriers);
+        }
+
+        for (auto const& resource : m_resources)
+        {
+            if (resource.imported || resource.firstPass == InvalidId) {
+                continue;
+            }
+
+            printf("  Transient %-16s %8.2f MiB @ %8.2f MiB, passes %u - %u\n", resource.name.c_str(), resource.size / MiB, resource.heapOffset / MiB, resource.firstPass, resource.lastPass);
+        }
+    }
+} // namespace Engine
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief Resource access states, mirroring the D3D12 resource states used by passes. Read states can be combined.
+    enum class ResourceState : uint32_t
+    {
+        Undefined = 0,                      //< transient before its first use
+        RenderTarget = 1 << 0,
+        DepthWrite = 1 << 1,
+        UnorderedAccess = 1 << 2,
+        CopyDest = 1 << 3,
+        DepthRead = 1 << 4,
+        PixelShaderResource = 1 << 5,
+        NonPixelShaderResource = 1 << 6,
+        CopySource = 1 << 7,
+        Present = 1 << 8,                   //< exclusive, can't be combined with other reads
+    };
+
+    constexpr ResourceState operator|(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+
+    constexpr ResourceState operator&(ResourceState a, ResourceState b) { return static_cast<ResourceState>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); }
+
+    constexpr ResourceState WriteStates = ResourceState::RenderTarget | ResourceState::DepthWrite | ResourceState::UnorderedAccess | ResourceState::CopyDest;
+
+    /// @brief Frame graph of passes declaring the resources they read & write. Compiling culls passes whose results are never
+    /// used, places transient resources with disjoint lifetimes at overlapping heap offsets & derives the barriers between
+    /// passes. Only bookkeeping lives here, the renderer translates barriers & creates the resources.
+    class RenderGraph
+    {
+    public:
+        using ResourceId = uint32_t;
+        using PassId = uint32_t;
+        using Execute = std::function<void()>;
+        static constexpr uint32_t InvalidId = UINT32_MAX;
+
+        enum class BarrierType
+        {
+            Transition,
+            SplitBegin,     //< right after the previous access, ended before the next one so other passes cover its latency
+            SplitEnd,
+            Aliasing,       //< the resource takes over heap memory from aliasedResource, InvalidId if several overlap it
+        };
+
+        struct Barrier
+        {
+            BarrierType type;
+            ResourceId resource;
+            ResourceId aliasedResource;
+            ResourceState before;
+            ResourceState after;
+        };
+
+        struct Access
+        {
+            ResourceId resource;
+            ResourceState state;
+        };
+
+        struct Statistics
+        {
+            uint32_t passCount;
+            uint32_t culledPassCount;
+            uint32_t barrierCount;          //< barrier entries, split barriers count begin & end
+            uint32_t barrierBatchCount;     //< batches recorded, one per pass with barriers & one at the end
+            uint32_t splitBarrierCount;
+            uint32_t aliasingBarrierCount;
+            uint32_t transientCount;
+            uint64_t transientMemory;       //< aliased heap size
+            uint64_t unaliasedTransientMemory;
+        };
+
+        /// @brief Resource owned outside the graph, it's in the initial state before the first pass & left in the final state.
+        ResourceId importResource(char const* name, ResourceState initialState, ResourceState finalState);
+
+        /// @brief Resource only used within the graph, its memory may alias other transients. The first pass writing it after
+        /// an aliasing barrier must initialize it, e.g. clear or discard render targets.
+        ResourceId createTransient(char const* name, uint64_t size, uint64_t alignment);
+
+        /// @brief Passes run in the order they were added. Passes with side effects are never culled.
+        PassId addPass(char const* name, Execute execute, bool sideEffects = false);
+
+        void read(PassId pass, ResourceId resource, ResourceState state);
+
+        void write(PassId pass, ResourceId resource, ResourceState state);
+
+        /// @brief Cull passes, compute transient lifetimes & heap offsets, then the barriers before each pass & at the end.
+        void compile();
+
+        /// @brief Run the compiled passes in order, each non-empty barrier batch is recorded right before its pass.
+        void execute(std::function<void(std::vector<Barrier> const&)> const& recordBarriers) const;
+
+        /// @brief Print passes with their barriers, transient placements & statistics.
+        void report(char const* title) const;
+
+        size_t passCount() const { return m_passes.size(); }
+
+        size_t resourceCount() const { return m_resources.size(); }
+
+        bool culled(PassId pass) const { return m_passes[pass].culled; }
+
+        std::vector<Access> const& passAccesses(PassId pass) const { return m_passes[pass].accesses; }
+
+        std::vector<Barrier> const& passBarriers(PassId pass) const { return m_passes[pass].barriers; }
+
+        std::vector<Barrier> const& finalBarriers() const { return m_finalBarriers; }
+
+        bool transient(ResourceId resource) const { return !m_resources[resource].imported; }
+
+        /// @brief Transients are created in the state of their first access & returned to it right after their last one.
+        ResourceState initialState(ResourceId resource) const { return m_resources[resource].initialState; }
+
+        /// @brief InvalidId for transients no remaining pass uses.
+        PassId firstPass(ResourceId resource) const { return m_resources[resource].firstPass; }
+
+        PassId lastPass(ResourceId resource) const { return m_resources[resource].lastPass; }
+
+        uint64_t heapOffset(ResourceId resource) const { return m_resources[resource].heapOffset; }
+
+        uint64_t size(ResourceId resource) const { return m_resources[resource].size; }
+
+        uint64_t transientHeapSize() const { return m_statistics.transientMemory; }
+
+        Statistics const& statistics() const { return m_statistics; }
+
+    private:
+        struct Resource
+        {
+            std::string name;
+            bool imported = false;
+            ResourceState initialState = ResourceState::Undefined;
+            ResourceState finalState = ResourceState::Undefined;
+            uint64_t size = 0;
+            uint64_t alignment = 1;
+            uint64_t heapOffset = 0;
+            PassId firstPass = InvalidId;
+            PassId lastPass = InvalidId;
+        };
+
+        struct Pass
+        {
+            std::string name;
+            Execute execute;
+            bool sideEffects = false;
+            bool culled = false;
+            std::vector<Access> accesses;
+            std::vector<Barrier> barriers;  //< recorded before the pass
+        };
+
+        void access(PassId pass, ResourceId resource, ResourceState state);
+
+        void cullPasses();
+
+        void placeTransients();
+
+        void computeBarriers();
+
+        /// @brief Read states of the resource from the given pass up to its next write, transitioned to at once.
+        ResourceState combinedReadState(ResourceId resource, PassId pass) const;
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        std::vector<Barrier> m_finalBarriers;
+        Statistics m_statistics{};
+    };
+} // namespace Engine
@@ -1,5 +1,6 @@
 #include "renderer.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 #include <SDL_syswm.h>
@@ -11,6 +12,7 @@ void Buffer::destroy()
     }
 
     handle.Reset();
+    Renderer::freeMemory(memory);
 }
 
 void Buffer::map()
@@ -34,10 +36,86 @@ void Buffer::unmap()
 void Texture::destroy()
 {
     handle.Reset();
+    Renderer::freeMemory(memory);
+}
+
+void RenderGraphResources::destroy()
+{
+    resources.clear();
+    descs.clear();
+    clearValues.clear();
+    transients.clear();
+    transientDescs.clear();
+    transientOffsets.clear();
+    transientHeap.Reset();
+    transientHeapSize = 0;
 }
 
 namespace Renderer
 {
+    constexpr char const* MemoryHeapNames[] = { "default", "upload", "readback" };
+    constexpr char const* MemoryCategoryNames[] = { "buffers", "textures", "render targets" };
+    constexpr uint32_t MemoryCategoryCount = sizeof(MemoryCategoryNames) / sizeof(MemoryCategoryNames[0]);
+
+    /// @brief Pools are ordered by heap type, then resource category.
+    static uint32_t memoryPoolIndex(D3D12_RESOURCE_DESC const& desc, D3D12_HEAP_TYPE heap)
+    {
+        uint32_t heapIdx = 0;
+        switch (heap)
+        {
+        case D3D12_HEAP_TYPE_DEFAULT: heapIdx = 0; break;
+        case D3D12_HEAP_TYPE_UPLOAD: heapIdx = 1; break;
+        case D3D12_HEAP_TYPE_READBACK: heapIdx = 2; break;
+        default: return UINT32_MAX;
+        }
+
+        uint32_t categoryIdx = 0;
+        if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER) {
+            categoryIdx = (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ? 2 : 1;
+        }
+
+        return heapIdx * MemoryCategoryCount + categoryIdx;
+    }
+
+    /// @brief Called with the memory lock held. Empty blocks release their heap unless it's the pool's last one.
+    static void releaseMemory(MemoryAllocation const& memory)
+    {
+        MemoryPool& pool = memoryPools[memory.poolIdx];
+        MemoryBlock& block = pool.blocks[memory.blockIdx];
+        block.allocator.free(memory.handle);
+        if (!block.allocator.empty()) {
+            return;
+        }
+
+        uint32_t const liveBlockCount = static_cast<uint32_t>(std::count_if(pool.blocks.begin(), pool.blocks.end(), [](MemoryBlock const& poolBlock) { return poolBlock.heap != nullptr; }));
+        if (liveBlockCount > 1) {
+            block.heap.Reset();
+        }
+    }
+
+    static D3D12_RESOURCE_STATES graphResourceState(Engine::ResourceState state)
+    {
+        uint32_t const bits = static_cast<uint32_t>(state);
+        D3D12_RESOURCE_STATES resourceState = D3D12_RESOURCE_STATE_COMMON; //< also present & undefined
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::RenderTarget)) { resourceState |= D3D12_RESOURCE_STATE_RENDER_TARGET; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::DepthWrite)) { resourceState |= D3D12_RESOURCE_STATE_DEPTH_WRITE; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::UnorderedAccess)) { resourceState |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::CopyDest)) { resourceState |= D3D12_RESOURCE_STATE_COPY_DEST; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::DepthRead)) { resourceState |= D3D12_RESOURCE_STATE_DEPTH_READ; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::PixelShaderResource)) { resourceState |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::NonPixelShaderResource)) { resourceState |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE; }
+        if (bits & static_cast<uint32_t>(Engine::ResourceState::CopySource)) { resourceState |= D3D12_RESOURCE_STATE_COPY_SOURCE; }
+        return resourceState;
+    }
+
+    static bool sameResourceDesc(D3D12_RESOURCE_DESC const& a, D3D12_RESOURCE_DESC const& b)
+    {
+        return a.Dimension == b.Dimension && a.Alignment == b.Alignment && a.Width == b.Width && a.Height == b.Height
+            && a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels && a.Format == b.Format
+            && a.SampleDesc.Count == b.SampleDesc.Count && a.SampleDesc.Quality == b.SampleDesc.Quality
+            && a.Layout == b.Layout && a.Flags == b.Flags;
+    }
+
 	bool init(SDL_Window* pWindow)
 	{
         // Create DXGI factory
@@ -226,31 +304,6 @@ namespace Renderer
             rtvHandle.Offset(1, rtvHeapIncrementSize);
         }
 
-        D3D12_CLEAR_VALUE depthStencilClearValue = CD3DX12_CLEAR_VALUE(SwapDepthStencilFormat, 1.0F, 0x00);
-        if (!createTexture(
-            depthStencilTarget,
-            D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-            SwapDepthStencilFormat,
-            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL,
-            D3D12_RESOURCE_STATE_DEPTH_WRITE,
-            D3D12_HEAP_TYPE_DEFAULT,
-            windowWidth, windowHeight, 1,
-            1, 1, 1, 0,
-            &depthStencilClearValue
-        ))
-        {
-            printf("D3D12 swap depth buffer create failed\n");
-            return false;
-        }
-
-        D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
-        dsvDesc.Format = SwapDepthStencilFormat;
-        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-        dsvDesc.Texture2D.MipSlice = 0;
-
-        CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(dsvHeap->GetCPUDescriptorHandleForHeapStart());
-        device->CreateDepthStencilView(depthStencilTarget.handle.Get(), &dsvDesc, dsvHandle);
-
         // Create synchronization primitives
         fenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
         if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)))
@@ -260,19 +313,68 @@ namespace Renderer
             return false;
         }
 
-        // Create command allocator & command list
-        if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator))))
+        // Create the upload command allocator, frame command lists are created on demand by the recorder
+        if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&uploadCommandAllocator))))
         {
-            printf("D3D12 command allocator create failed\n");
+            printf("D3D12 upload command allocator create failed\n");
             return false;
         }
 
-        if (FAILED(device->CreateCommandList(0x00, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList))))
+        Engine::CommandListBackend commandListBackend{};
+        commandListBackend.createList = [](uint32_t frameIdx, uint32_t listIdx)
+        {
+            assert(listIdx == frameCommandLists[frameIdx].size());
+            ComPtr<ID3D12CommandAllocator> allocator;
+            ComPtr<ID3D12GraphicsCommandList> list;
+            if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))
+                || FAILED(device->CreateCommandList(0x00, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(&list))))
+            {
+                printf("D3D12 command list create failed\n");
+                return false;
+            }
+
+            frameCommandAllocators[frameIdx].push_back(allocator);
+            frameCommandLists[frameIdx].push_back(list);
+            return true;
+        };
+        commandListBackend.resetList = [](uint32_t frameIdx, uint32_t listIdx)
         {
-            printf("D3D12 command list create failed\n");
+            ID3D12CommandAllocator* pAllocator = frameCommandAllocators[frameIdx][listIdx].Get();
+            return SUCCEEDED(pAllocator->Reset()) && SUCCEEDED(frameCommandLists[frameIdx][listIdx]->Reset(pAllocator, nullptr));
+        };
+        commandListBackend.closeList = [](uint32_t frameIdx, uint32_t listIdx)
+        {
+            return SUCCEEDED(frameCommandLists[frameIdx][listIdx]->Close());
+        };
+        commandListBackend.executeLists = [](uint32_t frameIdx, uint32_t listCount)
+        {
+            std::vector<ID3D12CommandList*> commandLists(listCount);
+            for (uint32_t listIdx = 0; listIdx < listCount; listIdx++) {
+                commandLists[listIdx] = frameCommandLists[frameIdx][listIdx].Get();
+            }
+
+            commandQueue->ExecuteCommandLists(listCount, commandLists.data());
+        };
+        commandRecorder.setBackend(commandListBackend);
+
+        // Create shader visible descriptor heap
+        D3D12_DESCRIPTOR_HEAP_DESC descriptorHeapDesc{};
+        descriptorHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+        descriptorHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+        descriptorHeapDesc.NumDescriptors = DescriptorHeapSize;
+        descriptorHeapDesc.NodeMask = 0x00;
+        if (FAILED(device->CreateDescriptorHeap(&descriptorHeapDesc, IID_PPV_ARGS(&descriptorHeap))))
+        {
+            printf("D3D12 descriptor heap create failed\n");
+            return false;
+        }
+
+        // Create upload ring
+        if (!createBuffer(uploadRingBuffer, UploadRingSize, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_HEAP_TYPE_UPLOAD, true))
+        {
+            printf("D3D12 upload ring create failed\n");
             return false;
         }
-        commandList->Close(); //< close on create, reset happens in render
 
         return true;
 	}
@@ -281,19 +383,30 @@ namespace Renderer
 	{
         waitForGPU();
 
+        uploadRingBuffer.destroy();
+        descriptorHeap.Reset();
         commandList.Reset();
-        commandAllocator.Reset();
+        uploadCommandAllocator.Reset();
+        for (uint32_t frameIdx = 0; frameIdx < FrameCount; frameIdx++)
+        {
+            frameCommandLists[frameIdx].clear();
+            frameCommandAllocators[frameIdx].clear();
+        }
 
         CloseHandle(fenceEvent);
         fence.Reset();
 
         dsvHeap.Reset();
         rtvHeap.Reset();
-        depthStencilTarget.destroy();
         for (UINT i = 0; i < FrameCount; i++) {
             renderTargets[i].Reset();
         }
         swapchain.Reset();
+
+        // Released last, every placed resource must be destroyed by now
+        for (auto& pool : memoryPools) {
+            pool.blocks.clear();
+        }
         
         commandQueue.Reset();
         device.Reset();
@@ -304,7 +417,6 @@ namespace Renderer
     bool resizeSwapResources(uint32_t width, uint32_t height)
     {
         // Release swap resources
-        depthStencilTarget.destroy();
         for (uint32_t frameIdx = 0; frameIdx < FrameCount; frameIdx++) {
             renderTargets[frameIdx].Reset();
         }
@@ -318,24 +430,6 @@ namespace Renderer
             return false;
         }
 
-        // Resize depth buffer
-        D3D12_CLEAR_VALUE depthStencilClearValue = CD3DX12_CLEAR_VALUE(SwapDepthStencilFormat, 1.0F, 0x00);
-        if (!createTexture(
-            depthStencilTarget,
-            D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-            SwapDepthStencilFormat,
-            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL,
-            D3D12_RESOURCE_STATE_DEPTH_WRITE,
-            D3D12_HEAP_TYPE_DEFAULT,
-            width, height, 1,
-            1, 1, 1, 0,
-            &depthStencilClearValue
-        ))
-        {
-            printf("D3D12 swap depth buffer resize failed\n");
-            return false;
-        }
-
         // Recreate swap resources
         CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(rtvHeap->GetCPUDescriptorHandleForHeapStart());
         for (uint32_t frameIdx = 0; frameIdx < FrameCount; frameIdx++)
@@ -356,14 +450,6 @@ namespace Renderer
             rtvHandle.Offset(1, rtvHeapIncrementSize);
         }
 
-        D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
-        dsvDesc.Format = SwapDepthStencilFormat;
-        dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
-        dsvDesc.Texture2D.MipSlice = 0;
-
-        CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(dsvHeap->GetCPUDescriptorHandleForHeapStart());
-        device->CreateDepthStencilView(depthStencilTarget.handle.Get(), &dsvDesc, dsvHandle);
-
         return true;
     }
 
@@ -380,8 +466,7 @@ namespace Renderer
         buffer.pData = nullptr;
 
         D3D12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
-        D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(heap);
-        if (FAILED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &bufferDesc, resourceState, nullptr, IID_PPV_ARGS(&buffer.handle)))) {
+        if (!createResource(bufferDesc, heap, resourceState, nullptr, buffer.handle, buffer.memory)) {
             return false;
         }
 
@@ -426,14 +511,154 @@ namespace Renderer
         texture.levels = levels;
 
         D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC(dimension, 0U, width, height, static_cast<uint16_t>(depthOrLayers), static_cast<uint16_t>(levels), format, samples, sampleQuality, initialLayout, flags);
-        D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(heap);
-        if (FAILED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &textureDesc, resourceState, pOptimizedClearValue, IID_PPV_ARGS(&texture.handle)))) {
+        if (!createResource(textureDesc, heap, resourceState, pOptimizedClearValue, texture.handle, texture.memory)) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool createResource(
+        D3D12_RESOURCE_DESC const& desc,
+        D3D12_HEAP_TYPE heap,
+        D3D12_RESOURCE_STATES resourceState,
+        D3D12_CLEAR_VALUE const* pOptimizedClearValue,
+        ComPtr<ID3D12Resource>& resource,
+        MemoryAllocation& memory
+    )
+    {
+        memory = MemoryAllocation{};
+
+        D3D12_RESOURCE_ALLOCATION_INFO const allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+        uint32_t const poolIdx = memoryPoolIndex(desc, heap);
+        if (poolIdx == UINT32_MAX || allocationInfo.SizeInBytes > MemoryBlockSize)
+        {
+            D3D12_HEAP_PROPERTIES heapProps = CD3DX12_HEAP_PROPERTIES(heap);
+            return SUCCEEDED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &desc, resourceState, pOptimizedClearValue, IID_PPV_ARGS(&resource)));
+        }
+
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        MemoryPool& pool = memoryPools[poolIdx];
+        Engine::TLSFAllocator::Allocation allocation{};
+        uint32_t blockIdx = 0;
+        for (; blockIdx < pool.blocks.size(); blockIdx++)
+        {
+            if (pool.blocks[blockIdx].heap == nullptr) {
+                continue;
+            }
+
+            allocation = pool.blocks[blockIdx].allocator.allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            if (allocation.handle != Engine::TLSFAllocator::InvalidHandle) {
+                break;
+            }
+        }
+
+        if (allocation.handle == Engine::TLSFAllocator::InvalidHandle)
+        {
+            // Reuse a released block's slot, live allocations keep their block index. Only render targets can be MSAA & need
+            // the 4MB alignment.
+            uint32_t const categoryIdx = poolIdx % MemoryCategoryCount;
+            D3D12_HEAP_FLAGS const heapFlags = (categoryIdx == 0) ? D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS
+                : (categoryIdx == 1) ? D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES
+                : D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+            uint64_t const heapAlignment = (categoryIdx == 2) ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+            CD3DX12_HEAP_DESC const heapDesc(MemoryBlockSize, heap, heapAlignment, heapFlags);
+
+            ComPtr<ID3D12Heap> blockHeap;
+            if (FAILED(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&blockHeap))))
+            {
+                printf("D3D12 memory block create failed\n");
+                return false;
+            }
+
+            blockIdx = static_cast<uint32_t>(std::find_if(pool.blocks.begin(), pool.blocks.end(), [](MemoryBlock const& block) { return block.heap == nullptr; }) - pool.blocks.begin());
+            if (blockIdx == pool.blocks.size()) {
+                pool.blocks.emplace_back();
+            }
+
+            pool.blocks[blockIdx].heap = blockHeap;
+            pool.blocks[blockIdx].allocator = Engine::TLSFAllocator(MemoryBlockSize);
+            allocation = pool.blocks[blockIdx].allocator.allocate(allocationInfo.SizeInBytes, allocationInfo.Alignment);
+            assert(allocation.handle != Engine::TLSFAllocator::InvalidHandle);
+        }
+
+        MemoryAllocation const placement{ poolIdx, blockIdx, allocation.handle };
+        if (FAILED(device->CreatePlacedResource(pool.blocks[blockIdx].heap.Get(), allocation.offset, &desc, resourceState, pOptimizedClearValue, IID_PPV_ARGS(&resource))))
+        {
+            releaseMemory(placement);
             return false;
         }
 
+        memory = placement;
         return true;
     }
 
+    void freeMemory(MemoryAllocation& memory)
+    {
+        if (memory.poolIdx == UINT32_MAX) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        releaseMemory(memory);
+        memory = MemoryAllocation{};
+    }
+
+    MemoryStatistics memoryStatistics()
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        MemoryStatistics statistics{};
+        uint64_t freeSize = 0;
+        uint64_t largestFreeSize = 0;
+        for (auto const& pool : memoryPools)
+        {
+            for (auto const& block : pool.blocks)
+            {
+                if (block.heap == nullptr) {
+                    continue;
+                }
+
+                Engine::TLSFAllocator::Statistics const blockStatistics = block.allocator.statistics();
+                statistics.usedSize += blockStatistics.usedSize;
+                statistics.reservedSize += block.allocator.capacity();
+                statistics.blockCount++;
+                statistics.allocationCount += blockStatistics.allocationCount;
+                statistics.defragmentationCandidates += static_cast<uint32_t>(block.allocator.defragmentationCandidates(UINT32_MAX).size());
+                freeSize += blockStatistics.freeSize;
+                largestFreeSize += blockStatistics.largestFreeBlock;
+            }
+        }
+
+        if (freeSize > 0) {
+            statistics.fragmentation = 1.0F - static_cast<float>(static_cast<double>(largestFreeSize) / static_cast<double>(freeSize));
+        }
+
+        return statistics;
+    }
+
+    void reportMemory()
+    {
+        std::lock_guard<std::mutex> lock(memoryMutex);
+        constexpr double MiB = 1024.0 * 1024.0;
+        for (uint32_t poolIdx = 0; poolIdx < MemoryPoolCount; poolIdx++)
+        {
+            for (uint32_t blockIdx = 0; blockIdx < memoryPools[poolIdx].blocks.size(); blockIdx++)
+            {
+                MemoryBlock const& block = memoryPools[poolIdx].blocks[blockIdx];
+                if (block.heap == nullptr) {
+                    continue;
+                }
+
+                Engine::TLSFAllocator::Statistics const statistics = block.allocator.statistics();
+                printf("Memory %s %s block %u: %.1f / %.1f MiB used by %u allocations, %u free ranges (largest %.1f MiB, %.0f%% fragmented), %zu defragmentation candidates\n",
+                    MemoryHeapNames[poolIdx / MemoryCategoryCount], MemoryCategoryNames[poolIdx % MemoryCategoryCount], blockIdx,
+                    statistics.usedSize / MiB, block.allocator.capacity() / MiB, statistics.allocationCount,
+                    statistics.freeBlockCount, statistics.largestFreeBlock / MiB, statistics.fragmentation * 100.0F,
+                    block.allocator.defragmentationCandidates(UINT32_MAX).size());
+            }
+        }
+    }
+
     void waitForGPU()
     {
         if (commandQueue == nullptr || fenceEvent == nullptr)
@@ -441,7 +666,7 @@ namespace Renderer
             return;
         }
 
-        uint64_t const currentValue = fenceValue;
+        uint64_t const currentValue = frameTimeline.nextSignal();
         commandQueue->Signal(fence.Get(), currentValue);
 
         if (fence->GetCompletedValue() < currentValue)
@@ -450,6 +675,255 @@ namespace Renderer
             WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
         }
 
-        fenceValue++;
+        uploadRing.retire(currentValue);
+    }
+
+    bool beginFrame()
+    {
+        // Only blocks once the GPU is a full set of frames behind
+        uint64_t const slotValue = frameTimeline.beginFrame();
+        if (fence->GetCompletedValue() < slotValue)
+        {
+            fence->SetEventOnCompletion(slotValue, fenceEvent);
+            WaitForSingleObjectEx(fenceEvent, INFINITE, FALSE);
+        }
+
+        uploadRing.retire(fence->GetCompletedValue());
+
+        transientDescriptors.beginFrame(frameTimeline.frameIndex());
+
+        // The slot's lists & allocators are reused, its previous frame completed
+        commandRecorder.beginFrame(frameTimeline.frameIndex());
+        uint32_t const listIdx = commandRecorder.acquireList();
+        if (listIdx == Engine::CommandRecorder::InvalidList) {
+            return false;
+        }
+
+        commandList = frameCommandLists[frameTimeline.frameIndex()][listIdx];
+        ID3D12DescriptorHeap* ppDescriptorHeaps[] = { descriptorHeap.Get() };
+        commandList->SetDescriptorHeaps(1, ppDescriptorHeaps);
+        return true;
+    }
+
+    bool recordParallel(
+        Engine::JobSystem& jobs,
+        uint32_t drawCount,
+        uint32_t minDrawsPerChunk,
+        std::function<void(ID3D12GraphicsCommandList* pCommandList, Engine::DrawChunk const& chunk)> const& record
+    )
+    {
+        uint32_t const frameIdx = frameTimeline.frameIndex();
+        bool const recorded = commandRecorder.recordParallel(jobs, drawCount, minDrawsPerChunk, [frameIdx, &record](uint32_t listIdx, Engine::DrawChunk const& chunk)
+        {
+            ID3D12GraphicsCommandList* pCommandList = frameCommandLists[frameIdx][listIdx].Get();
+            ID3D12DescriptorHeap* ppDescriptorHeaps[] = { descriptorHeap.Get() };
+            pCommandList->SetDescriptorHeaps(1, ppDescriptorHeaps);
+            record(pCommandList, chunk);
+        });
+
+        // Commands recorded after the chunks go to a list submitted after them
+        uint32_t const listIdx = recorded ? commandRecorder.acquireList() : Engine::CommandRecorder::InvalidList;
+        if (listIdx == Engine::CommandRecorder::InvalidList)
+        {
+            printf("D3D12 parallel command list recording failed\n");
+            return false;
+        }
+
+        commandList = frameCommandLists[frameIdx][listIdx];
+        ID3D12DescriptorHeap* ppDescriptorHeaps[] = { descriptorHeap.Get() };
+        commandList->SetDescriptorHeaps(1, ppDescriptorHeaps);
+        return true;
+    }
+
+    bool submitFrame()
+    {
+        return commandRecorder.submit();
+    }
+
+    Engine::RenderGraph::ResourceId importGraphResource(
+        Engine::RenderGraph& graph,
+        RenderGraphResources& resources,
+        char const* name,
+        ID3D12Resource* pResource,
+        Engine::ResourceState initialState,
+        Engine::ResourceState finalState
+    )
+    {
+        Engine::RenderGraph::ResourceId const id = graph.importResource(name, initialState, finalState);
+        resources.resources.resize(graph.resourceCount(), nullptr);
+        resources.descs.resize(graph.resourceCount());
+        resources.clearValues.resize(graph.resourceCount());
+        resources.resources[id] = pResource;
+        return id;
+    }
+
+    Engine::RenderGraph::ResourceId declareGraphTransient(
+        Engine::RenderGraph& graph,
+        RenderGraphResources& resources,
+        char const* name,
+        D3D12_RESOURCE_DESC const& desc,
+        D3D12_CLEAR_VALUE const& clearValue
+    )
+    {
+        assert(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL));
+
+        D3D12_RESOURCE_ALLOCATION_INFO const allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+        Engine::RenderGraph::ResourceId const id = graph.createTransient(name, allocationInfo.SizeInBytes, allocationInfo.Alignment);
+        resources.resources.resize(graph.resourceCount(), nullptr);
+        resources.descs.resize(graph.resourceCount());
+        resources.clearValues.resize(graph.resourceCount());
+        resources.descs[id] = desc;
+        resources.clearValues[id] = clearValue;
+        return id;
+    }
+
+    bool realizeGraphTransients(Engine::RenderGraph const& graph, RenderGraphResources& resources, bool& recreated)
+    {
+        // Transients no remaining pass uses aren't created, their offset is kept at UINT64_MAX
+        size_t const resourceCount = graph.resourceCount();
+        bool changed = resources.transients.size() != resourceCount || resources.transientHeapSize < graph.transientHeapSize();
+        for (Engine::RenderGraph::ResourceId id = 0; id < resourceCount && !changed; id++)
+        {
+            bool const used = graph.transient(id) && graph.firstPass(id) != Engine::RenderGraph::InvalidId;
+            uint64_t const offset = used ? graph.heapOffset(id) : UINT64_MAX;
+            changed = offset != resources.transientOffsets[id] || (used && !sameResourceDesc(resources.descs[id], resources.transientDescs[id]));
+        }
+
+        recreated = changed;
+        if (changed)
+        {
+            // Placements move, the previous transients may still be used by frames in flight
+            waitForGPU();
+            resources.transients.assign(resourceCount, nullptr);
+            resources.transientDescs.assign(resourceCount, D3D12_RESOURCE_DESC{});
+            resources.transientOffsets.assign(resourceCount, UINT64_MAX);
+            if (resources.transientHeapSize < graph.transientHeapSize())
+            {
+                resources.transientHeap.Reset();
+                resources.transientHeapSize = 0;
+
+                CD3DX12_HEAP_DESC const heapDesc(graph.transientHeapSize(), D3D12_HEAP_TYPE_DEFAULT, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+                if (FAILED(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&resources.transientHeap))))
+                {
+                    printf("D3D12 render graph transient heap create failed\n");
+                    return false;
+                }
+
+                resources.transientHeapSize = graph.transientHeapSize();
+            }
+
+            for (Engine::RenderGraph::ResourceId id = 0; id < resourceCount; id++)
+            {
+                if (!graph.transient(id) || graph.firstPass(id) == Engine::RenderGraph::InvalidId) {
+                    continue;
+                }
+
+                if (FAILED(device->CreatePlacedResource(resources.transientHeap.Get(), graph.heapOffset(id), &resources.descs[id], graphResourceState(graph.initialState(id)), &resources.clearValues[id], IID_PPV_ARGS(&resources.transients[id]))))
+                {
+                    printf("D3D12 render graph transient create failed\n");
+                    resources.transients.clear();
+                    return false;
+                }
+
+                resources.transientDescs[id] = resources.descs[id];
+                resources.transientOffsets[id] = graph.heapOffset(id);
+            }
+        }
+
+        for (Engine::RenderGraph::ResourceId id = 0; id < resourceCount; id++)
+        {
+            if (graph.transient(id)) {
+                resources.resources[id] = resources.transients[id].Get();
+            }
+        }
+
+        return true;
+    }
+
+    void executeGraph(Engine::RenderGraph const& graph, RenderGraphResources const& resources)
+    {
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        graph.execute([&](std::vector<Engine::RenderGraph::Barrier> const& graphBarriers) {
+            barriers.clear();
+            for (auto const& barrier : graphBarriers)
+            {
+                ID3D12Resource* pResource = resources.resources[barrier.resource];
+                if (barrier.type == Engine::RenderGraph::BarrierType::Aliasing)
+                {
+                    ID3D12Resource* pAliased = (barrier.aliasedResource != Engine::RenderGraph::InvalidId) ? resources.resources[barrier.aliasedResource] : nullptr;
+                    barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(pAliased, pResource));
+                    continue;
+                }
+
+                D3D12_RESOURCE_BARRIER_FLAGS const flags = (barrier.type == Engine::RenderGraph::BarrierType::SplitBegin) ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY
+                    : (barrier.type == Engine::RenderGraph::BarrierType::SplitEnd) ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY
+                    : D3D12_RESOURCE_BARRIER_FLAG_NONE;
+                barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(pResource, graphResourceState(barrier.before), graphResourceState(barrier.after), D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, flags));
+            }
+
+            commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+        });
+    }
+
+    void endFrame()
+    {
+        uint64_t const frameValue = frameTimeline.endFrame();
+        uploadRing.submit(frameValue); //< covers allocations copied by the frame's command list
+        commandQueue->Signal(fence.Get(), frameValue);
+    }
+
+    uint32_t allocateDescriptors(uint32_t count)
+    {
+        uint32_t const index = staticDescriptors.allocate(count);
+        if (index == Engine::DescriptorFreeList::InvalidIndex) {
+            printf("D3D12 static descriptors exhausted (%u requested, %u free)\n", count, staticDescriptors.freeCount());
+        }
+
+        return index;
+    }
+
+    void freeDescriptors(uint32_t index, uint32_t count)
+    {
+        staticDescriptors.free(index, count);
+    }
+
+    uint32_t allocateTransientDescriptors(uint32_t count)
+    {
+        uint32_t const index = transientDescriptors.allocate(count);
+        if (index == Engine::DescriptorFrameAllocator::InvalidIndex) {
+            printf("D3D12 transient descriptors exhausted (%u requested, %u per frame)\n", count, transientDescriptors.frameCapacity());
+        }
+
+        return index;
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor(uint32_t index)
+    {
+        return CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptorHeap->GetCPUDescriptorHandleForHeapStart(), static_cast<INT>(index), cbvsrvHeapIncrementSize);
+    }
+
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptor(uint32_t index)
+    {
+        return CD3DX12_GPU_DESCRIPTOR_HANDLE(descriptorHeap->GetGPUDescriptorHandleForHeapStart(), static_cast<INT>(index), cbvsrvHeapIncrementSize);
+    }
+
+    bool allocateUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+    {
+        uploadRing.retire(fence->GetCompletedValue());
+
+        uint64_t const offset = uploadRing.allocate(size, alignment);
+        if (offset == Engine::RingAllocator::InvalidOffset) {
+            return false;
+        }
+
+        allocation.pResource = uploadRingBuffer.handle.Get();
+        allocation.offset = offset;
+        allocation.pData = static_cast<uint8_t*>(uploadRingBuffer.pData) + offset;
+        return true;
+    }
+
+    void fenceUploads()
+    {
+        uploadRing.submit(frameTimeline.lastSignaledValue() + 1); //< next value signaled, after the executed copies
     }
 }
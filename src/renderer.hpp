@@ -6,8 +6,27 @@
 #include <directx/d3dx12.h>
 #include <SDL.h>
 
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "command_recorder.hpp"
+#include "descriptor_allocator.hpp"
+#include "frame_timeline.hpp"
+#include "render_graph.hpp"
+#include "ring_allocator.hpp"
+#include "tlsf_allocator.hpp"
+
 using Microsoft::WRL::ComPtr;
 
+/// @brief Placement of a resource within a renderer memory block, committed resources have no pool.
+struct MemoryAllocation
+{
+    uint32_t poolIdx = UINT32_MAX;
+    uint32_t blockIdx = 0;
+    Engine::TLSFAllocator::Handle handle = Engine::TLSFAllocator::InvalidHandle;
+};
+
 struct Buffer
 {
     void destroy();
@@ -17,6 +36,7 @@ struct Buffer
     void unmap();
 
     ComPtr<ID3D12Resource> handle;
+    MemoryAllocation memory;
     size_t size;
     bool mapped;
     void* pData;
@@ -27,6 +47,7 @@ struct Texture
     void destroy();
 
     ComPtr<ID3D12Resource> handle;
+    MemoryAllocation memory;
     DXGI_FORMAT format;
     uint32_t width;
     uint32_t height;
@@ -34,13 +55,67 @@ struct Texture
     uint32_t levels;
 };
 
+/// @brief Upload ring sub-allocation, written by the CPU until the command list copying from it was executed.
+struct UploadAllocation
+{
+    ID3D12Resource* pResource;
+    uint64_t offset;
+    void* pData;
+};
+
+/// @brief D3D12 resources of a render graph by resource id. Transients are placed in one heap at their graph offsets & only
+/// recreated when their descriptions or placements change.
+struct RenderGraphResources
+{
+    void destroy();
+
+    std::vector<ID3D12Resource*> resources;
+    std::vector<D3D12_RESOURCE_DESC> descs;             //< transient descriptions declared this frame
+    std::vector<D3D12_CLEAR_VALUE> clearValues;
+    std::vector<ComPtr<ID3D12Resource>> transients;
+    std::vector<D3D12_RESOURCE_DESC> transientDescs;    //< descriptions the transients were created with
+    std::vector<uint64_t> transientOffsets;
+    ComPtr<ID3D12Heap> transientHeap;
+    uint64_t transientHeapSize;
+};
+
 namespace Renderer
 {
+    /// @brief Heap sub-allocated by placed resources, the heap is released once the block is empty.
+    struct MemoryBlock
+    {
+        ComPtr<ID3D12Heap> heap;
+        Engine::TLSFAllocator allocator{ 0 };
+    };
+
+    /// @brief Memory blocks for one heap type & resource category. Categories get separate heaps so resource heap tier 1
+    /// devices are supported.
+    struct MemoryPool
+    {
+        std::vector<MemoryBlock> blocks;
+    };
+
+    /// @brief Totals over all memory blocks, committed resources aren't included.
+    struct MemoryStatistics
+    {
+        uint64_t usedSize;
+        uint64_t reservedSize;
+        uint32_t blockCount;
+        uint32_t allocationCount;
+        uint32_t defragmentationCandidates;
+        float fragmentation; //< share of free space outside each block's largest free range
+    };
+
     constexpr D3D_FEATURE_LEVEL MinFeatureLevel = D3D_FEATURE_LEVEL_11_0;
     constexpr DXGI_FORMAT SwapColorFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
     constexpr DXGI_FORMAT SwapColorSRGBFormat = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
     constexpr DXGI_FORMAT SwapDepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    constexpr uint32_t FrameCount = 3;
+    constexpr uint32_t FrameCount = 3; //< swap buffers & frames in flight
+    constexpr uint64_t UploadRingSize = 32 * 1024 * 1024;
+    constexpr uint32_t DescriptorHeapSize = 4096;
+    constexpr uint32_t StaticDescriptorCount = 1024; //< the rest is split between frame slots for transient descriptors
+    constexpr uint64_t MemoryBlockSize = 64 * 1024 * 1024; //< larger resources are committed
+    constexpr uint32_t MemoryPoolCount = 9; //< default, upload & readback heaps for buffers, textures & render target textures
 
     inline ComPtr<IDXGIFactory6> dxgiFactory = nullptr;
 
@@ -54,16 +129,28 @@ namespace Renderer
     inline BOOL tearingSupport = FALSE;
     inline ComPtr<IDXGISwapChain4> swapchain = nullptr;
     inline ComPtr<ID3D12Resource> renderTargets[FrameCount]{};
-    inline Texture depthStencilTarget{};
     inline ComPtr<ID3D12DescriptorHeap> rtvHeap = nullptr; //< for swap rtvs
-    inline ComPtr<ID3D12DescriptorHeap> dsvHeap = nullptr; //< for swap dsv(s)
+    inline ComPtr<ID3D12DescriptorHeap> dsvHeap = nullptr; //< for the frame graph's depth dsv
 
     inline ComPtr<ID3D12Fence> fence = nullptr;
     inline HANDLE fenceEvent = nullptr;
-    inline uint64_t fenceValue = 0;
+    inline Engine::FrameTimeline frameTimeline{ FrameCount };
+
+    inline ComPtr<ID3D12CommandAllocator> uploadCommandAllocator = nullptr; //< for uploads outside of the frame loop
+    inline std::vector<ComPtr<ID3D12CommandAllocator>> frameCommandAllocators[FrameCount]{}; //< one per list, reset with the frame slot
+    inline std::vector<ComPtr<ID3D12GraphicsCommandList>> frameCommandLists[FrameCount]{};
+    inline Engine::CommandRecorder commandRecorder{ FrameCount };
+    inline ComPtr<ID3D12GraphicsCommandList> commandList = nullptr; //< the frame's list recorded on the main thread
 
-    inline ComPtr<ID3D12CommandAllocator> commandAllocator = nullptr;
-    inline ComPtr<ID3D12GraphicsCommandList> commandList = nullptr;
+    inline ComPtr<ID3D12DescriptorHeap> descriptorHeap = nullptr; //< shader visible CBV/SRV/UAV heap, bound once per frame
+    inline Engine::DescriptorFreeList staticDescriptors{ 0, StaticDescriptorCount };
+    inline Engine::DescriptorFrameAllocator transientDescriptors{ StaticDescriptorCount, DescriptorHeapSize - StaticDescriptorCount, FrameCount };
+
+    inline MemoryPool memoryPools[MemoryPoolCount]{};
+    inline std::mutex memoryMutex; //< resources are created concurrently at startup
+
+    inline Buffer uploadRingBuffer{}; //< persistently mapped, sub-allocated by the upload ring
+    inline Engine::RingAllocator uploadRing{ UploadRingSize };
 
     bool init(SDL_Window* pWindow);
 
@@ -97,5 +184,91 @@ namespace Renderer
         D3D12_TEXTURE_LAYOUT initialLayout = D3D12_TEXTURE_LAYOUT_UNKNOWN
     );
 
+    /// @brief Move to the next frame slot, wait until its previous frame completed, open the frame's first command list &
+    /// bind the descriptor heap.
+    bool beginFrame();
+
+    /// @brief Record draws into command lists in parallel, one contiguous chunk per list, each list starting with the
+    /// descriptor heap bound. The frame continues on a new command list submitted after the chunks.
+    bool recordParallel(
+        Engine::JobSystem& jobs,
+        uint32_t drawCount,
+        uint32_t minDrawsPerChunk,
+        std::function<void(ID3D12GraphicsCommandList* pCommandList, Engine::DrawChunk const& chunk)> const& record
+    );
+
+    /// @brief Close the frame's command lists & execute them in recording order with a single submit.
+    bool submitFrame();
+
+    /// @brief Place a resource in a memory block of its heap type & category, respecting its 64KB or 4MB placement alignment.
+    /// Resources larger than a block or on custom heaps are committed. Thread safe.
+    bool createResource(
+        D3D12_RESOURCE_DESC const& desc,
+        D3D12_HEAP_TYPE heap,
+        D3D12_RESOURCE_STATES resourceState,
+        D3D12_CLEAR_VALUE const* pOptimizedClearValue,
+        ComPtr<ID3D12Resource>& resource,
+        MemoryAllocation& memory
+    );
+
+    /// @brief Release a placement once its resource was released & no frame in flight uses it. Thread safe.
+    void freeMemory(MemoryAllocation& memory);
+
+    MemoryStatistics memoryStatistics();
+
+    /// @brief Print usage, fragmentation & defragmentation hints of each memory pool.
+    void reportMemory();
+
+    /// @brief Add a resource owned outside the graph, e.g. a swap buffer.
+    Engine::RenderGraph::ResourceId importGraphResource(
+        Engine::RenderGraph& graph,
+        RenderGraphResources& resources,
+        char const* name,
+        ID3D12Resource* pResource,
+        Engine::ResourceState initialState,
+        Engine::ResourceState finalState
+    );
+
+    /// @brief Add a render target or depth stencil transient, sized & aligned by the device for placement.
+    Engine::RenderGraph::ResourceId declareGraphTransient(
+        Engine::RenderGraph& graph,
+        RenderGraphResources& resources,
+        char const* name,
+        D3D12_RESOURCE_DESC const& desc,
+        D3D12_CLEAR_VALUE const& clearValue
+    );
+
+    /// @brief Create the compiled graph's transients at their heap offsets in their initial states. Replacing transients waits
+    /// for the GPU, recreated tells whether their views must be rewritten.
+    bool realizeGraphTransients(Engine::RenderGraph const& graph, RenderGraphResources& resources, bool& recreated);
+
+    /// @brief Record the compiled graph's passes on the command list, each barrier batch as one ResourceBarrier call.
+    void executeGraph(Engine::RenderGraph const& graph, RenderGraphResources const& resources);
+
+    /// @brief Signal the fence after the frame's submit, call once its command list was executed.
+    void endFrame();
+
+    inline uint32_t frameIndex() { return frameTimeline.frameIndex(); }
+
+    /// @brief Contiguous static descriptors, valid until freed. Freeing must wait until no frame in flight references them.
+    /// Not thread safe.
+    uint32_t allocateDescriptors(uint32_t count = 1);
+
+    void freeDescriptors(uint32_t index, uint32_t count = 1);
+
+    /// @brief Contiguous descriptors valid for the current frame only.
+    uint32_t allocateTransientDescriptors(uint32_t count);
+
+    D3D12_CPU_DESCRIPTOR_HANDLE cpuDescriptor(uint32_t index);
+
+    D3D12_GPU_DESCRIPTOR_HANDLE gpuDescriptor(uint32_t index);
+
+    /// @brief Sub-allocate upload memory, reclaiming allocations whose copies completed first. Not thread safe.
+    bool allocateUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation);
+
+    /// @brief Tag the upload allocations made since the last call with the next fence signal. Call after executing the command
+    /// lists copying from them.
+    void fenceUploads();
+
     void waitForGPU();
 } // namespace Renderer
@@ -0,0 +1,68 @@
+#include "ring_allocator.hpp"
+
+#include <cassert>
+
+namespace Engine
+{
+    uint64_t RingAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+        // Restart at the front once everything was reclaimed, avoids wrapping with an empty ring
+        if (m_usedSize == 0) {
+            m_head = m_tail = 0;
+        }
+
+        if (size == 0 || size > m_capacity || (m_usedSize > 0 && m_head == m_tail)) {
+            return InvalidOffset;
+        }
+
+        uint64_t offset = (m_tail + alignment - 1) & ~(alignment - 1);
+        if (m_tail >= m_head)
+        {
+            // Free space is past the tail & before the head, skip the end of the ring if the allocation doesn't fit there
+            if (offset + size > m_capacity)
+            {
+                if (size > m_head) {
+                    return InvalidOffset;
+                }
+
+                offset = 0;
+                m_usedSize += m_capacity - m_tail;
+                m_pendingSize += m_capacity - m_tail;
+                m_tail = 0;
+            }
+        }
+        else if (offset + size > m_head) {
+            return InvalidOffset;
+        }
+
+        uint64_t const allocatedSize = (offset - m_tail) + size;
+        m_usedSize += allocatedSize;
+        m_pendingSize += allocatedSize;
+        m_tail = (offset + size == m_capacity) ? 0 : offset + size;
+        return offset;
+    }
+
+    void RingAllocator::submit(uint64_t fenceValue)
+    {
+        assert(m_submissions.empty() || m_submissions.back().fenceValue <= fenceValue);
+        if (m_pendingSize == 0) {
+            return;
+        }
+
+        m_submissions.push_back(Submission{ fenceValue, m_tail, m_pendingSize });
+        m_pendingSize = 0;
+    }
+
+    void RingAllocator::retire(uint64_t completedFenceValue)
+    {
+        while (!m_submissions.empty() && m_submissions.front().fenceValue <= completedFenceValue)
+        {
+            Submission const& submission = m_submissions.front();
+            m_head = submission.end;
+            m_usedSize -= submission.size;
+            m_submissions.pop_front();
+        }
+    }
+} // namespace Engine
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+namespace Engine
+{
+    /// @brief Offsets of sub-allocations within a fixed capacity ring, reclaimed in submission order once the fence value they
+    /// were submitted with completed. The memory itself is owned by the caller.
+    class RingAllocator
+    {
+    public:
+        static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+        explicit RingAllocator(uint64_t capacity) : m_capacity(capacity) {}
+
+        /// @brief Alignment must be a power of two. Returns InvalidOffset if the free space can't fit the allocation.
+        uint64_t allocate(uint64_t size, uint64_t alignment);
+
+        /// @brief Tag the allocations made since the last submit with the fence value signaled after the work using them.
+        /// Fence values must not decrease.
+        void submit(uint64_t fenceValue);
+
+        /// @brief Reclaim submitted allocations whose fence value completed.
+        void retire(uint64_t completedFenceValue);
+
+        uint64_t capacity() const { return m_capacity; }
+
+        uint64_t usedSize() const { return m_usedSize; } //< includes alignment padding & space skipped when wrapping
+
+        uint64_t pendingSize() const { return m_pendingSize; } //< allocated since the last submit
+
+    private:
+        struct Submission
+        {
+            uint64_t fenceValue;
+            uint64_t end;   //< ring offset past the submission's last allocation
+            uint64_t size;
+        };
+
+        uint64_t m_capacity = 0;
+        uint64_t m_head = 0;    //< oldest live offset
+        uint64_t m_tail = 0;    //< next free offset
+        uint64_t m_usedSize = 0;
+        uint64_t m_pendingSize = 0;
+        std::deque<Submission> m_submissions;
+    };
+} // namespace Engine
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "math.hpp"
+
+namespace Engine
+{
+    /// @brief Simple TRS transform.
+    struct Transform
+    {
+        glm::mat4 matrix() const
+        {
+            return glm::translate(glm::identity<glm::mat4>(), position)
+                * glm::mat4_cast(rotation)
+                * glm::scale(glm::identity<glm::mat4>(), scale);
+        }
+
+        glm::vec3 position = glm::vec3(0.0F);
+        glm::quat rotation = glm::quat(1.0F, 0.0F, 0.0F, 0.0F);
+        glm::vec3 scale = glm::vec3(1.0F);
+    };
+
+    /// @brief Half line from the origin, the direction is normalized unless stated otherwise.
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    /// @brief Virtual camera.
+    struct Camera
+    {
+        glm::mat4 matrix() const
+        {
+            return glm::perspective(glm::radians(FOVy), aspectRatio, zNear, zFar) * glm::lookAt(position, position + forward, up);
+        }
+
+        /// @brief World space ray from the near plane through a pixel, in window coordinates with the origin at the top left.
+        Ray pickingRay(glm::vec2 const& pixel, glm::vec2 const& viewportSize) const
+        {
+            glm::vec2 const ndc = glm::vec2(pixel.x / viewportSize.x * 2.0F - 1.0F, 1.0F - pixel.y / viewportSize.y * 2.0F);
+            glm::mat4 const inverseViewproject = glm::inverse(matrix());
+            glm::vec4 const nearPoint = inverseViewproject * glm::vec4(ndc.x, ndc.y, 0.0F, 1.0F);
+            glm::vec4 const farPoint = inverseViewproject * glm::vec4(ndc.x, ndc.y, 1.0F, 1.0F);
+            glm::vec3 const origin = glm::vec3(nearPoint) / nearPoint.w;
+            return Ray{ origin, glm::normalize(glm::vec3(farPoint) / farPoint.w - origin) };
+        }
+
+        // Camera transform
+        glm::vec3 position = glm::vec3(0.0F);
+        glm::vec3 forward = glm::vec3(0.0F, 0.0F, 1.0F);
+        glm::vec3 up = glm::vec3(0.0F, 1.0F, 0.0F);
+
+        // Perspective camera data
+        float FOVy = 60.0F;
+        float aspectRatio = 1.0F;
+        float zNear = 0.1F;
+        float zFar = 100.0F;
+    };
+} // namespace Engine
@@ -0,0 +1,797 @@
+#include "scene_bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace Engine
+{
+    static BoundingBox merge(BoundingBox const& a, BoundingBox const& b)
+    {
+        return BoundingBox{
+            glm::vec3(std::min(a.aabbMin.x, b.aabbMin.x), std::min(a.aabbMin.y, b.aabbMin.y), std::min(a.aabbMin.z, b.aabbMin.z)),
+            glm::vec3(std::max(a.aabbMax.x, b.aabbMax.x), std::max(a.aabbMax.y, b.aabbMax.y), std::max(a.aabbMax.z, b.aabbMax.z))
+        };
+    }
+
+    static bool encloses(BoundingBox const& outer, BoundingBox const& inner)
+    {
+        return outer.aabbMin.x <= inner.aabbMin.x && outer.aabbMin.y <= inner.aabbMin.y && outer.aabbMin.z <= inner.aabbMin.z
+            && outer.aabbMax.x >= inner.aabbMax.x && outer.aabbMax.y >= inner.aabbMax.y && outer.aabbMax.z >= inner.aabbMax.z;
+    }
+
+    static float surfaceArea(BoundingBox const& bounds)
+    {
+        // Empty boxes have negative extents
+        float const extentX = std::max(bounds.aabbMax.x - bounds.aabbMin.x, 0.0F);
+        float const extentY = std::max(bounds.aabbMax.y - bounds.aabbMin.y, 0.0F);
+        float const extentZ = std::max(bounds.aabbMax.z - bounds.aabbMin.z, 0.0F);
+        return 2.0F * (extentX * extentY + extentY * extentZ + extentZ * extentX);
+    }
+
+    /// @brief Entry distance of the ray into the box clamped to [0, maxDistance], negative if missed.
+    static float intersectBox(BoundingBox const& bounds, glm::vec3 const& origin, glm::vec3 const& inverseDirection, float maxDistance)
+    {
+        glm::vec3 const t0 = (bounds.aabbMin - origin) * inverseDirection;
+        glm::vec3 const t1 = (bounds.aabbMax - origin) * inverseDirection;
+        glm::vec3 const tNear = glm::min(t0, t1);
+        glm::vec3 const tFar = glm::max(t0, t1);
+        float const entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0F));
+        float const exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return (entry <= exit) ? entry : -1.0F;
+    }
+
+    SceneBvh::~SceneBvh()
+    {
+        assert(m_pRebuild == nullptr);
+    }
+
+    void SceneBvh::build(uint32_t const* pObjects, BoundingBox const* pBounds, size_t count)
+    {
+        if (m_pRebuild != nullptr)
+        {
+            m_pRebuild->pJobs->wait(m_pRebuild->counter);
+            m_pRebuild.reset();
+            m_changedObjects.clear();
+            m_objectChanged.clear();
+        }
+
+        m_nodes.clear();
+        m_freeNodes.clear();
+        std::fill(m_objectLeaves.begin(), m_objectLeaves.end(), InvalidIndex);
+        m_root = buildNodes(pObjects, pBounds, count, m_nodes, m_internalArea);
+        m_objectCount = static_cast<uint32_t>(count);
+        for (uint32_t nodeIdx = 0; nodeIdx < m_nodes.size(); nodeIdx++)
+        {
+            uint32_t const object = m_nodes[nodeIdx].object;
+            if (object != InvalidIndex)
+            {
+                if (object >= m_objectLeaves.size()) {
+                    m_objectLeaves.resize(object + 1, InvalidIndex);
+                }
+                assert(m_objectLeaves[object] == InvalidIndex && "objects must be unique");
+                m_objectLeaves[object] = nodeIdx;
+            }
+        }
+
+        float const rootArea = (m_root != InvalidIndex) ? surfaceArea(m_nodes[m_root].bounds) : 0.0F;
+        m_sahCost = (rootArea > 0.0F) ? static_cast<float>(m_internalArea / rootArea) : 0.0F;
+        m_builtSahCost = m_sahCost;
+        m_builtCostValid = true;
+        m_rebuildCount++;
+    }
+
+    void SceneBvh::insert(uint32_t object, BoundingBox const& bounds)
+    {
+        if (object >= m_objectLeaves.size()) {
+            m_objectLeaves.resize(object + 1, InvalidIndex);
+        }
+
+        assert(m_objectLeaves[object] == InvalidIndex && "object already inserted");
+        m_objectLeaves[object] = insertLeaf(object, bounds);
+        m_objectCount++;
+        recordChange(object);
+    }
+
+    void SceneBvh::remove(uint32_t object)
+    {
+        assert(contains(object));
+        removeLeaf(m_objectLeaves[object]);
+        m_objectLeaves[object] = InvalidIndex;
+        m_objectCount--;
+        recordChange(object);
+    }
+
+    void SceneBvh::update(uint32_t object, BoundingBox const& bounds)
+    {
+        assert(contains(object));
+        Node& leaf = m_nodes[m_objectLeaves[object]];
+        if (leaf.bounds.aabbMin == bounds.aabbMin && leaf.bounds.aabbMax == bounds.aabbMax) {
+            return;
+        }
+
+        leaf.bounds = bounds;
+        markDirty(m_objectLeaves[object]);
+        recordChange(object);
+    }
+
+    void SceneBvh::refit(JobSystem* pJobs)
+    {
+        if (m_pRebuild != nullptr && m_pRebuild->counter.done())
+        {
+            m_pRebuild->pJobs->wait(m_pRebuild->counter);
+            finishRebuild();
+        }
+
+        // Post order over the dirty nodes only, clean subtrees keep their boxes
+        m_refitNodeCount = 0;
+        if (m_root != InvalidIndex && m_nodes[m_root].dirty)
+        {
+            std::vector<std::pair<uint32_t, bool>> stack;
+            stack.emplace_back(m_root, false);
+            while (!stack.empty())
+            {
+                auto const [nodeIdx, childrenDone] = stack.back();
+                stack.pop_back();
+
+                Node& node = m_nodes[nodeIdx];
+                if (isLeaf(nodeIdx))
+                {
+                    node.dirty = false;
+                    m_refitNodeCount++;
+                }
+                else if (!childrenDone)
+                {
+                    stack.emplace_back(nodeIdx, true);
+                    for (uint32_t const childIdx : node.children)
+                    {
+                        if (m_nodes[childIdx].dirty) {
+                            stack.emplace_back(childIdx, false);
+                        }
+                    }
+                }
+                else
+                {
+                    BoundingBox const bounds = merge(m_nodes[node.children[0]].bounds, m_nodes[node.children[1]].bounds);
+                    m_internalArea += static_cast<double>(surfaceArea(bounds)) - surfaceArea(node.bounds);
+                    node.bounds = bounds;
+                    node.dirty = false;
+                    m_refitNodeCount++;
+                }
+            }
+        }
+
+        float const rootArea = (m_root != InvalidIndex) ? surfaceArea(m_nodes[m_root].bounds) : 0.0F;
+        m_sahCost = (rootArea > 0.0F) ? static_cast<float>(std::max(m_internalArea, 0.0) / rootArea) : 0.0F;
+        if (!m_builtCostValid)
+        {
+            m_builtSahCost = m_sahCost;
+            m_builtCostValid = true;
+        }
+
+        if (m_pRebuild != nullptr || m_sahCost <= m_builtSahCost * RebuildThreshold) {
+            return;
+        }
+
+        if (pJobs != nullptr && m_objectCount >= MinRebuildObjectCount) {
+            startRebuild(*pJobs);
+        }
+        else
+        {
+            std::vector<uint32_t> objects;
+            std::vector<BoundingBox> bounds;
+            objects.reserve(m_objectCount);
+            bounds.reserve(m_objectCount);
+            for (uint32_t object = 0; object < m_objectLeaves.size(); object++)
+            {
+                if (m_objectLeaves[object] != InvalidIndex)
+                {
+                    objects.push_back(object);
+                    bounds.push_back(m_nodes[m_objectLeaves[object]].bounds);
+                }
+            }
+
+            build(objects.data(), bounds.data(), objects.size());
+        }
+    }
+
+    void SceneBvh::waitRebuild()
+    {
+        if (m_pRebuild != nullptr)
+        {
+            m_pRebuild->pJobs->wait(m_pRebuild->counter);
+            finishRebuild();
+        }
+    }
+
+    uint32_t SceneBvh::queryFrustum(Frustum const& frustum, std::vector<uint32_t>& objects) const
+    {
+        if (m_root == InvalidIndex) {
+            return 0;
+        }
+
+        constexpr uint32_t AllPlanes = (1U << 6) - 1;
+        uint32_t visitedCount = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> stack; //< node & the planes it still has to be tested against
+        stack.reserve(64);
+        stack.emplace_back(m_root, AllPlanes);
+        while (!stack.empty())
+        {
+            auto [nodeIdx, planeMask] = stack.back();
+            stack.pop_back();
+            visitedCount++;
+
+            Node const& node = m_nodes[nodeIdx];
+            bool outside = false;
+            for (uint32_t planeIdx = 0; planeIdx < 6 && !outside; planeIdx++)
+            {
+                if ((planeMask & (1U << planeIdx)) == 0) {
+                    continue;
+                }
+
+                // Furthest corner along the normal decides outside, the nearest one inside
+                glm::vec4 const& plane = frustum.planes[planeIdx];
+                glm::vec3 const positiveVertex = glm::vec3(
+                    plane.x >= 0.0F ? node.bounds.aabbMax.x : node.bounds.aabbMin.x,
+                    plane.y >= 0.0F ? node.bounds.aabbMax.y : node.bounds.aabbMin.y,
+                    plane.z >= 0.0F ? node.bounds.aabbMax.z : node.bounds.aabbMin.z
+                );
+                glm::vec3 const negativeVertex = glm::vec3(
+                    plane.x >= 0.0F ? node.bounds.aabbMin.x : node.bounds.aabbMax.x,
+                    plane.y >= 0.0F ? node.bounds.aabbMin.y : node.bounds.aabbMax.y,
+                    plane.z >= 0.0F ? node.bounds.aabbMin.z : node.bounds.aabbMax.z
+                );
+
+                if (plane.x * positiveVertex.x + plane.y * positiveVertex.y + plane.z * positiveVertex.z + plane.w < 0.0F) {
+                    outside = true;
+                }
+                else if (plane.x * negativeVertex.x + plane.y * negativeVertex.y + plane.z * negativeVertex.z + plane.w >= 0.0F) {
+                    planeMask &= ~(1U << planeIdx);
+                }
+            }
+
+            if (outside) {
+                continue;
+            }
+
+            if (isLeaf(nodeIdx)) {
+                objects.push_back(node.object);
+            }
+            else
+            {
+                stack.emplace_back(node.children[1], planeMask);
+                stack.emplace_back(node.children[0], planeMask);
+            }
+        }
+
+        return visitedCount;
+    }
+
+    uint32_t SceneBvh::querySphere(glm::vec3 const& center, float radius, std::vector<uint32_t>& objects) const
+    {
+        if (m_root == InvalidIndex) {
+            return 0;
+        }
+
+        uint32_t visitedCount = 0;
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+        while (!stack.empty())
+        {
+            uint32_t const nodeIdx = stack.back();
+            stack.pop_back();
+            visitedCount++;
+
+            Node const& node = m_nodes[nodeIdx];
+            glm::vec3 const offset = center - glm::clamp(center, node.bounds.aabbMin, node.bounds.aabbMax);
+            if (glm::dot(offset, offset) > radius * radius) {
+                continue;
+            }
+
+            if (isLeaf(nodeIdx)) {
+                objects.push_back(node.object);
+            }
+            else
+            {
+                stack.push_back(node.children[1]);
+                stack.push_back(node.children[0]);
+            }
+        }
+
+        return visitedCount;
+    }
+
+    SceneBvh::RayHit SceneBvh::raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance, Intersect const& intersect) const
+    {
+        RayHit hit{};
+        hit.distance = maxDistance;
+        if (m_root == InvalidIndex) {
+            return hit;
+        }
+
+        // Zero components divide to infinities, the slabs of those axes then span everything or nothing
+        glm::vec3 const inverseDirection = glm::vec3(1.0F) / direction;
+        float const rootEntry = intersectBox(m_nodes[m_root].bounds, origin, inverseDirection, maxDistance);
+        if (rootEntry < 0.0F) {
+            return hit;
+        }
+
+        std::vector<std::pair<uint32_t, float>> stack; //< node & its entry distance
+        stack.reserve(64);
+        stack.emplace_back(m_root, rootEntry);
+        while (!stack.empty())
+        {
+            auto const [nodeIdx, entry] = stack.back();
+            stack.pop_back();
+            if (entry > hit.distance) {
+                continue;
+            }
+
+            Node const& node = m_nodes[nodeIdx];
+            if (isLeaf(nodeIdx))
+            {
+                float const distance = intersect ? intersect(node.object, hit.distance) : entry;
+                if (distance >= 0.0F && (distance < hit.distance || (distance == hit.distance && hit.object == InvalidIndex)))
+                {
+                    hit.object = node.object;
+                    hit.distance = distance;
+                }
+                continue;
+            }
+
+            // Nearer child on top of the stack so it can shorten the ray before the further one is visited
+            float const entry0 = intersectBox(m_nodes[node.children[0]].bounds, origin, inverseDirection, hit.distance);
+            float const entry1 = intersectBox(m_nodes[node.children[1]].bounds, origin, inverseDirection, hit.distance);
+            bool const swap = entry1 >= 0.0F && (entry0 < 0.0F || entry1 < entry0);
+            uint32_t const nearIdx = swap ? node.children[1] : node.children[0];
+            uint32_t const farIdx = swap ? node.children[0] : node.children[1];
+            float const nearEntry = swap ? entry1 : entry0;
+            float const farEntry = swap ? entry0 : entry1;
+            if (farEntry >= 0.0F) {
+                stack.emplace_back(farIdx, farEntry);
+            }
+            if (nearEntry >= 0.0F) {
+                stack.emplace_back(nearIdx, nearEntry);
+            }
+        }
+
+        return hit;
+    }
+
+    SceneBvh::Statistics SceneBvh::statistics() const
+    {
+        Statistics statistics{};
+        statistics.objectCount = m_objectCount;
+        statistics.nodeCount = static_cast<uint32_t>(m_nodes.size() - m_freeNodes.size());
+        statistics.refitNodeCount = m_refitNodeCount;
+        statistics.rebuildCount = m_rebuildCount;
+        statistics.sahCost = m_sahCost;
+        statistics.builtSahCost = m_builtSahCost;
+        statistics.rebuildPending = m_pRebuild != nullptr;
+        return statistics;
+    }
+
+    bool SceneBvh::validate() const
+    {
+        if (m_root == InvalidIndex) {
+            return m_objectCount == 0;
+        }
+
+        if (m_nodes[m_root].parent != InvalidIndex) {
+            return false;
+        }
+
+        uint32_t leafCount = 0;
+        uint32_t nodeCount = 0;
+        std::vector<uint32_t> stack{ m_root };
+        while (!stack.empty())
+        {
+            uint32_t const nodeIdx = stack.back();
+            stack.pop_back();
+            nodeCount++;
+
+            Node const& node = m_nodes[nodeIdx];
+            if (node.dirty) {
+                return false;
+            }
+
+            if (isLeaf(nodeIdx))
+            {
+                if (node.object >= m_objectLeaves.size() || m_objectLeaves[node.object] != nodeIdx) {
+                    return false;
+                }
+                leafCount++;
+                continue;
+            }
+
+            for (uint32_t const childIdx : node.children)
+            {
+                if (m_nodes[childIdx].parent != nodeIdx || !encloses(node.bounds, m_nodes[childIdx].bounds)) {
+                    return false;
+                }
+                stack.push_back(childIdx);
+            }
+        }
+
+        return leafCount == m_objectCount && nodeCount == m_nodes.size() - m_freeNodes.size();
+    }
+
+    uint32_t SceneBvh::allocateNode()
+    {
+        if (m_freeNodes.empty())
+        {
+            m_nodes.emplace_back();
+            return static_cast<uint32_t>(m_nodes.size() - 1);
+        }
+
+        uint32_t const nodeIdx = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return nodeIdx;
+    }
+
+    void SceneBvh::freeNode(uint32_t nodeIdx)
+    {
+        m_nodes[nodeIdx].parent = InvalidIndex;
+        m_freeNodes.push_back(nodeIdx);
+    }
+
+    void SceneBvh::markDirty(uint32_t nodeIdx)
+    {
+        while (nodeIdx != InvalidIndex && !m_nodes[nodeIdx].dirty)
+        {
+            m_nodes[nodeIdx].dirty = true;
+            nodeIdx = m_nodes[nodeIdx].parent;
+        }
+    }
+
+    void SceneBvh::recordChange(uint32_t object)
+    {
+        if (m_pRebuild == nullptr) {
+            return;
+        }
+
+        if (object >= m_objectChanged.size()) {
+            m_objectChanged.resize(object + 1, false);
+        }
+
+        if (!m_objectChanged[object])
+        {
+            m_objectChanged[object] = true;
+            m_changedObjects.push_back(object);
+        }
+    }
+
+    uint32_t SceneBvh::insertLeaf(uint32_t object, BoundingBox const& bounds)
+    {
+        uint32_t const leafIdx = allocateNode();
+        m_nodes[leafIdx] = Node{ bounds, InvalidIndex, { InvalidIndex, InvalidIndex }, object, true };
+        if (m_root == InvalidIndex)
+        {
+            m_root = leafIdx;
+            return leafIdx;
+        }
+
+        // Descend towards the child whose area grows the least, stop once a new parent here is cheaper than going deeper
+        uint32_t siblingIdx = m_root;
+        while (!isLeaf(siblingIdx))
+        {
+            Node const& node = m_nodes[siblingIdx];
+            float const area = surfaceArea(node.bounds);
+            float const combinedArea = surfaceArea(merge(node.bounds, bounds));
+            float const cost = 2.0F * combinedArea;
+            float const inheritanceCost = 2.0F * (combinedArea - area);
+
+            float childCosts[2];
+            for (uint32_t childSlot = 0; childSlot < 2; childSlot++)
+            {
+                BoundingBox const& childBounds = m_nodes[node.children[childSlot]].bounds;
+                float const childArea = surfaceArea(merge(childBounds, bounds));
+                childCosts[childSlot] = inheritanceCost + (isLeaf(node.children[childSlot]) ? childArea : childArea - surfaceArea(childBounds));
+            }
+
+            if (cost < childCosts[0] && cost < childCosts[1]) {
+                break;
+            }
+
+            siblingIdx = node.children[(childCosts[1] < childCosts[0]) ? 1 : 0];
+        }
+
+        // The new parent takes the sibling's place, its ancestors only grow so their boxes stay conservative until the refit
+        uint32_t const oldParentIdx = m_nodes[siblingIdx].parent;
+        uint32_t const parentIdx = allocateNode();
+        BoundingBox const parentBounds = merge(m_nodes[siblingIdx].bounds, bounds);
+        m_nodes[parentIdx] = Node{ parentBounds, oldParentIdx, { siblingIdx, leafIdx }, InvalidIndex, false };
+        m_internalArea += surfaceArea(parentBounds);
+        m_nodes[siblingIdx].parent = parentIdx;
+        m_nodes[leafIdx].parent = parentIdx;
+        if (oldParentIdx == InvalidIndex) {
+            m_root = parentIdx;
+        }
+        else
+        {
+            Node& oldParent = m_nodes[oldParentIdx];
+            oldParent.children[(oldParent.children[0] == siblingIdx) ? 0 : 1] = parentIdx;
+        }
+
+        markDirty(parentIdx);
+        return leafIdx;
+    }
+
+    void SceneBvh::removeLeaf(uint32_t leafIdx)
+    {
+        uint32_t const parentIdx = m_nodes[leafIdx].parent;
+        freeNode(leafIdx);
+        if (parentIdx == InvalidIndex)
+        {
+            m_root = InvalidIndex;
+            return;
+        }
+
+        // The sibling takes the parent's place
+        Node const& parent = m_nodes[parentIdx];
+        uint32_t const siblingIdx = parent.children[(parent.children[0] == leafIdx) ? 1 : 0];
+        uint32_t const grandParentIdx = parent.parent;
+        m_internalArea -= surfaceArea(parent.bounds);
+        m_nodes[siblingIdx].parent = grandParentIdx;
+        if (grandParentIdx == InvalidIndex) {
+            m_root = siblingIdx;
+        }
+        else
+        {
+            Node& grandParent = m_nodes[grandParentIdx];
+            grandParent.children[(grandParent.children[0] == parentIdx) ? 0 : 1] = siblingIdx;
+
+            // A dirty sibling had a dirty parent & so dirty ancestors, the boxes above only shrink with the refit
+            markDirty(grandParentIdx);
+        }
+
+        freeNode(parentIdx);
+    }
+
+    void SceneBvh::startRebuild(JobSystem& jobs)
+    {
+        m_pRebuild = std::make_unique<Rebuild>();
+        m_pRebuild->pJobs = &jobs;
+        m_pRebuild->objects.reserve(m_objectCount);
+        m_pRebuild->bounds.reserve(m_objectCount);
+        for (uint32_t object = 0; object < m_objectLeaves.size(); object++)
+        {
+            if (m_objectLeaves[object] != InvalidIndex)
+            {
+                m_pRebuild->objects.push_back(object);
+                m_pRebuild->bounds.push_back(m_nodes[m_objectLeaves[object]].bounds);
+            }
+        }
+
+        // The job only touches the snapshot, the live tree keeps serving queries & changes until the swap
+        m_objectChanged.assign(m_objectLeaves.size(), false);
+        m_changedObjects.clear();
+        Rebuild* pRebuild = m_pRebuild.get();
+        jobs.run([pRebuild]()
+        {
+            pRebuild->root = buildNodes(pRebuild->objects.data(), pRebuild->bounds.data(), pRebuild->objects.size(), pRebuild->nodes, pRebuild->internalArea);
+        }, &pRebuild->counter);
+    }
+
+    void SceneBvh::finishRebuild()
+    {
+        struct Change
+        {
+            uint32_t object;
+            bool alive;
+            BoundingBox bounds;
+        };
+
+        // Changes since the snapshot are taken from the live tree before it's replaced
+        std::vector<Change> changes;
+        changes.reserve(m_changedObjects.size());
+        for (uint32_t const object : m_changedObjects)
+        {
+            bool const alive = contains(object);
+            changes.push_back(Change{ object, alive, alive ? m_nodes[m_objectLeaves[object]].bounds : BoundingBox{} });
+        }
+
+        std::unique_ptr<Rebuild> const pRebuild = std::move(m_pRebuild);
+        m_changedObjects.clear();
+        m_objectChanged.clear();
+
+        m_nodes = std::move(pRebuild->nodes);
+        m_freeNodes.clear();
+        m_root = pRebuild->root;
+        m_internalArea = pRebuild->internalArea;
+        std::fill(m_objectLeaves.begin(), m_objectLeaves.end(), InvalidIndex);
+        for (uint32_t nodeIdx = 0; nodeIdx < m_nodes.size(); nodeIdx++)
+        {
+            if (m_nodes[nodeIdx].object != InvalidIndex) {
+                m_objectLeaves[m_nodes[nodeIdx].object] = nodeIdx;
+            }
+        }
+
+        float const rootArea = (m_root != InvalidIndex) ? surfaceArea(m_nodes[m_root].bounds) : 0.0F;
+        m_builtSahCost = (rootArea > 0.0F) ? static_cast<float>(m_internalArea / rootArea) : 0.0F;
+        m_builtCostValid = true;
+        m_rebuildCount++;
+
+        for (Change const& change : changes)
+        {
+            uint32_t const leafIdx = m_objectLeaves[change.object];
+            if (change.alive && leafIdx != InvalidIndex)
+            {
+                m_nodes[leafIdx].bounds = change.bounds;
+                markDirty(leafIdx);
+            }
+            else if (change.alive) {
+                m_objectLeaves[change.object] = insertLeaf(change.object, change.bounds);
+            }
+            else if (leafIdx != InvalidIndex)
+            {
+                removeLeaf(leafIdx);
+                m_objectLeaves[change.object] = InvalidIndex;
+            }
+        }
+    }
+
+    uint32_t SceneBvh::buildNodes(uint32_t const* pObjects, BoundingBox const* pBounds, size_t count, std::vector<Node>& nodes, double& internalArea)
+    {
+        constexpr uint32_t BinCount = 16;
+        constexpr size_t MedianSplitCount = 4;
+
+        struct Item
+        {
+            BoundingBox bounds;
+            glm::vec3 centroid;
+            uint32_t object;
+        };
+
+        struct Task
+        {
+            size_t begin;
+            size_t end;
+            uint32_t nodeIdx;
+        };
+
+        struct Bin
+        {
+            BoundingBox bounds;
+            uint32_t count;
+        };
+
+        nodes.clear();
+        internalArea = 0.0;
+        if (count == 0) {
+            return InvalidIndex;
+        }
+
+        // Empty boxes merge to the other operand, so bins & sweeps need no first item special case
+        BoundingBox const emptyBox{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()) };
+
+        std::vector<Item> items(count);
+        for (size_t itemIdx = 0; itemIdx < count; itemIdx++) {
+            items[itemIdx] = Item{ pBounds[itemIdx], (pBounds[itemIdx].aabbMin + pBounds[itemIdx].aabbMax) * 0.5F, pObjects[itemIdx] };
+        }
+
+        nodes.reserve(2 * count - 1);
+        nodes.push_back(Node{ emptyBox, InvalidIndex, { InvalidIndex, InvalidIndex }, InvalidIndex, false });
+        std::vector<Task> stack{ Task{ 0, count, 0 } };
+        while (!stack.empty())
+        {
+            Task const task = stack.back();
+            stack.pop_back();
+
+            if (task.end - task.begin == 1)
+            {
+                nodes[task.nodeIdx].bounds = items[task.begin].bounds;
+                nodes[task.nodeIdx].object = items[task.begin].object;
+                continue;
+            }
+
+            BoundingBox bounds = emptyBox;
+            BoundingBox centroidBounds = emptyBox;
+            for (size_t itemIdx = task.begin; itemIdx < task.end; itemIdx++)
+            {
+                bounds = merge(bounds, items[itemIdx].bounds);
+                centroidBounds = merge(centroidBounds, BoundingBox{ items[itemIdx].centroid, items[itemIdx].centroid });
+            }
+
+            nodes[task.nodeIdx].bounds = bounds;
+            internalArea += surfaceArea(bounds);
+
+            // Small ranges split at the median of the widest centroid axis, binning costs more than it finds there
+            glm::vec3 const centroidExtent = centroidBounds.aabbMax - centroidBounds.aabbMin;
+            size_t middle = task.begin + (task.end - task.begin) / 2;
+            if (task.end - task.begin <= MedianSplitCount)
+            {
+                int const axis = (centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z) ? 0 : ((centroidExtent.y >= centroidExtent.z) ? 1 : 2);
+                std::nth_element(items.begin() + task.begin, items.begin() + middle, items.begin() + task.end, [axis](Item const& a, Item const& b) { return a.centroid[axis] < b.centroid[axis]; });
+            }
+            else
+            {
+                // Bin centroids along all axes in one pass & take the split with the lowest area times count on both sides
+                glm::vec3 const binScale = glm::vec3(
+                    centroidExtent.x > 0.0F ? BinCount / centroidExtent.x : 0.0F,
+                    centroidExtent.y > 0.0F ? BinCount / centroidExtent.y : 0.0F,
+                    centroidExtent.z > 0.0F ? BinCount / centroidExtent.z : 0.0F
+                );
+                auto const binIndex = [&centroidBounds, &binScale](glm::vec3 const& centroid, int axis)
+                {
+                    return std::min(BinCount - 1, static_cast<uint32_t>((centroid[axis] - centroidBounds.aabbMin[axis]) * binScale[axis]));
+                };
+
+                Bin bins[3][BinCount];
+                for (auto& axisBins : bins) {
+                    std::fill(std::begin(axisBins), std::end(axisBins), Bin{ emptyBox, 0 });
+                }
+                for (size_t itemIdx = task.begin; itemIdx < task.end; itemIdx++)
+                {
+                    Item const& item = items[itemIdx];
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        Bin& bin = bins[axis][binIndex(item.centroid, axis)];
+                        bin.bounds = merge(bin.bounds, item.bounds);
+                        bin.count++;
+                    }
+                }
+
+                float bestCost = std::numeric_limits<float>::max();
+                int bestAxis = -1;
+                uint32_t bestSplit = 0;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (!(centroidExtent[axis] > 0.0F)) {
+                        continue;
+                    }
+
+                    // Right sides are swept first, a split at s puts bins [0, s) on the left
+                    float rightCosts[BinCount]{};
+                    BoundingBox rightBounds = emptyBox;
+                    uint32_t rightCount = 0;
+                    for (uint32_t binIdx = BinCount - 1; binIdx > 0; binIdx--)
+                    {
+                        rightBounds = merge(rightBounds, bins[axis][binIdx].bounds);
+                        rightCount += bins[axis][binIdx].count;
+                        rightCosts[binIdx] = surfaceArea(rightBounds) * static_cast<float>(rightCount);
+                    }
+
+                    BoundingBox leftBounds = emptyBox;
+                    uint32_t leftCount = 0;
+                    for (uint32_t split = 1; split < BinCount; split++)
+                    {
+                        leftBounds = merge(leftBounds, bins[axis][split - 1].bounds);
+                        leftCount += bins[axis][split - 1].count;
+                        if (leftCount == 0 || leftCount == task.end - task.begin) {
+                            continue;
+                        }
+
+                        float const cost = surfaceArea(leftBounds) * static_cast<float>(leftCount) + rightCosts[split];
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = split;
+                        }
+                    }
+                }
+
+                // Coincident centroids keep the middle split
+                if (bestAxis >= 0)
+                {
+                    auto const split = std::partition(items.begin() + task.begin, items.begin() + task.end, [&](Item const& item) { return binIndex(item.centroid, bestAxis) < bestSplit; });
+                    middle = static_cast<size_t>(split - items.begin());
+                }
+            }
+
+            uint32_t const leftIdx = static_cast<uint32_t>(nodes.size());
+            uint32_t const rightIdx = leftIdx + 1;
+            nodes.push_back(Node{ emptyBox, task.nodeIdx, { InvalidIndex, InvalidIndex }, InvalidIndex, false });
+            nodes.push_back(Node{ emptyBox, task.nodeIdx, { InvalidIndex, InvalidIndex }, InvalidIndex, false });
+            nodes[task.nodeIdx].children[0] = leftIdx;
+            nodes[task.nodeIdx].children[1] = rightIdx;
+            stack.push_back(Task{ middle, task.end, rightIdx });
+            stack.push_back(Task{ task.begin, middle, leftIdx });
+        }
+
+        return 0;
+    }
+} // namespace Engine
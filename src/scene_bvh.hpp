@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "culling.hpp"
+#include "job_system.hpp"
+#include "math.hpp"
+
+namespace Engine
+{
+    /// @brief Dynamic bounding volume hierarchy over scene objects, one object per leaf. Inserts descend by surface area cost,
+    /// updates & removals only mark the path to the root dirty & refit recomputes the dirty subtrees. Once motion degrades the
+    /// tree's SAH cost past RebuildThreshold times the cost after the last build, a binned SAH rebuild runs as a background job
+    /// on a snapshot & is swapped in with the changes made meanwhile replayed. Objects are caller chosen indices.
+    class SceneBvh
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+        static constexpr float RebuildThreshold = 1.3F;     //< SAH cost growth over the last build that starts a rebuild
+        static constexpr uint32_t MinRebuildObjectCount = 64; //< smaller trees rebuild synchronously
+
+        /// @brief Exact intersection distance of the ray with the object up to maxDistance, negative if missed.
+        using Intersect = std::function<float(uint32_t object, float maxDistance)>;
+
+        struct RayHit
+        {
+            uint32_t object = InvalidIndex;
+            float distance = 0.0F;
+        };
+
+        struct Statistics
+        {
+            uint32_t objectCount;
+            uint32_t nodeCount;
+            uint32_t refitNodeCount;    //< nodes recomputed by the last refit
+            uint32_t rebuildCount;      //< SAH builds swapped in since construction
+            float sahCost;              //< sum of internal node areas relative to the root's, valid after a refit
+            float builtSahCost;         //< cost right after the last build
+            bool rebuildPending;
+        };
+
+        SceneBvh() = default;
+
+        /// @brief A pending background rebuild must have been waited for.
+        ~SceneBvh();
+
+        SceneBvh(SceneBvh const&) = delete;
+        SceneBvh& operator=(SceneBvh const&) = delete;
+
+        /// @brief Replace every object with a binned SAH build of the given ones, a pending rebuild is waited for & discarded.
+        void build(uint32_t const* pObjects, BoundingBox const* pBounds, size_t count);
+
+        void insert(uint32_t object, BoundingBox const& bounds);
+
+        void remove(uint32_t object);
+
+        /// @brief Set the object's bounds, unchanged bounds don't dirty the tree.
+        void update(uint32_t object, BoundingBox const& bounds);
+
+        bool contains(uint32_t object) const { return object < m_objectLeaves.size() && m_objectLeaves[object] != InvalidIndex; }
+
+        /// @brief Recompute the dirty subtrees, queries see changes only after a refit. Swaps in a finished rebuild, then starts
+        /// a background rebuild on the job system if the tree degraded, without one it rebuilds in place.
+        void refit(JobSystem* pJobs = nullptr);
+
+        /// @brief Wait for a background rebuild & swap it in, required before the job system is destroyed. Like refit it must
+        /// run on one of the job system's workers.
+        void waitRebuild();
+
+        /// @brief Append the objects whose box intersects the frustum & return the number of nodes visited. Planes a node lies
+        /// entirely inside of are skipped for its subtree & subtrees inside all planes are appended without tests.
+        uint32_t queryFrustum(Frustum const& frustum, std::vector<uint32_t>& objects) const;
+
+        /// @brief Append the objects whose box overlaps the sphere & return the number of nodes visited.
+        uint32_t querySphere(glm::vec3 const& center, float radius, std::vector<uint32_t>& objects) const;
+
+        /// @brief Closest object hit along the normalized direction within maxDistance, nearer subtrees first. Without an
+        /// intersect function the object boxes are hit.
+        RayHit raycast(glm::vec3 const& origin, glm::vec3 const& direction, float maxDistance, Intersect const& intersect = nullptr) const;
+
+        Statistics statistics() const;
+
+        /// @brief Check parent links, the object to leaf mapping & that every box holds its children, for tests after a refit.
+        bool validate() const;
+
+    private:
+        struct Node
+        {
+            BoundingBox bounds;
+            uint32_t parent;
+            uint32_t children[2];   //< InvalidIndex for leaves
+            uint32_t object;        //< InvalidIndex for internal nodes
+            bool dirty;
+        };
+
+        /// @brief Snapshot of the leaves & the tree built from it by a background job.
+        struct Rebuild
+        {
+            std::vector<uint32_t> objects;
+            std::vector<BoundingBox> bounds;
+            std::vector<Node> nodes;
+            uint32_t root = InvalidIndex;
+            double internalArea = 0.0;
+            JobSystem* pJobs = nullptr;
+            JobSystem::Counter counter;
+        };
+
+        bool isLeaf(uint32_t nodeIdx) const { return m_nodes[nodeIdx].children[0] == InvalidIndex; }
+
+        uint32_t allocateNode();
+
+        void freeNode(uint32_t nodeIdx);
+
+        /// @brief Mark the node & its ancestors dirty, stops at the first dirty one since its ancestors already are.
+        void markDirty(uint32_t nodeIdx);
+
+        /// @brief Remember objects changed while a rebuild is pending so they are replayed onto the rebuilt tree.
+        void recordChange(uint32_t object);
+
+        uint32_t insertLeaf(uint32_t object, BoundingBox const& bounds);
+
+        void removeLeaf(uint32_t leafIdx);
+
+        void startRebuild(JobSystem& jobs);
+
+        void finishRebuild();
+
+        /// @brief Binned SAH build into nodes, returns the root.
+        static uint32_t buildNodes(uint32_t const* pObjects, BoundingBox const* pBounds, size_t count, std::vector<Node>& nodes, double& internalArea);
+
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_freeNodes;
+        std::vector<uint32_t> m_objectLeaves;   //< leaf of each object, InvalidIndex if absent
+        uint32_t m_root = InvalidIndex;
+        uint32_t m_objectCount = 0;
+
+        double m_internalArea = 0.0;            //< kept up to date by inserts, removals & refits
+        float m_sahCost = 0.0F;
+        float m_builtSahCost = 0.0F;
+        bool m_builtCostValid = false;          //< set by the first refit after a build
+        uint32_t m_refitNodeCount = 0;
+        uint32_t m_rebuildCount = 0;
+
+        std::unique_ptr<Rebuild> m_pRebuild;
+        std::vector<uint32_t> m_changedObjects;
+        std::vector<bool> m_objectChanged;
+    };
+} // namespace Engine
@@ -0,0 +1,231 @@
+#include "shader_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+namespace Engine
+{
+    namespace ShaderCache
+    {
+        static bool readFile(char const* path, std::string& contents)
+        {
+            FILE* pFile = fopen(path, "rb");
+            if (pFile == nullptr) {
+                return false;
+            }
+
+            contents.clear();
+            char buffer[4096];
+            size_t readSize = 0;
+            while ((readSize = fread(buffer, 1, sizeof(buffer), pFile)) > 0) {
+                contents.append(buffer, readSize);
+            }
+
+            bool const success = ferror(pFile) == 0;
+            fclose(pFile);
+            return success;
+        }
+
+        /// @brief Names of the #include "name" & #include <name> directives, in order.
+        static void parseIncludes(std::string const& source, std::vector<std::string>& includes)
+        {
+            size_t lineStart = 0;
+            while (lineStart < source.size())
+            {
+                size_t lineEnd = source.find('\n', lineStart);
+                lineEnd = (lineEnd == std::string::npos) ? source.size() : lineEnd;
+
+                size_t position = source.find_first_not_of(" \t", lineStart);
+                if (position < lineEnd && source[position] == '#')
+                {
+                    position = source.find_first_not_of(" \t", position + 1);
+                    if (position < lineEnd && source.compare(position, 7, "include") == 0)
+                    {
+                        position = source.find_first_not_of(" \t", position + 7);
+                        if (position < lineEnd && (source[position] == '"' || source[position] == '<'))
+                        {
+                            char const closing = (source[position] == '"') ? '"' : '>';
+                            size_t const nameEnd = source.find(closing, position + 1);
+                            if (nameEnd < lineEnd) {
+                                includes.push_back(source.substr(position + 1, nameEnd - position - 1));
+                            }
+                        }
+                    }
+                }
+
+                lineStart = lineEnd + 1;
+            }
+        }
+
+        /// @brief Append the includes of the listed file that aren't listed yet, each followed by its own includes.
+        static void appendIncludes(std::string const& path, std::vector<std::string>& files)
+        {
+            std::string contents;
+            if (!readFile(path.c_str(), contents)) {
+                return;
+            }
+
+            std::vector<std::string> includes;
+            parseIncludes(contents, includes);
+            std::filesystem::path const directory = std::filesystem::path(path).parent_path();
+            for (std::string const& include : includes)
+            {
+                std::string const includePath = (directory / include).lexically_normal().generic_string();
+                if (std::find(files.begin(), files.end(), includePath) == files.end())
+                {
+                    files.push_back(includePath);
+                    appendIncludes(includePath, files);
+                }
+            }
+        }
+
+        bool collectIncludes(char const* sourcePath, std::vector<std::string>& files)
+        {
+            files.clear();
+            std::string contents;
+            if (!readFile(sourcePath, contents)) {
+                return false;
+            }
+
+            files.push_back(std::filesystem::path(sourcePath).lexically_normal().generic_string());
+            appendIncludes(files.front(), files);
+            return true;
+        }
+
+        static uint64_t hashString(std::string const& value, uint64_t hash)
+        {
+            uint64_t const size = value.size();
+            hash = Hash::fnv1a(&size, sizeof(size), hash);
+            return Hash::fnv1a(value.data(), value.size(), hash);
+        }
+
+        bool computeKey(ShaderDesc const& desc, uint64_t& key)
+        {
+            std::vector<std::string> files;
+            if (!collectIncludes(desc.sourcePath.c_str(), files)) {
+                return false;
+            }
+
+            uint64_t hash = Hash::fnv1a(&Version, sizeof(Version));
+            hash = hashString(desc.entryPoint, hash);
+            hash = hashString(desc.profile, hash);
+            hash = Hash::fnv1a(&desc.compileFlags, sizeof(desc.compileFlags), hash);
+
+            uint64_t const defineCount = desc.defines.size();
+            hash = Hash::fnv1a(&defineCount, sizeof(defineCount), hash);
+            for (Define const& define : desc.defines)
+            {
+                hash = hashString(define.name, hash);
+                hash = hashString(define.value, hash);
+            }
+
+            // Missing includes are hashed too, so creating one later changes the key
+            std::string contents;
+            for (std::string const& file : files)
+            {
+                uint8_t const present = readFile(file.c_str(), contents) ? 1 : 0;
+                hash = hashString(file, hash);
+                hash = Hash::fnv1a(&present, sizeof(present), hash);
+                hash = hashString(present ? contents : std::string(), hash);
+            }
+
+            key = hash;
+            return true;
+        }
+
+        std::string cachePath(char const* directory, uint64_t key)
+        {
+            char name[17];
+            snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+            return (std::filesystem::path(directory) / name).generic_string() + FileExtension;
+        }
+
+        bool write(char const* path, uint64_t key, uint8_t const* pBytecode, size_t size)
+        {
+            Header header{};
+            header.magic = Magic;
+            header.version = Version;
+            header.key = key;
+            header.bytecodeSize = size;
+            header.bytecodeHash = Hash::fnv1a(pBytecode, size);
+
+            // Write to a temporary file first, so a crash never leaves a truncated cache behind
+            std::string const tempPath = std::string(path) + ".tmp";
+            FILE* pFile = fopen(tempPath.c_str(), "wb");
+            if (pFile == nullptr) {
+                return false;
+            }
+
+            bool success = fwrite(&header, sizeof(Header), 1, pFile) == 1;
+            success = success && (size == 0 || fwrite(pBytecode, 1, size, pFile) == size);
+            success = (fclose(pFile) == 0) && success;
+
+            std::error_code error;
+            if (success) {
+                std::filesystem::rename(tempPath, path, error);
+            }
+
+            if (!success || error)
+            {
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        bool read(char const* path, uint64_t key, std::vector<uint8_t>& bytecode)
+        {
+            MappedFile file;
+            if (!file.open(path) || file.size() < sizeof(Header)) {
+                return false;
+            }
+
+            Header const* pHeader = static_cast<Header const*>(file.data());
+            if (pHeader->magic != Magic || pHeader->version != Version || pHeader->key != key || pHeader->bytecodeSize != file.size() - sizeof(Header)) {
+                return false;
+            }
+
+            uint8_t const* pBytecode = static_cast<uint8_t const*>(file.data()) + sizeof(Header);
+            if (Hash::fnv1a(pBytecode, pHeader->bytecodeSize) != pHeader->bytecodeHash) {
+                return false;
+            }
+
+            bytecode.assign(pBytecode, pBytecode + pHeader->bytecodeSize);
+            return true;
+        }
+
+        LoadResult load(char const* directory, ShaderDesc const& desc, Compile const& compile, std::vector<uint8_t>& bytecode)
+        {
+            uint64_t key = 0;
+            if (!computeKey(desc, key))
+            {
+                printf("Shader source not found [%s]\n", desc.sourcePath.c_str());
+                return LoadResult::Failed;
+            }
+
+            std::string const path = cachePath(directory, key);
+            if (read(path.c_str(), key, bytecode)) {
+                return LoadResult::Loaded;
+            }
+
+            if (!compile(desc, bytecode)) {
+                return LoadResult::Failed;
+            }
+
+            // A failed store only costs the next launch a compile
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+            if (!write(path.c_str(), key, bytecode.data(), bytecode.size())) {
+                printf("Shader cache write failed [%s]\n", path.c_str());
+            }
+
+            return LoadResult::Compiled;
+        }
+    } // namespace ShaderCache
+} // namespace Engine
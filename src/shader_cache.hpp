@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Engine
+{
+    namespace ShaderCache
+    {
+        constexpr uint32_t Magic = 0x48435348; //< "SHCH"
+        constexpr uint32_t Version = 1; //< bump whenever the layout or the shader compiler changes cached contents
+        constexpr char const* FileExtension = ".shadercache";
+
+        struct Define
+        {
+            std::string name;
+            std::string value;
+        };
+
+        /// @brief Everything that determines a shader's bytecode, besides the contents of its files.
+        struct ShaderDesc
+        {
+            std::string sourcePath;
+            std::string entryPoint;
+            std::string profile;            //< e.g. vs_5_0
+            std::vector<Define> defines;
+            uint32_t compileFlags = 0;      //< D3DCOMPILE flags, hashed as is
+        };
+
+        /// @brief Cache file header, followed by the bytecode.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t key;
+            uint64_t bytecodeSize;
+            uint64_t bytecodeHash;
+        };
+
+        enum class LoadResult
+        {
+            Loaded,     //< cache hit
+            Compiled,   //< cache miss, compiled & stored
+            Failed,
+        };
+
+        /// @brief Compile the shader to bytecode, the shader compiler in the renderer & a stub in tests.
+        using Compile = std::function<bool(ShaderDesc const& desc, std::vector<uint8_t>& bytecode)>;
+
+        /// @brief The source file followed by every file it includes, depth first & each once. Includes are found by scanning for
+        /// #include lines & resolved relative to the including file like the standard file include handler, so includes in
+        /// inactive preprocessor branches are followed too. Missing includes are listed. False if the source can't be read.
+        bool collectIncludes(char const* sourcePath, std::vector<std::string>& files);
+
+        /// @brief Hash of the include closure's paths & contents, the entry point, profile, defines & compile flags. False if
+        /// the source can't be read.
+        bool computeKey(ShaderDesc const& desc, uint64_t& key);
+
+        std::string cachePath(char const* directory, uint64_t key);
+
+        bool write(char const* path, uint64_t key, uint8_t const* pBytecode, size_t size);
+
+        /// @brief Read the bytecode if the file holds the key's shader & its contents are intact.
+        bool read(char const* path, uint64_t key, std::vector<uint8_t>& bytecode);
+
+        /// @brief Read the shader's bytecode from the cache directory, or compile & store it on a miss. Files are only ever
+        /// looked up by key, so edited sources, includes or settings miss & compile again. Thread safe for different shaders.
+        LoadResult load(char const* directory, ShaderDesc const& desc, Compile const& compile, std::vector<uint8_t>& bytecode);
+    } // namespace ShaderCache
+} // namespace Engine
@@ -0,0 +1,41 @@
+#include "startup.hpp"
+
+#include <string>
+
+namespace Engine
+{
+    namespace Startup
+    {
+        void buildGraph(TaskGraph& graph, Assets& assets, Stages const& stages)
+        {
+            TaskGraph::TaskId const compileVertexShader = graph.addTask("Compile vertex shader", stages.compileVertexShader);
+            TaskGraph::TaskId const compilePixelShader = graph.addTask("Compile pixel shader", stages.compilePixelShader);
+            TaskGraph::TaskId const readMesh = graph.addTask("Read mesh", [&assets]() { return AssetLoader::readMesh(MeshPath, assets.mesh); });
+
+            TaskGraph::TaskId readTextures[MaterialTextureCount];
+            for (uint32_t textureIdx = 0; textureIdx < MaterialTextureCount; textureIdx++)
+            {
+                std::string const name = "Read texture " + std::to_string(textureIdx);
+                readTextures[textureIdx] = graph.addTask(name.c_str(), [&assets, textureIdx]()
+                {
+                    MaterialTexture const& materialTexture = MaterialTextures[textureIdx];
+                    assets.pTextures[textureIdx] = std::make_unique<AssetLoader::TextureSource>();
+                    return AssetLoader::readTexture(materialTexture.path, materialTexture.type, *assets.pTextures[textureIdx]);
+                });
+            }
+
+            graph.addTask("Create pipeline", stages.createPipeline, { compileVertexShader, compilePixelShader });
+
+            // Submit only waits on the tasks recording uploads, the pipeline doesn't need the GPU queue
+            std::vector<TaskGraph::TaskId> uploads;
+            uploads.push_back(graph.addTask("Create mesh", [&assets, &stages]() { return stages.createMesh(assets.mesh); }, { readMesh }));
+            for (uint32_t textureIdx = 0; textureIdx < MaterialTextureCount; textureIdx++)
+            {
+                std::string const name = "Create texture " + std::to_string(textureIdx);
+                uploads.push_back(graph.addTask(name.c_str(), [&assets, &stages, textureIdx]() { return stages.createTexture(textureIdx, assets.pTextures[textureIdx]); }, { readTextures[textureIdx] }));
+            }
+
+            graph.addTask("Submit uploads", stages.submitUploads, uploads);
+        }
+    } // namespace Startup
+} // namespace Engine
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "asset_loader.hpp"
+#include "task_graph.hpp"
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace Startup
+    {
+        /// @brief Material texture loaded at startup, its SRV goes to the index'th descriptor of the material table.
+        struct MaterialTexture
+        {
+            char const* path;
+            TextureType type;
+        };
+
+        constexpr char const* MeshPath = "data/assets/suzanne.obj";
+        constexpr char const* ShaderPath = "data/shaders/shader.hlsl";
+        constexpr char const* ShaderCacheDirectory = "data/shaders/cache"; //< compiled bytecode by shader key
+        constexpr MaterialTexture MaterialTextures[] = {
+            MaterialTexture{ "data/assets/brickwall.jpg", TextureType::Color },
+            MaterialTexture{ "data/assets/brickwall_normal.jpg", TextureType::Normal },
+        };
+        constexpr uint32_t MaterialTextureCount = sizeof(MaterialTextures) / sizeof(MaterialTextures[0]);
+
+        /// @brief CPU side startup results, filled by the asset read tasks & consumed by the renderer stages. Texture sources
+        /// are heap allocated so streaming textures can keep their mapping alive.
+        struct Assets
+        {
+            AssetLoader::MeshSource mesh{};
+            std::unique_ptr<AssetLoader::TextureSource> pTextures[MaterialTextureCount]{};
+        };
+
+        /// @brief Renderer side stages, stubbed for headless runs. Resource creation may run concurrently & records its uploads
+        /// for the single submit at the end.
+        struct Stages
+        {
+            std::function<bool()> compileVertexShader;
+            std::function<bool()> compilePixelShader;
+            std::function<bool()> createPipeline;
+            std::function<bool(AssetLoader::MeshSource&)> createMesh;
+            std::function<bool(uint32_t, std::unique_ptr<AssetLoader::TextureSource>&)> createTexture; //< may take ownership of the source
+            std::function<bool()> submitUploads;
+        };
+
+        /// @brief Add the startup tasks: asset reads & shader compilation overlap, each resource is created as soon as its
+        /// inputs are ready & all uploads are submitted once at the end. Assets & stages must outlive the graph's execution.
+        void buildGraph(TaskGraph& graph, Assets& assets, Stages const& stages);
+    } // namespace Startup
+} // namespace Engine
@@ -0,0 +1,176 @@
+#include "tangent_space.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    namespace TangentSpace
+    {
+        constexpr size_t GrainSize = 16 * 1024; //< elements per parallel job
+
+        /// @brief Per triangle tangent frames, structure of arrays so the face pass vectorizes.
+        struct FaceFrames
+        {
+            std::vector<float> tangentX;
+            std::vector<float> tangentY;
+            std::vector<float> tangentZ;
+            std::vector<float> bitangentX;
+            std::vector<float> bitangentY;
+            std::vector<float> bitangentZ;
+            std::vector<float> cornerAngles;   //< 3 per triangle, in index order
+        };
+
+        static float cornerAngle(glm::vec3 const& edgeA, glm::vec3 const& edgeB)
+        {
+            float const lengths = std::sqrt(glm::dot(edgeA, edgeA) * glm::dot(edgeB, edgeB));
+            if (lengths <= 0.0F) {
+                return 0.0F;
+            }
+
+            return std::acos(glm::clamp(glm::dot(edgeA, edgeB) / lengths, -1.0F, 1.0F));
+        }
+
+        /// @brief Gram-Schmidt against the normal, zero if nothing is left.
+        static glm::vec3 projectOntoPlane(glm::vec3 const& normal, glm::vec3 const& vector)
+        {
+            glm::vec3 const projected = vector - normal * glm::dot(normal, vector);
+            float const length = glm::length(projected);
+            return (length > 1e-12F) ? projected / length : glm::vec3(0.0F);
+        }
+
+        void generateTangents(MeshData& meshData)
+        {
+            std::vector<Vertex>& vertices = meshData.vertices;
+            std::vector<uint32_t> const& indices = meshData.indices;
+            assert(indices.size() % 3 == 0); //< Need multiple of 3 for triangle indices
+
+            size_t const vertexCount = vertices.size();
+            size_t const triangleCount = indices.size() / 3;
+
+            // Gather the attributes the face pass reads into SoA arrays
+            std::vector<float> positionX(vertexCount);
+            std::vector<float> positionY(vertexCount);
+            std::vector<float> positionZ(vertexCount);
+            std::vector<float> texCoordU(vertexCount);
+            std::vector<float> texCoordV(vertexCount);
+            JobSystem::parallelForCurrent(vertexCount, GrainSize, [&](size_t begin, size_t end)
+            {
+                for (size_t vertexIdx = begin; vertexIdx < end; vertexIdx++)
+                {
+                    Vertex const& vertex = vertices[vertexIdx];
+                    positionX[vertexIdx] = vertex.position.x;
+                    positionY[vertexIdx] = vertex.position.y;
+                    positionZ[vertexIdx] = vertex.position.z;
+                    texCoordU[vertexIdx] = vertex.texCoord.x;
+                    texCoordV[vertexIdx] = vertex.texCoord.y;
+                }
+            });
+
+            // Face pass, tangent & bitangent follow +u & +v, mirrored texture coords flip the bitangent relative to the normal
+            FaceFrames faces{};
+            faces.tangentX.resize(triangleCount);
+            faces.tangentY.resize(triangleCount);
+            faces.tangentZ.resize(triangleCount);
+            faces.bitangentX.resize(triangleCount);
+            faces.bitangentY.resize(triangleCount);
+            faces.bitangentZ.resize(triangleCount);
+            faces.cornerAngles.resize(triangleCount * 3);
+            JobSystem::parallelForCurrent(triangleCount, GrainSize, [&](size_t begin, size_t end)
+            {
+                for (size_t triangleIdx = begin; triangleIdx < end; triangleIdx++)
+                {
+                    uint32_t const i0 = indices[triangleIdx * 3 + 0];
+                    uint32_t const i1 = indices[triangleIdx * 3 + 1];
+                    uint32_t const i2 = indices[triangleIdx * 3 + 2];
+
+                    glm::vec3 const p0(positionX[i0], positionY[i0], positionZ[i0]);
+                    glm::vec3 const p1(positionX[i1], positionY[i1], positionZ[i1]);
+                    glm::vec3 const p2(positionX[i2], positionY[i2], positionZ[i2]);
+                    glm::vec3 const e1 = p1 - p0;
+                    glm::vec3 const e2 = p2 - p0;
+
+                    float const du1 = texCoordU[i1] - texCoordU[i0];
+                    float const dv1 = texCoordV[i1] - texCoordV[i0];
+                    float const du2 = texCoordU[i2] - texCoordU[i0];
+                    float const dv2 = texCoordV[i2] - texCoordV[i0];
+
+                    // Only the sign of the determinant matters once normalized, degenerate texture coords give zero
+                    float const det = du1 * dv2 - du2 * dv1;
+                    float const sign = (det > 0.0F) ? 1.0F : ((det < 0.0F) ? -1.0F : 0.0F);
+                    glm::vec3 tangent = (e1 * dv2 - e2 * dv1) * sign;
+                    glm::vec3 bitangent = (e2 * du1 - e1 * du2) * sign;
+
+                    float const tangentLength = glm::length(tangent);
+                    float const bitangentLength = glm::length(bitangent);
+                    tangent = (tangentLength > 0.0F) ? tangent / tangentLength : glm::vec3(0.0F);
+                    bitangent = (bitangentLength > 0.0F) ? bitangent / bitangentLength : glm::vec3(0.0F);
+
+                    faces.tangentX[triangleIdx] = tangent.x;
+                    faces.tangentY[triangleIdx] = tangent.y;
+                    faces.tangentZ[triangleIdx] = tangent.z;
+                    faces.bitangentX[triangleIdx] = bitangent.x;
+                    faces.bitangentY[triangleIdx] = bitangent.y;
+                    faces.bitangentZ[triangleIdx] = bitangent.z;
+                    faces.cornerAngles[triangleIdx * 3 + 0] = cornerAngle(e1, e2);
+                    faces.cornerAngles[triangleIdx * 3 + 1] = cornerAngle(p2 - p1, p0 - p1);
+                    faces.cornerAngles[triangleIdx * 3 + 2] = cornerAngle(p0 - p2, p1 - p2);
+                }
+            });
+
+            // Vertex to corner adjacency (CSR), lets the vertex pass gather without write conflicts
+            std::vector<uint32_t> cornerOffsets(vertexCount + 1, 0);
+            for (uint32_t const index : indices) {
+                cornerOffsets[index + 1]++;
+            }
+
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++) {
+                cornerOffsets[vertexIdx + 1] += cornerOffsets[vertexIdx];
+            }
+
+            std::vector<uint32_t> vertexCorners(indices.size());
+            std::vector<uint32_t> cornerCursors(cornerOffsets.begin(), cornerOffsets.end() - 1);
+            for (size_t cornerIdx = 0; cornerIdx < indices.size(); cornerIdx++) {
+                vertexCorners[cornerCursors[indices[cornerIdx]]++] = static_cast<uint32_t>(cornerIdx);
+            }
+
+            // Vertex pass, angle weighted accumulation in the tangent plane, then orthogonalize & derive handedness
+            JobSystem::parallelForCurrent(vertexCount, GrainSize, [&](size_t begin, size_t end)
+            {
+                for (size_t vertexIdx = begin; vertexIdx < end; vertexIdx++)
+                {
+                    Vertex& vertex = vertices[vertexIdx];
+                    float const normalLength = glm::length(vertex.normal);
+                    glm::vec3 const normal = (normalLength > 0.0F) ? vertex.normal / normalLength : glm::vec3(0.0F);
+
+                    glm::vec3 tangentSum(0.0F);
+                    glm::vec3 bitangentSum(0.0F);
+                    for (uint32_t offset = cornerOffsets[vertexIdx]; offset < cornerOffsets[vertexIdx + 1]; offset++)
+                    {
+                        uint32_t const cornerIdx = vertexCorners[offset];
+                        uint32_t const triangleIdx = cornerIdx / 3;
+                        float const weight = faces.cornerAngles[cornerIdx];
+
+                        glm::vec3 const faceTangent(faces.tangentX[triangleIdx], faces.tangentY[triangleIdx], faces.tangentZ[triangleIdx]);
+                        glm::vec3 const faceBitangent(faces.bitangentX[triangleIdx], faces.bitangentY[triangleIdx], faces.bitangentZ[triangleIdx]);
+                        tangentSum += projectOntoPlane(normal, faceTangent) * weight;
+                        bitangentSum += projectOntoPlane(normal, faceBitangent) * weight;
+                    }
+
+                    glm::vec3 tangent = projectOntoPlane(normal, tangentSum);
+                    if (tangent == glm::vec3(0.0F))
+                    {
+                        // No usable texture coords, any tangent perpendicular to the normal will do
+                        glm::vec3 const axis = (std::abs(normal.x) < 0.9F) ? glm::vec3(1.0F, 0.0F, 0.0F) : glm::vec3(0.0F, 1.0F, 0.0F);
+                        tangent = projectOntoPlane(normal, axis);
+                    }
+
+                    float const handedness = (glm::dot(glm::cross(normal, tangent), bitangentSum) < 0.0F) ? -1.0F : 1.0F;
+                    vertex.tangent = glm::vec4(tangent, handedness);
+                }
+            });
+        }
+    } // namespace TangentSpace
+} // namespace Engine
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "mesh.hpp"
+
+namespace Engine
+{
+    namespace TangentSpace
+    {
+        /// @brief Generate per vertex tangents & handedness from positions, normals & texture coords.
+        /// Face tangents are projected onto each vertex normal & accumulated weighted by the corner angle, so the result
+        /// does not depend on triangle order. Triangles with degenerate texture coords don't contribute, vertices without
+        /// any contribution get an arbitrary tangent perpendicular to their normal.
+        void generateTangents(MeshData& meshData);
+    } // namespace TangentSpace
+} // namespace Engine
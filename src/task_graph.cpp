@@ -0,0 +1,183 @@
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace Engine
+{
+    TaskGraph::TaskId TaskGraph::addTask(char const* name, Function function, std::vector<TaskId> const& dependencies)
+    {
+        TaskId const taskId = static_cast<TaskId>(m_tasks.size());
+
+        Task task{};
+        task.name = name;
+        task.function = std::move(function);
+        for (TaskId dependency : dependencies)
+        {
+            assert(dependency < taskId && "Dependencies must be added before their dependents");
+            task.dependencies.push_back(dependency);
+            m_tasks[dependency].dependents.push_back(taskId);
+        }
+
+        m_tasks.push_back(std::move(task));
+        return taskId;
+    }
+
+    bool TaskGraph::execute(JobSystem& jobs)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point const start = Clock::now();
+        auto const elapsedMS = [start]() { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+
+        std::mutex mutex;
+        JobSystem::Counter counter;
+        std::vector<bool> dependencyFailed(m_tasks.size(), false);
+
+        // Called with the lock held, collects dependents that became runnable & completes skipped ones in place
+        auto const complete = [&](TaskId taskId, std::vector<TaskId>& runnable)
+        {
+            std::vector<TaskId> worklist = { taskId };
+            while (!worklist.empty())
+            {
+                TaskId const completedId = worklist.back();
+                worklist.pop_back();
+
+                Task const& completed = m_tasks[completedId];
+                for (TaskId dependentId : completed.dependents)
+                {
+                    Task& dependent = m_tasks[dependentId];
+                    dependencyFailed[dependentId] = dependencyFailed[dependentId] || completed.state != TaskState::Succeeded;
+                    if (--dependent.remainingDependencies > 0) {
+                        continue;
+                    }
+
+                    if (dependencyFailed[dependentId])
+                    {
+                        dependent.state = TaskState::Skipped;
+                        dependent.startMS = dependent.endMS = completed.endMS;
+                        worklist.push_back(dependentId);
+                    }
+                    else {
+                        runnable.push_back(dependentId);
+                    }
+                }
+            }
+        };
+
+        // Dependents are spawned by the job that completed their last dependency, before it finishes, so the counter only
+        // drops to zero once every task ran or was skipped
+        std::function<void(TaskId)> runTask = [&](TaskId taskId)
+        {
+            double const startMS = elapsedMS();
+            bool const succeeded = m_tasks[taskId].function();
+            double const endMS = elapsedMS();
+
+            std::vector<TaskId> runnable;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Task& task = m_tasks[taskId];
+                task.startMS = startMS;
+                task.endMS = endMS;
+                task.state = succeeded ? TaskState::Succeeded : TaskState::Failed;
+                complete(taskId, runnable);
+            }
+
+            for (TaskId runnableId : runnable) {
+                jobs.run([&runTask, runnableId]() { runTask(runnableId); }, &counter);
+            }
+        };
+
+        std::vector<TaskId> roots;
+        for (TaskId taskId = 0; taskId < m_tasks.size(); taskId++)
+        {
+            Task& task = m_tasks[taskId];
+            task.remainingDependencies = static_cast<uint32_t>(task.dependencies.size());
+            task.state = TaskState::Pending;
+            if (task.dependencies.empty()) {
+                roots.push_back(taskId);
+            }
+        }
+
+        for (TaskId root : roots) {
+            jobs.run([&runTask, root]() { runTask(root); }, &counter);
+        }
+
+        jobs.wait(counter);
+
+        m_wallTimeMS = elapsedMS();
+        return std::none_of(m_tasks.begin(), m_tasks.end(), [](Task const& task) { return task.state != TaskState::Succeeded; });
+    }
+
+    std::vector<TaskGraph::TaskId> TaskGraph::criticalPath() const
+    {
+        if (m_tasks.empty()) {
+            return {};
+        }
+
+        // Task ids are in topological order, so a single forward pass finds the longest chain ending at each task
+        std::vector<double> pathMS(m_tasks.size(), 0.0);
+        std::vector<TaskId> predecessor(m_tasks.size(), UINT32_MAX);
+        TaskId last = 0;
+        for (TaskId taskId = 0; taskId < m_tasks.size(); taskId++)
+        {
+            for (TaskId dependency : m_tasks[taskId].dependencies)
+            {
+                if (pathMS[dependency] > pathMS[taskId])
+                {
+                    pathMS[taskId] = pathMS[dependency];
+                    predecessor[taskId] = dependency;
+                }
+            }
+
+            pathMS[taskId] += durationMS(taskId);
+            if (pathMS[taskId] > pathMS[last]) {
+                last = taskId;
+            }
+        }
+
+        std::vector<TaskId> path;
+        for (TaskId taskId = last; taskId != UINT32_MAX; taskId = predecessor[taskId]) {
+            path.push_back(taskId);
+        }
+
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    void TaskGraph::report(char const* title) const
+    {
+        double summedMS = 0.0;
+        for (TaskId taskId = 0; taskId < m_tasks.size(); taskId++) {
+            summedMS += durationMS(taskId);
+        }
+
+        printf("%s (%zu tasks, %.2f ms wall, %.2f ms summed, %.1fx overlap)\n", title, m_tasks.size(), m_wallTimeMS, summedMS, summedMS / std::max(m_wallTimeMS, 1e-6));
+        for (TaskId taskId = 0; taskId < m_tasks.size(); taskId++)
+        {
+            Task const& task = m_tasks[taskId];
+            char const* status = "";
+            if (task.state == TaskState::Failed) {
+                status = " (failed)";
+            }
+            else if (task.state == TaskState::Skipped) {
+                status = " (skipped)";
+            }
+
+            printf("  %-28s %10.2f ms @ %10.2f ms%s\n", task.name.c_str(), durationMS(taskId), task.startMS, status);
+        }
+
+        std::vector<TaskId> const path = criticalPath();
+        double pathMS = 0.0;
+        std::string pathNames;
+        for (TaskId taskId : path)
+        {
+            pathMS += durationMS(taskId);
+            pathNames += (pathNames.empty() ? "" : " -> ") + m_tasks[taskId].name;
+        }
+
+        printf("  Critical path %.2f ms: %s\n", pathMS, pathNames.c_str());
+    }
+} // namespace Engine
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace Engine
+{
+    /// @brief Dependency graph of named tasks executed as jobs, each task running once all of its dependencies succeeded.
+    /// Records per task wall times to report the critical path.
+    class TaskGraph
+    {
+    public:
+        using TaskId = uint32_t;
+        using Function = std::function<bool()>;    //< returns false on failure, dependent tasks are skipped
+
+        /// @brief Dependencies must have been added before, which keeps the graph acyclic & task ids in topological order.
+        TaskId addTask(char const* name, Function function, std::vector<TaskId> const& dependencies = {});
+
+        /// @brief Run all tasks on the job system & run jobs until they finished or were skipped. Must be called by one of its
+        /// workers, tasks may split their own work with parallel for. Returns false if any task failed.
+        bool execute(JobSystem& jobs);
+
+        /// @brief Longest chain of dependent tasks by measured duration, first task first.
+        std::vector<TaskId> criticalPath() const;
+
+        /// @brief Print per task start & duration, the total wall time & the critical path.
+        void report(char const* title) const;
+
+        size_t taskCount() const { return m_tasks.size(); }
+
+        double wallTimeMS() const { return m_wallTimeMS; }
+
+        double durationMS(TaskId task) const { return m_tasks[task].endMS - m_tasks[task].startMS; }
+
+    private:
+        enum class TaskState
+        {
+            Pending,
+            Succeeded,
+            Failed,
+            Skipped,
+        };
+
+        struct Task
+        {
+            std::string name;
+            Function function;
+            std::vector<TaskId> dependencies;
+            std::vector<TaskId> dependents;
+            uint32_t remainingDependencies = 0;
+            TaskState state = TaskState::Pending;
+            double startMS = 0.0;   //< relative to the start of execute
+            double endMS = 0.0;
+        };
+
+        std::vector<Task> m_tasks;
+        double m_wallTimeMS = 0.0;
+    };
+} // namespace Engine
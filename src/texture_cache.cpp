@@ -0,0 +1,170 @@
+#include "texture_cache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+
+#include "block_compression.hpp"
+
+namespace Engine
+{
+    namespace TextureCache
+    {
+        static uint64_t alignUp(uint64_t value, uint64_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        std::string cachePath(char const* sourcePath)
+        {
+            return std::string(sourcePath) + FileExtension;
+        }
+
+        bool write(char const* path, MeshCache::SourceInfo const& sourceInfo, TextureData const& textureData)
+        {
+            if (textureData.levels.empty() || textureData.levels.size() > MaxLevels) {
+                return false;
+            }
+
+            Header header{};
+            header.magic = Magic;
+            header.version = Version;
+            header.sourceSize = sourceInfo.size;
+            header.sourceTimestamp = sourceInfo.timestamp;
+            header.sourceHash = sourceInfo.hash;
+            header.type = static_cast<uint32_t>(textureData.type);
+            header.format = static_cast<uint32_t>(textureData.format);
+            header.levelCount = static_cast<uint32_t>(textureData.levels.size());
+
+            // Smallest level first, placement & row pitch match the upload buffer footprints
+            uint64_t offset = sizeof(Header);
+            for (uint32_t levelIdx = header.levelCount; levelIdx-- > 0;)
+            {
+                TextureLevel const& level = textureData.levels[levelIdx];
+                Level& cachedLevel = header.levels[levelIdx];
+                offset = alignUp(offset, DataAlignment);
+                cachedLevel.offset = offset;
+                cachedLevel.width = level.width;
+                cachedLevel.height = level.height;
+                cachedLevel.rowPitch = static_cast<uint32_t>(alignUp(BlockCompression::rowPitch(textureData.format, level.width), RowPitchAlignment));
+                cachedLevel.rowCount = BlockCompression::rowCount(textureData.format, level.height);
+                offset += static_cast<uint64_t>(cachedLevel.rowPitch) * cachedLevel.rowCount;
+            }
+
+            // Write to a temporary file first, so a crash never leaves a truncated cache behind
+            std::string const tempPath = std::string(path) + ".tmp";
+            FILE* pFile = fopen(tempPath.c_str(), "wb");
+            if (pFile == nullptr) {
+                return false;
+            }
+
+            std::vector<uint8_t> const padding(DataAlignment + RowPitchAlignment, 0);
+            bool success = fwrite(&header, sizeof(Header), 1, pFile) == 1;
+            uint64_t written = sizeof(Header);
+            for (uint32_t levelIdx = header.levelCount; levelIdx-- > 0 && success;)
+            {
+                TextureLevel const& level = textureData.levels[levelIdx];
+                Level const& cachedLevel = header.levels[levelIdx];
+                size_t const rowSize = BlockCompression::rowPitch(textureData.format, level.width);
+                size_t const rowPadding = cachedLevel.rowPitch - rowSize;
+                uint64_t const paddingSize = cachedLevel.offset - written;
+                success = fwrite(padding.data(), 1, paddingSize, pFile) == paddingSize;
+                for (uint32_t row = 0; row < cachedLevel.rowCount && success; row++)
+                {
+                    success = fwrite(&level.data[row * rowSize], 1, rowSize, pFile) == rowSize;
+                    success = success && (rowPadding == 0 || fwrite(padding.data(), 1, rowPadding, pFile) == rowPadding);
+                }
+
+                written = cachedLevel.offset + static_cast<uint64_t>(cachedLevel.rowPitch) * cachedLevel.rowCount;
+            }
+            success = (fclose(pFile) == 0) && success;
+
+            std::error_code error;
+            if (success) {
+                std::filesystem::rename(tempPath, path, error);
+            }
+
+            if (!success || error)
+            {
+                std::filesystem::remove(tempPath, error);
+                return false;
+            }
+
+            return true;
+        }
+
+        bool open(char const* path, CachedTexture& cachedTexture)
+        {
+            MappedFile& file = cachedTexture.file;
+            if (!file.open(path)) {
+                return false;
+            }
+
+            if (file.size() < sizeof(Header))
+            {
+                file.close();
+                return false;
+            }
+
+            Header const* pHeader = static_cast<Header const*>(file.data());
+            if (pHeader->magic != Magic
+                || pHeader->version != Version
+                || pHeader->levelCount == 0
+                || pHeader->levelCount > MaxLevels
+                || pHeader->format > static_cast<uint32_t>(TextureFormat::BC7))
+            {
+                file.close();
+                return false;
+            }
+
+            TextureFormat const format = static_cast<TextureFormat>(pHeader->format);
+            for (uint32_t levelIdx = 0; levelIdx < pHeader->levelCount; levelIdx++)
+            {
+                Level const& level = pHeader->levels[levelIdx];
+                if (level.offset % DataAlignment != 0
+                    || level.rowPitch % RowPitchAlignment != 0
+                    || level.rowPitch < BlockCompression::rowPitch(format, level.width)
+                    || level.rowCount != BlockCompression::rowCount(format, level.height)
+                    || level.offset + static_cast<uint64_t>(level.rowPitch) * level.rowCount > file.size())
+                {
+                    file.close();
+                    return false;
+                }
+            }
+
+            cachedTexture.pHeader = pHeader;
+            return true;
+        }
+
+        bool load(char const* sourcePath, char const* path, CachedTexture& cachedTexture)
+        {
+            if (!open(path, cachedTexture)) {
+                return false;
+            }
+
+            // Cooked caches may be shipped without their source asset
+            MeshCache::SourceInfo sourceInfo{};
+            if (!MeshCache::querySource(sourcePath, sourceInfo, false)) {
+                return true;
+            }
+
+            Header const* pHeader = cachedTexture.pHeader;
+            if (pHeader->sourceSize == sourceInfo.size && pHeader->sourceTimestamp == sourceInfo.timestamp) {
+                return true;
+            }
+
+            // Timestamp changed (e.g. fresh checkout), fall back to comparing content hashes
+            if (pHeader->sourceSize == sourceInfo.size
+                && MeshCache::querySource(sourcePath, sourceInfo, true)
+                && pHeader->sourceHash == sourceInfo.hash)
+            {
+                return true;
+            }
+
+            cachedTexture.file.close();
+            cachedTexture.pHeader = nullptr;
+            return false;
+        }
+    } // namespace TextureCache
+} // namespace Engine
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "mapped_file.hpp"
+#include "mesh_cache.hpp"
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace TextureCache
+    {
+        constexpr uint32_t Magic = 0x48435854; //< "TXCH"
+        constexpr uint32_t Version = 1; //< bump whenever the layout or texture processing changes cached contents
+        constexpr uint32_t MaxLevels = 16;
+        constexpr uint64_t DataAlignment = 512; //< D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+        constexpr uint32_t RowPitchAlignment = 256; //< D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+        constexpr uint32_t MipTailSize = 128; //< levels up to this size are uploaded at load, larger ones stream in afterwards
+        constexpr char const* FileExtension = ".texcache";
+
+        /// @brief Subresource stored in the cache file in its final GPU format, rows padded to RowPitchAlignment.
+        struct Level
+        {
+            uint64_t offset;
+            uint32_t width;
+            uint32_t height;
+            uint32_t rowPitch;
+            uint32_t rowCount;  //< texel rows or block rows
+        };
+
+        /// @brief Cache file header, levels are stored smallest first so the mip tail is read before the detailed levels.
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceSize;
+            int64_t sourceTimestamp;
+            uint64_t sourceHash;
+            uint32_t type;      //< TextureType
+            uint32_t format;    //< TextureFormat
+            uint32_t levelCount;
+            uint32_t reserved;
+            Level levels[MaxLevels];
+        };
+
+        /// @brief Memory mapped cache file, level data points directly into the mapped view.
+        struct CachedTexture
+        {
+            TextureFormat format() const
+            {
+                return static_cast<TextureFormat>(pHeader->format);
+            }
+
+            uint8_t const* levelData(uint32_t levelIdx) const
+            {
+                return static_cast<uint8_t const*>(file.data()) + pHeader->levels[levelIdx].offset;
+            }
+
+            /// @brief Most detailed level of the mip tail, the smallest level if all levels are larger than MipTailSize.
+            uint32_t tailLevel() const
+            {
+                uint32_t levelIdx = 0;
+                while (levelIdx + 1 < pHeader->levelCount && (pHeader->levels[levelIdx].width > MipTailSize || pHeader->levels[levelIdx].height > MipTailSize)) {
+                    levelIdx++;
+                }
+
+                return levelIdx;
+            }
+
+            MappedFile file;
+            Header const* pHeader = nullptr;
+        };
+
+        std::string cachePath(char const* sourcePath);
+
+        bool write(char const* path, MeshCache::SourceInfo const& sourceInfo, TextureData const& textureData);
+
+        bool open(char const* path, CachedTexture& cachedTexture);
+
+        /// @brief Open a cache file and validate it against its source, using the source hash only if size or timestamp changed.
+        bool load(char const* sourcePath, char const* path, CachedTexture& cachedTexture);
+    } // namespace TextureCache
+} // namespace Engine
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief How texel values are interpreted, determines filtering & encoding.
+    enum class TextureType
+    {
+        Color,      //< gamma encoded RGB, linear alpha
+        Linear,     //< linear data, filtered as is
+        Normal,     //< tangent space normals packed into RGB, renormalized after filtering
+    };
+
+    /// @brief Storage format of the level data, block compressed formats store rows of 4x4 texel blocks.
+    enum class TextureFormat
+    {
+        RGBA8,      //< uncompressed, 4 bytes per texel
+        BC1,        //< RGB 5:6:5 endpoints, 8 bytes per block
+        BC3,        //< BC1 color plus interpolated alpha, 16 bytes per block
+        BC4,        //< single interpolated channel, 8 bytes per block
+        BC5,        //< two interpolated channels, 16 bytes per block, used for normal map XY
+        BC7,        //< RGBA with 7:7:7:7 + p-bit endpoints, 16 bytes per block
+    };
+
+    /// @brief Single mip level, tightly packed rows.
+    struct TextureLevel
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;
+    };
+
+    /// @brief CPU side texture data, level 0 is full resolution.
+    struct TextureData
+    {
+        TextureType type = TextureType::Color;
+        TextureFormat format = TextureFormat::RGBA8;
+        std::vector<TextureLevel> levels;
+    };
+} // namespace Engine
@@ -0,0 +1,88 @@
+#include "texture_import.hpp"
+
+#include <cassert>
+#include <cstdio>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "block_compression.hpp"
+#include "mip_generator.hpp"
+#include "timer.hpp"
+
+namespace Engine
+{
+    namespace TextureImport
+    {
+        /// @brief Mip generation & block compression of a decoded level 0.
+        static bool processImage(char const* path, TextureFormat format, TextureData& textureData)
+        {
+            Timer mipTimer{};
+            MipGenerator::generateMips(textureData);
+            mipTimer.tick();
+            printf("Generated mips [%s] (%zu levels, %.2f ms)\n", path, textureData.levels.size(), mipTimer.deltaTimeMS());
+
+            if (format == TextureFormat::RGBA8) {
+                return true;
+            }
+
+            size_t texelCount = 0;
+            for (auto const& level : textureData.levels) {
+                texelCount += static_cast<size_t>(level.width) * level.height;
+            }
+
+            Timer compressTimer{};
+            if (!BlockCompression::compress(textureData, format))
+            {
+                printf("Texture dimensions not a multiple of %u, keeping RGBA8 [%s]\n", BlockCompression::BlockDimension, path);
+                return true;
+            }
+            compressTimer.tick();
+            printf("Compressed texture [%s] (%s, %.2f ms, %.1f Mtexels/s)\n", path, BlockCompression::formatName(format), compressTimer.deltaTimeMS(),
+                static_cast<double>(texelCount) / 1e3 / compressTimer.deltaTimeMS());
+            return true;
+        }
+
+        bool decodeImage(char const* path, TextureType type, TextureData& textureData, uint32_t& channelCount)
+        {
+            assert(path != nullptr);
+
+            // Always expanded to RGBA8 for filtering, the channel count picks the stored format
+            int texWidth = 0;
+            int texHeight = 0;
+            int texChannels = 0;
+            stbi_uc* pTextureData = stbi_load(path, &texWidth, &texHeight, &texChannels, 4);
+            if (pTextureData == nullptr)
+            {
+                printf("STB Image texture load failed [%s]\n", path);
+                return false;
+            }
+            printf("Loaded texture [%s] (%d x %d x %d)\n", path, texWidth, texHeight, texChannels);
+
+            TextureLevel baseLevel{};
+            baseLevel.width = static_cast<uint32_t>(texWidth);
+            baseLevel.height = static_cast<uint32_t>(texHeight);
+            baseLevel.data.assign(pTextureData, pTextureData + static_cast<size_t>(texWidth) * texHeight * 4);
+            stbi_image_free(pTextureData);
+
+            textureData.type = type;
+            textureData.format = TextureFormat::RGBA8;
+            textureData.levels.clear();
+            textureData.levels.push_back(std::move(baseLevel));
+            channelCount = static_cast<uint32_t>(texChannels);
+            return true;
+        }
+
+        bool importImage(char const* path, TextureType type, TextureFormat format, TextureData& textureData)
+        {
+            uint32_t channelCount = 0;
+            return decodeImage(path, type, textureData, channelCount) && processImage(path, format, textureData);
+        }
+
+        bool importImage(char const* path, TextureType type, TextureData& textureData)
+        {
+            uint32_t channelCount = 0;
+            return decodeImage(path, type, textureData, channelCount) && processImage(path, BlockCompression::defaultFormat(type, channelCount), textureData);
+        }
+    } // namespace TextureImport
+} // namespace Engine
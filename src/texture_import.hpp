@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "texture_data.hpp"
+
+namespace Engine
+{
+    namespace TextureImport
+    {
+        /// @brief Decode an image file into an RGBA8 level 0, channelCount receives the channels stored in the file.
+        bool decodeImage(char const* path, TextureType type, TextureData& textureData, uint32_t& channelCount);
+
+        /// @brief Decode an image, generate its mip chain & block compress it to the given format, RGBA8 stays uncompressed.
+        bool importImage(char const* path, TextureType type, TextureFormat format, TextureData& textureData);
+
+        /// @brief Import using the default compressed format for the texture type & the image's channel count.
+        bool importImage(char const* path, TextureType type, TextureData& textureData);
+    } // namespace TextureImport
+} // namespace Engine
@@ -0,0 +1,328 @@
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Engine
+{
+    static uint32_t highestBit(uint64_t value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long bit = 0;
+        _BitScanReverse64(&bit, value);
+        return static_cast<uint32_t>(bit);
+#else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+    static uint32_t lowestBit(uint64_t value)
+    {
+        assert(value != 0);
+#ifdef _MSC_VER
+        unsigned long bit = 0;
+        _BitScanForward64(&bit, value);
+        return static_cast<uint32_t>(bit);
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+
+    static uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    TLSFAllocator::TLSFAllocator(uint64_t capacity)
+    {
+        m_capacity = capacity;
+        for (auto& heads : m_freeHeads) {
+            std::fill(std::begin(heads), std::end(heads), InvalidBlock);
+        }
+
+        // The block at offset 0 keeps index 0, merges keep the lower block & splits never create blocks below offset 0
+        if (capacity > 0) {
+            insertFree(createBlock(0, capacity));
+        }
+    }
+
+    TLSFAllocator::Allocation TLSFAllocator::allocate(uint64_t size, uint64_t alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        if (size == 0 || size > m_capacity) {
+            return Allocation{};
+        }
+
+        // Every block of the next size class fits the size, padding for alignment falls back to the worst case size class
+        uint32_t blockIdx = findFree(size);
+        if (blockIdx != InvalidBlock && alignUp(m_blocks[blockIdx].offset, alignment) + size > m_blocks[blockIdx].offset + m_blocks[blockIdx].size)
+        {
+            blockIdx = InvalidBlock;
+            if (alignment - 1 <= m_capacity - size) {
+                blockIdx = findFree(size + alignment - 1);
+            }
+        }
+
+        if (blockIdx == InvalidBlock) {
+            return Allocation{};
+        }
+
+        removeFree(blockIdx);
+
+        // Split off the alignment padding in front, its previous block is in use so it can't merge
+        uint64_t const blockOffset = m_blocks[blockIdx].offset;
+        uint64_t const alignedOffset = alignUp(blockOffset, alignment);
+        if (alignedOffset > blockOffset)
+        {
+            uint32_t const paddingIdx = createBlock(blockOffset, alignedOffset - blockOffset);
+            uint32_t const prevIdx = m_blocks[blockIdx].prevPhysical;
+            m_blocks[paddingIdx].prevPhysical = prevIdx;
+            m_blocks[paddingIdx].nextPhysical = blockIdx;
+            if (prevIdx != InvalidBlock) {
+                m_blocks[prevIdx].nextPhysical = paddingIdx;
+            }
+
+            m_blocks[blockIdx].prevPhysical = paddingIdx;
+            m_blocks[blockIdx].offset = alignedOffset;
+            m_blocks[blockIdx].size -= alignedOffset - blockOffset;
+            insertFree(paddingIdx);
+        }
+
+        // Split off the remainder behind
+        if (m_blocks[blockIdx].size > size)
+        {
+            uint32_t const remainderIdx = createBlock(alignedOffset + size, m_blocks[blockIdx].size - size);
+            uint32_t const nextIdx = m_blocks[blockIdx].nextPhysical;
+            m_blocks[remainderIdx].prevPhysical = blockIdx;
+            m_blocks[remainderIdx].nextPhysical = nextIdx;
+            if (nextIdx != InvalidBlock) {
+                m_blocks[nextIdx].prevPhysical = remainderIdx;
+            }
+
+            m_blocks[blockIdx].nextPhysical = remainderIdx;
+            m_blocks[blockIdx].size = size;
+            insertFree(remainderIdx);
+        }
+
+        Block& block = m_blocks[blockIdx];
+        block.free = false;
+        block.alignment = alignment;
+        m_usedSize += block.size;
+        m_allocationCount++;
+        return Allocation{ blockIdx, block.offset };
+    }
+
+    void TLSFAllocator::free(Handle handle)
+    {
+        assert(handle < m_blocks.size() && !m_blocks[handle].free);
+        m_usedSize -= m_blocks[handle].size;
+        m_allocationCount--;
+
+        uint32_t blockIdx = handle;
+        uint32_t const prevIdx = m_blocks[blockIdx].prevPhysical;
+        if (prevIdx != InvalidBlock && m_blocks[prevIdx].free)
+        {
+            removeFree(prevIdx);
+            blockIdx = merge(prevIdx, blockIdx);
+        }
+
+        uint32_t const nextIdx = m_blocks[blockIdx].nextPhysical;
+        if (nextIdx != InvalidBlock && m_blocks[nextIdx].free)
+        {
+            removeFree(nextIdx);
+            blockIdx = merge(blockIdx, nextIdx);
+        }
+
+        insertFree(blockIdx);
+    }
+
+    TLSFAllocator::Statistics TLSFAllocator::statistics() const
+    {
+        Statistics statistics{};
+        statistics.usedSize = m_usedSize;
+        statistics.freeSize = m_capacity - m_usedSize;
+        statistics.allocationCount = m_allocationCount;
+        for (uint32_t blockIdx = m_blocks.empty() ? InvalidBlock : 0; blockIdx != InvalidBlock; blockIdx = m_blocks[blockIdx].nextPhysical)
+        {
+            Block const& block = m_blocks[blockIdx];
+            if (block.free)
+            {
+                statistics.freeBlockCount++;
+                statistics.largestFreeBlock = std::max(statistics.largestFreeBlock, block.size);
+            }
+        }
+
+        if (statistics.freeSize > 0) {
+            statistics.fragmentation = 1.0F - static_cast<float>(static_cast<double>(statistics.largestFreeBlock) / static_cast<double>(statistics.freeSize));
+        }
+
+        return statistics;
+    }
+
+    std::vector<TLSFAllocator::Handle> TLSFAllocator::defragmentationCandidates(uint32_t maxCount) const
+    {
+        std::vector<Handle> candidates;
+        uint32_t largestFreeIdx = InvalidBlock; //< largest free block below the current one
+        for (uint32_t blockIdx = m_blocks.empty() ? InvalidBlock : 0; blockIdx != InvalidBlock; blockIdx = m_blocks[blockIdx].nextPhysical)
+        {
+            Block const& block = m_blocks[blockIdx];
+            if (block.free)
+            {
+                if (largestFreeIdx == InvalidBlock || block.size > m_blocks[largestFreeIdx].size) {
+                    largestFreeIdx = blockIdx;
+                }
+
+                continue;
+            }
+
+            if (largestFreeIdx != InvalidBlock)
+            {
+                Block const& largestFree = m_blocks[largestFreeIdx];
+                if (alignUp(largestFree.offset, block.alignment) + block.size <= largestFree.offset + largestFree.size) {
+                    candidates.push_back(blockIdx);
+                }
+            }
+        }
+
+        std::reverse(candidates.begin(), candidates.end());
+        if (candidates.size() > maxCount) {
+            candidates.resize(maxCount);
+        }
+
+        return candidates;
+    }
+
+    void TLSFAllocator::mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+    {
+        // Sizes below the second level count map linearly, larger sizes split each power of two into equal classes
+        if (size < SecondLevelCount)
+        {
+            firstLevel = 0;
+            secondLevel = static_cast<uint32_t>(size);
+            return;
+        }
+
+        uint32_t const bit = highestBit(size);
+        firstLevel = bit - SecondLevelLog + 1;
+        secondLevel = static_cast<uint32_t>(size >> (bit - SecondLevelLog)) - SecondLevelCount;
+    }
+
+    uint32_t TLSFAllocator::createBlock(uint64_t offset, uint64_t size)
+    {
+        uint32_t blockIdx = m_unusedBlocks;
+        if (blockIdx != InvalidBlock) {
+            m_unusedBlocks = m_blocks[blockIdx].nextFree;
+        }
+        else
+        {
+            blockIdx = static_cast<uint32_t>(m_blocks.size());
+            m_blocks.emplace_back();
+        }
+
+        m_blocks[blockIdx] = Block{ offset, size, 1, InvalidBlock, InvalidBlock, InvalidBlock, InvalidBlock, false };
+        return blockIdx;
+    }
+
+    void TLSFAllocator::releaseBlock(uint32_t blockIdx)
+    {
+        m_blocks[blockIdx].free = false;
+        m_blocks[blockIdx].nextFree = m_unusedBlocks;
+        m_unusedBlocks = blockIdx;
+    }
+
+    void TLSFAllocator::insertFree(uint32_t blockIdx)
+    {
+        uint32_t firstLevel = 0;
+        uint32_t secondLevel = 0;
+        mapping(m_blocks[blockIdx].size, firstLevel, secondLevel);
+
+        uint32_t const headIdx = m_freeHeads[firstLevel][secondLevel];
+        Block& block = m_blocks[blockIdx];
+        block.free = true;
+        block.prevFree = InvalidBlock;
+        block.nextFree = headIdx;
+        if (headIdx != InvalidBlock) {
+            m_blocks[headIdx].prevFree = blockIdx;
+        }
+
+        m_freeHeads[firstLevel][secondLevel] = blockIdx;
+        m_secondLevelBitmaps[firstLevel] |= 1U << secondLevel;
+        m_firstLevelBitmap |= 1ULL << firstLevel;
+    }
+
+    void TLSFAllocator::removeFree(uint32_t blockIdx)
+    {
+        uint32_t firstLevel = 0;
+        uint32_t secondLevel = 0;
+        mapping(m_blocks[blockIdx].size, firstLevel, secondLevel);
+
+        Block const& block = m_blocks[blockIdx];
+        if (block.prevFree != InvalidBlock) {
+            m_blocks[block.prevFree].nextFree = block.nextFree;
+        }
+        if (block.nextFree != InvalidBlock) {
+            m_blocks[block.nextFree].prevFree = block.prevFree;
+        }
+
+        if (m_freeHeads[firstLevel][secondLevel] == blockIdx)
+        {
+            m_freeHeads[firstLevel][secondLevel] = block.nextFree;
+            if (block.nextFree == InvalidBlock)
+            {
+                m_secondLevelBitmaps[firstLevel] &= ~(1U << secondLevel);
+                if (m_secondLevelBitmaps[firstLevel] == 0) {
+                    m_firstLevelBitmap &= ~(1ULL << firstLevel);
+                }
+            }
+        }
+    }
+
+    uint32_t TLSFAllocator::findFree(uint64_t size) const
+    {
+        // Round up to the next size class so any block in it is large enough
+        if (size >= SecondLevelCount) {
+            size += (1ULL << (highestBit(size) - SecondLevelLog)) - 1;
+        }
+
+        uint32_t firstLevel = 0;
+        uint32_t secondLevel = 0;
+        mapping(size, firstLevel, secondLevel);
+
+        uint32_t secondLevelMap = m_secondLevelBitmaps[firstLevel] & (~0U << secondLevel);
+        if (secondLevelMap == 0)
+        {
+            if (firstLevel + 1 >= FirstLevelCount) {
+                return InvalidBlock;
+            }
+
+            uint64_t const firstLevelMap = m_firstLevelBitmap & (~0ULL << (firstLevel + 1));
+            if (firstLevelMap == 0) {
+                return InvalidBlock;
+            }
+
+            firstLevel = lowestBit(firstLevelMap);
+            secondLevelMap = m_secondLevelBitmaps[firstLevel];
+        }
+
+        return m_freeHeads[firstLevel][lowestBit(secondLevelMap)];
+    }
+
+    uint32_t TLSFAllocator::merge(uint32_t blockIdx, uint32_t nextIdx)
+    {
+        assert(m_blocks[blockIdx].nextPhysical == nextIdx);
+        uint32_t const afterIdx = m_blocks[nextIdx].nextPhysical;
+        m_blocks[blockIdx].size += m_blocks[nextIdx].size;
+        m_blocks[blockIdx].nextPhysical = afterIdx;
+        if (afterIdx != InvalidBlock) {
+            m_blocks[afterIdx].prevPhysical = blockIdx;
+        }
+
+        releaseBlock(nextIdx);
+        return blockIdx;
+    }
+} // namespace Engine
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+    /// @brief Two level segregated fit allocator for offsets within a fixed capacity range. Allocation & free are constant time,
+    /// freed blocks merge with their free neighbours immediately. The memory itself is owned by the caller.
+    class TLSFAllocator
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = UINT32_MAX;
+
+        struct Allocation
+        {
+            Handle handle = InvalidHandle;
+            uint64_t offset = 0;
+        };
+
+        struct Statistics
+        {
+            uint64_t usedSize;          //< includes alignment padding that was too small to split off
+            uint64_t freeSize;
+            uint64_t largestFreeBlock;
+            uint32_t allocationCount;
+            uint32_t freeBlockCount;
+            float fragmentation;        //< 0 while the free space is a single block, towards 1 as it splinters
+        };
+
+        explicit TLSFAllocator(uint64_t capacity);
+
+        /// @brief Alignment must be a power of two. Returns an invalid handle if no free block fits the aligned allocation.
+        Allocation allocate(uint64_t size, uint64_t alignment);
+
+        void free(Handle handle);
+
+        uint64_t capacity() const { return m_capacity; }
+
+        bool empty() const { return m_allocationCount == 0; }
+
+        uint64_t offset(Handle handle) const { return m_blocks[handle].offset; }
+
+        uint64_t size(Handle handle) const { return m_blocks[handle].size; }
+
+        Statistics statistics() const;
+
+        /// @brief Defragmentation hints, allocations that fit a free block placed below them ordered highest first. Moving them
+        /// (allocate, copy & free the original) compacts used space towards the front so free space merges.
+        std::vector<Handle> defragmentationCandidates(uint32_t maxCount) const;
+
+    private:
+        static constexpr uint32_t SecondLevelLog = 4;
+        static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog;
+        static constexpr uint32_t FirstLevelCount = 64 - SecondLevelLog + 1;
+        static constexpr uint32_t InvalidBlock = UINT32_MAX;
+
+        struct Block
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t alignment;     //< requested alignment while used
+            uint32_t prevPhysical;
+            uint32_t nextPhysical;
+            uint32_t prevFree;      //< also links unused block slots
+            uint32_t nextFree;
+            bool free;
+        };
+
+        static void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+        uint32_t createBlock(uint64_t offset, uint64_t size);
+
+        void releaseBlock(uint32_t blockIdx);
+
+        void insertFree(uint32_t blockIdx);
+
+        void removeFree(uint32_t blockIdx);
+
+        /// @brief First free block from the size class of the given size upwards, InvalidBlock if there is none.
+        uint32_t findFree(uint64_t size) const;
+
+        /// @brief Merge a free block into its free physical neighbour, returns the surviving block.
+        uint32_t merge(uint32_t blockIdx, uint32_t nextIdx);
+
+        std::vector<Block> m_blocks;
+        uint32_t m_unusedBlocks = InvalidBlock;
+        uint32_t m_freeHeads[FirstLevelCount][SecondLevelCount];
+        uint64_t m_firstLevelBitmap = 0;
+        uint32_t m_secondLevelBitmaps[FirstLevelCount]{};
+        uint64_t m_capacity = 0;
+        uint64_t m_usedSize = 0;
+        uint32_t m_allocationCount = 0;
+    };
+} // namespace Engine
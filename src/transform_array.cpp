@@ -0,0 +1,361 @@
+#include "transform_array.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_ARRAY_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Engine
+{
+    /// @brief Model & normal matrix of one instance from its components, the normal matrix of a TRS transform is its rotation
+    /// with the inverse scale.
+    static void computeInstance(
+        float px, float py, float pz,
+        float qx, float qy, float qz, float qw,
+        float sx, float sy, float sz,
+        float* pOut
+    )
+    {
+        float const r00 = 1.0F - 2.0F * (qy * qy + qz * qz);
+        float const r01 = 2.0F * (qx * qy + qw * qz);
+        float const r02 = 2.0F * (qx * qz - qw * qy);
+        float const r10 = 2.0F * (qx * qy - qw * qz);
+        float const r11 = 1.0F - 2.0F * (qx * qx + qz * qz);
+        float const r12 = 2.0F * (qy * qz + qw * qx);
+        float const r20 = 2.0F * (qx * qz + qw * qy);
+        float const r21 = 2.0F * (qy * qz - qw * qx);
+        float const r22 = 1.0F - 2.0F * (qx * qx + qy * qy);
+        float const ix = 1.0F / sx;
+        float const iy = 1.0F / sy;
+        float const iz = 1.0F / sz;
+
+        float const instance[32] = {
+            r00 * sx, r01 * sx, r02 * sx, 0.0F,
+            r10 * sy, r11 * sy, r12 * sy, 0.0F,
+            r20 * sz, r21 * sz, r22 * sz, 0.0F,
+            px, py, pz, 1.0F,
+            r00 * ix, r01 * ix, r02 * ix, 0.0F,
+            r10 * iy, r11 * iy, r12 * iy, 0.0F,
+            r20 * iz, r21 * iz, r22 * iz, 0.0F,
+            0.0F, 0.0F, 0.0F, 1.0F,
+        };
+
+        for (size_t idx = 0; idx < 32; idx++) {
+            pOut[idx] = instance[idx];
+        }
+    }
+
+#ifdef TRANSFORM_ARRAY_SSE
+    /// @brief Model & normal matrices of four instances whose components are spread over the register lanes.
+    static void writeBatch(
+        __m128 px, __m128 py, __m128 pz,
+        __m128 qx, __m128 qy, __m128 qz, __m128 qw,
+        __m128 sx, __m128 sy, __m128 sz,
+        float* pOut
+    )
+    {
+        // Each register holds one matrix element of the four instances
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const one = _mm_set1_ps(1.0F);
+        __m128 const two = _mm_set1_ps(2.0F);
+        __m128 const ix = _mm_div_ps(one, sx);
+        __m128 const iy = _mm_div_ps(one, sy);
+        __m128 const iz = _mm_div_ps(one, sz);
+
+        __m128 const xx = _mm_mul_ps(qx, qx);
+        __m128 const yy = _mm_mul_ps(qy, qy);
+        __m128 const zz = _mm_mul_ps(qz, qz);
+        __m128 const xy = _mm_mul_ps(qx, qy);
+        __m128 const xz = _mm_mul_ps(qx, qz);
+        __m128 const yz = _mm_mul_ps(qy, qz);
+        __m128 const wx = _mm_mul_ps(qw, qx);
+        __m128 const wy = _mm_mul_ps(qw, qy);
+        __m128 const wz = _mm_mul_ps(qw, qz);
+
+        __m128 const r00 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        __m128 const r01 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        __m128 const r02 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        __m128 const r10 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        __m128 const r11 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        __m128 const r12 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        __m128 const r20 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        __m128 const r21 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        __m128 const r22 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+        // Transpose element registers into the instances' columns, model columns first & normal columns after
+        __m128 columns[8][4] = {
+            { _mm_mul_ps(r00, sx), _mm_mul_ps(r01, sx), _mm_mul_ps(r02, sx), zero },
+            { _mm_mul_ps(r10, sy), _mm_mul_ps(r11, sy), _mm_mul_ps(r12, sy), zero },
+            { _mm_mul_ps(r20, sz), _mm_mul_ps(r21, sz), _mm_mul_ps(r22, sz), zero },
+            { px, py, pz, one },
+            { _mm_mul_ps(r00, ix), _mm_mul_ps(r01, ix), _mm_mul_ps(r02, ix), zero },
+            { _mm_mul_ps(r10, iy), _mm_mul_ps(r11, iy), _mm_mul_ps(r12, iy), zero },
+            { _mm_mul_ps(r20, iz), _mm_mul_ps(r21, iz), _mm_mul_ps(r22, iz), zero },
+            { zero, zero, zero, one },
+        };
+
+        for (auto& column : columns) {
+            _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+        }
+
+        // Instance by instance, so write combined memory receives whole lines
+        for (size_t instanceIdx = 0; instanceIdx < 4; instanceIdx++)
+        {
+            for (size_t columnIdx = 0; columnIdx < 8; columnIdx++) {
+                _mm_storeu_ps(pOut + instanceIdx * 32 + columnIdx * 4, columns[columnIdx][instanceIdx]);
+            }
+        }
+    }
+#endif
+
+    uint32_t TransformArray::add(Transform const& transform)
+    {
+        uint32_t const index = size();
+        resize(index + 1);
+        set(index, transform);
+        return index;
+    }
+
+    void TransformArray::set(uint32_t index, Transform const& transform)
+    {
+        assert(index < size());
+        m_positionX[index] = transform.position.x;
+        m_positionY[index] = transform.position.y;
+        m_positionZ[index] = transform.position.z;
+        m_rotationX[index] = transform.rotation.x;
+        m_rotationY[index] = transform.rotation.y;
+        m_rotationZ[index] = transform.rotation.z;
+        m_rotationW[index] = transform.rotation.w;
+        m_scaleX[index] = transform.scale.x;
+        m_scaleY[index] = transform.scale.y;
+        m_scaleZ[index] = transform.scale.z;
+        m_moved[index] = 1;
+    }
+
+    Transform TransformArray::get(uint32_t index) const
+    {
+        assert(index < size());
+        Transform transform{};
+        transform.position = glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]);
+        transform.rotation = glm::quat(m_rotationW[index], m_rotationX[index], m_rotationY[index], m_rotationZ[index]);
+        transform.scale = glm::vec3(m_scaleX[index], m_scaleY[index], m_scaleZ[index]);
+        return transform;
+    }
+
+    void TransformArray::resize(uint32_t count)
+    {
+        m_positionX.resize(count, 0.0F);
+        m_positionY.resize(count, 0.0F);
+        m_positionZ.resize(count, 0.0F);
+        m_rotationX.resize(count, 0.0F);
+        m_rotationY.resize(count, 0.0F);
+        m_rotationZ.resize(count, 0.0F);
+        m_rotationW.resize(count, 1.0F);
+        m_scaleX.resize(count, 1.0F);
+        m_scaleY.resize(count, 1.0F);
+        m_scaleZ.resize(count, 1.0F);
+        m_moved.resize(count, 1);
+    }
+
+    void TransformArray::rotate(size_t begin, size_t end, glm::quat const& rotation)
+    {
+        assert(begin <= end && end <= size());
+        std::fill(m_moved.begin() + begin, m_moved.begin() + end, uint8_t(1));
+        size_t idx = begin;
+#ifdef TRANSFORM_ARRAY_SSE
+        __m128 const rx = _mm_set1_ps(rotation.x);
+        __m128 const ry = _mm_set1_ps(rotation.y);
+        __m128 const rz = _mm_set1_ps(rotation.z);
+        __m128 const rw = _mm_set1_ps(rotation.w);
+        for (; idx + BatchSize <= end; idx += BatchSize)
+        {
+            __m128 const qx = _mm_loadu_ps(&m_rotationX[idx]);
+            __m128 const qy = _mm_loadu_ps(&m_rotationY[idx]);
+            __m128 const qz = _mm_loadu_ps(&m_rotationZ[idx]);
+            __m128 const qw = _mm_loadu_ps(&m_rotationW[idx]);
+            __m128 const x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, rx), _mm_mul_ps(qx, rw)), _mm_sub_ps(_mm_mul_ps(qy, rz), _mm_mul_ps(qz, ry)));
+            __m128 const y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, ry), _mm_mul_ps(qy, rw)), _mm_sub_ps(_mm_mul_ps(qz, rx), _mm_mul_ps(qx, rz)));
+            __m128 const z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qw, rz), _mm_mul_ps(qz, rw)), _mm_sub_ps(_mm_mul_ps(qx, ry), _mm_mul_ps(qy, rx)));
+            __m128 const w = _mm_sub_ps(_mm_mul_ps(qw, rw), _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, rx), _mm_mul_ps(qy, ry)), _mm_mul_ps(qz, rz)));
+
+            // Renormalize so rounding doesn't accumulate over frames of spinning, the rsqrt estimate is refined by one Newton step
+            __m128 const lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+            __m128 const estimate = _mm_rsqrt_ps(lengthSquared);
+            __m128 const inverseLength = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5F), estimate), _mm_sub_ps(_mm_set1_ps(3.0F), _mm_mul_ps(_mm_mul_ps(lengthSquared, estimate), estimate)));
+            _mm_storeu_ps(&m_rotationX[idx], _mm_mul_ps(x, inverseLength));
+            _mm_storeu_ps(&m_rotationY[idx], _mm_mul_ps(y, inverseLength));
+            _mm_storeu_ps(&m_rotationZ[idx], _mm_mul_ps(z, inverseLength));
+            _mm_storeu_ps(&m_rotationW[idx], _mm_mul_ps(w, inverseLength));
+        }
+#endif
+
+        for (; idx < end; idx++)
+        {
+            glm::quat const result = glm::normalize(glm::quat(m_rotationW[idx], m_rotationX[idx], m_rotationY[idx], m_rotationZ[idx]) * rotation);
+            m_rotationX[idx] = result.x;
+            m_rotationY[idx] = result.y;
+            m_rotationZ[idx] = result.z;
+            m_rotationW[idx] = result.w;
+        }
+    }
+
+    void TransformArray::computeMatrices(size_t begin, size_t end, InstanceData* pInstances) const
+    {
+        assert(begin <= end && end <= size());
+        size_t idx = begin;
+        float* pOut = reinterpret_cast<float*>(pInstances);
+#ifdef TRANSFORM_ARRAY_SSE
+        for (; idx + BatchSize <= end; idx += BatchSize, pOut += BatchSize * 32)
+        {
+            writeBatch(
+                _mm_loadu_ps(&m_positionX[idx]), _mm_loadu_ps(&m_positionY[idx]), _mm_loadu_ps(&m_positionZ[idx]),
+                _mm_loadu_ps(&m_rotationX[idx]), _mm_loadu_ps(&m_rotationY[idx]), _mm_loadu_ps(&m_rotationZ[idx]), _mm_loadu_ps(&m_rotationW[idx]),
+                _mm_loadu_ps(&m_scaleX[idx]), _mm_loadu_ps(&m_scaleY[idx]), _mm_loadu_ps(&m_scaleZ[idx]),
+                pOut
+            );
+        }
+#endif
+
+        for (; idx < end; idx++, pOut += 32)
+        {
+            computeInstance(
+                m_positionX[idx], m_positionY[idx], m_positionZ[idx],
+                m_rotationX[idx], m_rotationY[idx], m_rotationZ[idx], m_rotationW[idx],
+                m_scaleX[idx], m_scaleY[idx], m_scaleZ[idx],
+                pOut
+            );
+        }
+    }
+
+    void TransformArray::gatherMatrices(uint32_t const* pIndices, size_t count, InstanceData* pInstances) const
+    {
+        size_t idx = 0;
+        float* pOut = reinterpret_cast<float*>(pInstances);
+#ifdef TRANSFORM_ARRAY_SSE
+        // Gather the components of four instances into register lanes, the batch math is the same as for ranges
+        for (; idx + BatchSize <= count; idx += BatchSize, pOut += BatchSize * 32)
+        {
+            uint32_t const i0 = pIndices[idx + 0];
+            uint32_t const i1 = pIndices[idx + 1];
+            uint32_t const i2 = pIndices[idx + 2];
+            uint32_t const i3 = pIndices[idx + 3];
+            assert(i0 < size() && i1 < size() && i2 < size() && i3 < size());
+            writeBatch(
+                _mm_setr_ps(m_positionX[i0], m_positionX[i1], m_positionX[i2], m_positionX[i3]),
+                _mm_setr_ps(m_positionY[i0], m_positionY[i1], m_positionY[i2], m_positionY[i3]),
+                _mm_setr_ps(m_positionZ[i0], m_positionZ[i1], m_positionZ[i2], m_positionZ[i3]),
+                _mm_setr_ps(m_rotationX[i0], m_rotationX[i1], m_rotationX[i2], m_rotationX[i3]),
+                _mm_setr_ps(m_rotationY[i0], m_rotationY[i1], m_rotationY[i2], m_rotationY[i3]),
+                _mm_setr_ps(m_rotationZ[i0], m_rotationZ[i1], m_rotationZ[i2], m_rotationZ[i3]),
+                _mm_setr_ps(m_rotationW[i0], m_rotationW[i1], m_rotationW[i2], m_rotationW[i3]),
+                _mm_setr_ps(m_scaleX[i0], m_scaleX[i1], m_scaleX[i2], m_scaleX[i3]),
+                _mm_setr_ps(m_scaleY[i0], m_scaleY[i1], m_scaleY[i2], m_scaleY[i3]),
+                _mm_setr_ps(m_scaleZ[i0], m_scaleZ[i1], m_scaleZ[i2], m_scaleZ[i3]),
+                pOut
+            );
+        }
+#endif
+
+        for (; idx < count; idx++, pOut += 32)
+        {
+            uint32_t const instanceIdx = pIndices[idx];
+            assert(instanceIdx < size());
+            computeInstance(
+                m_positionX[instanceIdx], m_positionY[instanceIdx], m_positionZ[instanceIdx],
+                m_rotationX[instanceIdx], m_rotationY[instanceIdx], m_rotationZ[instanceIdx], m_rotationW[instanceIdx],
+                m_scaleX[instanceIdx], m_scaleY[instanceIdx], m_scaleZ[instanceIdx],
+                pOut
+            );
+        }
+    }
+
+    void TransformArray::computeSpheres(size_t begin, size_t end, MeshBounds const& bounds, SphereArray& spheres) const
+    {
+        assert(begin <= end && end <= size() && end <= spheres.size());
+
+        // Rotate the scaled local center with v + 2w (q x v) + 2 q x (q x v), plain loops over the arrays vectorize
+        glm::vec3 const localCenter = bounds.sphereCenter;
+        for (size_t idx = begin; idx < end; idx++)
+        {
+            float const qx = m_rotationX[idx];
+            float const qy = m_rotationY[idx];
+            float const qz = m_rotationZ[idx];
+            float const qw = m_rotationW[idx];
+            float const sx = m_scaleX[idx];
+            float const sy = m_scaleY[idx];
+            float const sz = m_scaleZ[idx];
+            float const vx = localCenter.x * sx;
+            float const vy = localCenter.y * sy;
+            float const vz = localCenter.z * sz;
+            float const tx = 2.0F * (qy * vz - qz * vy);
+            float const ty = 2.0F * (qz * vx - qx * vz);
+            float const tz = 2.0F * (qx * vy - qy * vx);
+            spheres.centerX[idx] = m_positionX[idx] + vx + qw * tx + (qy * tz - qz * ty);
+            spheres.centerY[idx] = m_positionY[idx] + vy + qw * ty + (qz * tx - qx * tz);
+            spheres.centerZ[idx] = m_positionZ[idx] + vz + qw * tz + (qx * ty - qy * tx);
+
+            float const maxScale = std::max(std::abs(sx), std::max(std::abs(sy), std::abs(sz)));
+            spheres.radius[idx] = bounds.sphereRadius * maxScale;
+        }
+    }
+
+    size_t TransformArray::updateMovedSpheres(size_t begin, size_t end, MeshBounds const& bounds, SphereArray& spheres, uint32_t* pMoved)
+    {
+        assert(begin <= end && end <= size());
+        size_t movedCount = 0;
+        for (size_t idx = begin; idx < end; idx++)
+        {
+            if (m_moved[idx] != 0)
+            {
+                m_moved[idx] = 0;
+                pMoved[movedCount++] = static_cast<uint32_t>(idx);
+            }
+        }
+
+        // Fully moved ranges keep the vectorized loop
+        if (movedCount == end - begin) {
+            computeSpheres(begin, end, bounds, spheres);
+        }
+        else
+        {
+            for (size_t movedIdx = 0; movedIdx < movedCount; movedIdx++) {
+                computeSpheres(pMoved[movedIdx], pMoved[movedIdx] + 1, bounds, spheres);
+            }
+        }
+
+        return movedCount;
+    }
+
+    uint32_t TransformArray::nearest(glm::vec3 const& point) const
+    {
+        uint32_t nearestIdx = InvalidIndex;
+        float nearestDistance = std::numeric_limits<float>::max();
+        for (uint32_t idx = 0; idx < size(); idx++)
+        {
+            float const dx = m_positionX[idx] - point.x;
+            float const dy = m_positionY[idx] - point.y;
+            float const dz = m_positionZ[idx] - point.z;
+            float const distance = dx * dx + dy * dy + dz * dz;
+            if (distance < nearestDistance)
+            {
+                nearestDistance = distance;
+                nearestIdx = idx;
+            }
+        }
+
+        return nearestIdx;
+    }
+
+    InstanceData TransformArray::instanceData(Transform const& transform)
+    {
+        InstanceData instance{};
+        instance.model = transform.matrix();
+        instance.normal = glm::mat4(glm::inverse(glm::transpose(glm::mat3(instance.model))));
+        return instance;
+    }
+} // namespace Engine
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "culling.hpp"
+#include "math.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+
+namespace Engine
+{
+    /// @brief Per instance shader data, indexed by SV_InstanceID. Column major like the scene constants.
+    struct InstanceData
+    {
+        glm::mat4 model;
+        glm::mat4 normal;   //< inverse transpose of the model rotation & scale
+    };
+
+    static_assert(sizeof(InstanceData) == 32 * sizeof(float), "instance data must match the shader's structured buffer stride");
+
+    /// @brief TRS transforms in structure of arrays layout, every component in its own array so a batch of instances loads
+    /// with one vector load per component. Matrices are generated in batches of BatchSize instances with SSE. Instances are
+    /// flagged as moved by set, resize & rotate until their spheres are updated, so static instances skip bounds updates.
+    class TransformArray
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+        static constexpr size_t BatchSize = 4;
+
+        uint32_t add(Transform const& transform);
+
+        void set(uint32_t index, Transform const& transform);
+
+        Transform get(uint32_t index) const;
+
+        /// @brief New instances get the identity transform.
+        void resize(uint32_t count);
+
+        void clear() { resize(0); }
+
+        uint32_t size() const { return static_cast<uint32_t>(m_positionX.size()); }
+
+        /// @brief Post multiply the rotations of [begin, end) with the rotation, spinning each instance around its local axes.
+        /// Results are renormalized, so spinning every frame doesn't drift from unit quaternions.
+        void rotate(size_t begin, size_t end, glm::quat const& rotation);
+
+        /// @brief Write the matrices of [begin, end) to pInstances[0, end - begin). Each instance is written in order & never
+        /// read, so pInstances may point to write combined upload memory.
+        void computeMatrices(size_t begin, size_t end, InstanceData* pInstances) const;
+
+        /// @brief Write the matrices of the indexed instances to pInstances[0, count), e.g. the visible instances after culling.
+        void gatherMatrices(uint32_t const* pIndices, size_t count, InstanceData* pInstances) const;
+
+        /// @brief World space bounding spheres of [begin, end) from the mesh's object space sphere, written at the same indices.
+        void computeSpheres(size_t begin, size_t end, MeshBounds const& bounds, SphereArray& spheres) const;
+
+        /// @brief Recompute the spheres of the moved instances in [begin, end) & clear their flags. Writes their indices to
+        /// pMoved[0, count) in order & returns the count. Disjoint ranges may be updated concurrently.
+        size_t updateMovedSpheres(size_t begin, size_t end, MeshBounds const& bounds, SphereArray& spheres, uint32_t* pMoved);
+
+        bool moved(uint32_t index) const { return m_moved[index] != 0; }
+
+        /// @brief Index of the instance closest to the point, InvalidIndex if empty.
+        uint32_t nearest(glm::vec3 const& point) const;
+
+        /// @brief Matrices of a single transform, the reference the batches are checked against.
+        static InstanceData instanceData(Transform const& transform);
+
+    private:
+        std::vector<float> m_positionX;
+        std::vector<float> m_positionY;
+        std::vector<float> m_positionZ;
+        std::vector<float> m_rotationX;
+        std::vector<float> m_rotationY;
+        std::vector<float> m_rotationZ;
+        std::vector<float> m_rotationW;
+        std::vector<float> m_scaleX;
+        std::vector<float> m_scaleY;
+        std::vector<float> m_scaleZ;
+        std::vector<uint8_t> m_moved;   //< bytes, so concurrent ranges never share a flag's storage
+    };
+} // namespace Engine
@@ -0,0 +1,405 @@
+#include "triangle_bvh.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRIANGLE_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Engine
+{
+    static BoundingBox merge(BoundingBox const& a, BoundingBox const& b)
+    {
+        return BoundingBox{
+            glm::vec3(std::min(a.aabbMin.x, b.aabbMin.x), std::min(a.aabbMin.y, b.aabbMin.y), std::min(a.aabbMin.z, b.aabbMin.z)),
+            glm::vec3(std::max(a.aabbMax.x, b.aabbMax.x), std::max(a.aabbMax.y, b.aabbMax.y), std::max(a.aabbMax.z, b.aabbMax.z))
+        };
+    }
+
+    static float surfaceArea(BoundingBox const& bounds)
+    {
+        // Empty boxes have negative extents
+        float const extentX = std::max(bounds.aabbMax.x - bounds.aabbMin.x, 0.0F);
+        float const extentY = std::max(bounds.aabbMax.y - bounds.aabbMin.y, 0.0F);
+        float const extentZ = std::max(bounds.aabbMax.z - bounds.aabbMin.z, 0.0F);
+        return 2.0F * (extentX * extentY + extentY * extentZ + extentZ * extentX);
+    }
+
+    void TriangleBvh::build(Vertex const* pVertices, size_t vertexCount, uint32_t const* pIndices, size_t indexCount)
+    {
+        static constexpr uint32_t BinCount = 16;
+        static constexpr float TraversalCost = 1.0F;   //< relative to one triangle test
+
+        struct Item
+        {
+            BoundingBox bounds;
+            glm::vec3 centroid;
+            uint32_t triangle;
+        };
+
+        struct Task
+        {
+            size_t begin;
+            size_t end;
+            uint32_t nodeIdx;
+            uint32_t slot;
+            uint32_t depth;
+        };
+
+        struct Bin
+        {
+            BoundingBox bounds;
+            uint32_t count;
+        };
+
+        m_nodes.clear();
+        m_triangles.clear();
+        m_triangleIds.clear();
+        m_depth = 0;
+
+        size_t const triangleCount = indexCount / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        std::vector<Item> items(triangleCount);
+        for (size_t triangleIdx = 0; triangleIdx < triangleCount; triangleIdx++)
+        {
+            assert(pIndices[triangleIdx * 3 + 0] < vertexCount && pIndices[triangleIdx * 3 + 1] < vertexCount && pIndices[triangleIdx * 3 + 2] < vertexCount);
+            glm::vec3 const& p0 = pVertices[pIndices[triangleIdx * 3 + 0]].position;
+            glm::vec3 const& p1 = pVertices[pIndices[triangleIdx * 3 + 1]].position;
+            glm::vec3 const& p2 = pVertices[pIndices[triangleIdx * 3 + 2]].position;
+            BoundingBox const bounds = merge(merge(BoundingBox{ p0, p0 }, BoundingBox{ p1, p1 }), BoundingBox{ p2, p2 });
+            items[triangleIdx] = Item{ bounds, (bounds.aabbMin + bounds.aabbMax) * 0.5F, static_cast<uint32_t>(triangleIdx) };
+        }
+
+        BoundingBox const emptyBox{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()) };
+        auto const setSlot = [this](uint32_t nodeIdx, uint32_t slot, BoundingBox const& bounds, uint32_t child, uint32_t count)
+        {
+            Node& node = m_nodes[nodeIdx];
+            node.boundsX[slot] = bounds.aabbMin.x;
+            node.boundsY[slot] = bounds.aabbMin.y;
+            node.boundsZ[slot] = bounds.aabbMin.z;
+            node.boundsX[slot + 2] = bounds.aabbMax.x;
+            node.boundsY[slot + 2] = bounds.aabbMax.y;
+            node.boundsZ[slot + 2] = bounds.aabbMax.z;
+            node.children[slot] = child;
+            node.counts[slot] = count;
+        };
+        auto const addNode = [this, &setSlot, &emptyBox]()
+        {
+            m_nodes.emplace_back();
+            uint32_t const nodeIdx = static_cast<uint32_t>(m_nodes.size() - 1);
+            setSlot(nodeIdx, 0, emptyBox, InvalidIndex, 0);
+            setSlot(nodeIdx, 1, emptyBox, InvalidIndex, 0);
+            return nodeIdx;
+        };
+
+        // Splits [begin, end) by binned SAH over the centroids & returns the middle, or end if a leaf is cheaper. Deep ranges &
+        // coincident centroids split at the median so the depth stays bounded.
+        auto const split = [&](size_t begin, size_t end, BoundingBox const& bounds, BoundingBox const& centroidBounds, bool allowLeaf, bool forceMedian) -> size_t
+        {
+            size_t const count = end - begin;
+            glm::vec3 const centroidExtent = centroidBounds.aabbMax - centroidBounds.aabbMin;
+            int const widestAxis = (centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z) ? 0 : ((centroidExtent.y >= centroidExtent.z) ? 1 : 2);
+            auto const medianSplit = [&]()
+            {
+                size_t const middle = begin + count / 2;
+                std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end, [widestAxis](Item const& a, Item const& b) { return a.centroid[widestAxis] < b.centroid[widestAxis]; });
+                return middle;
+            };
+
+            if (forceMedian || !(centroidExtent[widestAxis] > 0.0F)) {
+                return (allowLeaf && count <= MaxLeafTriangles) ? end : medianSplit();
+            }
+
+            glm::vec3 const binScale = glm::vec3(
+                centroidExtent.x > 0.0F ? BinCount / centroidExtent.x : 0.0F,
+                centroidExtent.y > 0.0F ? BinCount / centroidExtent.y : 0.0F,
+                centroidExtent.z > 0.0F ? BinCount / centroidExtent.z : 0.0F
+            );
+            auto const binIndex = [&centroidBounds, &binScale](glm::vec3 const& centroid, int axis)
+            {
+                return std::min(BinCount - 1, static_cast<uint32_t>((centroid[axis] - centroidBounds.aabbMin[axis]) * binScale[axis]));
+            };
+
+            Bin bins[3][BinCount];
+            for (auto& axisBins : bins) {
+                std::fill(std::begin(axisBins), std::end(axisBins), Bin{ emptyBox, 0 });
+            }
+            for (size_t itemIdx = begin; itemIdx < end; itemIdx++)
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Bin& bin = bins[axis][binIndex(items[itemIdx].centroid, axis)];
+                    bin.bounds = merge(bin.bounds, items[itemIdx].bounds);
+                    bin.count++;
+                }
+            }
+
+            float bestCost = std::numeric_limits<float>::max();
+            int bestAxis = -1;
+            uint32_t bestSplit = 0;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                // Right sides are swept first, a split at s puts bins [0, s) on the left
+                float rightCosts[BinCount]{};
+                BoundingBox rightBounds = emptyBox;
+                uint32_t rightCount = 0;
+                for (uint32_t binIdx = BinCount - 1; binIdx > 0; binIdx--)
+                {
+                    rightBounds = merge(rightBounds, bins[axis][binIdx].bounds);
+                    rightCount += bins[axis][binIdx].count;
+                    rightCosts[binIdx] = surfaceArea(rightBounds) * static_cast<float>(rightCount);
+                }
+
+                BoundingBox leftBounds = emptyBox;
+                uint32_t leftCount = 0;
+                for (uint32_t binIdx = 1; binIdx < BinCount; binIdx++)
+                {
+                    leftBounds = merge(leftBounds, bins[axis][binIdx - 1].bounds);
+                    leftCount += bins[axis][binIdx - 1].count;
+                    if (leftCount == 0 || leftCount == count) {
+                        continue;
+                    }
+
+                    float const cost = surfaceArea(leftBounds) * static_cast<float>(leftCount) + rightCosts[binIdx];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = binIdx;
+                    }
+                }
+            }
+
+            // A leaf costs its triangles, a split one traversal step plus its children weighted by their share of the area
+            float const area = surfaceArea(bounds);
+            if (allowLeaf && count <= MaxLeafTriangles && (bestAxis < 0 || area <= 0.0F || static_cast<float>(count) <= TraversalCost + bestCost / area)) {
+                return end;
+            }
+
+            if (bestAxis < 0) {
+                return medianSplit();
+            }
+
+            auto const middle = std::partition(items.begin() + begin, items.begin() + end, [&](Item const& item) { return binIndex(item.centroid, bestAxis) < bestSplit; });
+            return static_cast<size_t>(middle - items.begin());
+        };
+
+        auto const rangeBounds = [&items, &emptyBox](size_t begin, size_t end, BoundingBox& bounds, BoundingBox& centroidBounds)
+        {
+            bounds = emptyBox;
+            centroidBounds = emptyBox;
+            for (size_t itemIdx = begin; itemIdx < end; itemIdx++)
+            {
+                bounds = merge(bounds, items[itemIdx].bounds);
+                centroidBounds = merge(centroidBounds, BoundingBox{ items[itemIdx].centroid, items[itemIdx].centroid });
+            }
+        };
+
+        // The root always splits, a mesh of a single triangle leaves its second slot empty
+        m_nodes.reserve(2 * triangleCount / MaxLeafTriangles + 1);
+        uint32_t const rootIdx = addNode();
+        BoundingBox bounds{};
+        BoundingBox centroidBounds{};
+        rangeBounds(0, triangleCount, bounds, centroidBounds);
+        std::vector<Task> stack;
+        if (triangleCount == 1) {
+            stack.push_back(Task{ 0, 1, rootIdx, 0, 1 });
+        }
+        else
+        {
+            size_t const middle = split(0, triangleCount, bounds, centroidBounds, false, false);
+            stack.push_back(Task{ middle, triangleCount, rootIdx, 1, 1 });
+            stack.push_back(Task{ 0, middle, rootIdx, 0, 1 });
+        }
+
+        // Depth first with the left range on top, so every node's first child subtree follows it in the array
+        while (!stack.empty())
+        {
+            Task const task = stack.back();
+            stack.pop_back();
+            m_depth = std::max(m_depth, task.depth);
+
+            rangeBounds(task.begin, task.end, bounds, centroidBounds);
+            size_t const middle = split(task.begin, task.end, bounds, centroidBounds, true, task.depth >= MaxDepth / 2);
+            if (middle == task.end)
+            {
+                setSlot(task.nodeIdx, task.slot, bounds, static_cast<uint32_t>(task.begin), static_cast<uint32_t>(task.end - task.begin));
+                continue;
+            }
+
+            uint32_t const nodeIdx = addNode();
+            setSlot(task.nodeIdx, task.slot, bounds, nodeIdx, 0);
+            stack.push_back(Task{ middle, task.end, nodeIdx, 1, task.depth + 1 });
+            stack.push_back(Task{ task.begin, middle, nodeIdx, 0, task.depth + 1 });
+        }
+
+        m_triangles.resize(triangleCount * 3);
+        m_triangleIds.resize(triangleCount);
+        for (size_t triangleIdx = 0; triangleIdx < triangleCount; triangleIdx++)
+        {
+            uint32_t const meshTriangle = items[triangleIdx].triangle;
+            glm::vec3 const& p0 = pVertices[pIndices[meshTriangle * 3 + 0]].position;
+            glm::vec3 const& p1 = pVertices[pIndices[meshTriangle * 3 + 1]].position;
+            glm::vec3 const& p2 = pVertices[pIndices[meshTriangle * 3 + 2]].position;
+            m_triangles[triangleIdx * 3 + 0] = p0;
+            m_triangles[triangleIdx * 3 + 1] = p1 - p0;
+            m_triangles[triangleIdx * 3 + 2] = p2 - p0;
+            m_triangleIds[triangleIdx] = meshTriangle;
+        }
+    }
+
+    bool TriangleBvh::intersect(Ray const& ray, float maxDistance, TriangleHit& hit) const
+    {
+        hit = TriangleHit{ InvalidIndex, maxDistance, glm::vec2(0.0F), glm::vec3(0.0F) };
+        if (m_nodes.empty()) {
+            return false;
+        }
+
+        // Zero direction components divide to infinities, the slabs of those axes then span everything or nothing
+        glm::vec3 const inverseDirection = glm::vec3(1.0F) / ray.direction;
+#if defined(TRIANGLE_BVH_SSE)
+        __m128 const originX = _mm_set1_ps(ray.origin.x);
+        __m128 const originY = _mm_set1_ps(ray.origin.y);
+        __m128 const originZ = _mm_set1_ps(ray.origin.z);
+        __m128 const inverseX = _mm_set1_ps(inverseDirection.x);
+        __m128 const inverseY = _mm_set1_ps(inverseDirection.y);
+        __m128 const inverseZ = _mm_set1_ps(inverseDirection.z);
+#endif
+
+        uint32_t stack[MaxDepth + 2];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            Node const& node = m_nodes[stack[--stackSize]];
+
+            // Slab distances of both children at once, lanes hold [min0, min1, max0, max1] & the halves swap to order them
+            alignas(16) float entries[4];
+            uint32_t hitMask = 0;
+#if defined(TRIANGLE_BVH_SSE)
+            __m128 const tX = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.boundsX), originX), inverseX);
+            __m128 const tY = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.boundsY), originY), inverseY);
+            __m128 const tZ = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.boundsZ), originZ), inverseZ);
+            __m128 const swappedX = _mm_shuffle_ps(tX, tX, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128 const swappedY = _mm_shuffle_ps(tY, tY, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128 const swappedZ = _mm_shuffle_ps(tZ, tZ, _MM_SHUFFLE(1, 0, 3, 2));
+            __m128 const entry = _mm_max_ps(_mm_max_ps(_mm_min_ps(tX, swappedX), _mm_min_ps(tY, swappedY)), _mm_max_ps(_mm_min_ps(tZ, swappedZ), _mm_setzero_ps()));
+            __m128 const exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(tX, swappedX), _mm_max_ps(tY, swappedY)), _mm_min_ps(_mm_max_ps(tZ, swappedZ), _mm_set1_ps(hit.distance)));
+            _mm_store_ps(entries, entry);
+            hitMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(entry, exit))) & 3;
+#else
+            for (uint32_t slot = 0; slot < 2; slot++)
+            {
+                float const tX0 = (node.boundsX[slot] - ray.origin.x) * inverseDirection.x;
+                float const tX1 = (node.boundsX[slot + 2] - ray.origin.x) * inverseDirection.x;
+                float const tY0 = (node.boundsY[slot] - ray.origin.y) * inverseDirection.y;
+                float const tY1 = (node.boundsY[slot + 2] - ray.origin.y) * inverseDirection.y;
+                float const tZ0 = (node.boundsZ[slot] - ray.origin.z) * inverseDirection.z;
+                float const tZ1 = (node.boundsZ[slot + 2] - ray.origin.z) * inverseDirection.z;
+                float const entry = std::max(std::max(std::min(tX0, tX1), std::min(tY0, tY1)), std::max(std::min(tZ0, tZ1), 0.0F));
+                float const exit = std::min(std::min(std::max(tX0, tX1), std::max(tY0, tY1)), std::min(std::max(tZ0, tZ1), hit.distance));
+                entries[slot] = entry;
+                hitMask |= (entry <= exit) ? (1U << slot) : 0;
+            }
+#endif
+
+            // Leaves are tested right away, nearest first, & node children pushed so the nearer one is visited next
+            uint32_t const first = (hitMask == 3 && entries[1] < entries[0]) ? 1 : 0;
+            uint32_t pushed[2];
+            uint32_t pushedCount = 0;
+            for (uint32_t order = 0; order < 2; order++)
+            {
+                uint32_t const slot = first ^ order;
+                if ((hitMask & (1U << slot)) == 0 || node.children[slot] == InvalidIndex) {
+                    continue;
+                }
+
+                if (node.counts[slot] == 0) {
+                    pushed[pushedCount++] = node.children[slot];
+                }
+                else
+                {
+                    for (uint32_t triangleIdx = node.children[slot]; triangleIdx < node.children[slot] + node.counts[slot]; triangleIdx++) {
+                        intersectTriangle(ray, triangleIdx, hit);
+                    }
+                }
+            }
+
+            while (pushedCount > 0) {
+                stack[stackSize++] = pushed[--pushedCount];
+            }
+        }
+
+        if (hit.triangle == InvalidIndex) {
+            return false;
+        }
+
+        // Hits are found in leaf order, the position is taken from the triangle so it lies on its plane
+        uint32_t const triangleIdx = hit.triangle;
+        hit.triangle = m_triangleIds[triangleIdx];
+        hit.position = m_triangles[triangleIdx * 3] + m_triangles[triangleIdx * 3 + 1] * hit.barycentrics.x + m_triangles[triangleIdx * 3 + 2] * hit.barycentrics.y;
+        return true;
+    }
+
+    bool TriangleBvh::intersectBruteForce(Ray const& ray, float maxDistance, TriangleHit& hit) const
+    {
+        hit = TriangleHit{ InvalidIndex, maxDistance, glm::vec2(0.0F), glm::vec3(0.0F) };
+        for (uint32_t triangleIdx = 0; triangleIdx < m_triangleIds.size(); triangleIdx++) {
+            intersectTriangle(ray, triangleIdx, hit);
+        }
+
+        if (hit.triangle == InvalidIndex) {
+            return false;
+        }
+
+        uint32_t const triangleIdx = hit.triangle;
+        hit.triangle = m_triangleIds[triangleIdx];
+        hit.position = m_triangles[triangleIdx * 3] + m_triangles[triangleIdx * 3 + 1] * hit.barycentrics.x + m_triangles[triangleIdx * 3 + 2] * hit.barycentrics.y;
+        return true;
+    }
+
+    bool TriangleBvh::intersectTriangle(Ray const& ray, uint32_t triangleIdx, TriangleHit& hit) const
+    {
+        glm::vec3 const& vertex = m_triangles[triangleIdx * 3];
+        glm::vec3 const& edge1 = m_triangles[triangleIdx * 3 + 1];
+        glm::vec3 const& edge2 = m_triangles[triangleIdx * 3 + 2];
+
+        // Both sides are hit, degenerate triangles & rays in the triangle's plane are not
+        glm::vec3 const p = glm::cross(ray.direction, edge2);
+        float const determinant = glm::dot(edge1, p);
+        if (determinant == 0.0F) {
+            return false;
+        }
+
+        float const inverseDeterminant = 1.0F / determinant;
+        glm::vec3 const offset = ray.origin - vertex;
+        float const u = glm::dot(offset, p) * inverseDeterminant;
+        if (u < 0.0F || u > 1.0F) {
+            return false;
+        }
+
+        glm::vec3 const q = glm::cross(offset, edge1);
+        float const v = glm::dot(ray.direction, q) * inverseDeterminant;
+        if (v < 0.0F || u + v > 1.0F) {
+            return false;
+        }
+
+        float const distance = glm::dot(edge2, q) * inverseDeterminant;
+        if (distance < 0.0F || distance >= hit.distance) {
+            return false;
+        }
+
+        // The triangle is in leaf order until the query finishes
+        hit.triangle = triangleIdx;
+        hit.distance = distance;
+        hit.barycentrics = glm::vec2(u, v);
+        return true;
+    }
+} // namespace Engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "culling.hpp"
+#include "math.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+
+namespace Engine
+{
+    /// @brief Closest triangle along a ray, the position is v0 + (v1 - v0) * u + (v2 - v0) * v for barycentrics (u, v).
+    struct TriangleHit
+    {
+        uint32_t triangle;          //< index into the mesh's triangles, first index at triangle * 3
+        float distance;             //< in units of the ray direction's length
+        glm::vec2 barycentrics;
+        glm::vec3 position;
+    };
+
+    /// @brief Bounding volume hierarchy over the triangles of a mesh for ray queries, built with binned SAH & flattened in depth
+    /// first order. Each node holds the bounds of both children in one cache line so a ray tests them with a single set of SSE
+    /// slab operations. Triangles are copied in leaf order as a vertex & two edges.
+    class TriangleBvh
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+        static constexpr uint32_t MaxLeafTriangles = 8;
+
+        void build(Vertex const* pVertices, size_t vertexCount, uint32_t const* pIndices, size_t indexCount);
+
+        /// @brief Closest hit within maxDistance. The direction needn't be normalized, e.g. a world ray taken into object space
+        /// with the inverse model matrix keeps its world space distances.
+        bool intersect(Ray const& ray, float maxDistance, TriangleHit& hit) const;
+
+        /// @brief Every triangle tested in turn, the reference for intersect.
+        bool intersectBruteForce(Ray const& ray, float maxDistance, TriangleHit& hit) const;
+
+        uint32_t triangleCount() const { return static_cast<uint32_t>(m_triangleIds.size()); }
+
+        uint32_t nodeCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+        /// @brief Maximum node depth, traversal keeps a fixed size stack of this many entries.
+        uint32_t depth() const { return m_depth; }
+
+    private:
+        static constexpr uint32_t MaxDepth = 64;
+
+        /// @brief Child slot i is a node if counts[i] is zero, otherwise a leaf of counts[i] triangles from children[i].
+        /// Bounds are the children's min & max per axis, [min0, min1, max0, max1] as loaded by the slab test.
+        struct alignas(64) Node
+        {
+            float boundsX[4];
+            float boundsY[4];
+            float boundsZ[4];
+            uint32_t children[2];
+            uint32_t counts[2];
+        };
+
+        static_assert(sizeof(Node) == 64, "nodes must fill exactly one cache line");
+
+        /// @brief Möller-Trumbore test against the triangle in leaf order, updates the hit if closer.
+        bool intersectTriangle(Ray const& ray, uint32_t triangleIdx, TriangleHit& hit) const;
+
+        std::vector<Node> m_nodes;
+        std::vector<glm::vec3> m_triangles;     //< v0, v1 - v0 & v2 - v0 per triangle in leaf order
+        std::vector<uint32_t> m_triangleIds;    //< mesh triangle of each triangle in leaf order
+        uint32_t m_depth = 0;
+    };
+} // namespace Engine
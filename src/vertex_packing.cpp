@@ -0,0 +1,273 @@
+#include "vertex_packing.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace Engine
+{
+    namespace VertexPacking
+    {
+        static uint16_t quantizeUnorm16(float value)
+        {
+            return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 65535.0F));
+        }
+
+        static int16_t quantizeSnorm16(float value)
+        {
+            return static_cast<int16_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * 32767.0F));
+        }
+
+        static uint8_t quantizeUnorm8(float value)
+        {
+            return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 255.0F));
+        }
+
+        static float angleDegrees(glm::vec3 const& a, glm::vec3 const& b)
+        {
+            // atan2 stays accurate for tiny angles, unlike acos of the dot product
+            return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+        }
+
+        uint16_t floatToHalf(float value)
+        {
+            uint32_t bits = 0;
+            memcpy(&bits, &value, sizeof(bits));
+
+            uint32_t const sign = (bits >> 16) & 0x8000;
+            uint32_t const exponent = (bits >> 23) & 0xFF;
+            uint32_t mantissa = bits & 0x007FFFFF;
+
+            if (exponent == 0xFF) { //< inf or nan
+                return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x0200 : 0));
+            }
+
+            int32_t const halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+            if (halfExponent >= 0x1F) { //< overflow to inf
+                return static_cast<uint16_t>(sign | 0x7C00);
+            }
+
+            if (halfExponent <= 0)
+            {
+                // Subnormal or zero, shift in the implicit bit and round to nearest even
+                if (halfExponent < -10) {
+                    return static_cast<uint16_t>(sign);
+                }
+
+                mantissa |= 0x00800000;
+                uint32_t const shift = static_cast<uint32_t>(14 - halfExponent);
+                uint32_t halfMantissa = mantissa >> shift;
+                uint32_t const remainder = mantissa & ((1U << shift) - 1);
+                uint32_t const halfway = 1U << (shift - 1);
+                if (remainder > halfway || (remainder == halfway && (halfMantissa & 1) != 0)) {
+                    halfMantissa++;
+                }
+
+                return static_cast<uint16_t>(sign | halfMantissa);
+            }
+
+            // Normal, round to nearest even (mantissa carry correctly bumps the exponent)
+            uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+            uint32_t const remainder = mantissa & 0x1FFF;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1) != 0)) {
+                half++;
+            }
+
+            return static_cast<uint16_t>(half);
+        }
+
+        float halfToFloat(uint16_t value)
+        {
+            uint32_t const sign = static_cast<uint32_t>(value & 0x8000) << 16;
+            uint32_t exponent = (value >> 10) & 0x1F;
+            uint32_t mantissa = value & 0x03FF;
+
+            uint32_t bits = 0;
+            if (exponent == 0x1F)
+            {
+                bits = sign | 0x7F800000 | (mantissa << 13);
+            }
+            else if (exponent == 0)
+            {
+                if (mantissa == 0)
+                {
+                    bits = sign;
+                }
+                else
+                {
+                    // Normalize subnormal
+                    exponent = 127 - 15 + 1;
+                    while ((mantissa & 0x0400) == 0)
+                    {
+                        mantissa <<= 1;
+                        exponent--;
+                    }
+
+                    bits = sign | (exponent << 23) | ((mantissa & 0x03FF) << 13);
+                }
+            }
+            else
+            {
+                bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+            }
+
+            float result = 0.0F;
+            memcpy(&result, &bits, sizeof(result));
+            return result;
+        }
+
+        glm::vec2 octEncode(glm::vec3 const& direction)
+        {
+            float const l1Norm = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+            if (l1Norm <= 0.0F) {
+                return glm::vec2(0.0F);
+            }
+
+            glm::vec2 encoded = glm::vec2(direction.x, direction.y) / l1Norm;
+            if (direction.z < 0.0F)
+            {
+                // Fold lower hemisphere over the diagonals
+                glm::vec2 const folded = glm::vec2(1.0F - std::abs(encoded.y), 1.0F - std::abs(encoded.x));
+                encoded.x = (encoded.x >= 0.0F) ? folded.x : -folded.x;
+                encoded.y = (encoded.y >= 0.0F) ? folded.y : -folded.y;
+            }
+
+            return encoded;
+        }
+
+        glm::vec3 octDecode(glm::vec2 const& encoded)
+        {
+            glm::vec3 direction = glm::vec3(encoded.x, encoded.y, 1.0F - std::abs(encoded.x) - std::abs(encoded.y));
+            float const t = std::max(-direction.z, 0.0F);
+            direction.x += (direction.x >= 0.0F) ? -t : t;
+            direction.y += (direction.y >= 0.0F) ? -t : t;
+            return glm::normalize(direction);
+        }
+
+        QuantizationBounds computeBounds(Vertex const* pVertices, size_t vertexCount)
+        {
+            QuantizationBounds bounds{};
+            if (vertexCount == 0) {
+                return bounds;
+            }
+
+            glm::vec3 minimum = pVertices[0].position;
+            glm::vec3 maximum = pVertices[0].position;
+            for (size_t vertexIdx = 1; vertexIdx < vertexCount; vertexIdx++)
+            {
+                minimum = glm::min(minimum, pVertices[vertexIdx].position);
+                maximum = glm::max(maximum, pVertices[vertexIdx].position);
+            }
+
+            bounds.min = minimum;
+            bounds.extent = maximum - minimum;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (bounds.extent[axis] <= 0.0F) {
+                    bounds.extent[axis] = 1.0F; //< flat axis, avoid division by zero
+                }
+            }
+
+            return bounds;
+        }
+
+        PackedVertex encode(Vertex const& vertex, QuantizationBounds const& bounds)
+        {
+            glm::vec3 const relativePosition = (vertex.position - bounds.min) / bounds.extent;
+            glm::vec2 const normal = octEncode(vertex.normal);
+            glm::vec2 const tangent = octEncode(glm::vec3(vertex.tangent));
+
+            PackedVertex packedVertex{};
+            packedVertex.position[0] = quantizeUnorm16(relativePosition.x);
+            packedVertex.position[1] = quantizeUnorm16(relativePosition.y);
+            packedVertex.position[2] = quantizeUnorm16(relativePosition.z);
+            packedVertex.position[3] = (vertex.tangent.w < 0.0F) ? 0 : UINT16_MAX; //< tangent handedness
+            packedVertex.color[0] = quantizeUnorm8(vertex.color.x);
+            packedVertex.color[1] = quantizeUnorm8(vertex.color.y);
+            packedVertex.color[2] = quantizeUnorm8(vertex.color.z);
+            packedVertex.color[3] = UINT8_MAX;
+            packedVertex.normal[0] = quantizeSnorm16(normal.x);
+            packedVertex.normal[1] = quantizeSnorm16(normal.y);
+            packedVertex.tangent[0] = quantizeSnorm16(tangent.x);
+            packedVertex.tangent[1] = quantizeSnorm16(tangent.y);
+            packedVertex.texCoord[0] = floatToHalf(vertex.texCoord.x);
+            packedVertex.texCoord[1] = floatToHalf(vertex.texCoord.y);
+            return packedVertex;
+        }
+
+        Vertex decode(PackedVertex const& packedVertex, QuantizationBounds const& bounds)
+        {
+            glm::vec3 const relativePosition = glm::vec3(
+                static_cast<float>(packedVertex.position[0]),
+                static_cast<float>(packedVertex.position[1]),
+                static_cast<float>(packedVertex.position[2])
+            ) / 65535.0F;
+
+            // Matches D3D snorm conversion, both -32768 and -32767 map to -1.0
+            glm::vec2 const normal = glm::max(glm::vec2(packedVertex.normal[0], packedVertex.normal[1]) / 32767.0F, glm::vec2(-1.0F));
+            glm::vec2 const tangent = glm::max(glm::vec2(packedVertex.tangent[0], packedVertex.tangent[1]) / 32767.0F, glm::vec2(-1.0F));
+
+            Vertex vertex{};
+            vertex.position = bounds.min + relativePosition * bounds.extent;
+            vertex.color = glm::vec3(packedVertex.color[0], packedVertex.color[1], packedVertex.color[2]) / 255.0F;
+            vertex.normal = octDecode(normal);
+            vertex.tangent = glm::vec4(octDecode(tangent), (packedVertex.position[3] != 0) ? 1.0F : -1.0F);
+            vertex.texCoord = glm::vec2(halfToFloat(packedVertex.texCoord[0]), halfToFloat(packedVertex.texCoord[1]));
+            return vertex;
+        }
+
+        void packVertices(Vertex const* pVertices, size_t vertexCount, QuantizationBounds const& bounds, PackedVertex* pPackedVertices)
+        {
+            assert(pVertices != nullptr);
+            assert(pPackedVertices != nullptr);
+
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++) {
+                pPackedVertices[vertexIdx] = encode(pVertices[vertexIdx], bounds);
+            }
+        }
+
+        PackingError measureError(Vertex const* pVertices, size_t vertexCount, QuantizationBounds const& bounds)
+        {
+            PackingError error{};
+            for (size_t vertexIdx = 0; vertexIdx < vertexCount; vertexIdx++)
+            {
+                Vertex const& vertex = pVertices[vertexIdx];
+                Vertex const decoded = decode(encode(vertex, bounds), bounds);
+
+                glm::vec3 const positionDelta = glm::abs(decoded.position - vertex.position);
+                glm::vec3 const colorDelta = glm::abs(decoded.color - glm::clamp(vertex.color, 0.0F, 1.0F));
+                glm::vec2 const texCoordDelta = glm::abs(decoded.texCoord - vertex.texCoord);
+
+                error.position = std::max(error.position, std::max(positionDelta.x, std::max(positionDelta.y, positionDelta.z)));
+                error.color = std::max(error.color, std::max(colorDelta.x, std::max(colorDelta.y, colorDelta.z)));
+                error.texCoord = std::max(error.texCoord, std::max(texCoordDelta.x, texCoordDelta.y));
+                error.normalDegrees = std::max(error.normalDegrees, angleDegrees(vertex.normal, decoded.normal));
+                float const tangentDegrees = ((vertex.tangent.w < 0.0F) == (decoded.tangent.w < 0.0F)) ? angleDegrees(glm::vec3(vertex.tangent), glm::vec3(decoded.tangent)) : 180.0F;
+                error.tangentDegrees = std::max(error.tangentDegrees, tangentDegrees);
+            }
+
+            return error;
+        }
+
+        IndexFormat indexFormat(size_t vertexCount)
+        {
+            return (vertexCount <= UINT16_MAX) ? IndexFormat::R16_UINT : IndexFormat::R32_UINT;
+        }
+
+        PackingError errorBounds(QuantizationBounds const& bounds, float maxTexCoord)
+        {
+            // Half a quantization step for unorm values, half a ulp for half floats (11 bit significand)
+            float const maxExtent = std::max(bounds.extent.x, std::max(bounds.extent.y, bounds.extent.z));
+            float const halfUlpScale = std::exp2(std::floor(std::log2(std::max(maxTexCoord, 6.1035156e-05F)))) / 2048.0F;
+
+            PackingError error{};
+            error.position = 0.5F * maxExtent / 65535.0F + 1e-6F * maxExtent;
+            error.normalDegrees = 0.01F;    //< octahedral snorm16 worst case is ~0.005 degrees
+            error.tangentDegrees = 0.01F;
+            error.texCoord = halfUlpScale + 1e-7F;
+            error.color = 0.5F / 255.0F + 1e-6F;
+            return error;
+        }
+    } // namespace VertexPacking
+} // namespace Engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "math.hpp"
+#include "mesh.hpp"
+
+namespace Engine
+{
+    /// @brief Quantized vertex data, decoded in the vertex shader.
+    struct PackedVertex
+    {
+        uint16_t position[4];   //< unorm16 relative to mesh bounds, tangent handedness in w
+        uint8_t color[4];       //< unorm8 rgb, alpha unused
+        int16_t normal[2];      //< snorm16 octahedral
+        int16_t tangent[2];     //< snorm16 octahedral
+        uint16_t texCoord[2];   //< half float
+    };
+    static_assert(sizeof(PackedVertex) == 24, "PackedVertex layout must match the packed input layout");
+
+    namespace VertexPacking
+    {
+        /// @brief Index buffer element format, mapped to DXGI_FORMAT_R16_UINT & DXGI_FORMAT_R32_UINT by the renderer.
+        enum class IndexFormat
+        {
+            R16_UINT,
+            R32_UINT,
+        };
+
+        /// @brief Mesh bounds used to quantize positions, passed to the vertex shader for decoding.
+        struct QuantizationBounds
+        {
+            glm::vec3 min = glm::vec3(0.0F);
+            glm::vec3 extent = glm::vec3(1.0F);
+        };
+
+        /// @brief Maximum round trip error per attribute.
+        struct PackingError
+        {
+            float position = 0.0F;          //< object space units
+            float normalDegrees = 0.0F;
+            float tangentDegrees = 0.0F;
+            float texCoord = 0.0F;
+            float color = 0.0F;
+        };
+
+        uint16_t floatToHalf(float value);
+
+        float halfToFloat(uint16_t value);
+
+        glm::vec2 octEncode(glm::vec3 const& direction);
+
+        glm::vec3 octDecode(glm::vec2 const& encoded);
+
+        QuantizationBounds computeBounds(Vertex const* pVertices, size_t vertexCount);
+
+        PackedVertex encode(Vertex const& vertex, QuantizationBounds const& bounds);
+
+        Vertex decode(PackedVertex const& packedVertex, QuantizationBounds const& bounds);
+
+        void packVertices(Vertex const* pVertices, size_t vertexCount, QuantizationBounds const& bounds, PackedVertex* pPackedVertices);
+
+        PackingError measureError(Vertex const* pVertices, size_t vertexCount, QuantizationBounds const& bounds);
+
+        /// @brief 16-bit indices whenever every vertex is addressable by one, halving the index buffer.
+        IndexFormat indexFormat(size_t vertexCount);
+
+        /// @brief Worst case round trip error expected from the packed encodings, given the largest texture coordinate magnitude.
+        PackingError errorBounds(QuantizationBounds const& bounds, float maxTexCoord);
+    } // namespace VertexPacking
+} // namespace Engine
@@ -0,0 +1,288 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset_loader.hpp"
+#include "block_compression.hpp"
+#include "job_system.hpp"
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "mip_generator.hpp"
+#include "obj_parser.hpp"
+#include "startup.hpp"
+#include "task_graph.hpp"
+#include "texture_import.hpp"
+#include "timer.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    bool benchmarkOBJ(char const* sourcePath)
+    {
+        constexpr uint32_t RunCount = 3;
+
+        struct Parser
+        {
+            char const* name;
+            bool (*parse)(char const*, MeshData&);
+        };
+
+        Parser const parsers[] = {
+            { "TinyOBJ", [](char const* path, MeshData& meshData) { return MeshHelpers::parseOBJTinyObj(path, meshData); } },
+            { "ObjParser", [](char const* path, MeshData& meshData) { return ObjParser::parse(path, meshData); } },
+        };
+
+        JobSystem jobs{}; //< parsing & processing split their loops over the calling thread's job system
+        MeshCache::SourceInfo sourceInfo{};
+        if (!MeshCache::querySource(sourcePath, sourceInfo, false))
+        {
+            printf("OBJ file open failed [%s]\n", sourcePath);
+            return false;
+        }
+
+        MeshData results[2]{};
+        double bestTimeMS[2]{};
+        for (size_t parserIdx = 0; parserIdx < 2; parserIdx++)
+        {
+            bestTimeMS[parserIdx] = 1e30;
+            for (uint32_t run = 0; run < RunCount; run++)
+            {
+                Timer timer{};
+                if (!parsers[parserIdx].parse(sourcePath, results[parserIdx])) {
+                    return false;
+                }
+
+                timer.tick();
+                bestTimeMS[parserIdx] = std::min(bestTimeMS[parserIdx], timer.deltaTimeMS());
+            }
+        }
+
+        // Triangulation order may differ between parsers, the surface area does not
+        double surfaceArea[2]{};
+        for (size_t parserIdx = 0; parserIdx < 2; parserIdx++)
+        {
+            MeshData const& result = results[parserIdx];
+            for (size_t i = 0; i < result.indices.size(); i += 3)
+            {
+                glm::vec3 const& p0 = result.vertices[result.indices[i + 0]].position;
+                glm::vec3 const& p1 = result.vertices[result.indices[i + 1]].position;
+                glm::vec3 const& p2 = result.vertices[result.indices[i + 2]].position;
+                surfaceArea[parserIdx] += 0.5 * static_cast<double>(glm::length(glm::cross(p1 - p0, p2 - p0)));
+            }
+        }
+
+        double const areaDifference = std::abs(surfaceArea[0] - surfaceArea[1]) / std::max(surfaceArea[0], 1e-12);
+        bool const matching = results[0].vertices.size() == results[1].vertices.size()
+            && results[0].indices.size() == results[1].indices.size()
+            && areaDifference < 1e-4;
+
+        size_t const triangleCount = results[1].indices.size() / 3;
+        printf("OBJ parse [%s] (%.1f MiB, %zu triangles, best of %u):\n", sourcePath, static_cast<double>(sourceInfo.size) / (1024.0 * 1024.0), triangleCount, RunCount);
+        for (size_t parserIdx = 0; parserIdx < 2; parserIdx++)
+        {
+            double const seconds = bestTimeMS[parserIdx] / 1000.0;
+            printf("  %-10s %10.2f ms %10.1f MiB/s %10.2f Mtriangles/s\n",
+                parsers[parserIdx].name,
+                bestTimeMS[parserIdx],
+                static_cast<double>(sourceInfo.size) / (1024.0 * 1024.0) / seconds,
+                static_cast<double>(triangleCount) / 1e6 / seconds
+            );
+        }
+        printf("  Speedup: %.1fx\n", bestTimeMS[0] / bestTimeMS[1]);
+
+        if (!matching)
+        {
+            printf("Warning: parser outputs differ (%zu / %zu vertices, %zu / %zu indices, %.4f%% surface area difference)\n",
+                results[0].vertices.size(), results[1].vertices.size(), results[0].indices.size(), results[1].indices.size(), 100.0 * areaDifference);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool benchmarkMips(uint32_t size)
+    {
+        struct Config
+        {
+            char const* name;
+            TextureType type;
+            MipGenerator::MipFilter filter;
+        };
+
+        Config const configs[] = {
+            { "color box", TextureType::Color, MipGenerator::MipFilter::Box },
+            { "color kaiser", TextureType::Color, MipGenerator::MipFilter::Kaiser },
+            { "normal box", TextureType::Normal, MipGenerator::MipFilter::Box },
+            { "normal kaiser", TextureType::Normal, MipGenerator::MipFilter::Kaiser },
+        };
+
+        // Value noise over a gradient, hashed per texel so the content has detail at every level
+        TextureLevel baseLevel{};
+        baseLevel.width = size;
+        baseLevel.height = size;
+        baseLevel.data.resize(static_cast<size_t>(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                uint32_t hash = x * 0x8DA6B343U ^ y * 0xD8163841U;
+                hash = (hash ^ (hash >> 15)) * 0x2C1B3C6DU;
+                uint8_t* pTexel = &baseLevel.data[(static_cast<size_t>(y) * size + x) * 4];
+                pTexel[0] = static_cast<uint8_t>((x * 255) / size / 2 + (hash & 0x7F));
+                pTexel[1] = static_cast<uint8_t>((y * 255) / size / 2 + ((hash >> 8) & 0x7F));
+                pTexel[2] = static_cast<uint8_t>(128 + ((hash >> 16) & 0x7F));
+                pTexel[3] = 255;
+            }
+        }
+
+        JobSystem jobs{}; //< mip generation splits its loops over the calling thread's job system
+        printf("Mip generation %u x %u:\n", size, size);
+        for (auto const& config : configs)
+        {
+            TextureData texture{};
+            texture.type = config.type;
+            texture.levels.push_back(baseLevel);
+
+            Timer timer{};
+            MipGenerator::generateMips(texture, config.filter);
+            timer.tick();
+
+            double const seconds = timer.deltaTimeMS() / 1000.0;
+            printf("  %-14s %10.2f ms %10.1f Mtexels/s (%zu levels)\n", config.name, timer.deltaTimeMS(), static_cast<double>(size) * size / 1e6 / seconds, texture.levels.size());
+        }
+
+        // A flat color must stay exactly the same down the whole chain
+        TextureData flat{};
+        flat.type = TextureType::Color;
+        flat.levels.push_back(TextureLevel{ 64, 64, std::vector<uint8_t>(64 * 64 * 4, 0) });
+        for (size_t idx = 0; idx < flat.levels[0].data.size(); idx += 4) {
+            flat.levels[0].data[idx + 0] = 17;
+            flat.levels[0].data[idx + 1] = 128;
+            flat.levels[0].data[idx + 2] = 250;
+            flat.levels[0].data[idx + 3] = 255;
+        }
+
+        MipGenerator::generateMips(flat, MipGenerator::MipFilter::Kaiser);
+        TextureLevel const& smallest = flat.levels.back();
+        if (smallest.data[0] != 17 || smallest.data[1] != 128 || smallest.data[2] != 250 || smallest.data[3] != 255)
+        {
+            printf("Warning: flat color drifted through the mip chain (%u %u %u %u)\n", smallest.data[0], smallest.data[1], smallest.data[2], smallest.data[3]);
+            return false;
+        }
+
+        return true;
+    }
+
+    bool benchmarkBlockCompression(char const* imagePath, TextureType type)
+    {
+        constexpr double MinPsnr = 30.0; //< dB, anything below means the encoder is broken rather than the content being hard
+
+        JobSystem jobs{}; //< mip generation & compression split their loops over the calling thread's job system
+        TextureData source{};
+        uint32_t channelCount = 0;
+        if (!TextureImport::decodeImage(imagePath, type, source, channelCount)) {
+            return false;
+        }
+
+        MipGenerator::generateMips(source);
+
+        size_t texelCount = 0;
+        size_t sourceSize = 0;
+        for (auto const& level : source.levels)
+        {
+            texelCount += static_cast<size_t>(level.width) * level.height;
+            sourceSize += level.data.size();
+        }
+
+        std::vector<TextureFormat> formats = { TextureFormat::BC1, TextureFormat::BC3, TextureFormat::BC7 };
+        channelCount = 3;
+        if (type == TextureType::Normal)
+        {
+            formats = { TextureFormat::BC5, TextureFormat::BC1, TextureFormat::BC7 };
+            channelCount = 2; //< Z is reconstructed in the shader
+        }
+        else if (type == TextureType::Linear)
+        {
+            formats = { TextureFormat::BC4, TextureFormat::BC1, TextureFormat::BC7 };
+            channelCount = 1; //< single channel data, as stored in BC4
+        }
+
+        printf("Block compression [%s] (%u x %u, %zu levels, %u channel PSNR):\n", imagePath, source.levels[0].width, source.levels[0].height, source.levels.size(), channelCount);
+        bool success = true;
+        for (TextureFormat format : formats)
+        {
+            TextureData compressed = source;
+            Timer timer{};
+            if (!BlockCompression::compress(compressed, format))
+            {
+                printf("  %-5s skipped, dimensions aren't a multiple of %u\n", BlockCompression::formatName(format), BlockCompression::BlockDimension);
+                continue;
+            }
+            timer.tick();
+
+            TextureData decoded{};
+            if (!BlockCompression::decompress(compressed, decoded))
+            {
+                printf("  %-5s decode failed\n", BlockCompression::formatName(format));
+                success = false;
+                continue;
+            }
+
+            size_t compressedSize = 0;
+            double minLevelPsnr = std::numeric_limits<double>::infinity();
+            for (size_t levelIdx = 0; levelIdx < source.levels.size(); levelIdx++)
+            {
+                compressedSize += compressed.levels[levelIdx].data.size();
+                minLevelPsnr = std::min(minLevelPsnr, BlockCompression::psnr(source.levels[levelIdx], decoded.levels[levelIdx], channelCount));
+            }
+
+            double const basePsnr = BlockCompression::psnr(source.levels[0], decoded.levels[0], channelCount);
+            double const seconds = timer.deltaTimeMS() / 1000.0;
+            printf("  %-5s %10.2f ms %8.1f Mtexels/s %8.1f KiB (%4.1f:1) PSNR %6.2f dB (worst level %6.2f dB)\n",
+                BlockCompression::formatName(format), timer.deltaTimeMS(), static_cast<double>(texelCount) / 1e6 / seconds,
+                static_cast<double>(compressedSize) / 1024.0, static_cast<double>(sourceSize) / static_cast<double>(compressedSize),
+                basePsnr, minLevelPsnr
+            );
+
+            if (format == BlockCompression::defaultFormat(type) && basePsnr < MinPsnr)
+            {
+                printf("Warning: %s PSNR below %.1f dB\n", BlockCompression::formatName(format), MinPsnr);
+                success = false;
+            }
+        }
+
+        return success;
+    }
+
+    bool benchmarkStartup(uint32_t threadCount)
+    {
+        // Shader compilation only reads the source & GPU resource creation is skipped, the asset reads run for real
+        auto const readShader = []() { MappedFile shaderSource{}; return shaderSource.open(Startup::ShaderPath); };
+        Startup::Stages stages{};
+        stages.compileVertexShader = readShader;
+        stages.compilePixelShader = readShader;
+        stages.createPipeline = []() { return true; };
+        stages.createMesh = [](AssetLoader::MeshSource&) { return true; };
+        stages.createTexture = [](uint32_t, std::unique_ptr<AssetLoader::TextureSource>& pSource) { pSource.reset(); return true; };
+        stages.submitUploads = []() { return true; };
+
+        JobSystem jobs(threadCount);
+        TaskGraph graph{};
+        Startup::Assets assets{};
+        Startup::buildGraph(graph, assets, stages);
+
+        bool const success = graph.execute(jobs);
+        std::string const title = "Startup on " + std::to_string(jobs.threadCount()) + " threads";
+        graph.report(title.c_str());
+        return success;
+    }
+} // namespace Tests
@@ -0,0 +1,176 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "tests.hpp"
+
+using namespace Engine;
+
+static void printUsage()
+{
+    printf("Usage: EngineTests <command> <argument> [argument...] [--normal | --linear]\n");
+    printf("  obj-bench <input.obj>        Compare OBJ parser throughput against TinyOBJ\n");
+    printf("  mip-bench <size>             Time mip chain generation on synthetic square textures of the given sizes\n");
+    printf("  bc-bench <image>             Block compress an image's mip chain in each format, report throughput & PSNR against the decoded result\n");
+    printf("  startup-bench <threads>      Run the renderer startup graph with stubbed GPU stages on the given worker counts, from the repo root\n");
+    printf("  meshlet-test <input.obj>     Check meshlet normal cones never cull a cluster with a triangle facing the camera, on the mesh & a concave valley\n");
+    printf("  lod-test <input.obj>         Check LOD triangle counts against their targets, error growth per level & the measured error bound\n");
+    printf("  pack-test <input.obj>        Check packed vertex round trip errors against their bounds, decoded vertices & the index format\n");
+    printf("  tangent-test <input.obj>     Check tangents are unit length, orthogonal to the normal & handed by the texture mapping, on the mesh & a mirrored quad\n");
+    printf("  ring-test <operations>       Check upload ring allocation & retirement against a simulated GPU fence timeline\n");
+    printf("  frame-test <frames>          Check frame slot & fence bookkeeping against a simulated GPU timeline, report pipelined frame times\n");
+    printf("  descriptor-test <operations> Check descriptor free list & frame allocator against an ownership map, report allocation throughput\n");
+    printf("  heap-test <operations>       Check placed resource heap allocation against live ranges, report fragmentation & throughput against first fit\n");
+    printf("  render-graph-test <graphs>   Compile a deferred frame & random graphs, replay their barriers & report barrier counts & transient memory\n");
+    printf("  job-test <jobs>              Check jobs, parallel for & continuations, report spawn overhead, scaling over worker counts & contention\n");
+    printf("  command-test <frames>        Check parallel command list recording & pool recycling against a mock device, report recording speedup\n");
+    printf("  instance-bench <instances>   Check & time SoA instance matrix batches against per object matrices, single threaded & on the job system\n");
+    printf("  cull-bench <objects>         Check mesh & instance bounds & SIMD sphere culling against the scalar reference, report objects/ns\n");
+    printf("  bvh-bench <objects>          Check scene BVH queries against brute force through edits & rebuilds, report culling cost over motion rates\n");
+    printf("  ray-bench <input.obj>        Check triangle BVH ray hits against brute force & picking rays against projection, report Mrays/s\n");
+    printf("  sort-bench <packets>         Check draw packet radix sort against a stable sort & state skipping against a mock, report Mpackets/s\n");
+    printf("  shader-test <lookups>        Check shader cache keys, hits & invalidation with a stub compiler, report the cost of a hit\n");
+    printf("  --normal      Treat the bc-bench image as a tangent space normal map, --linear as non color data\n");
+    printf("Every command runs once per argument & exits with 1 if any check failed.\n");
+}
+
+/// @brief Counts must be whole numbers of at least 1, zero iterations would pass without checking anything.
+static bool parseCount(char const* text, uint32_t& count)
+{
+    char* pEnd = nullptr;
+    long const value = strtol(text, &pEnd, 10);
+    if (pEnd == text || *pEnd != '\0' || value < 1 || value > static_cast<long>(UINT32_MAX))
+    {
+        printf("Invalid count [%s], expected a number of at least 1\n", text);
+        return false;
+    }
+
+    count = static_cast<uint32_t>(value);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    char const* command = argv[1];
+    TextureType textureType = TextureType::Color;
+    std::vector<char const*> arguments;
+    for (int argIdx = 2; argIdx < argc; argIdx++)
+    {
+        if (strcmp(argv[argIdx], "--normal") == 0) {
+            textureType = TextureType::Normal;
+        }
+        else if (strcmp(argv[argIdx], "--linear") == 0) {
+            textureType = TextureType::Linear;
+        }
+        else {
+            arguments.push_back(argv[argIdx]);
+        }
+    }
+
+    if (arguments.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::function<bool(char const* path)> runPath;
+    std::function<bool(uint32_t count)> runCount;
+    if (strcmp(command, "obj-bench") == 0) {
+        runPath = Tests::benchmarkOBJ;
+    }
+    else if (strcmp(command, "bc-bench") == 0) {
+        runPath = [textureType](char const* path) { return Tests::benchmarkBlockCompression(path, textureType); };
+    }
+    else if (strcmp(command, "meshlet-test") == 0) {
+        runPath = Tests::testMeshlets;
+    }
+    else if (strcmp(command, "lod-test") == 0) {
+        runPath = Tests::testLods;
+    }
+    else if (strcmp(command, "pack-test") == 0) {
+        runPath = Tests::testVertexPacking;
+    }
+    else if (strcmp(command, "tangent-test") == 0) {
+        runPath = Tests::testTangents;
+    }
+    else if (strcmp(command, "ray-bench") == 0) {
+        runPath = Tests::benchmarkTriangleBvh;
+    }
+    else if (strcmp(command, "mip-bench") == 0) {
+        runCount = Tests::benchmarkMips;
+    }
+    else if (strcmp(command, "startup-bench") == 0) {
+        runCount = Tests::benchmarkStartup;
+    }
+    else if (strcmp(command, "ring-test") == 0) {
+        runCount = Tests::testRingAllocator;
+    }
+    else if (strcmp(command, "frame-test") == 0) {
+        runCount = Tests::testFrameTimeline;
+    }
+    else if (strcmp(command, "descriptor-test") == 0) {
+        runCount = Tests::testDescriptorAllocator;
+    }
+    else if (strcmp(command, "heap-test") == 0) {
+        runCount = Tests::testHeapAllocator;
+    }
+    else if (strcmp(command, "render-graph-test") == 0) {
+        runCount = Tests::testRenderGraph;
+    }
+    else if (strcmp(command, "job-test") == 0) {
+        runCount = Tests::testJobSystem;
+    }
+    else if (strcmp(command, "command-test") == 0) {
+        runCount = Tests::testCommandRecorder;
+    }
+    else if (strcmp(command, "instance-bench") == 0) {
+        runCount = Tests::benchmarkInstances;
+    }
+    else if (strcmp(command, "cull-bench") == 0) {
+        runCount = Tests::benchmarkCulling;
+    }
+    else if (strcmp(command, "bvh-bench") == 0) {
+        runCount = Tests::benchmarkSceneBvh;
+    }
+    else if (strcmp(command, "sort-bench") == 0) {
+        runCount = Tests::benchmarkDrawSort;
+    }
+    else if (strcmp(command, "shader-test") == 0) {
+        runCount = Tests::testShaderCache;
+    }
+    else
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Parse every count up front, so a typo doesn't surface after minutes of earlier runs
+    std::vector<uint32_t> counts;
+    for (char const* argument : arguments)
+    {
+        uint32_t count = 0;
+        if (runCount && !parseCount(argument, count))
+        {
+            printUsage();
+            return 1;
+        }
+
+        counts.push_back(count);
+    }
+
+    bool success = true;
+    for (size_t argIdx = 0; argIdx < arguments.size(); argIdx++) {
+        success = (runCount ? runCount(counts[argIdx]) : runPath(arguments[argIdx])) && success;
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,449 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "command_recorder.hpp"
+#include "culling.hpp"
+#include "frame_timeline.hpp"
+#include "job_system.hpp"
+#include "scene.hpp"
+#include "timer.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    bool testJobSystem(uint32_t jobCount)
+    {
+        Checker check{ "Job system" };
+
+        uint32_t const hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+        {
+            JobSystem jobs(hardwareThreads);
+
+            std::atomic<uint32_t> runCount{ 0 };
+            JobSystem::Counter counter;
+            for (uint32_t jobIdx = 0; jobIdx < jobCount; jobIdx++) {
+                jobs.run([&runCount]() { runCount.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            }
+            jobs.wait(counter);
+            check(runCount.load() == jobCount, "every job runs once before its counter drops to zero");
+
+            std::vector<std::atomic<uint32_t>> visits(jobCount);
+            jobs.parallelFor(jobCount, 64, [&visits](size_t begin, size_t end)
+            {
+                for (size_t index = begin; index < end; index++) {
+                    visits[index].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+            check(std::all_of(visits.begin(), visits.end(), [](std::atomic<uint32_t> const& visit) { return visit.load() == 1; }), "parallel for visits every index once");
+
+            std::atomic<uint64_t> nestedSum{ 0 };
+            jobs.parallelFor(64, 1, [&jobs, &nestedSum](size_t begin, size_t end)
+            {
+                for (size_t outerIdx = begin; outerIdx < end; outerIdx++)
+                {
+                    jobs.parallelFor(1024, 16, [&nestedSum](size_t innerBegin, size_t innerEnd)
+                    {
+                        uint64_t sum = 0;
+                        for (size_t index = innerBegin; index < innerEnd; index++) {
+                            sum += index;
+                        }
+                        nestedSum.fetch_add(sum, std::memory_order_relaxed);
+                    });
+                }
+            });
+            check(nestedSum.load() == 64ULL * (1023ULL * 1024ULL / 2), "parallel for nested in jobs completes every inner range");
+
+            // Continuations see their whole dependency, chains of them run in order, repeated to expose races
+            uint32_t const roundCount = std::max(1U, jobCount / 1000);
+            for (uint32_t roundIdx = 0; roundIdx < roundCount && check.passed(); roundIdx++)
+            {
+                JobSystem::Counter producers;
+                JobSystem::Counter consumers;
+                std::atomic<uint32_t> produced{ 0 };
+                uint32_t seenByContinuation = 0;
+                for (uint32_t jobIdx = 0; jobIdx < 256; jobIdx++) {
+                    jobs.run([&produced]() { produced.fetch_add(1, std::memory_order_relaxed); }, &producers);
+                }
+                jobs.runAfter(producers, [&]() { seenByContinuation = produced.load(std::memory_order_relaxed); }, &consumers);
+                jobs.wait(consumers);
+                check(seenByContinuation == 256, "continuation runs after all jobs of its dependency");
+
+                bool lateContinuationRan = false;
+                JobSystem::Counter late;
+                jobs.runAfter(producers, [&lateContinuationRan]() { lateContinuationRan = true; }, &late);
+                jobs.wait(late);
+                check(lateContinuationRan, "continuation of a finished dependency runs right away");
+
+                constexpr uint32_t StageCount = 8;
+                JobSystem::Counter stages[StageCount];
+                std::vector<uint32_t> stageOrder;
+                std::atomic<uint32_t> stageWork{ 0 };
+                for (uint32_t stageIdx = 0; stageIdx < StageCount; stageIdx++)
+                {
+                    // Each stage spawns its own jobs into the next stage's dependency from within a job
+                    auto const stage = [&, stageIdx]()
+                    {
+                        stageOrder.push_back(stageIdx);
+                        for (uint32_t jobIdx = 0; jobIdx < 16; jobIdx++) {
+                            jobs.run([&stageWork]() { stageWork.fetch_add(1, std::memory_order_relaxed); }, &stages[stageIdx]);
+                        }
+                    };
+
+                    if (stageIdx == 0) {
+                        jobs.run(stage, &stages[0]);
+                    }
+                    else {
+                        jobs.runAfter(stages[stageIdx - 1], stage, &stages[stageIdx]);
+                    }
+                }
+                jobs.wait(stages[StageCount - 1]);
+
+                bool ordered = stageOrder.size() == StageCount;
+                for (uint32_t stageIdx = 0; stageIdx < stageOrder.size(); stageIdx++) {
+                    ordered = ordered && stageOrder[stageIdx] == stageIdx;
+                }
+                check(ordered && stageWork.load() == StageCount * 16, "continuation chain runs its stages in order after their spawned jobs");
+            }
+        }
+
+        // Spawn overhead of empty jobs pushed by the main thread
+        printf("Spawn overhead (%u empty jobs):\n", jobCount);
+        for (uint32_t threadCount : { 1U, hardwareThreads })
+        {
+            JobSystem jobs(threadCount);
+            Timer timer{};
+            JobSystem::Counter counter;
+            for (uint32_t jobIdx = 0; jobIdx < jobCount; jobIdx++) {
+                jobs.run([]() {}, &counter);
+            }
+            jobs.wait(counter);
+            timer.tick();
+            printf("  Job system, %2u threads: %8.1f ns per job\n", threadCount, timer.deltaTimeMS() * 1e6 / std::max(1U, jobCount));
+        }
+
+        // Scaling of the per object transform & culling work over worker counts
+        constexpr size_t ObjectCount = 1 << 18;
+        constexpr uint32_t RunCount = 5;
+        std::vector<Transform> transforms(ObjectCount);
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+        auto const randomUnit = [&random]() { return static_cast<float>(random() % 2001) / 1000.0F - 1.0F; };
+        for (auto& transform : transforms)
+        {
+            transform.position = glm::vec3(randomUnit(), randomUnit(), randomUnit()) * 100.0F;
+            transform.rotation = glm::angleAxis(randomUnit() * 3.14159F, glm::normalize(glm::vec3(randomUnit(), randomUnit(), randomUnit()) + glm::vec3(0.0F, 2.0F, 0.0F)));
+            transform.scale = glm::vec3(0.5F + randomUnit() * 0.25F);
+        }
+
+        Camera camera{};
+        camera.aspectRatio = 16.0F / 9.0F;
+        camera.zFar = 200.0F;
+        Frustum const frustum = Culling::extractFrustum(camera.matrix());
+        std::vector<glm::mat4> models(ObjectCount);
+        std::vector<uint8_t> visible(ObjectCount);
+        auto const updateObjects = [&](size_t begin, size_t end)
+        {
+            for (size_t objectIdx = begin; objectIdx < end; objectIdx++)
+            {
+                models[objectIdx] = transforms[objectIdx].matrix();
+                visible[objectIdx] = Culling::testSphere(frustum, glm::vec3(models[objectIdx][3]), transforms[objectIdx].scale.x) ? 1 : 0;
+            }
+        };
+
+        updateObjects(0, ObjectCount);
+        size_t const visibleCount = static_cast<size_t>(std::count(visible.begin(), visible.end(), uint8_t(1)));
+
+        std::vector<uint32_t> threadCounts;
+        for (uint32_t threadCount = 1; threadCount < hardwareThreads; threadCount *= 2) {
+            threadCounts.push_back(threadCount);
+        }
+        threadCounts.push_back(hardwareThreads);
+
+        printf("Transform & cull scaling (%zu objects, %zu visible, best of %u):\n", ObjectCount, visibleCount, RunCount);
+        double singleThreadMS = 0.0;
+        for (uint32_t threadCount : threadCounts)
+        {
+            JobSystem jobs(threadCount);
+            double bestMS = std::numeric_limits<double>::max();
+            for (uint32_t runIdx = 0; runIdx < RunCount; runIdx++)
+            {
+                std::fill(visible.begin(), visible.end(), uint8_t(0));
+                Timer timer{};
+                jobs.parallelFor(ObjectCount, 1024, updateObjects);
+                timer.tick();
+                bestMS = std::min(bestMS, timer.deltaTimeMS());
+            }
+
+            check(static_cast<size_t>(std::count(visible.begin(), visible.end(), uint8_t(1))) == visibleCount, "parallel transform & cull matches the serial result");
+            singleThreadMS = (threadCount == 1) ? bestMS : singleThreadMS;
+            JobSystem::Statistics const statistics = jobs.statistics();
+            printf("  %2u threads: %7.3f ms, %5.2fx speedup, %3.0f%% efficiency, %llu jobs, %llu stolen\n",
+                threadCount, bestMS, singleThreadMS / bestMS, 100.0 * singleThreadMS / (bestMS * threadCount),
+                static_cast<unsigned long long>(statistics.executedCount), static_cast<unsigned long long>(statistics.stolenCount));
+        }
+
+        // Contention: single item ranges & a spawn tree where every worker pushes & steals at once
+        {
+            JobSystem jobs(hardwareThreads);
+            std::atomic<uint64_t> sum{ 0 };
+            Timer timer{};
+            jobs.parallelFor(jobCount, 1, [&sum](size_t begin, size_t end) { sum.fetch_add(end - begin, std::memory_order_relaxed); });
+            timer.tick();
+            JobSystem::Statistics statistics = jobs.statistics();
+            check(sum.load() == jobCount, "single item parallel for covers every index");
+            printf("Contention, %u threads:\n", hardwareThreads);
+            printf("  Single item ranges: %8.1f ns per item, %llu stolen, %llu failed steals, %llu sleeps\n",
+                timer.deltaTimeMS() * 1e6 / std::max(1U, jobCount), static_cast<unsigned long long>(statistics.stolenCount),
+                static_cast<unsigned long long>(statistics.failedStealCount), static_cast<unsigned long long>(statistics.sleepCount));
+
+            uint32_t depth = 1;
+            while ((2U << depth) - 1 < jobCount && depth < 20) {
+                depth++;
+            }
+
+            jobs.resetStatistics();
+            std::atomic<uint32_t> nodeCount{ 0 };
+            JobSystem::Counter tree;
+            std::function<void(uint32_t)> spawnNode = [&](uint32_t level)
+            {
+                nodeCount.fetch_add(1, std::memory_order_relaxed);
+                if (level < depth)
+                {
+                    jobs.run([&spawnNode, level]() { spawnNode(level + 1); }, &tree);
+                    jobs.run([&spawnNode, level]() { spawnNode(level + 1); }, &tree);
+                }
+            };
+
+            timer.reset();
+            jobs.run([&spawnNode]() { spawnNode(0); }, &tree);
+            jobs.wait(tree);
+            timer.tick();
+            statistics = jobs.statistics();
+            check(nodeCount.load() == (2U << depth) - 1, "recursively spawned jobs all run");
+            printf("  Spawn tree:         %8.1f ns per job, %u jobs, %llu stolen, %llu failed steals, %llu sleeps\n",
+                timer.deltaTimeMS() * 1e6 / nodeCount.load(), nodeCount.load(), static_cast<unsigned long long>(statistics.stolenCount),
+                static_cast<unsigned long long>(statistics.failedStealCount), static_cast<unsigned long long>(statistics.sleepCount));
+        }
+
+        printf("Job system %s\n", check.passed() ? "passed" : "FAILED");
+        return check.passed();
+    }
+
+    bool testCommandRecorder(uint32_t frameCount)
+    {
+        Checker check{ "Command recorder" };
+
+        // Chunks cover the draws in order with sizes differing by at most one
+        auto const validChunks = [](std::vector<DrawChunk> const& chunks, uint32_t drawCount)
+        {
+            uint32_t nextDraw = 0;
+            uint32_t minCount = UINT32_MAX;
+            uint32_t maxCount = 0;
+            for (auto const& chunk : chunks)
+            {
+                if (chunk.firstDraw != nextDraw || chunk.drawCount == 0) {
+                    return false;
+                }
+
+                nextDraw += chunk.drawCount;
+                minCount = std::min(minCount, chunk.drawCount);
+                maxCount = std::max(maxCount, chunk.drawCount);
+            }
+
+            return nextDraw == drawCount && (chunks.empty() || maxCount - minCount <= 1);
+        };
+
+        check(CommandRecorder::splitDraws(0, 8, 1).empty(), "no draws need no chunks");
+        check(CommandRecorder::splitDraws(10, 4, 1).size() == 4 && validChunks(CommandRecorder::splitDraws(10, 4, 1), 10), "draws are split evenly over the chunks");
+        check(CommandRecorder::splitDraws(100, 8, 64).size() == 1, "chunks keep the minimum draw count");
+        check(CommandRecorder::splitDraws(3, 8, 64).size() == 1, "fewer draws than the minimum still get a chunk");
+        check(CommandRecorder::splitDraws(100000, 8, 64).size() == 8, "chunk count is limited to the maximum");
+
+        // Recording mock on a simulated GPU timeline, the GPU completes frames with a random lag
+        struct MockList
+        {
+            bool open = false;
+            uint64_t submittedValue = 0;
+            std::atomic<uint32_t> recorderCount{ 0 };
+            std::vector<uint32_t> commands;
+        };
+
+        constexpr uint32_t FrameSlotCount = 3;
+        constexpr uint32_t Marker = UINT32_MAX; //< recorded by the lists before & after the parallel chunks
+        FrameTimeline timeline(FrameSlotCount);
+        uint64_t completedValue = 0;
+        std::vector<std::unique_ptr<MockList>> lists[FrameSlotCount];
+        std::vector<uint32_t> executedCommands;
+        uint32_t executeCount = 0;
+        uint32_t executedListCount = 0;
+        std::atomic<uint32_t> sharedRecordings{ 0 };
+        std::atomic<uint32_t> closedRecordings{ 0 };
+
+        CommandListBackend backend{};
+        backend.createList = [&](uint32_t frameIdx, uint32_t listIdx)
+        {
+            check(listIdx == lists[frameIdx].size(), "lists are created in pool order");
+            lists[frameIdx].push_back(std::make_unique<MockList>());
+            lists[frameIdx].back()->open = true;
+            return true;
+        };
+        backend.resetList = [&](uint32_t frameIdx, uint32_t listIdx)
+        {
+            MockList& list = *lists[frameIdx][listIdx];
+            check(!list.open, "only closed lists are reset");
+            check(list.submittedValue <= completedValue, "allocators are only reset once their GPU work completed");
+            list.open = true;
+            list.commands.clear();
+            return true;
+        };
+        backend.closeList = [&](uint32_t frameIdx, uint32_t listIdx)
+        {
+            MockList& list = *lists[frameIdx][listIdx];
+            check(list.open, "lists are closed once");
+            list.open = false;
+            return true;
+        };
+        backend.executeLists = [&](uint32_t frameIdx, uint32_t listCount)
+        {
+            executeCount++;
+            executedListCount = listCount;
+            for (uint32_t listIdx = 0; listIdx < listCount; listIdx++)
+            {
+                MockList const& list = *lists[frameIdx][listIdx];
+                check(!list.open, "executed lists are closed");
+                executedCommands.insert(executedCommands.end(), list.commands.begin(), list.commands.end());
+            }
+        };
+
+        CommandRecorder recorder(FrameSlotCount);
+        recorder.setBackend(backend);
+        uint32_t const hardwareThreads = std::max(1U, std::thread::hardware_concurrency());
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+        uint32_t maxPoolSize = 0;
+        {
+            JobSystem jobs(hardwareThreads);
+            for (uint32_t frameIdx = 0; frameIdx < frameCount && check.passed(); frameIdx++)
+            {
+                // The CPU waits for the slot's previous frame before reusing its lists
+                completedValue = std::max(completedValue, timeline.beginFrame());
+                uint32_t const slotIdx = timeline.frameIndex();
+                recorder.beginFrame(slotIdx);
+
+                uint32_t const firstListIdx = recorder.acquireList();
+                check(firstListIdx == 0, "the frame's first list is the slot's first list");
+                lists[slotIdx][firstListIdx]->commands.push_back(Marker);
+
+                uint32_t const drawCount = random() % 4096;
+                uint32_t const minDrawsPerChunk = 1 + random() % 512;
+                bool const recorded = recorder.recordParallel(jobs, drawCount, minDrawsPerChunk, [&](uint32_t listIdx, DrawChunk const& chunk)
+                {
+                    MockList& list = *lists[slotIdx][listIdx];
+                    if (list.recorderCount.fetch_add(1) != 0) {
+                        sharedRecordings.fetch_add(1);
+                    }
+                    if (!list.open) {
+                        closedRecordings.fetch_add(1);
+                    }
+
+                    for (uint32_t drawIdx = chunk.firstDraw; drawIdx < chunk.firstDraw + chunk.drawCount; drawIdx++) {
+                        list.commands.push_back(drawIdx);
+                    }
+                    list.recorderCount.fetch_sub(1);
+                });
+                check(recorded, "parallel recording opens a list per chunk");
+
+                uint32_t const lastListIdx = recorder.acquireList();
+                lists[slotIdx][lastListIdx]->commands.push_back(Marker);
+
+                executedCommands.clear();
+                uint32_t const executeCountBefore = executeCount;
+                check(recorder.submit(), "submit closes every list");
+                check(executeCount == executeCountBefore + 1 && executedListCount == recorder.statistics().listCount, "the frame's lists are executed with one submit");
+
+                bool ordered = executedCommands.size() == static_cast<size_t>(drawCount) + 2 && executedCommands.front() == Marker && executedCommands.back() == Marker;
+                for (uint32_t drawIdx = 0; drawIdx < drawCount && ordered; drawIdx++) {
+                    ordered = executedCommands[1 + drawIdx] == drawIdx;
+                }
+                check(ordered, "lists execute in recording order & cover every draw once");
+                check(recorder.statistics().chunkCount == CommandRecorder::splitDraws(drawCount, jobs.threadCount(), minDrawsPerChunk).size(), "each chunk is recorded into its own list");
+
+                uint64_t const frameValue = timeline.endFrame();
+                for (uint32_t listIdx = 0; listIdx < recorder.statistics().listCount; listIdx++) {
+                    lists[slotIdx][listIdx]->submittedValue = frameValue;
+                }
+
+                completedValue = std::max(completedValue, frameValue - std::min<uint64_t>(frameValue, random() % FrameSlotCount));
+                maxPoolSize = std::max(maxPoolSize, recorder.poolSize(slotIdx));
+            }
+
+            check(sharedRecordings.load() == 0, "no list is recorded by two threads at once");
+            check(closedRecordings.load() == 0, "chunks are only recorded into open lists");
+            check(maxPoolSize <= jobs.threadCount() + 2, "pools don't grow beyond the chunks & main thread lists of a frame");
+        }
+
+        printf("Command recorder %s (%u frames, %u lists created, at most %u per frame slot)\n",
+            check.passed() ? "passed" : "FAILED", frameCount, recorder.statistics().createdCount, maxPoolSize);
+
+        // Recording throughput with a simulated per draw recording cost, against a single list
+        constexpr uint32_t BenchmarkDrawCount = 20000;
+        constexpr uint32_t DrawCostIterations = 200;
+        std::vector<uint32_t> recordedDraws(BenchmarkDrawCount);
+        auto const recordDraws = [&recordedDraws](uint32_t, DrawChunk const& chunk)
+        {
+            for (uint32_t drawIdx = chunk.firstDraw; drawIdx < chunk.firstDraw + chunk.drawCount; drawIdx++)
+            {
+                uint32_t hash = drawIdx;
+                for (uint32_t iteration = 0; iteration < DrawCostIterations; iteration++) {
+                    hash = hash * 1664525U + 1013904223U;
+                }
+                recordedDraws[drawIdx] = hash;
+            }
+        };
+
+        CommandListBackend benchmarkBackend{};
+        benchmarkBackend.createList = [](uint32_t, uint32_t) { return true; };
+        benchmarkBackend.resetList = [](uint32_t, uint32_t) { return true; };
+        benchmarkBackend.closeList = [](uint32_t, uint32_t) { return true; };
+        benchmarkBackend.executeLists = [](uint32_t, uint32_t) {};
+
+        Timer timer{};
+        recordDraws(0, DrawChunk{ 0, BenchmarkDrawCount });
+        timer.tick();
+        double const singleListMS = timer.deltaTimeMS();
+        printf("Recording %u draws: single list %.3f ms\n", BenchmarkDrawCount, singleListMS);
+        for (uint32_t threadCount = 1; threadCount <= hardwareThreads; threadCount = (threadCount < hardwareThreads && threadCount * 2 > hardwareThreads) ? hardwareThreads : threadCount * 2)
+        {
+            JobSystem jobs(threadCount);
+            CommandRecorder benchmarkRecorder(FrameSlotCount);
+            benchmarkRecorder.setBackend(benchmarkBackend);
+            double bestMS = std::numeric_limits<double>::max();
+            for (uint32_t runIdx = 0; runIdx < 5; runIdx++)
+            {
+                benchmarkRecorder.beginFrame(runIdx % FrameSlotCount);
+                timer.reset();
+                benchmarkRecorder.recordParallel(jobs, BenchmarkDrawCount, 256, recordDraws);
+                benchmarkRecorder.submit();
+                timer.tick();
+                bestMS = std::min(bestMS, timer.deltaTimeMS());
+            }
+
+            printf("  %2u threads: %7.3f ms in %u lists, %5.2fx speedup\n", threadCount, bestMS, benchmarkRecorder.statistics().listCount, singleListMS / bestMS);
+            if (threadCount == hardwareThreads) {
+                break;
+            }
+        }
+
+        return check.passed();
+    }
+} // namespace Tests
@@ -0,0 +1,559 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "descriptor_allocator.hpp"
+#include "frame_timeline.hpp"
+#include "ring_allocator.hpp"
+#include "timer.hpp"
+#include "tlsf_allocator.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    bool testRingAllocator(uint32_t operationCount)
+    {
+        Checker check{ "Ring allocator" };
+
+        // Fixed cases, the fence is faked by submitting & retiring values by hand
+        {
+            RingAllocator ring(1024);
+            check(ring.allocate(256, 1) == 0, "first allocation starts at 0");
+            check(ring.allocate(100, 256) == 256, "aligned allocation follows the first");
+            check(ring.allocate(700, 1) == RingAllocator::InvalidOffset, "allocation larger than the free space fails");
+            ring.submit(1);
+            check(ring.pendingSize() == 0 && ring.usedSize() == 356, "submit tags pending allocations");
+
+            check(ring.allocate(512, 512) == 512, "allocation fills up to the end");
+            ring.submit(2);
+            check(ring.allocate(1, 1) == RingAllocator::InvalidOffset, "allocation fails while the ring is fully in use");
+
+            ring.retire(0);
+            check(ring.usedSize() == 1024, "retiring an earlier fence value keeps all allocations");
+            ring.retire(1);
+            check(ring.usedSize() == 668, "retiring the first fence value reclaims its allocations");
+            check(ring.allocate(300, 4) == 0, "allocation wraps into reclaimed space");
+            check(ring.allocate(300, 4) == RingAllocator::InvalidOffset, "allocation doesn't overrun in use space");
+            ring.submit(3);
+
+            ring.retire(2);
+            check(ring.allocate(400, 4) == 300, "allocation uses space reclaimed behind the wrapped tail");
+            check(ring.allocate(400, 4) == RingAllocator::InvalidOffset, "allocation too large for either end fails");
+            check(ring.allocate(200, 4) == 700, "allocation uses the end of the ring");
+            ring.submit(4);
+
+            ring.retire(4);
+            check(ring.usedSize() == 0, "retiring the last fence value frees everything");
+            check(ring.allocate(1024, 1) == 0, "empty ring restarts at the front");
+            check(ring.allocate(0, 1) == RingAllocator::InvalidOffset && ring.allocate(2048, 1) == RingAllocator::InvalidOffset, "empty & oversized allocations fail");
+        }
+
+        // Simulated GPU timeline completing submissions a few frames late, live allocations must never overlap
+        struct LiveAllocation
+        {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t fenceValue;
+        };
+
+        constexpr uint64_t Capacity = 64 * 1024;
+        RingAllocator ring(Capacity);
+        std::vector<LiveAllocation> liveAllocations;
+        uint64_t submittedFence = 0;
+        uint64_t completedFence = 0;
+        uint32_t failedCount = 0;
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+
+        for (uint32_t operationIdx = 0; operationIdx < operationCount && check.passed(); operationIdx++)
+        {
+            uint64_t const size = 1 + random() % (Capacity / 8);
+            uint64_t const alignment = 1ULL << (random() % 10);
+            uint64_t const offset = ring.allocate(size, alignment);
+            if (offset == RingAllocator::InvalidOffset)
+            {
+                failedCount++;
+                check(!liveAllocations.empty(), "allocation fails only while the ring is in use");
+            }
+            else
+            {
+                check(offset % alignment == 0 && offset + size <= Capacity, "allocation is aligned & within the ring");
+                for (auto const& live : liveAllocations) {
+                    check(offset + size <= live.offset || live.offset + live.size <= offset, "allocation overlaps a live allocation");
+                }
+
+                liveAllocations.push_back(LiveAllocation{ offset, size, submittedFence + 1 });
+            }
+
+            // Submit a frame every few allocations, the GPU completes up to 3 frames behind
+            if (random() % 4 == 0) {
+                ring.submit(++submittedFence);
+            }
+
+            completedFence = std::max(completedFence, submittedFence - std::min<uint64_t>(submittedFence, random() % 4));
+            ring.retire(completedFence);
+            liveAllocations.erase(std::remove_if(liveAllocations.begin(), liveAllocations.end(), [&](LiveAllocation const& live)
+            {
+                return live.fenceValue <= completedFence;
+            }), liveAllocations.end());
+        }
+
+        ring.submit(++submittedFence);
+        ring.retire(submittedFence);
+        check(ring.usedSize() == 0, "all space is reclaimed once the last fence value completed");
+
+        printf("Ring allocator %s (%u operations, %u allocations deferred while in use)\n", check.passed() ? "passed" : "FAILED", operationCount, failedCount);
+        return check.passed();
+    }
+
+    bool testFrameTimeline(uint32_t frameCount)
+    {
+        Checker check{ "Frame timeline" };
+
+        // Simulated GPU executing submits in order, each frame's CPU & GPU cost vary around the given averages. Per slot constant
+        // buffers are only written once the GPU finished the frame last reading them.
+        struct Workload
+        {
+            char const* name;
+            double cpuMS;
+            double gpuMS;
+        };
+
+        Workload const workloads[] = {
+            { "balanced", 8.0, 8.0 },
+            { "GPU bound", 4.0, 12.0 },
+            { "CPU bound", 12.0, 4.0 },
+        };
+
+        constexpr uint32_t SlotCount = 3;
+        for (auto const& workload : workloads)
+        {
+            FrameTimeline timeline(SlotCount);
+            std::vector<double> signalTimes = { 0.0 };    //< GPU time at which each fence value completes, value 0 is complete at start
+            std::vector<uint64_t> slotReaders(SlotCount, 0);    //< fence value of the frame last reading each slot's buffer
+            double cpuTime = 0.0;
+            double gpuTime = 0.0;
+            double waitTime = 0.0;
+            uint32_t maxInFlight = 0;
+            uint32_t state = 0x2545F491U;
+            auto const jitter = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return 0.75 + 0.5 * static_cast<double>(state % 1024) / 1024.0; };
+
+            for (uint32_t frameIdx = 0; frameIdx < frameCount; frameIdx++)
+            {
+                // Wait for the slot as the renderer does, blocking until the GPU completes its previous frame
+                uint64_t const waitValue = timeline.beginFrame();
+                check(waitValue < signalTimes.size(), "wait value was signaled");
+                if (signalTimes[waitValue] > cpuTime)
+                {
+                    waitTime += signalTimes[waitValue] - cpuTime;
+                    cpuTime = signalTimes[waitValue];
+                }
+
+                uint32_t const slot = timeline.frameIndex();
+                check(slot == frameIdx % SlotCount, "slots are used round robin");
+                check(signalTimes[slotReaders[slot]] <= cpuTime, "slot buffer is written while the GPU reads it");
+
+                uint32_t inFlight = 0;
+                for (double signalTime : signalTimes) {
+                    inFlight += (signalTime > cpuTime) ? 1 : 0;
+                }
+                maxInFlight = std::max(maxInFlight, inFlight);
+                check(inFlight < SlotCount, "more frames in flight than slots");
+
+                // Record, then submit & signal. An occasional queue flush signals outside of the frame loop
+                cpuTime += workload.cpuMS * jitter();
+                uint64_t const frameValue = timeline.endFrame();
+                check(frameValue == signalTimes.size(), "fence values increase by one per signal");
+                gpuTime = std::max(gpuTime, cpuTime) + workload.gpuMS * jitter();
+                signalTimes.push_back(gpuTime);
+                slotReaders[slot] = frameValue;
+
+                if (frameIdx % 97 == 96)
+                {
+                    uint64_t const flushValue = timeline.nextSignal();
+                    check(flushValue == signalTimes.size(), "flush signals follow frame signals");
+                    signalTimes.push_back(gpuTime);
+                    cpuTime = std::max(cpuTime, gpuTime);
+                }
+            }
+
+            // Serial reference waits for the GPU every frame, as the renderer did before frames in flight
+            double const serialMS = (workload.cpuMS + workload.gpuMS) * frameCount;
+            double const pipelinedMS = std::max(cpuTime, gpuTime);
+            printf("%-10s %u frames: %.2f ms / frame pipelined (%.2f ms CPU waiting), %.2f ms / frame serial, %u frames queued at most\n",
+                workload.name, frameCount, pipelinedMS / frameCount, waitTime / frameCount, serialMS / frameCount, maxInFlight + 1);
+        }
+
+        printf("Frame timeline %s\n", check.passed() ? "passed" : "FAILED");
+        return check.passed();
+    }
+
+    bool testDescriptorAllocator(uint32_t operationCount)
+    {
+        Checker check{ "Descriptor allocator" };
+
+        // Fixed cases for merging freed ranges with their neighbours
+        {
+            DescriptorFreeList freeList(16, 64);
+            uint32_t const a = freeList.allocate(8);
+            uint32_t const b = freeList.allocate(8);
+            uint32_t const c = freeList.allocate(8);
+            check(a == 16 && b == 24 && c == 32, "allocations are contiguous from the heap offset");
+            check(freeList.allocate(41) == DescriptorFreeList::InvalidIndex, "allocation larger than the free space fails");
+
+            freeList.free(b, 8);
+            check(freeList.freeRangeCount() == 2 && freeList.largestFreeRange() == 40, "freed range between allocations stays separate");
+            check(freeList.allocate(4) == 24, "first fit reuses the freed range");
+            freeList.free(24, 4);
+            freeList.free(a, 8);
+            check(freeList.freeRangeCount() == 2, "freed range merges with the next free range");
+            freeList.free(c, 8);
+            check(freeList.freeRangeCount() == 1 && freeList.freeCount() == 64, "freed range merges with both neighbours");
+            check(freeList.allocate(64) == 16 && freeList.freeCount() == 0, "merged ranges satisfy a full size allocation");
+            check(freeList.allocate(0) == DescriptorFreeList::InvalidIndex, "empty allocation fails");
+        }
+
+        {
+            DescriptorFrameAllocator frameAllocator(100, 30, 3);
+            frameAllocator.beginFrame(1);
+            check(frameAllocator.allocate(4) == 110 && frameAllocator.allocate(6) == 114, "frame allocations are linear in the slot's region");
+            check(frameAllocator.allocate(1) == DescriptorFrameAllocator::InvalidIndex, "frame allocation fails once the region is full");
+            frameAllocator.beginFrame(2);
+            check(frameAllocator.allocate(10) == 120 && frameAllocator.peakCount() == 10, "next slot starts at its own region");
+            frameAllocator.beginFrame(1);
+            check(frameAllocator.usedCount() == 0 && frameAllocator.allocate(1) == 110, "reused slot restarts its region");
+        }
+
+        // Random allocations & frees checked against a per descriptor ownership map, live ranges must never overlap
+        struct LiveRange
+        {
+            uint32_t index;
+            uint32_t count;
+        };
+
+        constexpr uint32_t Offset = 8;
+        constexpr uint32_t Capacity = 4096;
+        DescriptorFreeList freeList(Offset, Capacity);
+        std::vector<bool> used(Capacity, false);
+        std::vector<LiveRange> liveRanges;
+        uint32_t failedCount = 0;
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+
+        for (uint32_t operationIdx = 0; operationIdx < operationCount && check.passed(); operationIdx++)
+        {
+            if (liveRanges.empty() || random() % 2 == 0)
+            {
+                // Mostly single descriptors with the occasional table
+                uint32_t const count = (random() % 8 == 0) ? 1 + random() % 64 : 1;
+                uint32_t const index = freeList.allocate(count);
+                if (index == DescriptorFreeList::InvalidIndex)
+                {
+                    failedCount++;
+                    check(freeList.largestFreeRange() < count, "allocation fails only without a large enough free range");
+                    continue;
+                }
+
+                check(index >= Offset && index + count <= Offset + Capacity, "allocation is within the heap");
+                for (uint32_t descriptorIdx = index; descriptorIdx < index + count && check.passed(); descriptorIdx++)
+                {
+                    check(!used[descriptorIdx - Offset], "allocation overlaps a live range");
+                    used[descriptorIdx - Offset] = true;
+                }
+
+                liveRanges.push_back(LiveRange{ index, count });
+            }
+            else
+            {
+                size_t const liveIdx = random() % liveRanges.size();
+                LiveRange const live = liveRanges[liveIdx];
+                liveRanges[liveIdx] = liveRanges.back();
+                liveRanges.pop_back();
+                freeList.free(live.index, live.count);
+                for (uint32_t descriptorIdx = live.index; descriptorIdx < live.index + live.count; descriptorIdx++) {
+                    used[descriptorIdx - Offset] = false;
+                }
+            }
+
+            check(freeList.freeCount() == static_cast<uint32_t>(std::count(used.begin(), used.end(), false)), "free count matches the live ranges");
+        }
+
+        uint32_t const peakRangeCount = freeList.freeRangeCount();
+        for (auto const& live : liveRanges) {
+            freeList.free(live.index, live.count);
+        }
+        check(freeList.freeRangeCount() == 1 && freeList.freeCount() == Capacity, "freeing everything merges back into a single range");
+
+        // Throughput of the typical patterns, static descriptors churned one at a time & a transient table per draw
+        constexpr uint32_t BenchmarkCount = 1000000;
+        Timer timer{};
+        uint32_t checksum = 0;
+        {
+            DescriptorFreeList benchmarkList(0, Capacity);
+            std::vector<uint32_t> indices;
+            for (uint32_t descriptorIdx = 0; descriptorIdx < Capacity / 2; descriptorIdx++) {
+                indices.push_back(benchmarkList.allocate(1));
+            }
+
+            timer.reset();
+            for (uint32_t benchmarkIdx = 0; benchmarkIdx < BenchmarkCount; benchmarkIdx++)
+            {
+                uint32_t& index = indices[random() % indices.size()];
+                benchmarkList.free(index, 1);
+                index = benchmarkList.allocate(1);
+                checksum += index;
+            }
+            timer.tick();
+        }
+        double const freeListMS = timer.deltaTimeMS();
+
+        {
+            DescriptorFrameAllocator benchmarkAllocator(0, Capacity, 3);
+            timer.reset();
+            for (uint32_t benchmarkIdx = 0; benchmarkIdx < BenchmarkCount; benchmarkIdx++)
+            {
+                if (benchmarkIdx % 256 == 0) {
+                    benchmarkAllocator.beginFrame((benchmarkIdx / 256) % 3);
+                }
+                checksum += benchmarkAllocator.allocate(4);
+            }
+            timer.tick();
+        }
+        double const frameAllocatorMS = timer.deltaTimeMS();
+
+        printf("Descriptor allocator %s (%u operations, %u allocations failed, %u free ranges before teardown)\n", check.passed() ? "passed" : "FAILED", operationCount, failedCount, peakRangeCount);
+        printf("  Free list free+allocate: %.1f M ops/s\n", BenchmarkCount / std::max(freeListMS, 1e-6) / 1000.0);
+        printf("  Frame allocator allocate: %.1f M ops/s (checksum %u)\n", BenchmarkCount / std::max(frameAllocatorMS, 1e-6) / 1000.0, checksum);
+        return check.passed();
+    }
+
+    bool testHeapAllocator(uint32_t operationCount)
+    {
+        Checker check{ "Heap allocator" };
+
+        constexpr uint64_t KiB = 1024;
+        constexpr uint64_t MiB = 1024 * KiB;
+        constexpr uint64_t PlacementAlignment = 64 * KiB;
+        constexpr uint64_t MSAAPlacementAlignment = 4 * MiB;
+
+        // Fixed cases for placement alignment, good fit & merging
+        {
+            TLSFAllocator heap(64 * MiB);
+            TLSFAllocator::Allocation const a = heap.allocate(256 * KiB, PlacementAlignment);
+            TLSFAllocator::Allocation const b = heap.allocate(PlacementAlignment, MSAAPlacementAlignment);
+            check(a.offset == 0 && b.offset == 4 * MiB, "MSAA allocation skips to the next 4MB boundary");
+            check(heap.statistics().freeBlockCount == 2, "alignment padding is split off as a free block");
+
+            TLSFAllocator::Allocation const c = heap.allocate(MiB, PlacementAlignment);
+            check(c.offset == 256 * KiB, "good fit uses the alignment padding before the larger free block");
+
+            heap.free(a.handle);
+            heap.free(c.handle);
+            check(heap.statistics().freeBlockCount == 2 && heap.statistics().largestFreeBlock == 60 * MiB - PlacementAlignment, "freed blocks merge in front of an allocation");
+            heap.free(b.handle);
+            TLSFAllocator::Statistics const statistics = heap.statistics();
+            check(statistics.freeBlockCount == 1 && statistics.largestFreeBlock == 64 * MiB && statistics.fragmentation == 0.0F, "freeing everything merges back into a single block");
+            check(heap.allocate(64 * MiB + 1, 1).handle == TLSFAllocator::InvalidHandle, "allocation larger than the heap fails");
+            check(heap.allocate(64 * MiB, PlacementAlignment).offset == 0, "allocation of the whole heap succeeds");
+        }
+
+        {
+            TLSFAllocator heap(16 * MiB);
+            TLSFAllocator::Allocation allocations[4];
+            for (auto& allocation : allocations) {
+                allocation = heap.allocate(MiB, PlacementAlignment);
+            }
+
+            heap.free(allocations[0].handle);
+            heap.free(allocations[1].handle);
+            std::vector<TLSFAllocator::Handle> const candidates = heap.defragmentationCandidates(8);
+            check(candidates.size() == 2 && candidates[0] == allocations[3].handle && candidates[1] == allocations[2].handle, "allocations above a fitting free block are defragmentation candidates, highest first");
+            check(heap.statistics().fragmentation > 0.0F, "free space split around allocations is fragmented");
+            check(heap.defragmentationCandidates(1).size() == 1, "defragmentation candidates are limited to the requested count");
+        }
+
+        // Random allocations & frees checked against a reference map of live ranges, including free block merging
+        struct LiveAllocation
+        {
+            TLSFAllocator::Handle handle;
+            uint64_t offset;
+            uint64_t size;
+            uint64_t alignment;
+        };
+
+        constexpr uint64_t Capacity = 256 * MiB;
+        TLSFAllocator heap(Capacity);
+        std::map<uint64_t, uint64_t> liveRanges; //< offset to end
+        std::vector<LiveAllocation> liveAllocations;
+        uint64_t liveSize = 0;
+        uint32_t failedCount = 0;
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+
+        for (uint32_t operationIdx = 0; operationIdx < operationCount && check.passed(); operationIdx++)
+        {
+            if (liveAllocations.empty() || random() % 5 < 3)
+            {
+                // Mostly placed resources in 64KB units, some MSAA targets & small arbitrary sub-allocations
+                uint64_t size = PlacementAlignment * (1 + random() % 64);
+                uint64_t alignment = PlacementAlignment;
+                uint32_t const kind = random() % 16;
+                if (kind == 0) {
+                    alignment = MSAAPlacementAlignment;
+                }
+                else if (kind == 1)
+                {
+                    size = 1 + random() % (256 * KiB);
+                    alignment = 1ULL << (random() % 9);
+                }
+
+                TLSFAllocator::Allocation const allocation = heap.allocate(size, alignment);
+                if (allocation.handle == TLSFAllocator::InvalidHandle)
+                {
+                    failedCount++;
+                    uint64_t const searchSize = size + alignment - 1;
+                    check(heap.statistics().largestFreeBlock < searchSize + searchSize / 16 + 1, "allocation fails only when no free block is a size class above the request");
+                    continue;
+                }
+
+                check(allocation.offset % alignment == 0 && allocation.offset + size <= Capacity, "allocation is aligned & within the heap");
+                auto const next = liveRanges.lower_bound(allocation.offset);
+                check(next == liveRanges.end() || allocation.offset + size <= next->first, "allocation overlaps the next live range");
+                check(next == liveRanges.begin() || std::prev(next)->second <= allocation.offset, "allocation overlaps the previous live range");
+
+                liveRanges[allocation.offset] = allocation.offset + size;
+                liveAllocations.push_back(LiveAllocation{ allocation.handle, allocation.offset, size, alignment });
+                liveSize += size;
+            }
+            else
+            {
+                size_t const liveIdx = random() % liveAllocations.size();
+                LiveAllocation const live = liveAllocations[liveIdx];
+                liveAllocations[liveIdx] = liveAllocations.back();
+                liveAllocations.pop_back();
+                heap.free(live.handle);
+                liveRanges.erase(live.offset);
+                liveSize -= live.size;
+            }
+
+            // Free blocks must match the gaps between live ranges exactly, unmerged neighbours would show up as extra blocks
+            if (operationIdx % 256 == 0)
+            {
+                uint32_t gapCount = 0;
+                uint64_t largestGap = 0;
+                uint64_t end = 0;
+                for (auto const& range : liveRanges)
+                {
+                    gapCount += (range.first > end) ? 1 : 0;
+                    largestGap = std::max(largestGap, range.first - end);
+                    end = range.second;
+                }
+                gapCount += (Capacity > end) ? 1 : 0;
+                largestGap = std::max(largestGap, Capacity - end);
+
+                TLSFAllocator::Statistics const statistics = heap.statistics();
+                check(statistics.usedSize == liveSize && statistics.allocationCount == liveAllocations.size(), "used size matches the live allocations");
+                check(statistics.freeBlockCount == gapCount && statistics.largestFreeBlock == largestGap, "free blocks match the gaps between live allocations");
+            }
+        }
+
+        // Apply the defragmentation hints, moves only count when the new placement is lower
+        TLSFAllocator::Statistics const fragmentedStatistics = heap.statistics();
+        uint32_t moveCount = 0;
+        for (TLSFAllocator::Handle handle : heap.defragmentationCandidates(256))
+        {
+            auto const live = std::find_if(liveAllocations.begin(), liveAllocations.end(), [handle](LiveAllocation const& allocation) { return allocation.handle == handle; });
+            TLSFAllocator::Allocation const moved = heap.allocate(live->size, live->alignment);
+            if (moved.handle == TLSFAllocator::InvalidHandle) {
+                continue;
+            }
+
+            if (moved.offset > live->offset)
+            {
+                heap.free(moved.handle);
+                continue;
+            }
+
+            heap.free(live->handle);
+            live->handle = moved.handle;
+            live->offset = moved.offset;
+            moveCount++;
+        }
+        TLSFAllocator::Statistics const defragmentedStatistics = heap.statistics();
+        check(defragmentedStatistics.usedSize == liveSize, "defragmentation moves keep the used size");
+
+        for (auto const& live : liveAllocations) {
+            heap.free(live.handle);
+        }
+        check(heap.statistics().freeBlockCount == 1 && heap.statistics().largestFreeBlock == Capacity, "freeing everything merges back into a single block");
+
+        printf("Heap allocator %s (%u operations, %u allocations failed)\n", check.passed() ? "passed" : "FAILED", operationCount, failedCount);
+        printf("  Fragmentation %.1f%% over %u free blocks, %.1f%% over %u after %u defragmentation moves\n",
+            fragmentedStatistics.fragmentation * 100.0F, fragmentedStatistics.freeBlockCount, defragmentedStatistics.fragmentation * 100.0F, defragmentedStatistics.freeBlockCount, moveCount);
+
+        // Churn throughput against a first fit free list over 64KB units, random frees keep both around half full with 2k live
+        // allocations
+        constexpr uint32_t BenchmarkCount = 1000000;
+        constexpr uint32_t LiveCount = 2048;
+        constexpr uint64_t BenchmarkCapacity = 4096 * MiB;
+        constexpr uint32_t UnitCount = static_cast<uint32_t>(BenchmarkCapacity / PlacementAlignment);
+        std::vector<uint32_t> sizes(BenchmarkCount);
+        std::vector<uint32_t> slots(BenchmarkCount); //< live allocation replaced by each operation
+        for (uint32_t benchmarkIdx = 0; benchmarkIdx < BenchmarkCount; benchmarkIdx++)
+        {
+            sizes[benchmarkIdx] = 1 + random() % 32;
+            slots[benchmarkIdx] = random() % LiveCount;
+        }
+
+        Timer timer{};
+        uint64_t checksum = 0;
+        {
+            TLSFAllocator benchmarkHeap(BenchmarkCapacity);
+            std::vector<TLSFAllocator::Handle> handles;
+            for (uint32_t liveIdx = 0; liveIdx < LiveCount; liveIdx++) {
+                handles.push_back(benchmarkHeap.allocate(sizes[liveIdx] * PlacementAlignment, PlacementAlignment).handle);
+            }
+
+            timer.reset();
+            for (uint32_t benchmarkIdx = 0; benchmarkIdx < BenchmarkCount; benchmarkIdx++)
+            {
+                TLSFAllocator::Handle& handle = handles[slots[benchmarkIdx]];
+                benchmarkHeap.free(handle);
+                TLSFAllocator::Allocation const allocation = benchmarkHeap.allocate(sizes[benchmarkIdx] * PlacementAlignment, PlacementAlignment);
+                handle = allocation.handle;
+                checksum += allocation.offset;
+            }
+            timer.tick();
+        }
+        double const tlsfMS = timer.deltaTimeMS();
+
+        {
+            DescriptorFreeList benchmarkList(0, UnitCount);
+            std::vector<std::pair<uint32_t, uint32_t>> ranges;
+            for (uint32_t liveIdx = 0; liveIdx < LiveCount; liveIdx++) {
+                ranges.emplace_back(benchmarkList.allocate(sizes[liveIdx]), sizes[liveIdx]);
+            }
+
+            timer.reset();
+            for (uint32_t benchmarkIdx = 0; benchmarkIdx < BenchmarkCount; benchmarkIdx++)
+            {
+                auto& range = ranges[slots[benchmarkIdx]];
+                benchmarkList.free(range.first, range.second);
+                range = std::make_pair(benchmarkList.allocate(sizes[benchmarkIdx]), sizes[benchmarkIdx]);
+                checksum += range.first;
+            }
+            timer.tick();
+        }
+        double const firstFitMS = timer.deltaTimeMS();
+
+        printf("  TLSF free+allocate:      %.1f M ops/s\n", BenchmarkCount / std::max(tlsfMS, 1e-6) / 1000.0);
+        printf("  First fit free+allocate: %.1f M ops/s (checksum %llu)\n", BenchmarkCount / std::max(firstFitMS, 1e-6) / 1000.0, static_cast<unsigned long long>(checksum));
+        return check.passed();
+    }
+} // namespace Tests
@@ -0,0 +1,359 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "culling.hpp"
+#include "job_system.hpp"
+#include "lod.hpp"
+#include "mesh.hpp"
+#include "meshlet.hpp"
+#include "tangent_space.hpp"
+#include "vertex_packing.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    /// @brief Check no camera backface culls a meshlet that has a triangle facing it, counting the culled meshlets. A triangle
+    /// faces the camera if the camera is in front of its plane by more than the tolerance.
+    static bool checkConeCulling(MeshData const& meshData, glm::vec3 const* pCameras, size_t cameraCount, float tolerance, size_t& culledCount)
+    {
+        // Planes that contain everything, so only the normal cone can reject a meshlet
+        Frustum frustum{};
+        for (auto& plane : frustum.planes) {
+            plane = glm::vec4(0.0F, 0.0F, 0.0F, 1.0F);
+        }
+
+        MeshletData const& meshletData = meshData.meshlets;
+        for (size_t cameraIdx = 0; cameraIdx < cameraCount; cameraIdx++)
+        {
+            glm::vec3 const& camera = pCameras[cameraIdx];
+            for (size_t meshletIdx = 0; meshletIdx < meshletData.meshlets.size(); meshletIdx++)
+            {
+                if (Meshlets::cullMeshlet(meshletData.bounds[meshletIdx], frustum, camera) != Meshlets::CullResult::Backface) {
+                    continue;
+                }
+
+                culledCount++;
+                Meshlet const& meshlet = meshletData.meshlets[meshletIdx];
+                for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++)
+                {
+                    glm::vec3 positions[3];
+                    for (uint32_t corner = 0; corner < 3; corner++)
+                    {
+                        uint8_t const localIdx = meshletData.triangles[(meshlet.triangleOffset + triangle) * 3 + corner];
+                        positions[corner] = meshData.vertices[meshletData.vertices[meshlet.vertexOffset + localIdx]].position;
+                    }
+
+                    glm::vec3 const normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+                    float const length = glm::length(normal);
+                    if (length > 0.0F && glm::dot(camera - positions[0], normal / length) > tolerance)
+                    {
+                        printf("Meshlet check failed: meshlet %zu backface culled from (%.3f, %.3f, %.3f) while triangle %u faces the camera\n",
+                            meshletIdx, static_cast<double>(camera.x), static_cast<double>(camera.y), static_cast<double>(camera.z), triangle);
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /// @brief V shaped valley of upward facing quads along z, a concave cluster whose bounding sphere center lies in front of
+    /// every triangle.
+    static void buildValley(MeshData& meshData)
+    {
+        constexpr uint32_t Columns = 8;
+        constexpr uint32_t Rows = 4;
+        constexpr float Slope = 0.75F;
+
+        meshData = MeshData{};
+        for (uint32_t row = 0; row <= Rows; row++)
+        {
+            for (uint32_t column = 0; column <= Columns; column++)
+            {
+                float const x = -1.0F + 2.0F * static_cast<float>(column) / static_cast<float>(Columns);
+                Vertex vertex{};
+                vertex.position = glm::vec3(x, std::abs(x) * Slope, static_cast<float>(row) / static_cast<float>(Rows));
+                meshData.vertices.push_back(vertex);
+            }
+        }
+
+        for (uint32_t row = 0; row < Rows; row++)
+        {
+            for (uint32_t column = 0; column < Columns; column++)
+            {
+                uint32_t const v00 = row * (Columns + 1) + column;
+                uint32_t const v10 = v00 + 1;
+                uint32_t const v01 = v00 + Columns + 1;
+                uint32_t const v11 = v01 + 1;
+                meshData.indices.insert(meshData.indices.end(), { v00, v01, v10, v10, v01, v11 });
+            }
+        }
+
+        Meshlets::buildMeshlets(meshData, meshData.meshlets);
+    }
+
+    bool testMeshlets(char const* sourcePath)
+    {
+        constexpr uint32_t CameraCount = 2000;
+
+        JobSystem jobs{}; //< parsing & processing split their loops over the calling thread's job system
+        MeshData meshData{};
+        if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+            return false;
+        }
+
+        MeshHelpers::processMesh(meshData);
+
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return static_cast<float>(state) / static_cast<float>(UINT32_MAX); };
+
+        // Cameras all around & inside the mesh, close ones see the most triangles edge on
+        MeshBounds const meshBounds = Culling::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+        std::vector<glm::vec3> cameras(CameraCount);
+        for (auto& camera : cameras) {
+            camera = meshBounds.sphereCenter + (glm::vec3(random(), random(), random()) * 2.0F - 1.0F) * meshBounds.sphereRadius * 1.5F;
+        }
+
+        size_t meshCulled = 0;
+        bool success = checkConeCulling(meshData, cameras.data(), cameras.size(), meshBounds.sphereRadius * 1e-4F, meshCulled);
+
+        // Cameras inside the valley see every triangle, the ones well below it see none
+        MeshData valley{};
+        buildValley(valley);
+        for (auto& camera : cameras) {
+            camera = glm::vec3(random() * 3.0F - 1.5F, random() * 4.0F - 2.0F, random() * 2.0F - 0.5F);
+        }
+
+        size_t valleyCulled = 0;
+        success = success && checkConeCulling(valley, cameras.data(), cameras.size(), 1e-4F, valleyCulled);
+        if (success && (valley.meshlets.meshlets.size() != 1 || valley.meshlets.bounds[0].coneAxis == glm::vec3(0.0F) || valleyCulled == 0))
+        {
+            printf("Meshlet check failed: the valley should be one meshlet with a normal cone that culls from below\n");
+            success = false;
+        }
+
+        printf("Meshlet culling %s [%s] (%zu meshlets, %u cameras, %zu backface culls, %zu of %u cameras cull the concave valley)\n",
+            success ? "passed" : "FAILED", sourcePath, meshData.meshlets.meshlets.size(), CameraCount, meshCulled, valleyCulled, CameraCount);
+        return success;
+    }
+
+    bool testLods(char const* sourcePath)
+    {
+        constexpr float TargetTolerance = 0.02F;    //< levels may keep this ratio of triangles over their target
+        constexpr float MaxRelativeError = 0.05F;   //< measured error bound, relative to the bounding radius
+
+        JobSystem jobs{}; //< parsing & processing split their loops over the calling thread's job system
+        MeshData meshData{};
+        if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+            return false;
+        }
+
+        MeshHelpers::processMesh(meshData);
+
+        Checker check{ "LOD", true };
+
+        LodData const& lods = meshData.lods;
+        size_t const triangleCount = meshData.indices.size() / 3;
+        float const radius = Culling::computeBounds(meshData.vertices.data(), meshData.vertices.size()).sphereRadius;
+        float previousError = 0.0F;
+        float previousMeasuredError = 0.0F;
+        for (size_t levelIdx = 0; levelIdx < lods.levels.size(); levelIdx++)
+        {
+            LodLevel const& level = lods.levels[levelIdx];
+            float const targetTriangles = static_cast<float>(triangleCount) * Lods::DefaultLodRatios[levelIdx];
+            float const measuredError = Lods::measureError(meshData.vertices, lods.indices.data() + level.indexOffset, level.indexCount);
+            printf("  LOD %zu  %8u triangles (target %8.0f)  quadric error %.5f  measured error %.5f (relative to bounding radius)\n",
+                levelIdx + 1, level.indexCount / 3, static_cast<double>(targetTriangles),
+                static_cast<double>(level.error / radius),
+                static_cast<double>(measuredError / radius)
+            );
+
+            check(static_cast<float>(level.indexCount / 3) <= targetTriangles * (1.0F + TargetTolerance), "LOD %zu missed its triangle target", levelIdx + 1);
+            check(level.error >= previousError, "LOD %zu quadric error is below the previous level's", levelIdx + 1);
+            check(measuredError >= previousMeasuredError, "LOD %zu measured error is below the previous level's", levelIdx + 1);
+            check(measuredError <= radius * MaxRelativeError, "LOD %zu measured error exceeds the bound", levelIdx + 1);
+            previousError = level.error;
+            previousMeasuredError = measuredError;
+        }
+
+        printf("LODs %s [%s] (%zu levels, triangle targets within %.0f%%, measured error within %.0f%% of the bounding radius)\n",
+            check.passed() ? "passed" : "FAILED", sourcePath, lods.levels.size(), 100.0 * TargetTolerance, 100.0 * MaxRelativeError);
+        return check.passed();
+    }
+
+    bool testVertexPacking(char const* sourcePath)
+    {
+        constexpr size_t SpotCheckCount = 64;
+
+        JobSystem jobs{}; //< parsing & processing split their loops over the calling thread's job system
+        MeshData meshData{};
+        if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+            return false;
+        }
+
+        MeshHelpers::processMesh(meshData);
+
+        Checker check{ "Packing" };
+
+        std::vector<Vertex> const& vertices = meshData.vertices;
+        float maxTexCoord = 0.0F;
+        for (auto const& vertex : vertices) {
+            maxTexCoord = std::max(maxTexCoord, std::max(std::abs(vertex.texCoord.x), std::abs(vertex.texCoord.y)));
+        }
+
+        VertexPacking::QuantizationBounds const bounds = VertexPacking::computeBounds(vertices.data(), vertices.size());
+        VertexPacking::PackingError const error = VertexPacking::measureError(vertices.data(), vertices.size(), bounds);
+        VertexPacking::PackingError const errorBounds = VertexPacking::errorBounds(bounds, maxTexCoord);
+        check(error.position <= errorBounds.position, "position error exceeds its bound");
+        check(error.normalDegrees <= errorBounds.normalDegrees, "normal error exceeds its bound");
+        check(error.tangentDegrees <= errorBounds.tangentDegrees, "tangent error exceeds its bound");
+        check(error.texCoord <= errorBounds.texCoord, "texture coordinate error exceeds its bound");
+        check(error.color <= errorBounds.color, "color error exceeds its bound");
+
+        // Vertices spread over the mesh, decoded from the packed buffer the renderer uploads
+        std::vector<PackedVertex> packedVertices(vertices.size());
+        VertexPacking::packVertices(vertices.data(), vertices.size(), bounds, packedVertices.data());
+        size_t const spotStride = std::max<size_t>(1, vertices.size() / SpotCheckCount);
+        for (size_t vertexIdx = 0; vertexIdx < vertices.size(); vertexIdx += spotStride)
+        {
+            Vertex const& vertex = vertices[vertexIdx];
+            Vertex const decoded = VertexPacking::decode(packedVertices[vertexIdx], bounds);
+            glm::vec3 const positionDelta = glm::abs(decoded.position - vertex.position);
+            check(std::max(positionDelta.x, std::max(positionDelta.y, positionDelta.z)) <= errorBounds.position, "decoded position is off");
+            float const normalDegrees = glm::degrees(std::atan2(glm::length(glm::cross(decoded.normal, vertex.normal)), glm::dot(decoded.normal, vertex.normal)));
+            check(normalDegrees <= errorBounds.normalDegrees, "decoded normal is off");
+            check(std::abs(glm::length(decoded.normal) - 1.0F) < 1e-4F, "decoded normal isn't unit length");
+            check((decoded.tangent.w < 0.0F) == (vertex.tangent.w < 0.0F), "decoded tangent handedness flipped");
+            glm::vec2 const texCoordDelta = glm::abs(decoded.texCoord - vertex.texCoord);
+            check(std::max(texCoordDelta.x, texCoordDelta.y) <= errorBounds.texCoord, "decoded texture coordinate is off");
+        }
+
+        // 16-bit indices exactly when every vertex index fits in them
+        using VertexPacking::IndexFormat;
+        check(VertexPacking::indexFormat(vertices.size()) == (vertices.size() <= 65535 ? IndexFormat::R16_UINT : IndexFormat::R32_UINT), "mesh index format doesn't match its vertex count");
+        check(VertexPacking::indexFormat(1) == IndexFormat::R16_UINT, "a single vertex needs 32-bit indices");
+        check(VertexPacking::indexFormat(65535) == IndexFormat::R16_UINT, "65535 vertices need 32-bit indices");
+        check(VertexPacking::indexFormat(65536) == IndexFormat::R32_UINT, "65536 vertices fit 16-bit indices");
+
+        printf("Vertex packing %s [%s] (%zu vertices, %zu spot checks, %s indices): position %.3g / %.3g, normal %.3g / %.3g deg, tangent %.3g / %.3g deg, texcoord %.3g / %.3g, color %.3g / %.3g\n",
+            check.passed() ? "passed" : "FAILED", sourcePath, vertices.size(), (vertices.size() + spotStride - 1) / spotStride,
+            VertexPacking::indexFormat(vertices.size()) == IndexFormat::R16_UINT ? "16-bit" : "32-bit",
+            static_cast<double>(error.position), static_cast<double>(errorBounds.position),
+            static_cast<double>(error.normalDegrees), static_cast<double>(errorBounds.normalDegrees),
+            static_cast<double>(error.tangentDegrees), static_cast<double>(errorBounds.tangentDegrees),
+            static_cast<double>(error.texCoord), static_cast<double>(errorBounds.texCoord),
+            static_cast<double>(error.color), static_cast<double>(errorBounds.color)
+        );
+        return check.passed();
+    }
+
+    /// @brief Two quads facing +z with separate vertices, texture u along +x on the left & mirrored along -x on the right, as
+    /// on the seam of a symmetric mesh sharing one UV island. v runs along +y on both.
+    static void buildMirroredQuads(MeshData& meshData)
+    {
+        meshData = MeshData{};
+        for (float const left : { -1.0F, 0.0F })
+        {
+            uint32_t const base = static_cast<uint32_t>(meshData.vertices.size());
+            for (uint32_t corner = 0; corner < 4; corner++)
+            {
+                float const x = left + static_cast<float>(corner & 1);
+                float const y = static_cast<float>(corner >> 1);
+                Vertex vertex{};
+                vertex.position = glm::vec3(x, y, 0.0F);
+                vertex.normal = glm::vec3(0.0F, 0.0F, 1.0F);
+                vertex.texCoord = glm::vec2(1.0F - std::abs(x), y);
+                vertex.color = glm::vec3(1.0F);
+                meshData.vertices.push_back(vertex);
+            }
+
+            meshData.indices.insert(meshData.indices.end(), { base + 0, base + 1, base + 2, base + 2, base + 1, base + 3 });
+        }
+    }
+
+    bool testTangents(char const* sourcePath)
+    {
+        constexpr float Tolerance = 1e-3F;
+
+        Checker check{ "Tangent" };
+
+        auto const checkFrame = [&check](Vertex const& vertex)
+        {
+            glm::vec3 const tangent = glm::vec3(vertex.tangent);
+            check(std::abs(glm::length(tangent) - 1.0F) < Tolerance, "tangent isn't unit length");
+            check(std::abs(glm::dot(glm::normalize(vertex.normal), tangent)) < Tolerance, "tangent isn't orthogonal to the normal");
+            check(vertex.tangent.w == 1.0F || vertex.tangent.w == -1.0F, "handedness isn't +1 or -1");
+        };
+
+        // Mirrored texture coords flip the tangent & the handedness, the bitangent keeps following +v
+        MeshData quads{};
+        buildMirroredQuads(quads);
+        TangentSpace::generateTangents(quads);
+        for (size_t vertexIdx = 0; vertexIdx < quads.vertices.size(); vertexIdx++)
+        {
+            Vertex const& vertex = quads.vertices[vertexIdx];
+            bool const mirrored = vertexIdx >= 4;
+            checkFrame(vertex);
+            check(glm::length(glm::vec3(vertex.tangent) - glm::vec3(mirrored ? -1.0F : 1.0F, 0.0F, 0.0F)) < Tolerance, "quad tangent doesn't follow +u");
+            check(vertex.tangent.w == (mirrored ? -1.0F : 1.0F), "quad handedness doesn't match its texture mapping");
+        }
+
+        JobSystem jobs{}; //< parsing & processing split their loops over the calling thread's job system
+        MeshData meshData{};
+        if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+            return false;
+        }
+
+        // A triangle's handedness relative to a vertex normal is the sign of its texture mapping's determinant times the side
+        // of its plane the normal is on. Vertices whose triangles all agree must get that sign.
+        std::vector<Vertex> const& vertices = meshData.vertices;
+        std::vector<int8_t> expectedSigns(vertices.size(), 0); //< 0 no usable triangle yet, 2 triangles disagree
+        for (size_t triangleIdx = 0; triangleIdx < meshData.indices.size() / 3; triangleIdx++)
+        {
+            uint32_t const* pCorners = &meshData.indices[triangleIdx * 3];
+            Vertex const& v0 = vertices[pCorners[0]];
+            glm::vec3 const faceNormal = glm::cross(vertices[pCorners[1]].position - v0.position, vertices[pCorners[2]].position - v0.position);
+            glm::vec2 const uv1 = vertices[pCorners[1]].texCoord - v0.texCoord;
+            glm::vec2 const uv2 = vertices[pCorners[2]].texCoord - v0.texCoord;
+            float const det = uv1.x * uv2.y - uv2.x * uv1.y;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                float const side = glm::dot(vertices[pCorners[corner]].normal, faceNormal) * det;
+                if (side == 0.0F) {
+                    continue;
+                }
+
+                int8_t const sign = (side > 0.0F) ? 1 : -1;
+                int8_t& expected = expectedSigns[pCorners[corner]];
+                expected = (expected == 0 || expected == sign) ? sign : 2;
+            }
+        }
+
+        size_t signChecks = 0;
+        size_t mirroredCount = 0;
+        for (size_t vertexIdx = 0; vertexIdx < vertices.size(); vertexIdx++)
+        {
+            Vertex const& vertex = vertices[vertexIdx];
+            checkFrame(vertex);
+            mirroredCount += (vertex.tangent.w < 0.0F) ? 1 : 0;
+            if (expectedSigns[vertexIdx] == 1 || expectedSigns[vertexIdx] == -1)
+            {
+                check(vertex.tangent.w == static_cast<float>(expectedSigns[vertexIdx]), "handedness doesn't match the texture mapping of the vertex's triangles");
+                signChecks++;
+            }
+        }
+
+        check(signChecks > 0, "no vertex has triangles agreeing on their handedness");
+
+        printf("Tangent space %s [%s] (%zu vertices, %zu mirrored, %zu handedness checks, mirrored quad)\n",
+            check.passed() ? "passed" : "FAILED", sourcePath, vertices.size(), mirroredCount, signChecks);
+        return check.passed();
+    }
+} // namespace Tests
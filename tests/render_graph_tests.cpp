@@ -0,0 +1,337 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "render_graph.hpp"
+#include "timer.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    /// @brief Replay a compiled graph's barriers on simulated resource states, checking each pass finds its resources in the
+    /// declared states, split barriers aren't accessed mid transition & aliased transients are activated before their first use.
+    static bool validateRenderGraph(RenderGraph const& graph, std::vector<ResourceState> const& initialStates, std::vector<ResourceState> const& finalStates)
+    {
+        Checker check{ "Render graph", true };
+
+        std::vector<ResourceState> states(graph.resourceCount());
+        std::vector<bool> splitPending(graph.resourceCount(), false);
+        std::vector<bool> activated(graph.resourceCount(), false);
+        for (RenderGraph::ResourceId resourceId = 0; resourceId < graph.resourceCount(); resourceId++) {
+            states[resourceId] = graph.transient(resourceId) ? graph.initialState(resourceId) : initialStates[resourceId];
+        }
+
+        auto const memoryOverlaps = [&graph](RenderGraph::ResourceId a, RenderGraph::ResourceId b)
+        {
+            return graph.heapOffset(a) < graph.heapOffset(b) + graph.size(b) && graph.heapOffset(b) < graph.heapOffset(a) + graph.size(a);
+        };
+
+        // Transients with overlapping lifetimes must not share memory
+        for (RenderGraph::ResourceId a = 0; a < graph.resourceCount(); a++)
+        {
+            for (RenderGraph::ResourceId b = a + 1; b < graph.resourceCount(); b++)
+            {
+                if (!graph.transient(a) || !graph.transient(b) || graph.firstPass(a) == RenderGraph::InvalidId || graph.firstPass(b) == RenderGraph::InvalidId) {
+                    continue;
+                }
+
+                bool const lifetimesOverlap = graph.firstPass(a) <= graph.lastPass(b) && graph.firstPass(b) <= graph.lastPass(a);
+                check(!lifetimesOverlap || !memoryOverlaps(a, b), "transients in use at the same time share memory");
+            }
+        }
+
+        graph.execute([&](std::vector<RenderGraph::Barrier> const& barriers)
+        {
+            for (auto const& barrier : barriers)
+            {
+                switch (barrier.type)
+                {
+                case RenderGraph::BarrierType::Transition:
+                    check(!splitPending[barrier.resource] && states[barrier.resource] == barrier.before, "transition doesn't start from the current state");
+                    states[barrier.resource] = barrier.after;
+                    break;
+                case RenderGraph::BarrierType::SplitBegin:
+                    check(!splitPending[barrier.resource] && states[barrier.resource] == barrier.before, "split barrier doesn't start from the current state");
+                    splitPending[barrier.resource] = true;
+                    break;
+                case RenderGraph::BarrierType::SplitEnd:
+                    check(splitPending[barrier.resource], "split barrier ends without beginning");
+                    splitPending[barrier.resource] = false;
+                    states[barrier.resource] = barrier.after;
+                    break;
+                case RenderGraph::BarrierType::Aliasing:
+                    check(barrier.aliasedResource == RenderGraph::InvalidId || memoryOverlaps(barrier.resource, barrier.aliasedResource), "aliasing barrier between resources not sharing memory");
+                    activated[barrier.resource] = true;
+                    break;
+                }
+            }
+        });
+
+        // Replay again with the pass accesses, execute only exposes barrier batches so pass boundaries are rebuilt here
+        std::fill(splitPending.begin(), splitPending.end(), false);
+        for (RenderGraph::ResourceId resourceId = 0; resourceId < graph.resourceCount(); resourceId++) {
+            states[resourceId] = graph.transient(resourceId) ? graph.initialState(resourceId) : initialStates[resourceId];
+        }
+
+        auto const apply = [&](std::vector<RenderGraph::Barrier> const& barriers)
+        {
+            for (auto const& barrier : barriers)
+            {
+                if (barrier.type == RenderGraph::BarrierType::SplitBegin) {
+                    splitPending[barrier.resource] = true;
+                }
+                else if (barrier.type != RenderGraph::BarrierType::Aliasing)
+                {
+                    splitPending[barrier.resource] = false;
+                    states[barrier.resource] = barrier.after;
+                }
+            }
+        };
+
+        for (RenderGraph::PassId passId = 0; passId < graph.passCount(); passId++)
+        {
+            if (graph.culled(passId)) {
+                continue;
+            }
+
+            apply(graph.passBarriers(passId));
+            for (auto const& access : graph.passAccesses(passId))
+            {
+                ResourceState const state = states[access.resource];
+                bool const write = (access.state & WriteStates) != ResourceState::Undefined;
+                check(!splitPending[access.resource], "resource accessed during a split barrier");
+                check(state == access.state || (!write && state != ResourceState::Present && (state & WriteStates) == ResourceState::Undefined && (state & access.state) == access.state), "pass accesses a resource in the wrong state");
+
+                // Transients sharing memory with another must have been activated by an aliasing barrier
+                if (graph.transient(access.resource) && graph.firstPass(access.resource) == passId)
+                {
+                    bool shared = false;
+                    for (RenderGraph::ResourceId otherId = 0; otherId < graph.resourceCount(); otherId++)
+                    {
+                        shared = shared || (otherId != access.resource && graph.transient(otherId) && graph.firstPass(otherId) != RenderGraph::InvalidId && memoryOverlaps(access.resource, otherId));
+                    }
+                    check(!shared || activated[access.resource], "aliased transient used without an aliasing barrier");
+                }
+            }
+        }
+
+        apply(graph.finalBarriers());
+        for (RenderGraph::ResourceId resourceId = 0; resourceId < graph.resourceCount(); resourceId++)
+        {
+            check(!splitPending[resourceId], "split barrier still pending at the end");
+            ResourceState const expected = graph.transient(resourceId) ? graph.initialState(resourceId) : finalStates[resourceId];
+            check(graph.transient(resourceId) && graph.firstPass(resourceId) == RenderGraph::InvalidId ? true : states[resourceId] == expected, "resource doesn't end in its final state");
+        }
+
+        // Culled passes have no side effects & nothing later reads what they write
+        for (RenderGraph::PassId passId = 0; passId < graph.passCount(); passId++)
+        {
+            if (!graph.culled(passId)) {
+                continue;
+            }
+
+            for (auto const& access : graph.passAccesses(passId))
+            {
+                if ((access.state & WriteStates) == ResourceState::Undefined) {
+                    continue;
+                }
+
+                check(graph.transient(access.resource), "pass writing an imported resource was culled");
+                for (RenderGraph::PassId laterId = passId + 1; laterId < graph.passCount(); laterId++)
+                {
+                    for (auto const& laterAccess : graph.passAccesses(laterId)) {
+                        check(graph.culled(laterId) || laterAccess.resource != access.resource, "culled pass feeds a remaining pass");
+                    }
+                }
+            }
+        }
+
+        return check.passed();
+    }
+
+    bool testRenderGraph(uint32_t graphCount)
+    {
+        Checker check{ "Render graph" };
+
+        constexpr uint64_t MiB = 1024 * 1024;
+        constexpr uint64_t PlacementAlignment = 64 * 1024;
+        constexpr uint64_t MSAAPlacementAlignment = 4 * MiB;
+
+        // Deferred frame at 1080p with a debug view nothing reads, sizes as a D3D12 device would report them
+        {
+            RenderGraph graph;
+            std::vector<ResourceState> initialStates;
+            std::vector<ResourceState> finalStates;
+            auto const import = [&](char const* name, ResourceState initialState, ResourceState finalState)
+            {
+                initialStates.push_back(initialState);
+                finalStates.push_back(finalState);
+                return graph.importResource(name, initialState, finalState);
+            };
+            auto const transient = [&](char const* name, uint64_t size, uint64_t alignment)
+            {
+                initialStates.push_back(ResourceState::Undefined);
+                finalStates.push_back(ResourceState::Undefined);
+                return graph.createTransient(name, size, alignment);
+            };
+
+            RenderGraph::ResourceId const backbuffer = import("Backbuffer", ResourceState::Present, ResourceState::Present);
+            RenderGraph::ResourceId const shadowMap = transient("Shadow map", 16 * MiB, PlacementAlignment);
+            RenderGraph::ResourceId const depth = transient("Depth", 8 * MiB + 192 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const albedo = transient("Albedo", 8 * MiB + 192 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const normals = transient("Normals", 8 * MiB + 192 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const occlusion = transient("Occlusion", 2 * MiB + 64 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const lighting = transient("HDR lighting", 16 * MiB + 384 * 1024, MSAAPlacementAlignment);
+            RenderGraph::ResourceId const bloomDown = transient("Bloom down", 4 * MiB + 128 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const bloomUp = transient("Bloom up", 4 * MiB + 128 * 1024, PlacementAlignment);
+            RenderGraph::ResourceId const debugView = transient("Debug view", 8 * MiB + 192 * 1024, PlacementAlignment);
+
+            RenderGraph::PassId const shadowPass = graph.addPass("Shadows", nullptr);
+            graph.write(shadowPass, shadowMap, ResourceState::DepthWrite);
+
+            RenderGraph::PassId const gbufferPass = graph.addPass("GBuffer", nullptr);
+            graph.write(gbufferPass, depth, ResourceState::DepthWrite);
+            graph.write(gbufferPass, albedo, ResourceState::RenderTarget);
+            graph.write(gbufferPass, normals, ResourceState::RenderTarget);
+
+            RenderGraph::PassId const occlusionPass = graph.addPass("SSAO", nullptr);
+            graph.read(occlusionPass, depth, ResourceState::NonPixelShaderResource);
+            graph.read(occlusionPass, normals, ResourceState::NonPixelShaderResource);
+            graph.write(occlusionPass, occlusion, ResourceState::UnorderedAccess);
+
+            RenderGraph::PassId const debugPass = graph.addPass("Debug view", nullptr);
+            graph.read(debugPass, normals, ResourceState::PixelShaderResource);
+            graph.write(debugPass, debugView, ResourceState::RenderTarget);
+
+            RenderGraph::PassId const lightingPass = graph.addPass("Lighting", nullptr);
+            graph.read(lightingPass, shadowMap, ResourceState::PixelShaderResource);
+            graph.read(lightingPass, depth, ResourceState::PixelShaderResource);
+            graph.read(lightingPass, depth, ResourceState::DepthRead);
+            graph.read(lightingPass, albedo, ResourceState::PixelShaderResource);
+            graph.read(lightingPass, normals, ResourceState::PixelShaderResource);
+            graph.read(lightingPass, occlusion, ResourceState::PixelShaderResource);
+            graph.write(lightingPass, lighting, ResourceState::RenderTarget);
+
+            RenderGraph::PassId const bloomDownPass = graph.addPass("Bloom downsample", nullptr);
+            graph.read(bloomDownPass, lighting, ResourceState::NonPixelShaderResource);
+            graph.write(bloomDownPass, bloomDown, ResourceState::UnorderedAccess);
+
+            RenderGraph::PassId const bloomUpPass = graph.addPass("Bloom upsample", nullptr);
+            graph.read(bloomUpPass, bloomDown, ResourceState::NonPixelShaderResource);
+            graph.write(bloomUpPass, bloomUp, ResourceState::UnorderedAccess);
+
+            RenderGraph::PassId const tonemapPass = graph.addPass("Tonemap", nullptr);
+            graph.read(tonemapPass, lighting, ResourceState::PixelShaderResource);
+            graph.read(tonemapPass, bloomUp, ResourceState::PixelShaderResource);
+            graph.write(tonemapPass, backbuffer, ResourceState::RenderTarget);
+
+            RenderGraph::PassId const guiPass = graph.addPass("GUI", nullptr);
+            graph.write(guiPass, backbuffer, ResourceState::RenderTarget);
+
+            graph.compile();
+            graph.report("Deferred frame");
+
+            RenderGraph::Statistics const& statistics = graph.statistics();
+            check(graph.culled(debugPass) && statistics.culledPassCount == 1, "pass writing a transient nothing reads is culled");
+            check(graph.firstPass(debugView) == RenderGraph::InvalidId, "transient only used by culled passes isn't placed");
+            check(statistics.transientMemory < statistics.unaliasedTransientMemory, "transients with disjoint lifetimes alias");
+            check(statistics.splitBarrierCount > 0 && statistics.aliasingBarrierCount > 0, "shadow map transition is split & aliased transients are activated");
+            check(graph.heapOffset(lighting) % MSAAPlacementAlignment == 0, "transients are placed at their alignment");
+            check(validateRenderGraph(graph, initialStates, finalStates), "deferred frame barriers replay");
+
+            // Lighting reads depth as a shader resource & depth read at once, one transition covers both
+            uint32_t depthTransitions = 0;
+            for (RenderGraph::PassId passId = 0; passId < graph.passCount(); passId++)
+            {
+                for (auto const& barrier : graph.passBarriers(passId)) {
+                    depthTransitions += (barrier.resource == depth && barrier.type != RenderGraph::BarrierType::SplitEnd && barrier.type != RenderGraph::BarrierType::Aliasing) ? 1 : 0;
+                }
+            }
+            check(depthTransitions == 2, "depth transitions once to the combined read state of SSAO & lighting, then back");
+
+            constexpr uint32_t CompileCount = 10000;
+            Timer timer{};
+            for (uint32_t compileIdx = 0; compileIdx < CompileCount; compileIdx++) {
+                graph.compile();
+            }
+            timer.tick();
+            printf("  Compile: %.2f us\n", timer.deltaTimeMS() * 1000.0 / CompileCount);
+        }
+
+        // Random graphs, every compiled graph must replay cleanly
+        constexpr ResourceState ReadStates[] = { ResourceState::DepthRead, ResourceState::PixelShaderResource, ResourceState::NonPixelShaderResource, ResourceState::CopySource };
+        constexpr ResourceState WriteStateList[] = { ResourceState::RenderTarget, ResourceState::DepthWrite, ResourceState::UnorderedAccess, ResourceState::CopyDest };
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; };
+
+        RenderGraph::Statistics totals{};
+        for (uint32_t graphIdx = 0; graphIdx < graphCount && check.passed(); graphIdx++)
+        {
+            RenderGraph graph;
+            std::vector<ResourceState> initialStates;
+            std::vector<ResourceState> finalStates;
+            uint32_t const resourceCount = 2 + random() % 14;
+            for (uint32_t resourceIdx = 0; resourceIdx < resourceCount; resourceIdx++)
+            {
+                if (random() % 4 == 0)
+                {
+                    ResourceState const initialState = (random() % 2 == 0) ? ResourceState::Present : ReadStates[random() % 4];
+                    ResourceState const finalState = (random() % 2 == 0) ? ResourceState::Present : ReadStates[random() % 4];
+                    initialStates.push_back(initialState);
+                    finalStates.push_back(finalState);
+                    graph.importResource("Imported", initialState, finalState);
+                }
+                else
+                {
+                    initialStates.push_back(ResourceState::Undefined);
+                    finalStates.push_back(ResourceState::Undefined);
+                    graph.createTransient("Transient", PlacementAlignment * (1 + random() % 256), (random() % 8 == 0) ? MSAAPlacementAlignment : PlacementAlignment);
+                }
+            }
+
+            uint32_t const passCount = 1 + random() % 24;
+            for (uint32_t passIdx = 0; passIdx < passCount; passIdx++)
+            {
+                RenderGraph::PassId const passId = graph.addPass("Pass", nullptr, random() % 16 == 0);
+                std::vector<bool> accessed(resourceCount, false);
+                uint32_t const accessCount = 1 + random() % 4;
+                for (uint32_t accessIdx = 0; accessIdx < accessCount; accessIdx++)
+                {
+                    uint32_t const resourceId = random() % resourceCount;
+                    if (accessed[resourceId]) {
+                        continue;
+                    }
+
+                    accessed[resourceId] = true;
+                    if (random() % 2 == 0) {
+                        graph.write(passId, resourceId, WriteStateList[random() % 4]);
+                    }
+                    else {
+                        graph.read(passId, resourceId, ReadStates[random() % 4]);
+                    }
+                }
+            }
+
+            graph.compile();
+            check(validateRenderGraph(graph, initialStates, finalStates), "random graph barriers replay");
+
+            RenderGraph::Statistics const& statistics = graph.statistics();
+            totals.passCount += statistics.passCount;
+            totals.culledPassCount += statistics.culledPassCount;
+            totals.barrierCount += statistics.barrierCount;
+            totals.splitBarrierCount += statistics.splitBarrierCount;
+            totals.aliasingBarrierCount += statistics.aliasingBarrierCount;
+            totals.transientMemory += statistics.transientMemory;
+            totals.unaliasedTransientMemory += statistics.unaliasedTransientMemory;
+        }
+
+        printf("Render graph %s (%u random graphs, %u passes, %u culled, %u barriers, %u split, %u aliasing, transient memory %.1f%% of unaliased)\n",
+            check.passed() ? "passed" : "FAILED", graphCount, totals.passCount, totals.culledPassCount, totals.barrierCount, totals.splitBarrierCount, totals.aliasingBarrierCount,
+            totals.unaliasedTransientMemory > 0 ? 100.0 * static_cast<double>(totals.transientMemory) / static_cast<double>(totals.unaliasedTransientMemory) : 100.0);
+        return check.passed();
+    }
+} // namespace Tests
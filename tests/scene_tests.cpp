@@ -0,0 +1,904 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "culling.hpp"
+#include "draw_packet.hpp"
+#include "job_system.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+#include "scene_bvh.hpp"
+#include "timer.hpp"
+#include "transform_array.hpp"
+#include "triangle_bvh.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    bool benchmarkInstances(uint32_t instanceCount)
+    {
+        Checker check{ "Instance" };
+
+        // Random TRS transforms with non uniform scales, kept as AoS for the per object reference
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return static_cast<float>(state) / static_cast<float>(UINT32_MAX); };
+        std::vector<Transform> objects(instanceCount);
+        TransformArray transforms{};
+        for (auto& object : objects)
+        {
+            object.position = glm::vec3(random(), random(), random()) * 200.0F - 100.0F;
+            object.rotation = glm::normalize(glm::quat(random() * 2.0F - 1.0F, random() * 2.0F - 1.0F, random() * 2.0F - 1.0F, random() * 2.0F - 1.0F));
+            object.scale = glm::vec3(random(), random(), random()) * 1.5F + 0.5F;
+            transforms.add(object);
+        }
+
+        auto const maxError = [](InstanceData const& a, InstanceData const& b)
+        {
+            float error = 0.0F;
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    error = std::max(error, std::abs(a.model[column][row] - b.model[column][row]) / std::max(1.0F, std::abs(b.model[column][row])));
+                    error = std::max(error, std::abs(a.normal[column][row] - b.normal[column][row]) / std::max(1.0F, std::abs(b.normal[column][row])));
+                }
+            }
+
+            return error;
+        };
+
+        constexpr uint32_t RunCount = 5;
+        constexpr size_t GrainSize = 4096;
+        constexpr uint32_t SpinFrameCount = 1000; //< spins of every instance, as many frames of the animated scene
+        std::vector<InstanceData> reference(instanceCount);
+        std::vector<InstanceData> instances(instanceCount);
+        Timer timer{};
+        double referenceMS = std::numeric_limits<double>::max();
+        double batchMS = std::numeric_limits<double>::max();
+        double parallelMS = std::numeric_limits<double>::max();
+        JobSystem jobs{};
+        for (uint32_t runIdx = 0; runIdx < RunCount; runIdx++)
+        {
+            // Per object matrices & inverse as the renderer computed them before
+            timer.reset();
+            for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
+                reference[instanceIdx] = TransformArray::instanceData(objects[instanceIdx]);
+            }
+            timer.tick();
+            referenceMS = std::min(referenceMS, timer.deltaTimeMS());
+
+            timer.reset();
+            transforms.computeMatrices(0, instanceCount, instances.data());
+            timer.tick();
+            batchMS = std::min(batchMS, timer.deltaTimeMS());
+        }
+
+        float batchError = 0.0F;
+        for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
+            batchError = std::max(batchError, maxError(instances[instanceIdx], reference[instanceIdx]));
+        }
+        check(batchError < 1e-4F, "batched matrices match the per object reference");
+
+        for (uint32_t runIdx = 0; runIdx < RunCount; runIdx++)
+        {
+            std::fill(instances.begin(), instances.end(), InstanceData{});
+            timer.reset();
+            jobs.parallelFor(instanceCount, GrainSize, [&transforms, &instances](size_t begin, size_t end) { transforms.computeMatrices(begin, end, instances.data() + begin); });
+            timer.tick();
+            parallelMS = std::min(parallelMS, timer.deltaTimeMS());
+        }
+
+        float parallelError = 0.0F;
+        for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++) {
+            parallelError = std::max(parallelError, maxError(instances[instanceIdx], reference[instanceIdx]));
+        }
+        check(parallelError < 1e-4F, "parallel ranges with unaligned bounds match the reference");
+
+        // Rotation batches against quaternion products
+        glm::quat const spin = glm::angleAxis(0.01F, glm::vec3(0.0F, 1.0F, 0.0F));
+        transforms.rotate(1, instanceCount, spin);
+        float rotationError = 0.0F;
+        for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++)
+        {
+            glm::quat const expected = (instanceIdx == 0) ? objects[instanceIdx].rotation : objects[instanceIdx].rotation * spin;
+            glm::quat const actual = transforms.get(instanceIdx).rotation;
+            rotationError = std::max(rotationError, std::max(std::max(std::abs(actual.x - expected.x), std::abs(actual.y - expected.y)), std::max(std::abs(actual.z - expected.z), std::abs(actual.w - expected.w))));
+        }
+        check(rotationError < 1e-5F, "batched rotations match quaternion products & stay within their range");
+
+        // Spinning every frame keeps the rotations unit length instead of accumulating rounding
+        for (uint32_t frameIdx = 0; frameIdx < SpinFrameCount; frameIdx++) {
+            transforms.rotate(0, instanceCount, spin);
+        }
+
+        float lengthError = 0.0F;
+        for (uint32_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++)
+        {
+            glm::quat const rotation = transforms.get(instanceIdx).rotation;
+            float const length = std::sqrt(rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z + rotation.w * rotation.w);
+            lengthError = std::max(lengthError, std::abs(length - 1.0F));
+        }
+        check(lengthError < 1e-5F, "rotations spun every frame stay unit length");
+
+        auto const report = [instanceCount, referenceMS](char const* name, double timeMS)
+        {
+            printf("  %-22s %9.3f ms %8.2f ns/instance %9.1f M instances/s %6.2fx\n",
+                name, timeMS, timeMS * 1e6 / instanceCount, instanceCount / std::max(timeMS, 1e-6) / 1000.0, referenceMS / std::max(timeMS, 1e-6));
+        };
+
+        printf("Instance matrices, %u instances (best of %u, max relative error %.2g):\n", instanceCount, RunCount, std::max(batchError, parallelError));
+        report("AoS per object", referenceMS);
+        report("SoA batches", batchMS);
+        char parallelName[32];
+        snprintf(parallelName, sizeof(parallelName), "SoA batches, %u threads", jobs.threadCount());
+        report(parallelName, parallelMS);
+        return check.passed();
+    }
+
+    bool benchmarkCulling(uint32_t objectCount)
+    {
+        Checker check{ "Culling" };
+
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return static_cast<float>(state) / static_cast<float>(UINT32_MAX); };
+
+        // Mesh bounds hold every vertex & the box is tight
+        std::vector<Vertex> vertices(1000);
+        for (auto& vertex : vertices) {
+            vertex.position = glm::vec3(random() * 4.0F - 1.0F, random() * 2.0F, random() - 3.0F);
+        }
+        MeshBounds const bounds = Culling::computeBounds(vertices.data(), vertices.size());
+        bool boundsContain = true;
+        glm::vec3 aabbMin = vertices[0].position;
+        glm::vec3 aabbMax = vertices[0].position;
+        for (auto const& vertex : vertices)
+        {
+            boundsContain = boundsContain && glm::length(vertex.position - bounds.sphereCenter) <= bounds.sphereRadius * (1.0F + 1e-6F);
+            aabbMin = glm::min(aabbMin, vertex.position);
+            aabbMax = glm::max(aabbMax, vertex.position);
+        }
+        check(boundsContain, "the bounding sphere contains every vertex");
+        check(aabbMin == bounds.aabbMin && aabbMax == bounds.aabbMax, "the AABB is tight");
+
+        Camera camera{};
+        camera.position = glm::vec3(0.0F, 0.0F, 0.0F);
+        camera.forward = glm::normalize(glm::vec3(0.3F, -0.1F, 1.0F));
+        camera.aspectRatio = 16.0F / 9.0F;
+        camera.zFar = 500.0F;
+        Frustum const frustum = Culling::extractFrustum(camera);
+        Frustum const matrixFrustum = Culling::extractFrustum(camera.matrix());
+        check(std::equal(std::begin(frustum.planes), std::end(frustum.planes), std::begin(matrixFrustum.planes)), "camera frustum matches its matrix's frustum");
+
+        // World spheres of random transforms hold the transformed points of the local sphere
+        TransformArray transforms{};
+        for (uint32_t objectIdx = 0; objectIdx < objectCount; objectIdx++)
+        {
+            Transform transform{};
+            transform.position = glm::vec3(random(), random(), random()) * 1000.0F - 500.0F;
+            transform.rotation = glm::normalize(glm::quat(random() * 2.0F - 1.0F, random() * 2.0F - 1.0F, random() * 2.0F - 1.0F, random() * 2.0F - 1.0F));
+            transform.scale = glm::vec3(random(), random(), random()) * 3.0F + 0.25F;
+            transforms.add(transform);
+        }
+
+        SphereArray spheres{};
+        spheres.resize(objectCount);
+        transforms.computeSpheres(0, objectCount, bounds, spheres);
+        bool spheresContain = true;
+        for (uint32_t objectIdx = 0; objectIdx < std::min(objectCount, 10000U); objectIdx++)
+        {
+            glm::mat4 const model = transforms.get(objectIdx).matrix();
+            glm::vec3 const center = glm::vec3(spheres.centerX[objectIdx], spheres.centerY[objectIdx], spheres.centerZ[objectIdx]);
+            for (uint32_t pointIdx = 0; pointIdx < 4; pointIdx++)
+            {
+                glm::vec3 const direction = glm::normalize(glm::vec3(random(), random(), random()) * 2.0F - 1.0F);
+                glm::vec3 const point = glm::vec3(model * glm::vec4(bounds.sphereCenter + direction * bounds.sphereRadius, 1.0F));
+                spheresContain = spheresContain && glm::length(point - center) <= spheres.radius[objectIdx] * 1.0001F + 1e-3F;
+            }
+        }
+        check(spheresContain, "world spheres hold the transformed local spheres");
+
+        // Only instances moved since their last update get their spheres recomputed, in unaligned chunks like the renderer's
+        TransformArray movingTransforms = transforms;
+        SphereArray movedSpheres{};
+        movedSpheres.resize(objectCount);
+        std::vector<uint32_t> moved(objectCount);
+        auto const updateMoved = [&]()
+        {
+            size_t movedCount = 0;
+            for (size_t begin = 0; begin < objectCount; begin += 1000) {
+                movedCount += movingTransforms.updateMovedSpheres(begin, std::min<size_t>(begin + 1000, objectCount), bounds, movedSpheres, moved.data() + movedCount);
+            }
+            return movedCount;
+        };
+
+        check(updateMoved() == objectCount, "added instances are moved");
+        check(updateMoved() == 0, "updated instances are no longer moved");
+        size_t const rotatedBegin = objectCount / 3;
+        size_t const rotatedEnd = objectCount - objectCount / 4;
+        movingTransforms.rotate(rotatedBegin, rotatedEnd, glm::angleAxis(0.5F, glm::vec3(0.0F, 0.0F, 1.0F)));
+        movingTransforms.set(0, movingTransforms.get(0));
+        size_t const movedCount = updateMoved();
+        bool movedInOrder = movedCount == (rotatedEnd - rotatedBegin) + (rotatedBegin > 0 ? 1 : 0);
+        for (size_t movedIdx = 0; movedIdx < movedCount && movedInOrder; movedIdx++) {
+            movedInOrder = moved[movedIdx] == ((rotatedBegin > 0) ? ((movedIdx == 0) ? 0 : rotatedBegin + movedIdx - 1) : movedIdx);
+        }
+        check(movedInOrder, "rotated & set instances are moved, in order");
+
+        spheres.resize(objectCount);
+        movingTransforms.computeSpheres(0, objectCount, bounds, spheres);
+        bool movedSpheresMatch = true;
+        for (uint32_t objectIdx = 0; objectIdx < objectCount; objectIdx++)
+        {
+            movedSpheresMatch = movedSpheresMatch && movedSpheres.centerX[objectIdx] == spheres.centerX[objectIdx] && movedSpheres.centerY[objectIdx] == spheres.centerY[objectIdx]
+                && movedSpheres.centerZ[objectIdx] == spheres.centerZ[objectIdx] && movedSpheres.radius[objectIdx] == spheres.radius[objectIdx];
+        }
+        check(movedSpheresMatch, "updating moved spheres matches recomputing every sphere");
+        transforms.computeSpheres(0, objectCount, bounds, spheres);
+
+        // SIMD batches agree exactly with the scalar reference, also on unaligned ranges & with degenerate spheres
+        if (objectCount > 3)
+        {
+            spheres.radius[0] = 0.0F;
+            spheres.radius[1] = 1e30F;
+            spheres.centerX[2] = camera.position.x;
+            spheres.centerY[2] = camera.position.y;
+            spheres.centerZ[2] = camera.position.z;
+        }
+
+        std::vector<uint32_t> reference(objectCount);
+        std::vector<uint32_t> visible(objectCount);
+        for (uint32_t rangeIdx = 0; rangeIdx < 64 && check.passed(); rangeIdx++)
+        {
+            size_t const begin = (rangeIdx == 0) ? 0 : static_cast<size_t>(random() * objectCount);
+            size_t const end = (rangeIdx == 0) ? objectCount : begin + static_cast<size_t>(random() * (objectCount - begin));
+            size_t const referenceCount = Culling::cullSpheresScalar(frustum, spheres, begin, end, reference.data());
+            size_t const visibleCount = Culling::cullSpheres(frustum, spheres, begin, end, visible.data());
+            check(visibleCount == referenceCount && std::equal(reference.begin(), reference.begin() + referenceCount, visible.begin()), "SIMD culling matches the scalar reference");
+        }
+
+        // Gathered matrices of the visible list match the per object reference
+        size_t const visibleCount = Culling::cullSpheres(frustum, spheres, 0, objectCount, visible.data());
+        std::vector<InstanceData> instances(visibleCount);
+        transforms.gatherMatrices(visible.data(), visibleCount, instances.data());
+        float gatherError = 0.0F;
+        for (size_t visibleIdx = 0; visibleIdx < visibleCount; visibleIdx++)
+        {
+            InstanceData const expected = TransformArray::instanceData(transforms.get(visible[visibleIdx]));
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                {
+                    gatherError = std::max(gatherError, std::abs(instances[visibleIdx].model[column][row] - expected.model[column][row]) / std::max(1.0F, std::abs(expected.model[column][row])));
+                    gatherError = std::max(gatherError, std::abs(instances[visibleIdx].normal[column][row] - expected.normal[column][row]) / std::max(1.0F, std::abs(expected.normal[column][row])));
+                }
+            }
+        }
+        check(gatherError < 1e-4F, "gathered matrices of the visible instances match the reference");
+
+        constexpr uint32_t RunCount = 5;
+        Timer timer{};
+        double scalarMS = std::numeric_limits<double>::max();
+        double batchMS = std::numeric_limits<double>::max();
+        double parallelMS = std::numeric_limits<double>::max();
+        size_t checksum = 0;
+        JobSystem jobs{};
+        constexpr size_t ChunkSize = 4096;
+        for (uint32_t runIdx = 0; runIdx < RunCount; runIdx++)
+        {
+            timer.reset();
+            checksum += Culling::cullSpheresScalar(frustum, spheres, 0, objectCount, reference.data());
+            timer.tick();
+            scalarMS = std::min(scalarMS, timer.deltaTimeMS());
+
+            timer.reset();
+            checksum += Culling::cullSpheres(frustum, spheres, 0, objectCount, visible.data());
+            timer.tick();
+            batchMS = std::min(batchMS, timer.deltaTimeMS());
+
+            // Chunks cull in place on the job system, like the renderer's instance culling
+            timer.reset();
+            jobs.parallelFor((objectCount + ChunkSize - 1) / ChunkSize, 1, [&](size_t chunkBegin, size_t chunkEnd)
+            {
+                for (size_t chunkIdx = chunkBegin; chunkIdx < chunkEnd; chunkIdx++)
+                {
+                    size_t const begin = chunkIdx * ChunkSize;
+                    Culling::cullSpheres(frustum, spheres, begin, std::min<size_t>(begin + ChunkSize, objectCount), visible.data() + begin);
+                }
+            });
+            timer.tick();
+            parallelMS = std::min(parallelMS, timer.deltaTimeMS());
+        }
+
+        auto const report = [objectCount, scalarMS](char const* name, double timeMS)
+        {
+            printf("  %-22s %9.3f ms %8.3f objects/ns %6.2fx\n", name, timeMS, objectCount / std::max(timeMS * 1e6, 1e-6), scalarMS / std::max(timeMS, 1e-6));
+        };
+
+    #if defined(__AVX__)
+        char const* batchName = "SIMD batches (AVX)";
+    #elif defined(_M_X64) || defined(__SSE2__)
+        char const* batchName = "SIMD batches (SSE)";
+    #else
+        char const* batchName = "Batches (scalar)";
+    #endif
+        printf("Sphere culling, %u objects, %zu visible (best of %u, checksum %zu):\n", objectCount, visibleCount, RunCount, checksum);
+        report("Scalar", scalarMS);
+        report(batchName, batchMS);
+        char parallelName[32];
+        snprintf(parallelName, sizeof(parallelName), "SIMD, %u threads", jobs.threadCount());
+        report(parallelName, parallelMS);
+        return check.passed();
+    }
+
+    bool benchmarkSceneBvh(uint32_t objectCount)
+    {
+        Checker check{ "Scene BVH" };
+
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return static_cast<float>(state) / static_cast<float>(UINT32_MAX); };
+
+        // Spheres spread over a ground plane at constant density, so a fixed view sees a shrinking share as objects are added
+        float const extent = std::sqrt(static_cast<float>(objectCount)) * 3.0F;
+        SphereArray spheres{};
+        spheres.resize(objectCount);
+        auto const randomize = [&](uint32_t object)
+        {
+            spheres.centerX[object] = (random() * 2.0F - 1.0F) * extent;
+            spheres.centerY[object] = random() * 20.0F;
+            spheres.centerZ[object] = (random() * 2.0F - 1.0F) * extent;
+            spheres.radius[object] = random() * 1.5F + 0.25F;
+        };
+        auto const sphereBox = [&spheres](uint32_t object)
+        {
+            glm::vec3 const center = glm::vec3(spheres.centerX[object], spheres.centerY[object], spheres.centerZ[object]);
+            return BoundingBox{ center - spheres.radius[object], center + spheres.radius[object] };
+        };
+        for (uint32_t object = 0; object < objectCount; object++) {
+            randomize(object);
+        }
+
+        Camera camera{};
+        camera.position = glm::vec3(0.0F, 10.0F, 0.0F);
+        camera.forward = glm::normalize(glm::vec3(0.3F, -0.1F, 1.0F));
+        camera.aspectRatio = 16.0F / 9.0F;
+        camera.zFar = 300.0F;
+        Frustum const frustum = Culling::extractFrustum(camera);
+
+        // Brute force references over the live objects
+        std::vector<bool> alive(objectCount, true);
+        auto const bruteFrustum = [&]()
+        {
+            std::vector<uint32_t> objects;
+            for (uint32_t object = 0; object < objectCount; object++)
+            {
+                BoundingBox const box = sphereBox(object);
+                if (alive[object] && Culling::testAABB(frustum, box.aabbMin, box.aabbMax)) {
+                    objects.push_back(object);
+                }
+            }
+            return objects;
+        };
+        auto const intersectSphere = [&spheres](uint32_t object, glm::vec3 const& origin, glm::vec3 const& direction)
+        {
+            glm::vec3 const offset = origin - glm::vec3(spheres.centerX[object], spheres.centerY[object], spheres.centerZ[object]);
+            float const b = glm::dot(offset, direction);
+            float const c = glm::dot(offset, offset) - spheres.radius[object] * spheres.radius[object];
+            float const discriminant = b * b - c;
+            if (discriminant < 0.0F) {
+                return -1.0F;
+            }
+            float const distance = -b - std::sqrt(discriminant);
+            return (distance >= 0.0F) ? distance : ((-b + std::sqrt(discriminant) >= 0.0F) ? 0.0F : -1.0F);
+        };
+
+        SceneBvh bvh{};
+        std::vector<uint32_t> objects(objectCount);
+        std::vector<BoundingBox> bounds(objectCount);
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            objects[object] = object;
+            bounds[object] = sphereBox(object);
+        }
+
+        Timer timer{};
+        timer.reset();
+        bvh.build(objects.data(), bounds.data(), objectCount);
+        timer.tick();
+        double const buildMS = timer.deltaTimeMS();
+
+        auto const checkQueries = [&](char const* stage)
+        {
+            char description[128];
+            snprintf(description, sizeof(description), "tree is consistent %s", stage);
+            check(bvh.validate(), description);
+
+            std::vector<uint32_t> visible;
+            bvh.queryFrustum(frustum, visible);
+            std::sort(visible.begin(), visible.end());
+            snprintf(description, sizeof(description), "frustum query matches brute force %s", stage);
+            check(visible == bruteFrustum(), description);
+
+            for (uint32_t queryIdx = 0; queryIdx < 8; queryIdx++)
+            {
+                glm::vec3 const center = glm::vec3((random() * 2.0F - 1.0F) * extent, random() * 20.0F, (random() * 2.0F - 1.0F) * extent);
+                float const radius = random() * 20.0F;
+                std::vector<uint32_t> overlapping;
+                bvh.querySphere(center, radius, overlapping);
+                std::sort(overlapping.begin(), overlapping.end());
+                std::vector<uint32_t> expected;
+                for (uint32_t object = 0; object < objectCount; object++)
+                {
+                    BoundingBox const box = sphereBox(object);
+                    glm::vec3 const offset = center - glm::clamp(center, box.aabbMin, box.aabbMax);
+                    if (alive[object] && glm::dot(offset, offset) <= radius * radius) {
+                        expected.push_back(object);
+                    }
+                }
+                snprintf(description, sizeof(description), "sphere query matches brute force %s", stage);
+                check(overlapping == expected, description);
+
+                glm::vec3 const origin = glm::vec3((random() * 2.0F - 1.0F) * extent, random() * 20.0F, (random() * 2.0F - 1.0F) * extent);
+                glm::vec3 const direction = glm::normalize(glm::vec3(random() * 2.0F - 1.0F, random() * 0.2F - 0.1F, random() * 2.0F - 1.0F));
+                SceneBvh::RayHit const hit = bvh.raycast(origin, direction, 1000.0F, [&](uint32_t object, float) { return intersectSphere(object, origin, direction); });
+                float closest = 1000.0F;
+                for (uint32_t object = 0; object < objectCount; object++)
+                {
+                    float const distance = alive[object] ? intersectSphere(object, origin, direction) : -1.0F;
+                    if (distance >= 0.0F && distance < closest) {
+                        closest = distance;
+                    }
+                }
+                snprintf(description, sizeof(description), "raycast finds the closest hit %s", stage);
+                check(hit.distance == closest && (hit.object == SceneBvh::InvalidIndex) == (closest == 1000.0F), description);
+            }
+        };
+        checkQueries("after the SAH build");
+
+        // Removals, reinsertions & moves refit synchronously
+        for (uint32_t roundIdx = 0; roundIdx < 4 && check.passed(); roundIdx++)
+        {
+            for (uint32_t changeIdx = 0; changeIdx < std::max(1U, objectCount / 8); changeIdx++)
+            {
+                uint32_t const object = static_cast<uint32_t>(random() * (objectCount - 1));
+                float const choice = random();
+                if (alive[object] && choice < 0.3F)
+                {
+                    bvh.remove(object);
+                    alive[object] = false;
+                }
+                else if (!alive[object])
+                {
+                    randomize(object);
+                    bvh.insert(object, sphereBox(object));
+                    alive[object] = true;
+                }
+                else
+                {
+                    spheres.centerX[object] += random() * 4.0F - 2.0F;
+                    spheres.centerZ[object] += random() * 4.0F - 2.0F;
+                    bvh.update(object, sphereBox(object));
+                }
+            }
+
+            bvh.refit();
+            checkQueries("after removals, insertions & moves");
+        }
+
+        for (uint32_t object = 0; object < objectCount; object++)
+        {
+            if (!alive[object])
+            {
+                bvh.insert(object, sphereBox(object));
+                alive[object] = true;
+            }
+        }
+        bvh.refit();
+
+        // Everything drifts until background rebuilds are swapped in, the changes meanwhile are replayed onto them
+        JobSystem jobs{};
+        SceneBvh::Statistics const statisticsBefore = bvh.statistics();
+        for (uint32_t frameIdx = 0; frameIdx < 32 && check.passed(); frameIdx++)
+        {
+            for (uint32_t object = 0; object < objectCount; object++)
+            {
+                spheres.centerX[object] += (random() * 2.0F - 1.0F) * extent * 0.05F;
+                spheres.centerZ[object] += (random() * 2.0F - 1.0F) * extent * 0.05F;
+                bvh.update(object, sphereBox(object));
+            }
+            if (frameIdx % 4 == 0 && objectCount > 1)
+            {
+                uint32_t const object = static_cast<uint32_t>(random() * (objectCount - 1));
+                bvh.remove(object);
+                bvh.insert(object, sphereBox(object));
+            }
+
+            bvh.refit(&jobs);
+            if (frameIdx % 8 == 7) {
+                checkQueries("while rebuilding in the background");
+            }
+        }
+        bvh.waitRebuild();
+        bvh.refit();
+        checkQueries("after the background rebuild");
+        SceneBvh::Statistics const statisticsAfter = bvh.statistics();
+        uint32_t const driftRebuildCount = statisticsAfter.rebuildCount - statisticsBefore.rebuildCount;
+        check(driftRebuildCount > 0 || statisticsAfter.sahCost <= statisticsAfter.builtSahCost * SceneBvh::RebuildThreshold, "degraded trees are rebuilt");
+
+        // Brute force culling doesn't depend on motion, the tree pays for its updates & refits
+        constexpr uint32_t FrameCount = 16;
+        for (uint32_t object = 0; object < objectCount; object++) {
+            bounds[object] = sphereBox(object);
+        }
+        bvh.build(objects.data(), bounds.data(), objectCount);
+
+        std::vector<uint32_t> visible(objectCount);
+        double scalarMS = std::numeric_limits<double>::max();
+        double simdMS = std::numeric_limits<double>::max();
+        size_t bruteVisibleCount = 0;
+        for (uint32_t runIdx = 0; runIdx < 5; runIdx++)
+        {
+            timer.reset();
+            size_t visibleCount = 0;
+            for (uint32_t object = 0; object < objectCount; object++)
+            {
+                visible[visibleCount] = object;
+                visibleCount += Culling::testAABB(frustum, bounds[object].aabbMin, bounds[object].aabbMax) ? 1 : 0;
+            }
+            timer.tick();
+            scalarMS = std::min(scalarMS, timer.deltaTimeMS());
+            bruteVisibleCount = visibleCount;
+
+            timer.reset();
+            visibleCount = Culling::cullSpheres(frustum, spheres, 0, objectCount, visible.data());
+            timer.tick();
+            simdMS = std::min(simdMS, timer.deltaTimeMS());
+        }
+
+        printf("Scene BVH, %u objects, %zu visible, SAH build %.3f ms, %u rebuilds while drifting:\n", objectCount, bruteVisibleCount, buildMS, driftRebuildCount);
+        printf("  Brute force AABB              %9.3f ms / frame\n", scalarMS);
+        printf("  Brute force SIMD spheres      %9.3f ms / frame\n", simdMS);
+
+        float const motionRates[] = { 0.0F, 0.01F, 0.1F, 1.0F };
+        for (float const motionRate : motionRates)
+        {
+            uint32_t const movingCount = static_cast<uint32_t>(motionRate * objectCount);
+            double updateMS = 0.0;
+            double queryMS = 0.0;
+            uint64_t visitedCount = 0;
+            uint64_t refitCount = 0;
+            uint32_t const rebuildCountBefore = bvh.statistics().rebuildCount;
+            for (uint32_t frameIdx = 0; frameIdx < FrameCount; frameIdx++)
+            {
+                // Moving objects oscillate around their place so the scene keeps its density
+                timer.reset();
+                float const offset = (frameIdx % 2 == 0) ? 0.5F : -0.5F;
+                for (uint32_t movingIdx = 0; movingIdx < movingCount; movingIdx++)
+                {
+                    uint32_t const object = static_cast<uint32_t>((static_cast<uint64_t>(movingIdx) * objectCount) / std::max(1U, movingCount));
+                    bounds[object].aabbMin.x += offset;
+                    bounds[object].aabbMax.x += offset;
+                    bvh.update(object, bounds[object]);
+                }
+                bvh.refit(&jobs);
+                timer.tick();
+                updateMS += timer.deltaTimeMS();
+                refitCount += bvh.statistics().refitNodeCount;
+
+                timer.reset();
+                size_t const previousCount = objects.size();
+                objects.clear();
+                visitedCount += bvh.queryFrustum(frustum, objects);
+                timer.tick();
+                queryMS += timer.deltaTimeMS();
+                objects.reserve(previousCount);
+            }
+            bvh.waitRebuild();
+
+            printf("  BVH, %5.1f %% moving  %9.3f ms / frame (update & refit %8.3f ms, query %8.3f ms), %8.0f nodes refit, %8.0f visited, %u rebuilds\n",
+                motionRate * 100.0F, (updateMS + queryMS) / FrameCount, updateMS / FrameCount, queryMS / FrameCount,
+                static_cast<double>(refitCount) / FrameCount, static_cast<double>(visitedCount) / FrameCount, bvh.statistics().rebuildCount - rebuildCountBefore);
+        }
+
+        // Picking rays against the object boxes
+        constexpr uint32_t RayCount = 10000;
+        std::vector<glm::vec3> origins(RayCount);
+        std::vector<glm::vec3> directions(RayCount);
+        for (uint32_t rayIdx = 0; rayIdx < RayCount; rayIdx++)
+        {
+            origins[rayIdx] = camera.position;
+            directions[rayIdx] = glm::normalize(camera.forward + glm::vec3(random() - 0.5F, random() * 0.5F - 0.25F, random() - 0.5F));
+        }
+
+        timer.reset();
+        float distanceSum = 0.0F;
+        for (uint32_t rayIdx = 0; rayIdx < RayCount; rayIdx++) {
+            distanceSum += bvh.raycast(origins[rayIdx], directions[rayIdx], 1000.0F).distance;
+        }
+        timer.tick();
+        double const bvhRayMS = timer.deltaTimeMS();
+
+        uint32_t const bruteRayCount = std::max(1U, std::min(RayCount, 100000000U / std::max(1U, objectCount)));
+        timer.reset();
+        for (uint32_t rayIdx = 0; rayIdx < bruteRayCount; rayIdx++)
+        {
+            glm::vec3 const inverseDirection = glm::vec3(1.0F) / directions[rayIdx];
+            float closest = 1000.0F;
+            for (uint32_t object = 0; object < objectCount; object++)
+            {
+                glm::vec3 const t0 = (bounds[object].aabbMin - origins[rayIdx]) * inverseDirection;
+                glm::vec3 const t1 = (bounds[object].aabbMax - origins[rayIdx]) * inverseDirection;
+                glm::vec3 const tNear = glm::min(t0, t1);
+                glm::vec3 const tFar = glm::max(t0, t1);
+                float const entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0F));
+                float const exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, closest));
+                closest = (entry <= exit) ? entry : closest;
+            }
+            distanceSum += closest;
+        }
+        timer.tick();
+        double const bruteRayMS = timer.deltaTimeMS();
+
+        printf("  Raycast BVH %10.4g Mrays/s, brute force %10.4g Mrays/s (checksum %.1f)\n",
+            RayCount / std::max(bvhRayMS * 1e3, 1e-9), bruteRayCount / std::max(bruteRayMS * 1e3, 1e-9), static_cast<double>(distanceSum));
+        return check.passed();
+    }
+
+    bool benchmarkTriangleBvh(char const* sourcePath)
+    {
+        Checker check{ "Triangle BVH" };
+
+        JobSystem jobs{};
+        MeshData meshData{};
+        if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+            return false;
+        }
+
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state]() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return static_cast<float>(state) / static_cast<float>(UINT32_MAX); };
+
+        Timer timer{};
+        TriangleBvh bvh{};
+        timer.reset();
+        bvh.build(meshData.vertices.data(), meshData.vertices.size(), meshData.indices.data(), meshData.indices.size());
+        timer.tick();
+        double const buildMS = timer.deltaTimeMS();
+
+        // Rays start on a sphere around the mesh & aim at points in its box, so most of them hit
+        MeshBounds const bounds = Culling::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+        float const radius = std::max(bounds.sphereRadius, 1e-3F);
+        constexpr uint32_t RayCount = 200000;
+        std::vector<Ray> rays(RayCount);
+        for (Ray& ray : rays)
+        {
+            glm::vec3 direction = glm::vec3(random() * 2.0F - 1.0F, random() * 2.0F - 1.0F, random() * 2.0F - 1.0F);
+            direction = (glm::length(direction) > 1e-3F) ? glm::normalize(direction) : glm::vec3(0.0F, 0.0F, 1.0F);
+            ray.origin = bounds.sphereCenter + direction * radius * 2.0F;
+            glm::vec3 const target = bounds.aabbMin + (bounds.aabbMax - bounds.aabbMin) * glm::vec3(random(), random(), random());
+            ray.direction = glm::normalize(target - ray.origin);
+        }
+
+        // Closest hits must match testing every triangle, the positions must lie on the ray & on the mesh's own triangle
+        float const maxDistance = radius * 4.0F;
+        uint32_t const checkCount = std::max(1U, std::min(RayCount, 20000000U / std::max(1U, bvh.triangleCount())));
+        uint32_t hitCount = 0;
+        for (uint32_t rayIdx = 0; rayIdx < checkCount; rayIdx++)
+        {
+            TriangleHit hit{};
+            TriangleHit reference{};
+            bool const found = bvh.intersect(rays[rayIdx], maxDistance, hit);
+            check(found == bvh.intersectBruteForce(rays[rayIdx], maxDistance, reference), "hits match brute force");
+            if (!found || hit.distance != reference.distance) {
+                check(!found, "hit distances match brute force");
+                continue;
+            }
+
+            hitCount++;
+            glm::vec3 const& p0 = meshData.vertices[meshData.indices[hit.triangle * 3 + 0]].position;
+            glm::vec3 const& p1 = meshData.vertices[meshData.indices[hit.triangle * 3 + 1]].position;
+            glm::vec3 const& p2 = meshData.vertices[meshData.indices[hit.triangle * 3 + 2]].position;
+            glm::vec3 const surface = p0 + (p1 - p0) * hit.barycentrics.x + (p2 - p0) * hit.barycentrics.y;
+            check(glm::length(surface - hit.position) <= radius * 1e-4F, "hit position matches the barycentrics");
+            check(glm::length(rays[rayIdx].origin + rays[rayIdx].direction * hit.distance - hit.position) <= radius * 1e-4F, "hit position lies on the ray");
+            check(hit.barycentrics.x >= 0.0F && hit.barycentrics.y >= 0.0F && hit.barycentrics.x + hit.barycentrics.y <= 1.0F, "barycentrics inside the triangle");
+        }
+        check(hitCount > checkCount / 4, "most rays hit the mesh");
+
+        // Picking rays through random pixels must project their hits back onto the same pixel
+        Camera camera{};
+        camera.position = bounds.sphereCenter + glm::vec3(0.0F, 0.5F, 2.5F) * radius;
+        camera.forward = glm::normalize(bounds.sphereCenter - camera.position);
+        camera.aspectRatio = 16.0F / 9.0F;
+        camera.zNear = radius * 0.01F;
+        camera.zFar = radius * 10.0F;
+        glm::vec2 const viewportSize = glm::vec2(1920.0F, 1080.0F);
+        glm::mat4 const viewproject = camera.matrix();
+        uint32_t pickedCount = 0;
+        for (uint32_t pickIdx = 0; pickIdx < 1000; pickIdx++)
+        {
+            glm::vec2 const pixel = glm::vec2(random(), random()) * viewportSize;
+            Ray const ray = camera.pickingRay(pixel, viewportSize);
+            check(glm::length(ray.origin - camera.position) <= camera.zNear * 2.0F, "picking rays start at the near plane");
+
+            TriangleHit hit{};
+            if (!bvh.intersect(ray, camera.zFar, hit)) {
+                continue;
+            }
+
+            pickedCount++;
+            glm::vec4 const clip = viewproject * glm::vec4(hit.position, 1.0F);
+            glm::vec2 const projected = glm::vec2((clip.x / clip.w + 1.0F) * 0.5F * viewportSize.x, (1.0F - clip.y / clip.w) * 0.5F * viewportSize.y);
+            check(glm::length(projected - pixel) <= 0.05F, "picked positions project back onto the pixel");
+        }
+        check(pickedCount > 0, "picking rays hit the mesh");
+
+        timer.reset();
+        float distanceSum = 0.0F;
+        for (Ray const& ray : rays)
+        {
+            TriangleHit hit{};
+            bvh.intersect(ray, maxDistance, hit);
+            distanceSum += hit.distance;
+        }
+        timer.tick();
+        double const bvhMS = timer.deltaTimeMS();
+
+        uint32_t const bruteRayCount = std::max(1U, std::min(RayCount, 20000000U / std::max(1U, bvh.triangleCount())));
+        timer.reset();
+        for (uint32_t rayIdx = 0; rayIdx < bruteRayCount; rayIdx++)
+        {
+            TriangleHit hit{};
+            bvh.intersectBruteForce(rays[rayIdx], maxDistance, hit);
+            distanceSum += hit.distance;
+        }
+        timer.tick();
+        double const bruteMS = timer.deltaTimeMS();
+
+        // Queries are read only, so batches of rays run on every worker
+        std::vector<float> distances(RayCount);
+        timer.reset();
+        jobs.parallelFor(RayCount, 1024, [&](size_t begin, size_t end)
+        {
+            for (size_t rayIdx = begin; rayIdx < end; rayIdx++)
+            {
+                TriangleHit hit{};
+                bvh.intersect(rays[rayIdx], maxDistance, hit);
+                distances[rayIdx] = hit.distance;
+            }
+        });
+        timer.tick();
+        double const parallelMS = timer.deltaTimeMS();
+
+        printf("Triangle BVH, %s, %u triangles, %u nodes, depth %u, build %.3f ms, %u / %u rays hit:\n",
+            sourcePath, bvh.triangleCount(), bvh.nodeCount(), bvh.depth(), buildMS, hitCount, checkCount);
+        printf("  BVH                %10.4g Mrays/s\n", RayCount / std::max(bvhMS * 1e3, 1e-9));
+        printf("  BVH, %2u threads    %10.4g Mrays/s\n", jobs.threadCount(), RayCount / std::max(parallelMS * 1e3, 1e-9));
+        printf("  Brute force        %10.4g Mrays/s (checksum %.1f)\n", bruteRayCount / std::max(bruteMS * 1e3, 1e-9), static_cast<double>(distanceSum));
+        return check.passed();
+    }
+
+    bool benchmarkDrawSort(uint32_t packetCount)
+    {
+        Checker check{ "Draw sort" };
+
+        uint32_t state = 0x9E3779B9U;
+        auto const random = [&state](uint32_t range) { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state % range; };
+
+        // A scene's draws spread over a few passes & pipelines, many materials & meshes & every depth. The payload is the
+        // submission index, so stability shows in the sorted order.
+        std::vector<DrawPacket> scenePackets(packetCount);
+        for (uint32_t packetIdx = 0; packetIdx < packetCount; packetIdx++)
+        {
+            uint64_t const key = DrawKeys::encode(random(4), random(32), random(1024), random(4096), random(1U << DrawKeys::DepthBits));
+            scenePackets[packetIdx] = DrawPacket{ key, packetIdx, 3, 0, 1 };
+        }
+
+        for (DrawPacket const& packet : scenePackets)
+        {
+            uint64_t const key = DrawKeys::encode(DrawKeys::pass(packet.key), DrawKeys::pipeline(packet.key), DrawKeys::material(packet.key), DrawKeys::mesh(packet.key), DrawKeys::depth(packet.key));
+            check(key == packet.key, "key fields round trip");
+        }
+        check(DrawKeys::quantizeDepth(-1.0F, 10.0F) == 0 && DrawKeys::quantizeDepth(20.0F, 10.0F) == (1U << DrawKeys::DepthBits) - 1, "depth is clamped to the field");
+        check(DrawKeys::quantizeDepth(2.0F, 10.0F) < DrawKeys::quantizeDepth(3.0F, 10.0F), "depth is ordered front to back");
+
+        // The same draws without depth, so most keys repeat & the untouched digits are skipped
+        std::vector<DrawPacket> stateOnlyPackets = scenePackets;
+        for (DrawPacket& packet : stateOnlyPackets) {
+            packet.key &= ~((uint64_t(1) << DrawKeys::MeshShift) - 1);
+        }
+
+        JobSystem jobs{};
+        std::vector<DrawPacket> packets;
+        std::vector<DrawPacket> scratch;
+        Timer timer{};
+        constexpr uint32_t RepeatCount = 10;
+        struct Distribution
+        {
+            char const* name;
+            std::vector<DrawPacket> const* pPackets;
+        };
+
+        printf("Draw sort, %u packets:\n", packetCount);
+        for (Distribution const& distribution : { Distribution{ "full keys", &scenePackets }, Distribution{ "no depth", &stateOnlyPackets } })
+        {
+            std::vector<DrawPacket> reference = *distribution.pPackets;
+            std::stable_sort(reference.begin(), reference.end(), [](DrawPacket const& a, DrawPacket const& b) { return a.key < b.key; });
+
+            double sortMS = 0.0;
+            double radixMS = 0.0;
+            double parallelMS = 0.0;
+            for (uint32_t repeatIdx = 0; repeatIdx < RepeatCount; repeatIdx++)
+            {
+                packets = *distribution.pPackets;
+                timer.reset();
+                std::sort(packets.begin(), packets.end(), [](DrawPacket const& a, DrawPacket const& b) { return a.key < b.key; });
+                timer.tick();
+                sortMS += timer.deltaTimeMS();
+
+                packets = *distribution.pPackets;
+                timer.reset();
+                DrawPackets::sort(packets, scratch);
+                timer.tick();
+                radixMS += timer.deltaTimeMS();
+                check(std::equal(packets.begin(), packets.end(), reference.begin(), [](DrawPacket const& a, DrawPacket const& b) { return a.key == b.key && a.firstIndex == b.firstIndex; }), "radix sort matches a stable sort");
+
+                packets = *distribution.pPackets;
+                timer.reset();
+                DrawPackets::sort(packets, scratch, &jobs);
+                timer.tick();
+                parallelMS += timer.deltaTimeMS();
+                check(std::equal(packets.begin(), packets.end(), reference.begin(), [](DrawPacket const& a, DrawPacket const& b) { return a.key == b.key && a.firstIndex == b.firstIndex; }), "parallel radix sort matches a stable sort");
+            }
+
+            printf("  %-10s std::sort %8.2f Mpackets/s, radix %8.2f Mpackets/s, radix on %u threads %8.2f Mpackets/s\n", distribution.name,
+                packetCount * RepeatCount / std::max(sortMS * 1e3, 1e-9), packetCount * RepeatCount / std::max(radixMS * 1e3, 1e-9),
+                jobs.threadCount(), packetCount * RepeatCount / std::max(parallelMS * 1e3, 1e-9));
+        }
+
+        for (uint32_t pass = 0; pass < 4; pass++)
+        {
+            std::pair<size_t, size_t> const range = DrawPackets::passRange(packets, pass);
+            check(range.first == range.second || (DrawKeys::pass(packets[range.first].key) == pass && DrawKeys::pass(packets[range.second - 1].key) == pass), "pass ranges hold their pass");
+            check(range.first == 0 || DrawKeys::pass(packets[range.first - 1].key) < pass, "pass ranges start at their first packet");
+            check(range.second == packets.size() || DrawKeys::pass(packets[range.second].key) > pass, "pass ranges end after their last packet");
+        }
+
+        // Every draw must see the state its key asks for, whether or not the call setting it was skipped
+        uint32_t boundPipeline = UINT32_MAX;
+        uint32_t boundMaterial = UINT32_MAX;
+        uint32_t boundMesh = UINT32_MAX;
+        bool stateMatched = true;
+        DrawStateBackend backend{};
+        backend.setPipeline = [&boundPipeline](uint32_t pipeline) { boundPipeline = pipeline; };
+        backend.setMaterial = [&boundMaterial](uint32_t material) { boundMaterial = material; };
+        backend.setMesh = [&boundMesh](uint32_t mesh) { boundMesh = mesh; };
+        backend.draw = [&](DrawPacket const& packet)
+        {
+            stateMatched = stateMatched && boundPipeline == DrawKeys::pipeline(packet.key) && boundMaterial == DrawKeys::material(packet.key) && boundMesh == DrawKeys::mesh(packet.key);
+        };
+
+        packets = scenePackets;
+        DrawStatistics const unsortedStatistics = DrawPackets::submit(packets.data(), packets.size(), backend);
+        DrawPackets::sort(packets, scratch, &jobs);
+        boundPipeline = boundMaterial = boundMesh = UINT32_MAX;
+        timer.reset();
+        DrawStatistics const sortedStatistics = DrawPackets::submit(packets.data(), packets.size(), backend);
+        timer.tick();
+        check(stateMatched, "draws see the state of their keys");
+        check(sortedStatistics.drawCount == packetCount && unsortedStatistics.drawCount == packetCount, "every packet is drawn");
+        check(sortedStatistics.pipelineChanges + sortedStatistics.materialChanges + sortedStatistics.meshChanges + sortedStatistics.skippedChanges == packetCount * 3, "state is bound or skipped once per draw");
+        check(sortedStatistics.pipelineChanges <= 4 * 32, "sorted draws bind each pass' pipelines once");
+
+        printf("  State changes unsorted: %8u pipeline, %8u material, %8u mesh, %8u skipped\n", unsortedStatistics.pipelineChanges, unsortedStatistics.materialChanges, unsortedStatistics.meshChanges, unsortedStatistics.skippedChanges);
+        printf("  State changes sorted:   %8u pipeline, %8u material, %8u mesh, %8u skipped, walked at %.2f Mpackets/s\n", sortedStatistics.pipelineChanges, sortedStatistics.materialChanges, sortedStatistics.meshChanges, sortedStatistics.skippedChanges,
+            packetCount / std::max(timer.deltaTimeMS() * 1e3, 1e-9));
+        return check.passed();
+    }
+} // namespace Tests
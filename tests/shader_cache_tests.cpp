@@ -0,0 +1,175 @@
+#include "tests.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "shader_cache.hpp"
+#include "timer.hpp"
+
+using namespace Engine;
+
+namespace Tests
+{
+    bool testShaderCache(uint32_t lookupCount)
+    {
+        Checker check{ "Shader cache" };
+
+        std::error_code error;
+        std::filesystem::path const root = std::filesystem::temp_directory_path(error) / "asset_cooker_shader_test";
+        std::filesystem::remove_all(root, error);
+        std::filesystem::create_directories(root / "lib", error);
+        if (error)
+        {
+            printf("Shader cache test directory creation failed [%s]\n", root.generic_string().c_str());
+            return false;
+        }
+
+        auto const writeFile = [](std::filesystem::path const& path, char const* contents)
+        {
+            FILE* pFile = fopen(path.generic_string().c_str(), "wb");
+            if (pFile != nullptr)
+            {
+                fputs(contents, pFile);
+                fclose(pFile);
+            }
+        };
+
+        // The lighting include reaches the common one a second time, the optional one doesn't exist yet
+        writeFile(root / "shader.hlsl", "#include \"common.hlsli\"\n  #  include <lib/lighting.hlsli>\n#if 0\n#include \"optional.hlsli\"\n#endif\nfloat4 VSMain() : SV_Position { return lit(); }\n");
+        writeFile(root / "common.hlsli", "#pragma once\nstatic const float Pi = 3.14159;\n");
+        writeFile(root / "lib" / "lighting.hlsli", "#include \"../common.hlsli\"\nfloat4 lit() { return Pi; }\n");
+
+        // The stub compiler's bytecode names everything the key covers, so stale bytecode shows up as a mismatch
+        uint32_t compileCount = 0;
+        ShaderCache::Compile const compile = [&compileCount](ShaderCache::ShaderDesc const& desc, std::vector<uint8_t>& bytecode)
+        {
+            compileCount++;
+            if (desc.entryPoint == "Broken") {
+                return false;
+            }
+
+            uint64_t key = 0;
+            ShaderCache::computeKey(desc, key);
+            std::string const text = desc.entryPoint + " " + desc.profile + " " + std::to_string(key);
+            bytecode.assign(text.begin(), text.end());
+            return true;
+        };
+
+        std::string const cacheDirectory = (root / "cache").generic_string();
+        ShaderCache::ShaderDesc desc{};
+        desc.sourcePath = (root / "shader.hlsl").generic_string();
+        desc.entryPoint = "VSMain";
+        desc.profile = "vs_5_0";
+        desc.defines.push_back(ShaderCache::Define{ "PACKED_VERTICES", "1" });
+
+        std::vector<std::string> files;
+        check(ShaderCache::collectIncludes(desc.sourcePath.c_str(), files), "the source's includes are collected");
+        std::vector<std::string> const expectedFiles = {
+            (root / "shader.hlsl").lexically_normal().generic_string(),
+            (root / "common.hlsli").lexically_normal().generic_string(),
+            (root / "lib" / "lighting.hlsli").lexically_normal().generic_string(),
+            (root / "optional.hlsli").lexically_normal().generic_string(),
+        };
+        check(files == expectedFiles, "includes are listed depth first & once, missing ones too");
+
+        uint64_t baseKey = 0;
+        check(ShaderCache::computeKey(desc, baseKey), "keys are computed for existing sources");
+
+        // Every part of the description must reach the key
+        std::vector<uint64_t> keys = { baseKey };
+        auto const addVariantKey = [&](ShaderCache::ShaderDesc const& variant)
+        {
+            uint64_t key = 0;
+            ShaderCache::computeKey(variant, key);
+            keys.push_back(key);
+        };
+        ShaderCache::ShaderDesc variant = desc;
+        variant.entryPoint = "PSMain";
+        addVariantKey(variant);
+        variant = desc;
+        variant.profile = "vs_5_1";
+        addVariantKey(variant);
+        variant = desc;
+        variant.defines[0].value = "0";
+        addVariantKey(variant);
+        variant = desc;
+        variant.defines.push_back(ShaderCache::Define{ "SHADOWS", "1" });
+        addVariantKey(variant);
+        variant = desc;
+        variant.defines[0] = ShaderCache::Define{ "PACKED_VERTICES1", "" };
+        addVariantKey(variant);
+        variant = desc;
+        variant.compileFlags = 1;
+        addVariantKey(variant);
+        std::sort(keys.begin(), keys.end());
+        check(std::unique(keys.begin(), keys.end()) == keys.end(), "entry point, profile, defines & flags change the key");
+
+        std::vector<uint8_t> bytecode;
+        std::vector<uint8_t> cachedBytecode;
+        check(ShaderCache::load(cacheDirectory.c_str(), desc, compile, bytecode) == ShaderCache::LoadResult::Compiled && compileCount == 1, "the first load compiles");
+        check(ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode) == ShaderCache::LoadResult::Loaded && compileCount == 1, "the second load hits the cache");
+        check(cachedBytecode == bytecode, "cached bytecode matches the compiled bytecode");
+
+        // Editing an include misses, restoring it hits the earlier bytecode again
+        writeFile(root / "lib" / "lighting.hlsli", "#include \"../common.hlsli\"\nfloat4 lit() { return Pi * 2.0; }\n");
+        uint64_t editedKey = 0;
+        ShaderCache::computeKey(desc, editedKey);
+        check(editedKey != baseKey, "editing an include changes the key");
+        check(ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode) == ShaderCache::LoadResult::Compiled && compileCount == 2, "an edited include compiles again");
+        writeFile(root / "lib" / "lighting.hlsli", "#include \"../common.hlsli\"\nfloat4 lit() { return Pi; }\n");
+        check(ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode) == ShaderCache::LoadResult::Loaded && cachedBytecode == bytecode, "a restored include hits its earlier bytecode");
+
+        writeFile(root / "optional.hlsli", "\n");
+        uint64_t optionalKey = 0;
+        ShaderCache::computeKey(desc, optionalKey);
+        check(optionalKey != baseKey, "creating a missing include changes the key");
+        std::filesystem::remove(root / "optional.hlsli", error);
+
+        // Damaged files are recompiled & replaced
+        std::string const cachePath = ShaderCache::cachePath(cacheDirectory.c_str(), baseKey);
+        FILE* pFile = fopen(cachePath.c_str(), "r+b");
+        if (pFile != nullptr)
+        {
+            fseek(pFile, static_cast<long>(sizeof(ShaderCache::Header)), SEEK_SET);
+            fputc('X', pFile);
+            fclose(pFile);
+        }
+        check(!ShaderCache::read(cachePath.c_str(), baseKey, cachedBytecode), "corrupted bytecode is rejected");
+        check(ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode) == ShaderCache::LoadResult::Compiled && cachedBytecode == bytecode, "corrupted files are recompiled");
+        check(ShaderCache::read(cachePath.c_str(), baseKey, cachedBytecode) && cachedBytecode == bytecode, "recompiled files replace corrupted ones");
+        check(!ShaderCache::read(cachePath.c_str(), baseKey + 1, cachedBytecode), "files of other keys are rejected");
+        std::filesystem::resize_file(cachePath, sizeof(ShaderCache::Header) + bytecode.size() - 1, error);
+        check(!ShaderCache::read(cachePath.c_str(), baseKey, cachedBytecode), "truncated files are rejected");
+
+        uint32_t const compileCountBefore = compileCount;
+        variant = desc;
+        variant.entryPoint = "Broken";
+        uint64_t brokenKey = 0;
+        ShaderCache::computeKey(variant, brokenKey);
+        check(ShaderCache::load(cacheDirectory.c_str(), variant, compile, cachedBytecode) == ShaderCache::LoadResult::Failed, "compile errors fail the load");
+        check(!std::filesystem::exists(ShaderCache::cachePath(cacheDirectory.c_str(), brokenKey)), "failed compiles aren't cached");
+        variant = desc;
+        variant.sourcePath = (root / "missing.hlsl").generic_string();
+        check(ShaderCache::load(cacheDirectory.c_str(), variant, compile, cachedBytecode) == ShaderCache::LoadResult::Failed && compileCount == compileCountBefore + 1, "missing sources fail without compiling");
+
+        // A hit costs hashing the include closure & reading one small file
+        ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode);
+        Timer timer{};
+        timer.reset();
+        uint32_t hitCount = 0;
+        for (uint32_t lookupIdx = 0; lookupIdx < lookupCount; lookupIdx++) {
+            hitCount += (ShaderCache::load(cacheDirectory.c_str(), desc, compile, cachedBytecode) == ShaderCache::LoadResult::Loaded) ? 1 : 0;
+        }
+        timer.tick();
+        check(hitCount == lookupCount, "repeated loads hit the cache");
+
+        printf("Shader cache, %zu files in the include closure, %u lookups: %.3f ms / hit\n", files.size(), lookupCount, timer.deltaTimeMS() / std::max(1U, lookupCount));
+        std::filesystem::remove_all(root, error);
+        return check.passed();
+    }
+} // namespace Tests
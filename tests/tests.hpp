@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "texture_data.hpp"
+
+/// @brief Checks & benchmarks of the engine code that runs without a GPU. Each prints its results & returns false if a
+/// check failed.
+namespace Tests
+{
+    /// @brief Tracks whether a test's checks passed, printing each failed check as "<name> check failed: <description>".
+    /// Descriptions are printf formats of the remaining arguments. Replays of long sequences print their first failure only.
+    class Checker
+    {
+    public:
+        explicit Checker(char const* name, bool firstFailureOnly = false) : m_name(name), m_firstFailureOnly(firstFailureOnly) {}
+
+        /// @brief Returns the condition, so dependent checks can be skipped.
+        template<typename... Args>
+        bool operator()(bool condition, char const* description, Args... args)
+        {
+            if (condition) {
+                return true;
+            }
+
+            if (m_passed || !m_firstFailureOnly)
+            {
+                printf("%s check failed: ", m_name);
+                if constexpr (sizeof...(Args) == 0) {
+                    fputs(description, stdout);
+                }
+                else {
+                    printf(description, args...);
+                }
+                printf("\n");
+            }
+
+            m_passed = false;
+            return false;
+        }
+
+        bool passed() const { return m_passed; }
+
+    private:
+        char const* m_name;
+        bool m_firstFailureOnly;
+        bool m_passed = true;
+    };
+
+    bool benchmarkOBJ(char const* sourcePath);
+    bool benchmarkMips(uint32_t size);
+    bool benchmarkBlockCompression(char const* imagePath, Engine::TextureType type);
+    bool benchmarkStartup(uint32_t threadCount);
+
+    bool testMeshlets(char const* sourcePath);
+    bool testLods(char const* sourcePath);
+    bool testVertexPacking(char const* sourcePath);
+    bool testTangents(char const* sourcePath);
+
+    bool testRingAllocator(uint32_t operationCount);
+    bool testFrameTimeline(uint32_t frameCount);
+    bool testDescriptorAllocator(uint32_t operationCount);
+    bool testHeapAllocator(uint32_t operationCount);
+
+    bool testRenderGraph(uint32_t graphCount);
+
+    bool testJobSystem(uint32_t jobCount);
+    bool testCommandRecorder(uint32_t frameCount);
+
+    bool benchmarkInstances(uint32_t instanceCount);
+    bool benchmarkCulling(uint32_t objectCount);
+    bool benchmarkSceneBvh(uint32_t objectCount);
+    bool benchmarkTriangleBvh(char const* sourcePath);
+    bool benchmarkDrawSort(uint32_t packetCount);
+
+    bool testShaderCache(uint32_t lookupCount);
+} // namespace Tests
@@ -0,0 +1,423 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "block_compression.hpp"
+#include "culling.hpp"
+#include "job_system.hpp"
+#include "lod.hpp"
+#include "mesh.hpp"
+#include "mesh_cache.hpp"
+#include "meshlet.hpp"
+#include "texture_cache.hpp"
+#include "texture_import.hpp"
+#include "timer.hpp"
+#include "vertex_packing.hpp"
+
+using namespace Engine;
+
+static void printUsage()
+{
+    printf("Usage: AssetCooker mesh <input.obj> [output] [--compare]\n");
+    printf("       AssetCooker obj-generate <output.obj> [resolution]\n");
+    printf("       AssetCooker texture <image> [output] [--normal | --linear] [--format <format>] [--compare]\n");
+    printf("  mesh          Cook an OBJ mesh into a binary mesh cache (default output: <input>%s)\n", MeshCache::FileExtension);
+    printf("  --compare     Compare OBJ parse / image import time against cache load time\n");
+    printf("  obj-generate  Write a colored quad torus OBJ for benchmarking (default resolution: 1024)\n");
+    printf("  texture       Cook an image into a texture cache in its final GPU format (default output: <input>%s)\n", TextureCache::FileExtension);
+    printf("  --normal      Treat the image as a tangent space normal map, --linear as non color data\n");
+    printf("  --format      rgba8, bc1, bc3, bc4, bc5 or bc7 (default: picked from the texture type & channel count)\n");
+    printf("Checks & benchmarks of the engine code live in EngineTests.\n");
+}
+
+static void reportPacking(MeshData const& meshData)
+{
+    float maxTexCoord = 0.0F;
+    for (auto const& vertex : meshData.vertices) {
+        maxTexCoord = std::max(maxTexCoord, std::max(std::abs(vertex.texCoord.x), std::abs(vertex.texCoord.y)));
+    }
+
+    VertexPacking::QuantizationBounds const bounds = VertexPacking::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+    VertexPacking::PackingError const error = VertexPacking::measureError(meshData.vertices.data(), meshData.vertices.size(), bounds);
+    VertexPacking::PackingError const errorBounds = VertexPacking::errorBounds(bounds, maxTexCoord);
+
+    bool const shortIndices = VertexPacking::indexFormat(meshData.vertices.size()) == VertexPacking::IndexFormat::R16_UINT;
+    size_t const fullSize = meshData.vertices.size() * sizeof(Vertex) + meshData.indices.size() * sizeof(uint32_t);
+    size_t const packedSize = meshData.vertices.size() * sizeof(PackedVertex) + meshData.indices.size() * (shortIndices ? sizeof(uint16_t) : sizeof(uint32_t));
+    printf("Packed size: %.1f KiB -> %.1f KiB (%s indices)\n", static_cast<double>(fullSize) / 1024.0, static_cast<double>(packedSize) / 1024.0, shortIndices ? "16-bit" : "32-bit");
+    printf("Packing error (max / bound, EngineTests pack-test checks them):\n");
+    printf("  position  %12.8f / %12.8f\n", error.position, errorBounds.position);
+    printf("  normal    %12.8f / %12.8f deg\n", error.normalDegrees, errorBounds.normalDegrees);
+    printf("  tangent   %12.8f / %12.8f deg\n", error.tangentDegrees, errorBounds.tangentDegrees);
+    printf("  texcoord  %12.8f / %12.8f\n", error.texCoord, errorBounds.texCoord);
+    printf("  color     %12.8f / %12.8f\n", error.color, errorBounds.color);
+
+    if (error.position > errorBounds.position
+        || error.normalDegrees > errorBounds.normalDegrees
+        || error.tangentDegrees > errorBounds.tangentDegrees
+        || error.texCoord > errorBounds.texCoord
+        || error.color > errorBounds.color)
+    {
+        printf("Warning: packed vertex error exceeds expected bounds, consider disabling packed vertices for this mesh\n");
+    }
+}
+
+static void reportMeshletCulling(MeshData const& meshData)
+{
+    MeshletData const& meshletData = meshData.meshlets;
+    if (meshletData.meshlets.empty()) {
+        return;
+    }
+
+    size_t const triangleCount = meshData.indices.size() / 3;
+    printf("Meshlets: %zu (avg %.1f vertices, %.1f triangles)\n",
+        meshletData.meshlets.size(),
+        static_cast<double>(meshletData.vertices.size()) / static_cast<double>(meshletData.meshlets.size()),
+        static_cast<double>(triangleCount) / static_cast<double>(meshletData.meshlets.size())
+    );
+
+    // Orbit cameras on a fibonacci sphere around the mesh, all looking at its center, at a far & a close up distance
+    constexpr uint32_t CameraCount = 64;
+    constexpr float GoldenAngle = 2.39996323F;
+    constexpr float OrbitDistances[] = { 1.25F, 0.5F };
+
+    VertexPacking::QuantizationBounds const bounds = VertexPacking::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+    glm::vec3 const center = bounds.min + bounds.extent * 0.5F;
+    for (float const orbitDistance : OrbitDistances)
+    {
+        float const orbitRadius = glm::length(bounds.extent) * orbitDistance;
+
+        double frustumRejected = 0.0;
+        double backfaceRejected = 0.0;
+        double minRejected = 1.0;
+        double maxRejected = 0.0;
+        for (uint32_t cameraIdx = 0; cameraIdx < CameraCount; cameraIdx++)
+        {
+            float const y = 1.0F - 2.0F * (static_cast<float>(cameraIdx) + 0.5F) / static_cast<float>(CameraCount);
+            float const ringRadius = std::sqrt(1.0F - y * y);
+            float const theta = GoldenAngle * static_cast<float>(cameraIdx);
+            glm::vec3 const direction = glm::vec3(std::cos(theta) * ringRadius, y, std::sin(theta) * ringRadius);
+
+            Camera camera{};
+            camera.position = center + direction * orbitRadius;
+            camera.forward = -direction;
+            camera.up = (std::abs(direction.y) > 0.99F) ? glm::vec3(0.0F, 0.0F, 1.0F) : glm::vec3(0.0F, 1.0F, 0.0F);
+            camera.aspectRatio = 16.0F / 9.0F;
+            camera.zNear = orbitRadius * 0.01F;
+            camera.zFar = orbitRadius * 4.0F;
+
+            Frustum const frustum = Culling::extractFrustum(camera.matrix());
+            size_t culledByFrustum = 0;
+            size_t culledByBackface = 0;
+            for (size_t meshletIdx = 0; meshletIdx < meshletData.meshlets.size(); meshletIdx++)
+            {
+                uint32_t const meshletTriangles = meshletData.meshlets[meshletIdx].triangleCount;
+                switch (Meshlets::cullMeshlet(meshletData.bounds[meshletIdx], frustum, camera.position))
+                {
+                case Meshlets::CullResult::Frustum:
+                    culledByFrustum += meshletTriangles;
+                    break;
+                case Meshlets::CullResult::Backface:
+                    culledByBackface += meshletTriangles;
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            double const rejected = static_cast<double>(culledByFrustum + culledByBackface) / static_cast<double>(triangleCount);
+            frustumRejected += static_cast<double>(culledByFrustum) / static_cast<double>(triangleCount);
+            backfaceRejected += static_cast<double>(culledByBackface) / static_cast<double>(triangleCount);
+            minRejected = std::min(minRejected, rejected);
+            maxRejected = std::max(maxRejected, rejected);
+        }
+
+        printf("Meshlet culling, %u cameras at %.2fx extent: %.1f%% triangles rejected (%.1f%% frustum, %.1f%% backface, min %.1f%%, max %.1f%%)\n",
+            CameraCount, orbitDistance,
+            100.0 * (frustumRejected + backfaceRejected) / CameraCount,
+            100.0 * frustumRejected / CameraCount,
+            100.0 * backfaceRejected / CameraCount,
+            100.0 * minRejected,
+            100.0 * maxRejected
+        );
+    }
+}
+
+static void reportLods(MeshData const& meshData)
+{
+    LodData const& lods = meshData.lods;
+    size_t const triangleCount = meshData.indices.size() / 3;
+    VertexPacking::QuantizationBounds const bounds = VertexPacking::computeBounds(meshData.vertices.data(), meshData.vertices.size());
+    float const radius = glm::length(bounds.extent) * 0.5F;
+
+    printf("LODs: %zu (error relative to bounding radius, EngineTests lod-test checks targets & error bounds)\n", lods.levels.size());
+    for (size_t levelIdx = 0; levelIdx < lods.levels.size(); levelIdx++)
+    {
+        LodLevel const& level = lods.levels[levelIdx];
+        size_t const targetTriangles = static_cast<size_t>(static_cast<float>(triangleCount) * Lods::DefaultLodRatios[levelIdx]);
+        float const measuredError = Lods::measureError(meshData.vertices, lods.indices.data() + level.indexOffset, level.indexCount);
+        printf("  LOD %zu  %8u triangles (target %8zu)  quadric error %.5f  measured error %.5f\n",
+            levelIdx + 1,
+            level.indexCount / 3, targetTriangles,
+            static_cast<double>(level.error / radius),
+            static_cast<double>(measuredError / radius)
+        );
+    }
+}
+
+static bool cookMesh(char const* sourcePath, char const* outputPath, bool compare)
+{
+    Timer timer{};
+    MeshData meshData{};
+    if (!MeshHelpers::parseOBJ(sourcePath, meshData)) {
+        return false;
+    }
+
+    MeshHelpers::processMesh(meshData);
+
+    timer.tick();
+    double const parseTimeMS = timer.deltaTimeMS();
+
+    MeshCache::SourceInfo sourceInfo{};
+    if (!MeshCache::querySource(sourcePath, sourceInfo, true)
+        || !MeshCache::write(outputPath, sourceInfo, meshData))
+    {
+        printf("Mesh cache write failed [%s]\n", outputPath);
+        return false;
+    }
+
+    printf("Cooked mesh [%s] -> [%s] (%zu vertices, %zu indices)\n", sourcePath, outputPath, meshData.vertices.size(), meshData.indices.size());
+    reportPacking(meshData);
+    reportMeshletCulling(meshData);
+    reportLods(meshData);
+    if (!compare) {
+        return true;
+    }
+
+    // Copy cached arrays into a staging allocation, as the renderer does with its upload buffer
+    timer.reset();
+    MeshCache::CachedMesh cachedMesh{};
+    if (!MeshCache::open(outputPath, cachedMesh))
+    {
+        printf("Mesh cache open failed [%s]\n", outputPath);
+        return false;
+    }
+
+    size_t const vertexBytes = cachedMesh.vertexCount * sizeof(Vertex);
+    size_t const indexBytes = cachedMesh.indexCount * sizeof(uint32_t);
+    std::vector<uint8_t> staging(vertexBytes + indexBytes);
+    memcpy(staging.data(), cachedMesh.pVertices, vertexBytes);
+    memcpy(staging.data() + vertexBytes, cachedMesh.pIndices, indexBytes);
+
+    timer.tick();
+    double const cacheTimeMS = timer.deltaTimeMS();
+    printf("OBJ parse:  %10.2f ms\n", parseTimeMS);
+    printf("Cache load: %10.2f ms (%.1fx faster)\n", cacheTimeMS, parseTimeMS / cacheTimeMS);
+    return true;
+}
+
+static bool cookTexture(char const* sourcePath, char const* outputPath, TextureType type, TextureFormat const* pFormat, bool compare)
+{
+    Timer timer{};
+    TextureData textureData{};
+    bool const imported = (pFormat != nullptr)
+        ? TextureImport::importImage(sourcePath, type, *pFormat, textureData)
+        : TextureImport::importImage(sourcePath, type, textureData);
+    if (!imported) {
+        return false;
+    }
+
+    timer.tick();
+    double const importTimeMS = timer.deltaTimeMS();
+
+    MeshCache::SourceInfo sourceInfo{};
+    if (!MeshCache::querySource(sourcePath, sourceInfo, true)
+        || !TextureCache::write(outputPath, sourceInfo, textureData))
+    {
+        printf("Texture cache write failed [%s]\n", outputPath);
+        return false;
+    }
+
+    size_t dataSize = 0;
+    for (auto const& level : textureData.levels) {
+        dataSize += level.data.size();
+    }
+
+    printf("Cooked texture [%s] -> [%s] (%s, %u x %u, %zu levels, %.1f KiB)\n", sourcePath, outputPath, BlockCompression::formatName(textureData.format),
+        textureData.levels[0].width, textureData.levels[0].height, textureData.levels.size(), static_cast<double>(dataSize) / 1024.0);
+    if (!compare) {
+        return true;
+    }
+
+    // Decode only, the lower bound of the stb path before any mip generation or compression
+    timer.reset();
+    TextureData decoded{};
+    uint32_t channelCount = 0;
+    if (!TextureImport::decodeImage(sourcePath, type, decoded, channelCount)) {
+        return false;
+    }
+
+    timer.tick();
+    double const decodeTimeMS = timer.deltaTimeMS();
+
+    // Copy cached levels into a staging allocation mip tail first, as the renderer does with its upload buffer
+    Timer cacheTimer{};
+    TextureCache::CachedTexture cachedTexture{};
+    if (!TextureCache::open(outputPath, cachedTexture))
+    {
+        printf("Texture cache open failed [%s]\n", outputPath);
+        return false;
+    }
+
+    TextureCache::Header const& header = *cachedTexture.pHeader;
+    std::vector<uint8_t> staging(header.levels[0].offset + static_cast<size_t>(header.levels[0].rowPitch) * header.levels[0].rowCount);
+    uint32_t const tailLevel = cachedTexture.tailLevel();
+    double tailTimeMS = 0.0;
+    for (uint32_t levelIdx = header.levelCount; levelIdx-- > 0;)
+    {
+        TextureCache::Level const& level = header.levels[levelIdx];
+        memcpy(&staging[level.offset], cachedTexture.levelData(levelIdx), static_cast<size_t>(level.rowPitch) * level.rowCount);
+        if (levelIdx == tailLevel)
+        {
+            cacheTimer.tick();
+            tailTimeMS = cacheTimer.timeSinceStartMS();
+        }
+    }
+
+    cacheTimer.tick();
+    double const cacheTimeMS = cacheTimer.timeSinceStartMS();
+    printf("STB decode:          %10.2f ms\n", decodeTimeMS);
+    printf("STB + mips + encode: %10.2f ms\n", importTimeMS);
+    printf("Cache mip tail:      %10.2f ms (levels %u-%u usable)\n", tailTimeMS, tailLevel, header.levelCount - 1);
+    printf("Cache load:          %10.2f ms (%.1fx faster than decode, %.1fx faster than import)\n", cacheTimeMS, decodeTimeMS / cacheTimeMS, importTimeMS / cacheTimeMS);
+    return true;
+}
+
+static bool generateOBJ(char const* outputPath, uint32_t resolution)
+{
+    FILE* pFile = fopen(outputPath, "wb");
+    if (pFile == nullptr)
+    {
+        printf("OBJ file open failed [%s]\n", outputPath);
+        return false;
+    }
+
+    // Torus with a seam, so positions, normals & texture coords are indexed independently
+    constexpr float TwoPi = 6.28318531F;
+    uint32_t const majorCount = resolution;
+    uint32_t const minorCount = std::max(3U, resolution / 4);
+    fprintf(pFile, "# AssetCooker generated torus, %u x %u quads\n", majorCount, minorCount);
+    for (uint32_t i = 0; i < majorCount; i++)
+    {
+        for (uint32_t j = 0; j < minorCount; j++)
+        {
+            float const u = TwoPi * static_cast<float>(i) / static_cast<float>(majorCount);
+            float const v = TwoPi * static_cast<float>(j) / static_cast<float>(minorCount);
+            glm::vec3 const normal(std::cos(u) * std::cos(v), std::sin(v), std::sin(u) * std::cos(v));
+            glm::vec3 const position = glm::vec3(std::cos(u), 0.0F, std::sin(u)) + normal * 0.25F;
+            fprintf(pFile, "v %.6f %.6f %.6f %.4f %.4f %.4f\n", position.x, position.y, position.z, normal.x * 0.5F + 0.5F, normal.y * 0.5F + 0.5F, normal.z * 0.5F + 0.5F);
+            fprintf(pFile, "vn %.6f %.6f %.6f\n", normal.x, normal.y, normal.z);
+        }
+    }
+
+    for (uint32_t i = 0; i <= majorCount; i++)
+    {
+        for (uint32_t j = 0; j <= minorCount; j++) {
+            fprintf(pFile, "vt %.6f %.6f\n", static_cast<float>(i) / static_cast<float>(majorCount), static_cast<float>(j) / static_cast<float>(minorCount));
+        }
+    }
+
+    for (uint32_t i = 0; i < majorCount; i++)
+    {
+        for (uint32_t j = 0; j < minorCount; j++)
+        {
+            uint32_t const p[4] = {
+                i * minorCount + j + 1,
+                ((i + 1) % majorCount) * minorCount + j + 1,
+                ((i + 1) % majorCount) * minorCount + (j + 1) % minorCount + 1,
+                i * minorCount + (j + 1) % minorCount + 1,
+            };
+            uint32_t const t[4] = {
+                i * (minorCount + 1) + j + 1,
+                (i + 1) * (minorCount + 1) + j + 1,
+                (i + 1) * (minorCount + 1) + j + 2,
+                i * (minorCount + 1) + j + 2,
+            };
+            fprintf(pFile, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", p[0], t[0], p[0], p[3], t[3], p[3], p[2], t[2], p[2], p[1], t[1], p[1]);
+        }
+    }
+
+    bool const success = ferror(pFile) == 0;
+    fclose(pFile);
+    printf("Generated OBJ [%s] (%u quads)\n", outputPath, majorCount * minorCount);
+    return success;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        printUsage();
+        return 1;
+    }
+
+    JobSystem jobs{}; //< parsing, mesh processing & texture compression split their loops over it
+
+    char const* command = argv[1];
+    char const* sourcePath = argv[2];
+    char const* outputPath = nullptr;
+    bool compare = false;
+    TextureType textureType = TextureType::Color;
+    TextureFormat textureFormat = TextureFormat::RGBA8;
+    bool explicitFormat = false;
+    for (int argIdx = 3; argIdx < argc; argIdx++)
+    {
+        if (strcmp(argv[argIdx], "--compare") == 0) {
+            compare = true;
+        }
+        else if (strcmp(argv[argIdx], "--normal") == 0) {
+            textureType = TextureType::Normal;
+        }
+        else if (strcmp(argv[argIdx], "--linear") == 0) {
+            textureType = TextureType::Linear;
+        }
+        else if (strcmp(argv[argIdx], "--format") == 0)
+        {
+            explicitFormat = (argIdx + 1 < argc) && BlockCompression::parseFormat(argv[++argIdx], textureFormat);
+            if (!explicitFormat)
+            {
+                printUsage();
+                return 1;
+            }
+        }
+        else {
+            outputPath = argv[argIdx];
+        }
+    }
+
+    if (strcmp(command, "mesh") == 0)
+    {
+        std::string const defaultOutputPath = MeshCache::cachePath(sourcePath);
+        return cookMesh(sourcePath, outputPath != nullptr ? outputPath : defaultOutputPath.c_str(), compare) ? 0 : 1;
+    }
+
+    if (strcmp(command, "texture") == 0)
+    {
+        std::string const defaultOutputPath = TextureCache::cachePath(sourcePath);
+        return cookTexture(sourcePath, outputPath != nullptr ? outputPath : defaultOutputPath.c_str(), textureType, explicitFormat ? &textureFormat : nullptr, compare) ? 0 : 1;
+    }
+
+    if (strcmp(command, "obj-generate") == 0)
+    {
+        uint32_t const resolution = (outputPath != nullptr) ? static_cast<uint32_t>(std::max(4L, strtol(outputPath, nullptr, 10))) : 1024;
+        return generateOBJ(sourcePath, resolution) ? 0 : 1;
+    }
+
+    printUsage();
+    return 1;
+}